@@ -39,8 +39,14 @@
 
 #include "cyhal.h"
 #include "cybsp.h"
+#include "cy_pdl.h"
 #include "audio.h"
 #include "config.h"
+#include "decimator.h"
+#include "events.h"
+#include "profile.h"
+#include "ring.h"
+#include "timebase.h"
 
 /******************************************************************************
  * Macros
@@ -60,11 +66,50 @@
 #define PDM_DATA                    P10_5
 #define PDM_CLK                     P10_4
 
-/* Set up one buffer for data collection and one for processing */
-int16_t audio_buffer0[FRAME_SIZE] = {0};
-int16_t audio_buffer1[FRAME_SIZE] = {0};
-int16_t* active_rx_buffer;
-int16_t* full_rx_buffer;
+/* Samples per DMA X loop; every frame length is a multiple of this and the
+ * largest frame fits in the 256 iterations of the Y loop */
+#define DMA_X_COUNT                 (64u)
+
+/* Priority of the DMA segment complete interrupt. Higher than the sensor
+ * timers so that a frame is queued as soon as it is complete. */
+#define DMA_INTERRUPT_PRIORITY      (2u)
+
+/* Most segments of the circular capture buffer; a power of two */
+#define AUDIO_SEGMENTS_MAX          (8u)
+
+/* Samples in the circular capture buffer: two frames of FRAME_SIZE_MAX
+ * samples captured at DECIMATOR_MAX_FACTOR times the highest sent rate */
+#define AUDIO_CAPTURE_SIZE          (2 * FRAME_SIZE_MAX * DECIMATOR_MAX_FACTOR)
+
+/* A frame completed by the DMA, and the number of segments completed since
+ * the start of the capture, including this one */
+typedef struct
+{
+    int16_t *data;
+    uint32_t sequence;
+} audio_frame_t;
+
+/* The circular capture buffer is split into segments of one frame, as many as
+ * fit up to AUDIO_SEGMENTS_MAX, that the DMA fills in turn. Shorter frames
+ * thus leave the main loop more time before a frame is overwritten. */
+int16_t audio_buffer[AUDIO_CAPTURE_SIZE] = {0};
+static uint32_t segments = 2;
+static volatile uint32_t segments_filled = 0;
+
+/* Completed frames, queued by the DMA interrupt for the main loop */
+static audio_frame_t audio_frames[AUDIO_SEGMENTS_MAX];
+static ring_t audio_ring;
+
+/* Number of samples captured per frame at the PDM rate */
+static uint32_t read_size = FRAME_SIZE;
+static decimator_t decimator;
+
+/* Frames overwritten by the DMA before the main loop consumed them */
+static uint32_t overruns = 0;
+
+/* The measured rate of the PDM clock, from the samples captured since the
+ * DMA was started */
+static timebase_rate_t pdm_rate;
 
 
 /******************************************************************************
@@ -75,6 +120,14 @@ cyhal_pdm_pcm_t pdm_pcm;
 cyhal_clock_t   audio_clock;
 cyhal_clock_t   pll_clock;
 
+/* DMA channel reserved through the HAL, driven with a loop of chained
+ * descriptors, one per segment */
+cyhal_dma_t     pdm_dma;
+DW_Type*        pdm_dma_hw;
+uint32_t        pdm_dma_channel;
+IRQn_Type       pdm_dma_irq;
+cy_stc_dma_descriptor_t pdm_dma_descriptor[AUDIO_SEGMENTS_MAX];
+
 /* HAL PDM Configuration */
 const cyhal_pdm_pcm_cfg_t pdm_pcm_cfg =
 {
@@ -91,7 +144,10 @@ const cyhal_pdm_pcm_cfg_t pdm_pcm_cfg =
 * Function Prototypes
 *******************************************************************************/
 cy_rslt_t pdm_clock_init(void);
-void pdm_pcm_event_handler(void *arg, cyhal_pdm_pcm_event_t event);
+cy_rslt_t pdm_dma_init(void);
+cy_rslt_t pdm_dma_start(void);
+void pdm_dma_event_handler(void);
+static bool pdm_overwritten(const audio_frame_t *frame);
 
 
 /*******************************************************************************
@@ -103,8 +159,8 @@ void pdm_pcm_event_handler(void *arg, cyhal_pdm_pcm_event_t event);
 ********************************************************************************
 * Summary:
 *    A function used to initialize and configure the PDM based on the shield
-*    selected in the makefile. Starts an asynchronous read which triggers an
-*    interrupt when completed.
+*    selected in the makefile. Starts continuous DMA capture which triggers an
+*    interrupt each time a segment of the circular buffer is filled.
 *
 * Parameters:
 *   None
@@ -132,27 +188,35 @@ cy_rslt_t pdm_init(void)
         return result;
     }
 
-    /* Register the PDM callback and set the interrupt event */
-    cyhal_pdm_pcm_register_callback(&pdm_pcm, pdm_pcm_event_handler, NULL);
-    cyhal_pdm_pcm_enable_event(&pdm_pcm, CYHAL_PDM_PCM_ASYNC_COMPLETE, CYHAL_ISR_PRIORITY_DEFAULT, true);
+    /* Reserve the DMA channel and route the PDM RX request to it */
+    result = pdm_dma_init();
+    if(CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
 
-    result = cyhal_pdm_pcm_start(&pdm_pcm);
+    result = ring_init(&audio_ring, audio_frames, sizeof(audio_frames[0]), AUDIO_SEGMENTS_MAX);
     if(CY_RSLT_SUCCESS != result)
     {
         return result;
     }
 
-    /* Set up pointers to two buffers to implement a ping-pong buffer system.
-     * One gets filled by the PDM while the other can be processed. */
-    active_rx_buffer = audio_buffer0;
-    full_rx_buffer = audio_buffer1;
+    /* Pass samples through until a rate is selected */
+    decimator_init(&decimator, 1);
 
-    pdm_pcm_flag = false;
+#ifdef TIMEBASE_DISCIPLINE_AUDIO
+    /* The sensor timers follow the PDM clock */
+    timebase_set_reference(&pdm_rate);
+#endif
 
-    /* Start an asynchronous read */
-    cyhal_pdm_pcm_read_async(&pdm_pcm, active_rx_buffer, FRAME_SIZE);
+    /* Start filling the circular buffer before the FIFO starts filling */
+    result = pdm_dma_start();
+    if(CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
 
-    return CY_RSLT_SUCCESS;
+    return cyhal_pdm_pcm_start(&pdm_pcm);
 }
 
 /*******************************************************************************
@@ -216,52 +280,318 @@ cy_rslt_t pdm_clock_init(void)
 }
 
 /*******************************************************************************
-* Function Name: pdm_pcm_event_handler
+* Function Name: pdm_dma_init
 ********************************************************************************
 * Summary:
-*  PDM/PCM ISR handler. Swaps the two buffers and restarts the PDM async read.
-*  Set a flag to be processed in the main loop.
+*    Reserves a DMA channel triggered by the PDM/PCM RX FIFO request and
+*    installs the segment complete interrupt. The HAL takes care of the
+*    channel allocation and trigger routing; the descriptors are managed with
+*    the PDL since the HAL does not support descriptor chaining.
 *
 * Parameters:
-*  arg: not used
-*  event: event that occurred
+*   None
+*
+* Return:
+*     The status of the initialization.
 *
 *******************************************************************************/
-void pdm_pcm_event_handler(void *arg, cyhal_pdm_pcm_event_t event)
+cy_rslt_t pdm_dma_init(void)
 {
-    (void) arg;
-    (void) event;
+    cy_rslt_t result;
+    cyhal_dma_src_t source =
+    {
+        .source = CYHAL_TRIGGER_AUDIOSS0_TR_PDM_RX_REQ,
+        .input  = CYHAL_DMA_INPUT_TRIGGER_SINGLE_ELEMENT,
+    };
 
-    if(false == pdm_pcm_flag)
+    result = cyhal_dma_init_adv(&pdm_dma, &source, NULL, NULL, CYHAL_DMA_PRIORITY_DEFAULT, CYHAL_DMA_DIRECTION_PERIPH2MEM);
+    if(CY_RSLT_SUCCESS != result)
     {
-        pdm_pcm_flag = true;
+        return result;
+    }
+
+    pdm_dma_hw = (0 == pdm_dma.resource.block_num) ? DW0 : DW1;
+    pdm_dma_channel = pdm_dma.resource.channel_num;
 
-        /* Flip the active and the next rx buffers */
-        int16_t* temp = active_rx_buffer;
-        active_rx_buffer = full_rx_buffer;
-        full_rx_buffer = temp;
+    pdm_dma_irq = (IRQn_Type) (((0 == pdm_dma.resource.block_num) ? cpuss_interrupts_dw0_0_IRQn : cpuss_interrupts_dw1_0_IRQn) + pdm_dma_channel);
 
+    const cy_stc_sysint_t interrupt_config =
+    {
+        .intrSrc      = pdm_dma_irq,
+        .intrPriority = DMA_INTERRUPT_PRIORITY,
+    };
+    if(CY_SYSINT_SUCCESS != Cy_SysInt_Init(&interrupt_config, pdm_dma_event_handler))
+    {
+        return CYHAL_PDM_PCM_RSLT_ERR_INVALID_CONFIG_PARAM;
     }
-    /* Initiate the next pdm read */
-    cyhal_pdm_pcm_read_async(&pdm_pcm, active_rx_buffer, FRAME_SIZE);
+    NVIC_EnableIRQ(pdm_dma_irq);
+
+    Cy_DMA_Enable(pdm_dma_hw);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: pdm_dma_start
+********************************************************************************
+* Summary:
+*    (Re)starts the DMA with one descriptor of read_size samples per segment,
+*    chained in a loop so that the channel keeps cycling through the segments
+*    without any software involvement. Each descriptor raises an interrupt
+*    when its segment is full.
+*
+* Parameters:
+*   None
+*
+* Return:
+*     The status of the configuration.
+*
+*******************************************************************************/
+cy_rslt_t pdm_dma_start(void)
+{
+    cy_stc_dma_descriptor_config_t descriptor_config =
+    {
+        .retrigger       = CY_DMA_RETRIG_4CYC,
+        .interruptType   = CY_DMA_DESCR,
+        .triggerOutType  = CY_DMA_1ELEMENT,
+        .channelState    = CY_DMA_CHANNEL_ENABLED,
+        .triggerInType   = CY_DMA_1ELEMENT,
+        .dataSize        = CY_DMA_HALFWORD,
+        .srcTransferSize = CY_DMA_TRANSFER_SIZE_WORD,
+        .dstTransferSize = CY_DMA_TRANSFER_SIZE_DATA,
+        .descriptorType  = CY_DMA_2D_TRANSFER,
+        .srcAddress      = (void *) &pdm_pcm.base->RX_FIFO_RD,
+        .srcXincrement   = 0,
+        .dstXincrement   = 1,
+        .xCount          = DMA_X_COUNT,
+        .srcYincrement   = 0,
+        .dstYincrement   = DMA_X_COUNT,
+        .yCount          = read_size / DMA_X_COUNT,
+    };
+    cy_stc_dma_channel_config_t channel_config =
+    {
+        .descriptor  = &pdm_dma_descriptor[0],
+        .preemptable = false,
+        .priority    = 0,
+        .enable      = false,
+        .bufferable  = false,
+    };
+
+    Cy_DMA_Channel_Disable(pdm_dma_hw, pdm_dma_channel);
+
+    segments = AUDIO_CAPTURE_SIZE / read_size;
+    if (segments > AUDIO_SEGMENTS_MAX)
+    {
+        segments = AUDIO_SEGMENTS_MAX;
+    }
+
+    for (uint32_t segment = 0; segment < segments; segment++)
+    {
+        descriptor_config.dstAddress = &audio_buffer[segment * read_size];
+        descriptor_config.nextDescriptor = &pdm_dma_descriptor[(segment + 1) % segments];
+        if(CY_DMA_SUCCESS != Cy_DMA_Descriptor_Init(&pdm_dma_descriptor[segment], &descriptor_config))
+        {
+            return CYHAL_PDM_PCM_RSLT_ERR_INVALID_CONFIG_PARAM;
+        }
+    }
+
+    if(CY_DMA_SUCCESS != Cy_DMA_Channel_Init(pdm_dma_hw, pdm_dma_channel, &channel_config))
+    {
+        return CYHAL_PDM_PCM_RSLT_ERR_INVALID_CONFIG_PARAM;
+    }
+
+    /* Discard events of the previous configuration */
+    Cy_DMA_Channel_ClearInterrupt(pdm_dma_hw, pdm_dma_channel);
+    NVIC_ClearPendingIRQ(pdm_dma_irq);
+    ring_flush(&audio_ring);
+    segments_filled = 0;
+    timebase_rate_init(&pdm_rate, SAMPLE_RATE_HZ);
+
+    Cy_DMA_Channel_SetInterruptMask(pdm_dma_hw, pdm_dma_channel, CY_DMA_INTR_MASK);
+    Cy_DMA_Channel_Enable(pdm_dma_hw, pdm_dma_channel);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: pdm_dma_event_handler
+********************************************************************************
+* Summary:
+*  DMA ISR handler, called each time a segment is full. The DMA has already
+*  moved on to the next segment, so nothing needs to be re-armed here. The
+*  frame is queued for the main loop, which checks whether the DMA has come
+*  around to it again before it was consumed.
+*
+*******************************************************************************/
+void pdm_dma_event_handler(void)
+{
+    audio_frame_t frame;
+    uint32_t current;
+
+    Cy_DMA_Channel_ClearInterrupt(pdm_dma_hw, pdm_dma_channel);
+
+    /* The channel now runs the descriptor after the segment that was filled */
+    current = Cy_DMA_Channel_GetCurrentDescriptor(pdm_dma_hw, pdm_dma_channel) - pdm_dma_descriptor;
+    frame.data = &audio_buffer[((current + segments - 1) % segments) * read_size];
+    frame.sequence = ++segments_filled;
+    timebase_rate_update(&pdm_rate, segments_filled * read_size);
+
+    if (ring_push(&audio_ring, &frame))
+    {
+        events_post(EVENT_AUDIO);
+    }
+}
+
+/*******************************************************************************
+* Function Name: pdm_configure
+********************************************************************************
+* Summary:
+*  Selects the output sample rate and the number of samples in each audio
+*  frame. Rates below PDM_SAMPLE_RATE are derived by the decimator, so the PDM
+*  block keeps running at one rate. The DMA is restarted with the new frame
+*  length, dropping the frame in progress.
+*
+* Parameters:
+*  sample_rate: output rate; PDM_SAMPLE_RATE divided by 1, 2, 3 or 6
+*  size: samples per frame, a power of two from FRAME_SIZE_MIN to
+*        FRAME_SIZE_MAX
+*
+* Return:
+*  CY_RSLT_SUCCESS, or an error if the rate or size is not supported.
+*
+*******************************************************************************/
+cy_rslt_t pdm_configure(uint32_t sample_rate, uint32_t size)
+{
+    uint32_t factor;
+
+    if (size < FRAME_SIZE_MIN || size > FRAME_SIZE_MAX || (size & (size - 1)) != 0)
+    {
+        return CYHAL_PDM_PCM_RSLT_ERR_INVALID_CONFIG_PARAM;
+    }
+    if (0 == sample_rate || 0 != SAMPLE_RATE_HZ % sample_rate)
+    {
+        return CYHAL_PDM_PCM_RSLT_ERR_INVALID_CONFIG_PARAM;
+    }
+    factor = SAMPLE_RATE_HZ / sample_rate;
+    if (!decimator_init(&decimator, factor))
+    {
+        return CYHAL_PDM_PCM_RSLT_ERR_INVALID_CONFIG_PARAM;
+    }
+
+    read_size = size * factor;
+
+    return pdm_dma_start();
+}
+
+/*******************************************************************************
+* Function Name: pdm_get_overruns
+********************************************************************************
+* Summary:
+*  Returns the number of frames lost because the main loop did not consume
+*  them before the DMA wrapped around the circular buffer. Capture itself is
+*  continuous, so any gap in the audio stream shows up here.
+*
+*******************************************************************************/
+uint32_t pdm_get_overruns(void)
+{
+    return overruns + ring_get_overflows(&audio_ring);
+}
+
+/*******************************************************************************
+* Function Name: pdm_get_queue_max
+********************************************************************************
+* Summary:
+*  Returns the most frames that have waited in the audio ring for the main
+*  loop at once.
+*
+*******************************************************************************/
+uint32_t pdm_get_queue_max(void)
+{
+    return ring_get_high_water(&audio_ring);
+}
+
+/*******************************************************************************
+* Function Name: pdm_get_drift
+********************************************************************************
+* Summary:
+*  Returns the drift of the PDM clock against the timebase, measured since the
+*  capture was last started.
+*
+* Parameters:
+*  ppb: receives the drift in parts per billion
+*  seconds: receives the length of the measurement
+*
+* Return:
+*  True if the capture ran long enough to measure the drift.
+*
+*******************************************************************************/
+bool pdm_get_drift(int32_t *ppb, uint32_t *seconds)
+{
+    return timebase_rate_get_drift(&pdm_rate, ppb, seconds);
+}
+
+/*******************************************************************************
+* Function Name: pdm_overwritten
+********************************************************************************
+* Summary:
+*  Checks whether the DMA has started to fill the segment of a frame again.
+*  That happens when the segment before it completes, segments - 1
+*  completions after the frame.
+*
+* Parameters:
+*  frame: the frame
+*
+*******************************************************************************/
+static bool pdm_overwritten(const audio_frame_t *frame)
+{
+    return segments_filled - frame->sequence >= segments - 1;
 }
 
 /*******************************************************************************
 * Function Name: pdm_preprocessing_feed
 ********************************************************************************
 * Summary:
-*  This function returns the pdm data.
+*  This function takes the oldest completed frame and returns its pdm data,
+*  decimated to the selected sample rate. Frames the DMA has overwritten
+*  already are skipped, and a frame overwritten while it is decimated is
+*  still returned; both are counted as overruns.
 *
 * Parameters:
-*  preprocessed_data: Stores float PDM values
+*  preprocessed_data: Stores PDM values, room for FRAME_SIZE_MAX samples
+*
+* Return:
+*  The number of samples stored; 0 if no frame is available.
 *
 *******************************************************************************/
-void pdm_preprocessing_feed(int16_t *preprocessed_data)
+size_t pdm_preprocessing_feed(int16_t *preprocessed_data)
 {
-    for (uint32_t index = 0; index < FRAME_SIZE ; index ++)
+    PROFILE_SCOPE(PROFILE_PDM_PREPROCESSING_FEED);
+    audio_frame_t frame;
+    size_t count;
+
+    for (;;)
     {
-        preprocessed_data[index] = full_rx_buffer[index];
+        if (!ring_pop(&audio_ring, &frame))
+        {
+            return 0;
+        }
+        if (!pdm_overwritten(&frame))
+        {
+            break;
+        }
+        overruns++;
     }
+
+    {
+        PROFILE_SCOPE(PROFILE_DECIMATOR);
+        count = decimator_process(&decimator, frame.data, preprocessed_data, read_size);
+    }
+    if (pdm_overwritten(&frame))
+    {
+        overruns++;
+    }
+
+    return count;
 }
 
 /* [] END OF FILE */
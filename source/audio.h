@@ -45,18 +45,20 @@
 /******************************************************************************
  * Constants
  *****************************************************************************/
-/* Define how many samples in a frame */
+/* Define how many samples in a frame. The host may select any power of two
+ * between FRAME_SIZE_MIN and FRAME_SIZE_MAX when subscribing. */
 #define FRAME_SIZE                  (1024)
-
-/******************************************************************************
- * Global Variables
- *****************************************************************************/
-extern volatile bool pdm_pcm_flag;
+#define FRAME_SIZE_MIN              (128)
+#define FRAME_SIZE_MAX              (2048)
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 cy_rslt_t pdm_init(void);
-void pdm_preprocessing_feed(int16_t *preprocessed_data);
+cy_rslt_t pdm_configure(uint32_t sample_rate, uint32_t size);
+uint32_t pdm_get_overruns(void);
+uint32_t pdm_get_queue_max(void);
+bool pdm_get_drift(int32_t *ppb, uint32_t *seconds);
+size_t pdm_preprocessing_feed(int16_t *preprocessed_data);
 
 #endif /* SOURCE_AUDIO_H_ */
@@ -39,8 +39,13 @@
 * so agrees to indemnify Cypress against all liability.
 *******************************************************************************/
 
+#include <math.h>
 #include "bmm.h"
 #include "config.h"
+#include "bus.h"
+#include "calibration.h"
+#include "events.h"
+#include "timebase.h"
 #include "cyhal.h"
 #include "cybsp.h"
 #if defined(IM_MAG_BMM350) || (IM_XSS_BMM350)
@@ -55,10 +60,12 @@
 *******************************************************************************/
 #define I2C_TIMEOUT_MS          (1U)
 #define BMM350_SCAN_RATE        50
-#define BMM350_TIMER_FREQUENCY  100000
-#define BMM350_TIMER_PERIOD     (BMM350_TIMER_FREQUENCY/BMM350_SCAN_RATE)
 #define BMM350_TIMER_PRIORITY   4
 
+#if defined(BMM_INT_PIN) && !(defined(IM_MAG_BMM350) || defined(IM_XSS_BMM350))
+#error "BMM_INT_PIN is only supported for the BMM350"
+#endif
+
 #ifdef IM_XSS_BMM350
 #define BMM350_ADDRESS (MTB_BMM350_ADDRESS_DEFAULT)
 #else
@@ -75,14 +82,20 @@
     /* BMX160 driver structures */
     mtb_bmx160_t sensor_bmm150;
 #endif
+#ifdef BMM_INT_PIN
+static cyhal_gpio_callback_data_t bmm350_pin_callback;
+#else
 /* timer used for getting data */
-cyhal_timer_t bmm350_timer;
+static timebase_timer_t bmm350_timer;
+#endif
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-void bmm350_timer_intr_handler(void* callback_arg, cyhal_timer_event_t event);
+void bmm350_timer_intr_handler(void *arg);
+void bmm350_pin_handler(void* callback_arg, cyhal_gpio_event_t event);
 cy_rslt_t bmm350_timer_init(void);
+cy_rslt_t bmm350_pin_init(void);
 
 
 /*******************************************************************************
@@ -90,7 +103,9 @@ cy_rslt_t bmm350_timer_init(void);
 ********************************************************************************
 * Summary:
 *    A function used to initialize the magnetometer based on the shield selected 
-*    in the makefile. Starts a timer that triggers an interrupt at 50Hz.
+*    in the makefile. With BMM_INT_PIN the data ready interrupt of the BMM350
+*    signals each sample at 50Hz; otherwise a timer triggers an interrupt at
+*    50Hz.
 *
 * Parameters:
 *   None
@@ -105,26 +120,40 @@ cy_rslt_t mag_sensor_init(void)
     cy_rslt_t result;
 
 #ifdef IM_BMX_160_IMU_SPI
-    result = mtb_bmx160_init_spi(&sensor_bmm150, &spi, CYBSP_SPI_CS);
+    /* The IMU shares the SPI bus and may already be polling it */
+    result = bus_acquire(&bus_spi);
+    if(CY_RSLT_SUCCESS == result)
+    {
+        result = mtb_bmx160_init_spi(&sensor_bmm150, &spi, CYBSP_SPI_CS);
+        bus_release(&bus_spi);
+    }
     if(CY_RSLT_SUCCESS != result)
     {
         return result;
     }
-    bmm_flag = false;
 #endif
 
 #if defined(IM_MAG_BMM350) || (IM_XSS_BMM350)
-    /* Initialize BMM350 */
-    result = mtb_bmm350_init_i2c(&sensor_bmm350, &i2c, BMM350_ADDRESS);
+    /* Initialize BMM350. The IMU may already be polling the I2C bus. */
+    result = bus_acquire(&bus_i2c);
+    if(CY_RSLT_SUCCESS == result)
+    {
+        result = mtb_bmm350_init_i2c(&sensor_bmm350, &i2c, BMM350_ADDRESS);
+        bus_release(&bus_i2c);
+    }
     if(CY_RSLT_SUCCESS != result)
     {
         return result;
     }
-    bmm_flag = false;
 #endif
 
+#ifdef BMM_INT_PIN
+    /* Data ready interrupt for data collection */
+    result = bmm350_pin_init();
+#else
     /* Timer for data collection */
     result = bmm350_timer_init();
+#endif
     if(CY_RSLT_SUCCESS != result)
     {
         return result;
@@ -134,75 +163,58 @@ cy_rslt_t mag_sensor_init(void)
 }
 
 
+#ifdef BMM_INT_PIN
 /*******************************************************************************
-* Function Name: bmm350_timer_init
+* Function Name: bmm350_pin_init
 ********************************************************************************
 * Summary:
-*   Sets up an interrupt that triggers at the desired frequency.
+*   Sets the output data rate of the BMM350 to 50Hz and routes its data ready
+*   interrupt to the INT pin, which is connected to BMM_INT_PIN.
 *
 * Returns:
 *   The status of the initialization.
 *
 *
 *******************************************************************************/
-cy_rslt_t bmm350_timer_init(void)
+cy_rslt_t bmm350_pin_init(void)
 {
     cy_rslt_t rslt;
-    const cyhal_timer_cfg_t timer_cfg =
-    {
-        .compare_value = 0,                 /* Timer compare value, not used */
-        .period = BMM350_TIMER_PERIOD,      /* Defines the timer period */
-        .direction = CYHAL_TIMER_DIR_UP,    /* Timer counts up */
-        .is_compare = false,                /* Don't use compare mode */
-        .is_continuous = true,              /* Run the timer indefinitely */
-        .value = 0                          /* Initial value of counter */
-    };
-
-    /* Initialize the timer object. Does not use pin output ('pin' is NC) and
-    * does not use a pre-configured clock source ('clk' is NULL). */
-    rslt = cyhal_timer_init(&bmm350_timer, NC, NULL);
-    if (CY_RSLT_SUCCESS != rslt)
-    {
-        return rslt;
-    }
+    bool configured;
 
-    /* Apply timer configuration such as period, count direction, run mode, etc. */
-    rslt = cyhal_timer_configure(&bmm350_timer, &timer_cfg);
+    rslt = bus_acquire(&bus_i2c);
     if (CY_RSLT_SUCCESS != rslt)
     {
         return rslt;
     }
-
-    /* Set the frequency of timer to 100KHz */
-    rslt = cyhal_timer_set_frequency(&bmm350_timer, BMM350_TIMER_FREQUENCY);
-    if (CY_RSLT_SUCCESS != rslt)
+    configured = BMM350_OK == bmm350_set_odr_performance(BMM350_DATA_RATE_50HZ, BMM350_AVERAGING_4, &(sensor_bmm350.sensor)) &&
+                 BMM350_OK == bmm350_configure_interrupt(BMM350_PULSED, BMM350_ACTIVE_HIGH, BMM350_INTR_PUSH_PULL,
+                                                         BMM350_MAP_TO_PIN, &(sensor_bmm350.sensor)) &&
+                 BMM350_OK == bmm350_enable_interrupt(BMM350_ENABLE_INTERRUPT, &(sensor_bmm350.sensor));
+    bus_release(&bus_i2c);
+    if (!configured)
     {
-        return rslt;
+        return -1;
     }
 
-    /* Assign the ISR to execute on timer interrupt */
-    cyhal_timer_register_callback(&bmm350_timer, bmm350_timer_intr_handler, NULL);
-
-    /* Set the event on which timer interrupt occurs and enable it */
-    cyhal_timer_enable_event(&bmm350_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, BMM350_TIMER_PRIORITY, true);
-    
-    /* Start the timer with the configured settings */
-    rslt = cyhal_timer_start(&bmm350_timer);
+    rslt = cyhal_gpio_init(BMM_INT_PIN, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_NONE, false);
     if (CY_RSLT_SUCCESS != rslt)
     {
         return rslt;
     }
+    bmm350_pin_callback.callback = bmm350_pin_handler;
+    cyhal_gpio_register_callback(BMM_INT_PIN, &bmm350_pin_callback);
+    cyhal_gpio_enable_event(BMM_INT_PIN, CYHAL_GPIO_IRQ_RISE, BMM350_TIMER_PRIORITY, true);
 
     return CY_RSLT_SUCCESS;
 }
 
 
 /*******************************************************************************
-* Function Name: bmm350_timer_intr_handler
+* Function Name: bmm350_pin_handler
 ********************************************************************************
 * Summary:
-*   Interrupt handler for timer. Interrupt handler will get called at 50Hz and
-*   sets a flag that can be checked in main.
+*   Interrupt handler for the data ready interrupt. Called once per sample of
+*   the sensor and sets a flag that can be checked in main.
 *
 * Parameters:
 *     callback_arg: not used
@@ -210,49 +222,111 @@ cy_rslt_t bmm350_timer_init(void)
 *
 *
 *******************************************************************************/
-void bmm350_timer_intr_handler(void *callback_arg, cyhal_timer_event_t event)
+void bmm350_pin_handler(void *callback_arg, cyhal_gpio_event_t event)
 {
     (void) callback_arg;
     (void) event;
 
-    bmm_flag = true;
+    events_post(EVENT_MAG);
 }
+#else
+
+
+/*******************************************************************************
+* Function Name: bmm350_timer_init
+********************************************************************************
+* Summary:
+*   Starts a timebase timer that triggers at the desired frequency.
+*
+* Returns:
+*   The status of the initialization.
+*
+*
+*******************************************************************************/
+cy_rslt_t bmm350_timer_init(void)
+{
+    /* The timer sets the sample instants, so it follows the audio clock when
+     * the timers are disciplined */
+    timebase_timer_init(&bmm350_timer, bmm350_timer_intr_handler, NULL, true);
+
+    return timebase_start(&bmm350_timer, TIMEBASE_FREQUENCY, BMM350_SCAN_RATE, TIMEBASE_PHASE_MAG);
+}
+
+
+/*******************************************************************************
+* Function Name: bmm350_timer_intr_handler
+********************************************************************************
+* Summary:
+*   Timebase callback. Called at 50Hz and sets a flag that can be checked in
+*   main.
+*
+* Parameters:
+*     arg: not used
+*
+*
+*******************************************************************************/
+void bmm350_timer_intr_handler(void *arg)
+{
+    (void) arg;
+
+    events_post(EVENT_MAG);
+}
+#endif
 
 
 /*******************************************************************************
 * Function Name: bmm350_get_data
 ********************************************************************************
 * Summary:
-*   Reads Magnetometer data from the magnetometer and stores it in a buffer.
+*   Reads Magnetometer data from the magnetometer and stores it in a buffer as
+*   counts of BMM_SCALE microtesla. The BMM150 of the BMX160 reports these
+*   counts; the compensated BMM350 values are rounded to them. The counts are
+*   corrected with the calibration coefficients.
 *
 * Parameters:
 *     bmm_data: Stores Magnetometer data
 *
 *
 *******************************************************************************/
-void bmm350_get_data(float *bmm_data)
+void bmm350_get_data(int16_t *bmm_data)
 {
     cy_rslt_t result;
 #ifdef IM_BMX_160_IMU_SPI
     mtb_bmx160_data_t data_bmm;
-    result = mtb_bmx160_read(&sensor_bmm150, &data_bmm);
+    result = bus_acquire(&bus_spi);
+    if (CY_RSLT_SUCCESS == result)
+    {
+        result = mtb_bmx160_read(&sensor_bmm150, &data_bmm);
+        bus_release(&bus_spi);
+    }
     if (CY_RSLT_SUCCESS == result)
     {
         bmm_data[0] = data_bmm.mag.y;
         bmm_data[1] = data_bmm.mag.x;
         bmm_data[2] = data_bmm.mag.z;
+#ifdef IM_ENABLE_CALIBRATION
+        calibration_process(CALIBRATION_MAG, bmm_data, 1);
+#endif
     }
 #endif
 
 #if defined(IM_MAG_BMM350) || (IM_XSS_BMM350)
     /* Read data from BMM sensor */
     mtb_bmm350_data_t data_bmm;
-    result = mtb_bmm350_read(&sensor_bmm350, &data_bmm);
+    result = bus_acquire(&bus_i2c);
     if (CY_RSLT_SUCCESS == result)
     {
-        bmm_data[0] = data_bmm.sensor_data.y;
-        bmm_data[1] = data_bmm.sensor_data.x;
-        bmm_data[2] = data_bmm.sensor_data.z;
+        result = mtb_bmm350_read(&sensor_bmm350, &data_bmm);
+        bus_release(&bus_i2c);
+    }
+    if (CY_RSLT_SUCCESS == result)
+    {
+        bmm_data[0] = (int16_t) lroundf(data_bmm.sensor_data.y / BMM_SCALE);
+        bmm_data[1] = (int16_t) lroundf(data_bmm.sensor_data.x / BMM_SCALE);
+        bmm_data[2] = (int16_t) lroundf(data_bmm.sensor_data.z / BMM_SCALE);
+#ifdef IM_ENABLE_CALIBRATION
+        calibration_process(CALIBRATION_MAG, bmm_data, 1);
+#endif
     }
 #endif
 }
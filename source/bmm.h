@@ -43,21 +43,21 @@
 
 #include "cy_result.h"
 #include "stdbool.h"
-
-/******************************************************************************
- * Global Variables
- *****************************************************************************/
-extern volatile bool bmm_flag;
+#include "stdint.h"
 
 /******************************************************************************
  * Macros
  *****************************************************************************/
 #define BMM_AXIS 3
 
+/* Microtesla per count, as a value and as reported in the config? response */
+#define BMM_SCALE               (1.0f / 16.0f)
+#define BMM_SCALE_STRING        "0.0625"
+
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 cy_rslt_t mag_sensor_init(void);
-void bmm350_get_data(float *bmm_data);
+void bmm350_get_data(int16_t *bmm_data);
 
 #endif /* SOURCE_BMM_H_ */
@@ -0,0 +1,656 @@
+/******************************************************************************
+* File Name:   bus.c
+*
+* Description: This file implements the shared I2C and SPI buses: per-device
+*              handles, a queue of asynchronous transactions completed by
+*              interrupt, and arbitration with blocking sensor drivers.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "bus.h"
+#include "cybsp.h"
+#include "config.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define BUS_I2C_FREQUENCY           400000
+#define BUS_INTERRUPT_PRIORITY      7
+
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+cyhal_i2c_t i2c;
+cyhal_spi_t spi;
+cyhal_spi_t radar_spi;
+
+bus_t bus_i2c;
+bus_t bus_spi;
+bus_t bus_radar;
+
+
+/* Completion of a blocking transfer */
+typedef struct
+{
+    volatile bool done;
+    cy_rslt_t result;
+} bus_transfer_status_t;
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static cy_rslt_t bus_spi_init(bus_t *bus, cyhal_spi_t *obj, cyhal_gpio_t mosi, cyhal_gpio_t miso, cyhal_gpio_t clk);
+static void bus_start(bus_t *bus);
+static cy_rslt_t bus_begin(bus_t *bus);
+static void bus_complete(bus_t *bus, cy_rslt_t result);
+static void bus_cancel(bus_transaction_t *transaction, cy_rslt_t result);
+static void bus_i2c_event_handler(void *callback_arg, cyhal_i2c_event_t event);
+static void bus_spi_event_handler(void *callback_arg, cyhal_spi_event_t event);
+static void bus_transfer_handler(bus_transaction_t *transaction, cy_rslt_t result);
+
+
+/*******************************************************************************
+* Function Name: bus_init
+********************************************************************************
+* Summary:
+*    Initializes the I2C bus and, depending on the configuration, the SPI bus
+*    of the shield and the SPI bus of the radar. Each bus has its own block, so
+*    shield sensors and radar can be used together.
+*
+* Return:
+*     The status of the initialization.
+*
+*
+*******************************************************************************/
+cy_rslt_t bus_init(void)
+{
+    cy_rslt_t result;
+    cyhal_i2c_cfg_t i2c_config =
+    {
+         .is_slave = false,
+         .address = 0,
+         .frequencyhal_hz = BUS_I2C_FREQUENCY
+    };
+
+    /* Initialize I2C for IMU communication */
+    result = cyhal_i2c_init(&i2c, CYBSP_I2C_SDA, CYBSP_I2C_SCL, NULL);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    /* Configure the I2C */
+    result = cyhal_i2c_configure(&i2c, &i2c_config);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    bus_i2c.type = BUS_TYPE_I2C;
+    bus_i2c.hal = &i2c;
+    cyhal_i2c_register_callback(&i2c, bus_i2c_event_handler, &bus_i2c);
+    cyhal_i2c_enable_event(&i2c,
+                           (cyhal_i2c_event_t) (CYHAL_I2C_MASTER_WR_CMPLT_EVENT |
+                                                CYHAL_I2C_MASTER_RD_CMPLT_EVENT |
+                                                CYHAL_I2C_MASTER_ERR_EVENT),
+                           BUS_INTERRUPT_PRIORITY, true);
+
+#if defined(IM_BMI_160_IMU_SPI) || (IM_BMX_160_IMU_SPI)
+    result = bus_spi_init(&bus_spi, &spi, CYBSP_SPI_MOSI, CYBSP_SPI_MISO, CYBSP_SPI_CLK);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    /* Initialize the chip select line */
+    result = cyhal_gpio_init(CYBSP_SPI_CS, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, 1);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+#endif
+
+#ifdef IM_ENABLE_RADAR
+    /* The chip select line is initialized by the radar driver */
+    result = bus_spi_init(&bus_radar, &radar_spi, CYBSP_RSPI_MOSI, CYBSP_RSPI_MISO, CYBSP_RSPI_CLK);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+#endif
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_spi_init
+********************************************************************************
+* Summary:
+*    Initializes an SPI master for blocking transfers by the sensor drivers and
+*    asynchronous DMA transfers by the transaction queue.
+*
+* Parameters:
+*     bus: the bus to initialize
+*     obj: the SPI object of the bus
+*     mosi, miso, clk: the pins of the bus
+*
+* Return:
+*     The status of the initialization.
+*
+*
+*******************************************************************************/
+static cy_rslt_t bus_spi_init(bus_t *bus, cyhal_spi_t *obj, cyhal_gpio_t mosi, cyhal_gpio_t miso, cyhal_gpio_t clk)
+{
+    cy_rslt_t result;
+
+    result = cyhal_spi_init(obj, mosi, miso, clk, NC, NULL, 8, CYHAL_SPI_MODE_00_MSB, false);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+    result = cyhal_spi_set_frequency(obj, SPI_FREQUENCY);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+    result = cyhal_spi_set_async_mode(obj, CYHAL_ASYNC_DMA, CYHAL_DMA_PRIORITY_DEFAULT);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    bus->type = BUS_TYPE_SPI;
+    bus->hal = obj;
+    cyhal_spi_register_callback(obj, bus_spi_event_handler, bus);
+    cyhal_spi_enable_event(obj, CYHAL_SPI_IRQ_DONE, BUS_INTERRUPT_PRIORITY, true);
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_device_init_i2c
+********************************************************************************
+* Summary:
+*    Initializes the handle of a device on an I2C bus.
+*
+* Parameters:
+*     device: the handle to initialize
+*     bus: the bus the device is connected to
+*     address: the 7 bit address of the device
+*
+*
+*******************************************************************************/
+void bus_device_init_i2c(bus_device_t *device, bus_t *bus, uint16_t address)
+{
+    device->bus = bus;
+    device->address = address;
+    device->cs = NC;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_device_init_spi
+********************************************************************************
+* Summary:
+*    Initializes the handle of a device on an SPI bus. The chip select line
+*    must be initialized as an output by the caller or the sensor driver.
+*
+* Parameters:
+*     device: the handle to initialize
+*     bus: the bus the device is connected to
+*     cs: the chip select line of the device
+*
+*
+*******************************************************************************/
+void bus_device_init_spi(bus_device_t *device, bus_t *bus, cyhal_gpio_t cs)
+{
+    device->bus = bus;
+    device->address = 0;
+    device->cs = cs;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_submit
+********************************************************************************
+* Summary:
+*    Queues a transaction. It is started at once if the bus is free, and
+*    otherwise after the transactions before it. The callback is called from
+*    the bus interrupt when it has completed. The transaction must stay valid
+*    and must not be submitted again until then. May be called from interrupts.
+*
+* Parameters:
+*     transaction: the transaction to run
+*
+* Return:
+*     The status of the start if the transaction was started at once. If a
+*     queued transaction fails to start later, its callback gets the error.
+*
+*
+*******************************************************************************/
+cy_rslt_t bus_submit(bus_transaction_t *transaction)
+{
+    bus_t *bus = transaction->device->bus;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t state = cyhal_system_critical_section_enter();
+
+    transaction->next = NULL;
+    if (NULL == bus->head)
+    {
+        bus->head = transaction;
+        bus->tail = transaction;
+        if (!bus->locked)
+        {
+            /* A failed start is reported to the caller, not the callback */
+            result = bus_begin(bus);
+            if (CY_RSLT_SUCCESS != result)
+            {
+                bus->head = NULL;
+                bus->tail = NULL;
+            }
+        }
+    }
+    else
+    {
+        bus->tail->next = transaction;
+        bus->tail = transaction;
+    }
+
+    cyhal_system_critical_section_exit(state);
+    return result;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_transfer
+********************************************************************************
+* Summary:
+*    Queues a transaction and waits until it has completed, e.g. for register
+*    writes while configuring a sensor. A transaction that has not completed
+*    within BUS_TIMEOUT_US is aborted or taken off the queue. Must not be
+*    called from interrupts or while the bus is held.
+*
+* Parameters:
+*     device: the device to access
+*     tx, tx_size: the bytes to write
+*     rx, rx_size: receives the bytes read
+*
+* Return:
+*     The status of the transaction, or BUS_RSLT_ERR_TIMEOUT.
+*
+*
+*******************************************************************************/
+cy_rslt_t bus_transfer(const bus_device_t *device, const uint8_t *tx, size_t tx_size, uint8_t *rx, size_t rx_size)
+{
+    bus_transfer_status_t status = { .done = false, .result = CY_RSLT_SUCCESS };
+    bus_transaction_t transaction =
+    {
+        .device = device,
+        .tx = tx,
+        .tx_size = tx_size,
+        .rx = rx,
+        .rx_size = rx_size,
+        .callback = bus_transfer_handler,
+        .callback_arg = &status
+    };
+    cy_rslt_t result;
+
+    result = bus_submit(&transaction);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+    for (uint32_t waited = 0; !status.done && waited < BUS_TIMEOUT_US; waited += BUS_POLL_US)
+    {
+        cyhal_system_delay_us(BUS_POLL_US);
+    }
+    if (!status.done)
+    {
+        bus_cancel(&transaction, BUS_RSLT_ERR_TIMEOUT);
+    }
+
+    return status.result;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_transfer_handler
+********************************************************************************
+* Summary:
+*    Completes a transaction of bus_transfer.
+*
+* Parameters:
+*     transaction: the transaction
+*     result: the status of the transaction
+*
+*
+*******************************************************************************/
+static void bus_transfer_handler(bus_transaction_t *transaction, cy_rslt_t result)
+{
+    bus_transfer_status_t *status = (bus_transfer_status_t*) transaction->callback_arg;
+
+    status->result = result;
+    status->done = true;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_acquire
+********************************************************************************
+* Summary:
+*    Waits until the queued transactions have completed and no one else holds
+*    the bus, and holds it for blocking accesses by a sensor driver.
+*    Transactions submitted meanwhile wait until bus_release. Must not be
+*    called from interrupts.
+*
+* Parameters:
+*     bus: the bus to hold
+*
+* Return:
+*     CY_RSLT_SUCCESS, or BUS_RSLT_ERR_TIMEOUT if the bus did not become free
+*     within BUS_TIMEOUT_US; the bus is not held then.
+*
+*
+*******************************************************************************/
+cy_rslt_t bus_acquire(bus_t *bus)
+{
+    for (uint32_t waited = 0; waited < BUS_TIMEOUT_US; waited += BUS_POLL_US)
+    {
+        uint32_t state = cyhal_system_critical_section_enter();
+        if (!bus->locked && NULL == bus->head)
+        {
+            bus->locked = true;
+            cyhal_system_critical_section_exit(state);
+            return CY_RSLT_SUCCESS;
+        }
+        cyhal_system_critical_section_exit(state);
+        cyhal_system_delay_us(BUS_POLL_US);
+    }
+
+    return BUS_RSLT_ERR_TIMEOUT;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_release
+********************************************************************************
+* Summary:
+*    Releases a bus held by bus_acquire and starts the transactions submitted
+*    meanwhile.
+*
+* Parameters:
+*     bus: the bus to release
+*
+*
+*******************************************************************************/
+void bus_release(bus_t *bus)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+    bus->locked = false;
+    bus_start(bus);
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: bus_start
+********************************************************************************
+* Summary:
+*    Starts the transaction at the head of the queue unless one is running or
+*    the bus is held. Transactions that fail to start are completed with the
+*    error. Must be called from the bus interrupt or with interrupts disabled.
+*
+* Parameters:
+*     bus: the bus
+*
+*
+*******************************************************************************/
+static void bus_start(bus_t *bus)
+{
+    while (!bus->active && !bus->locked && NULL != bus->head)
+    {
+        cy_rslt_t result = bus_begin(bus);
+        if (CY_RSLT_SUCCESS != result)
+        {
+            bus_complete(bus, result);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: bus_begin
+********************************************************************************
+* Summary:
+*    Starts the transfer of the transaction at the head of the queue. Must be
+*    called from the bus interrupt or with interrupts disabled.
+*
+* Parameters:
+*     bus: the bus
+*
+* Return:
+*     The status of the start.
+*
+*
+*******************************************************************************/
+static cy_rslt_t bus_begin(bus_t *bus)
+{
+    bus_transaction_t *transaction = bus->head;
+    const bus_device_t *device = transaction->device;
+    cy_rslt_t result;
+
+    if (BUS_TYPE_I2C == bus->type)
+    {
+        result = cyhal_i2c_master_transfer_async((cyhal_i2c_t*) bus->hal, device->address,
+                                                 transaction->tx, transaction->tx_size,
+                                                 transaction->rx, transaction->rx_size);
+    }
+    else
+    {
+        cyhal_gpio_write(device->cs, false);
+        result = cyhal_spi_transfer_async((cyhal_spi_t*) bus->hal,
+                                          transaction->tx, transaction->tx_size,
+                                          transaction->rx, transaction->rx_size);
+        if (CY_RSLT_SUCCESS != result)
+        {
+            cyhal_gpio_write(device->cs, true);
+        }
+    }
+
+    bus->active = (CY_RSLT_SUCCESS == result);
+    return result;
+}
+
+
+/*******************************************************************************
+* Function Name: bus_complete
+********************************************************************************
+* Summary:
+*    Completes the running transaction and starts the next one.
+*
+* Parameters:
+*     bus: the bus
+*     result: the status of the transaction
+*
+*
+*******************************************************************************/
+static void bus_complete(bus_t *bus, cy_rslt_t result)
+{
+    bus_transaction_t *transaction = bus->head;
+
+    if (BUS_TYPE_SPI == bus->type)
+    {
+        cyhal_gpio_write(transaction->device->cs, true);
+    }
+
+    bus->head = transaction->next;
+    if (NULL == bus->head)
+    {
+        bus->tail = NULL;
+    }
+    bus->active = false;
+
+    /* The callback may submit the next transaction */
+    if (NULL != transaction->callback)
+    {
+        transaction->callback(transaction, result);
+    }
+
+    bus_start(bus);
+}
+
+
+/*******************************************************************************
+* Function Name: bus_cancel
+********************************************************************************
+* Summary:
+*    Ends a transaction that has not completed: a running transfer is aborted
+*    and completed with the result, a queued one is taken off the queue and
+*    its callback called with the result. Nothing is done if the transaction
+*    completed meanwhile.
+*
+* Parameters:
+*     transaction: the transaction
+*     result: the status passed to the callback
+*
+*
+*******************************************************************************/
+static void bus_cancel(bus_transaction_t *transaction, cy_rslt_t result)
+{
+    bus_t *bus = transaction->device->bus;
+    uint32_t state = cyhal_system_critical_section_enter();
+
+    if (bus->head == transaction)
+    {
+        if (bus->active)
+        {
+            if (BUS_TYPE_I2C == bus->type)
+            {
+                (void) cyhal_i2c_abort_async((cyhal_i2c_t*) bus->hal);
+            }
+            else
+            {
+                cyhal_spi_abort_async((cyhal_spi_t*) bus->hal);
+            }
+        }
+        bus_complete(bus, result);
+    }
+    else
+    {
+        for (bus_transaction_t *previous = bus->head; NULL != previous; previous = previous->next)
+        {
+            if (previous->next == transaction)
+            {
+                previous->next = transaction->next;
+                if (bus->tail == transaction)
+                {
+                    bus->tail = previous;
+                }
+                if (NULL != transaction->callback)
+                {
+                    transaction->callback(transaction, result);
+                }
+                break;
+            }
+        }
+    }
+
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: bus_i2c_event_handler
+********************************************************************************
+* Summary:
+*    Interrupt handler for I2C events. Events of blocking driver accesses, made
+*    while the bus is held, are ignored.
+*
+* Parameters:
+*     callback_arg: the bus
+*     event: the I2C events
+*
+*
+*******************************************************************************/
+static void bus_i2c_event_handler(void *callback_arg, cyhal_i2c_event_t event)
+{
+    bus_t *bus = (bus_t*) callback_arg;
+
+    if (!bus->active)
+    {
+        return;
+    }
+
+    if (0 != (event & CYHAL_I2C_MASTER_ERR_EVENT))
+    {
+        bus_complete(bus, BUS_RSLT_ERR_I2C);
+    }
+    else if (0 != (event & CYHAL_I2C_MASTER_RD_CMPLT_EVENT) ||
+             (0 != (event & CYHAL_I2C_MASTER_WR_CMPLT_EVENT) && 0 == bus->head->rx_size))
+    {
+        bus_complete(bus, CY_RSLT_SUCCESS);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: bus_spi_event_handler
+********************************************************************************
+* Summary:
+*    Interrupt handler for the end of an SPI transfer. Events of blocking driver
+*    accesses, made while the bus is held, are ignored.
+*
+* Parameters:
+*     callback_arg: the bus
+*     event: not used
+*
+*
+*******************************************************************************/
+static void bus_spi_event_handler(void *callback_arg, cyhal_spi_event_t event)
+{
+    bus_t *bus = (bus_t*) callback_arg;
+    (void) event;
+
+    if (bus->active)
+    {
+        bus_complete(bus, CY_RSLT_SUCCESS);
+    }
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+* File Name:   bus.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in bus.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_BUS_H_
+#define SOURCE_BUS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cyhal.h"
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Module of the bus results, at the end of the middleware range */
+#define BUS_RSLT_MODULE             (CY_RSLT_MODULE_MIDDLEWARE_BASE + 0xF0u)
+
+/* A transaction, or the wait for the bus, took longer than BUS_TIMEOUT_US */
+#define BUS_RSLT_ERR_TIMEOUT        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, BUS_RSLT_MODULE, 1u)
+
+/* The I2C block reported an error, e.g. a missing acknowledge */
+#define BUS_RSLT_ERR_I2C            CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, BUS_RSLT_MODULE, 2u)
+
+/* Longest wait for a transaction or for the bus. A radar FIFO burst of the
+ * largest frame takes about 11 ms at the SPI frequency. */
+#define BUS_TIMEOUT_US              (50000u)
+
+/* Interval at which the blocking functions check for completion */
+#define BUS_POLL_US                 (10u)
+
+/******************************************************************************
+ * Types
+ *****************************************************************************/
+typedef enum
+{
+    BUS_TYPE_I2C,
+    BUS_TYPE_SPI
+} bus_type_t;
+
+typedef struct bus_transaction bus_transaction_t;
+
+/* Called from the bus interrupt when a transaction has completed */
+typedef void (*bus_callback_t)(bus_transaction_t *transaction, cy_rslt_t result);
+
+/* A bus runs one transaction at a time; the others wait in a queue */
+typedef struct
+{
+    bus_type_t type;
+    void *hal;                              /* cyhal_i2c_t or cyhal_spi_t */
+    bus_transaction_t *volatile head;       /* Running or next transaction */
+    bus_transaction_t *tail;
+    volatile bool active;                   /* The head transaction is running */
+    volatile bool locked;                   /* Held by bus_acquire */
+} bus_t;
+
+/* A device on a bus */
+typedef struct
+{
+    bus_t *bus;
+    uint16_t address;                       /* 7 bit I2C address */
+    cyhal_gpio_t cs;                        /* SPI chip select, active low */
+} bus_device_t;
+
+/* A write followed by a read. For SPI both run full duplex from the start of
+ * the transaction, so the read data of a register access begins after the
+ * command bytes. */
+struct bus_transaction
+{
+    const bus_device_t *device;
+    const uint8_t *tx;
+    size_t tx_size;
+    uint8_t *rx;
+    size_t rx_size;
+    bus_callback_t callback;
+    void *callback_arg;
+    bus_transaction_t *next;
+};
+
+/******************************************************************************
+ * Global Variables
+ *****************************************************************************/
+extern bus_t bus_i2c;
+extern bus_t bus_spi;
+extern bus_t bus_radar;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+cy_rslt_t bus_init(void);
+void bus_device_init_i2c(bus_device_t *device, bus_t *bus, uint16_t address);
+void bus_device_init_spi(bus_device_t *device, bus_t *bus, cyhal_gpio_t cs);
+cy_rslt_t bus_submit(bus_transaction_t *transaction);
+cy_rslt_t bus_transfer(const bus_device_t *device, const uint8_t *tx, size_t tx_size, uint8_t *rx, size_t rx_size);
+cy_rslt_t bus_acquire(bus_t *bus);
+void bus_release(bus_t *bus);
+
+#endif /* SOURCE_BUS_H_ */
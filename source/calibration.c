@@ -0,0 +1,843 @@
+/******************************************************************************
+* File Name:   calibration.c
+*
+* Description: This file implements the calibration of the motion sensors:
+*              capture of the calibration data, persistence of the
+*              coefficients in flash and their correction of the samples.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "cyhal.h"
+#include "calibration.h"
+#include "imu.h"
+#include "bmm.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Gains are Q14 fixed point: a count is corrected to
+ * ((count - offset) * gain + 2^13) >> 14 */
+#define CALIBRATION_Q               (14)
+#define CALIBRATION_ONE             (1L << CALIBRATION_Q)
+
+/* Marks a valid record in flash; the low byte is the record version */
+#define CALIBRATION_MAGIC           (0x43414C01UL)
+
+/* The gyroscope bias and each accelerometer position are averaged over
+ * seconds of samples at the IMU rate. The magnetometer is captured for 30 s
+ * at its 50 Hz rate while the board is rotated. */
+#define CALIBRATION_GYRO_SECONDS    (2u)
+#define CALIBRATION_ACCEL_SECONDS   (1u)
+#define CALIBRATION_MAG_SAMPLES     (1500u)
+
+/* Largest standard deviation of a capture at rest, in counts: 0.5 dps for the
+ * gyroscope and 0.02 g for the accelerometer */
+#define CALIBRATION_GYRO_NOISE      (0.5f / GYRO_SCALE)
+#define CALIBRATION_ACCEL_NOISE     (0.02f / IMU_ACCEL_SCALE)
+
+/* In an accelerometer position gravity is along one axis: at least 0.8 g on
+ * that axis and at most 0.25 g on the others */
+#define CALIBRATION_ACCEL_ONE_G     (1.0f / IMU_ACCEL_SCALE)
+#define CALIBRATION_ACCEL_MIN_AXIS  (0.8f / IMU_ACCEL_SCALE)
+#define CALIBRATION_ACCEL_MAX_CROSS (0.25f / IMU_ACCEL_SCALE)
+#define CALIBRATION_ACCEL_POSITIONS (6u)
+
+/* Plausible strength of the fitted field, in microtesla */
+#define CALIBRATION_MAG_MIN_FIELD   (10.0f)
+#define CALIBRATION_MAG_MAX_FIELD   (150.0f)
+
+/* Accepted range of a gain */
+#define CALIBRATION_GAIN_MIN        (0.5f)
+#define CALIBRATION_GAIN_MAX        (1.5f)
+
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef enum
+{
+    CALIBRATION_STATE_NONE,
+    CALIBRATION_STATE_CAPTURING,
+    CALIBRATION_STATE_PARTIAL,
+    CALIBRATION_STATE_CALIBRATED,
+    CALIBRATION_STATE_FAILED
+} calibration_state_t;
+
+/* The coefficients as stored in flash */
+typedef struct
+{
+    uint32_t magic;
+    /* One bit per calibration_sensor_t with valid coefficients */
+    uint32_t valid;
+    int32_t offset[CALIBRATION_SENSORS][3];
+    int32_t gain[CALIBRATION_SENSORS][3];
+    uint32_t checksum;
+} calibration_record_t;
+
+/* A flash row holding a record */
+typedef union
+{
+    calibration_record_t record;
+    uint32_t words[CY_FLASH_SIZEOF_ROW / 4];
+} calibration_row_t;
+
+
+/*******************************************************************************
+* Local Constants
+*******************************************************************************/
+static const char* CALIBRATION_FORMAT =
+        "            \"calibration\": { \"status\": \"%s\", %s\"offset\": [ %ld, %ld, %ld ], "
+        "\"gain\": [ %lu.%04lu, %lu.%04lu, %lu.%04lu ] },\r\n";
+
+static const char* const CALIBRATION_STATE_NAMES[] =
+{
+    "uncalibrated", "capturing", "partial", "calibrated", "failed"
+};
+
+/* The flash row of the coefficients, in the emulated EEPROM region so that
+ * it is not shared with code or constants. Programming the device clears it. */
+CY_SECTION(".cy_em_eeprom") CY_ALIGN(CY_FLASH_SIZEOF_ROW)
+static const volatile calibration_row_t calibration_storage = { .words = { 0 } };
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+static cyhal_flash_t calibration_flash;
+static calibration_row_t calibration_row;
+
+/* The coefficients in use; sensors without valid coefficients have an offset
+ * of 0 and a gain of 1 */
+static calibration_record_t coefficients;
+static calibration_state_t states[CALIBRATION_SENSORS];
+
+/* The capture in progress, of one sensor at a time; no capture if the target
+ * is 0 */
+static calibration_sensor_t capture_sensor;
+static uint32_t capture_target = 0;
+static uint32_t capture_count;
+static int64_t capture_sum[3];
+static int64_t capture_squares[3];
+
+/* Magnetometer ellipsoid fit: the normal equations of the least squares fit
+ * of a x^2 + b y^2 + c z^2 + d x + e y + f z = 1 to the samples in
+ * microtesla, and the extent of the samples */
+static double fit_matrix[6][6];
+static double fit_vector[6];
+static float fit_min[3];
+static float fit_max[3];
+
+/* Mean counts on the axis with gravity in the accelerometer positions +x, -x,
+ * +y, -y, +z and -z, and the positions captured so far */
+static int32_t accel_positions[CALIBRATION_ACCEL_POSITIONS];
+static uint32_t accel_position_mask = 0;
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static void calibration_capture(const int16_t *data, uint32_t samples);
+static void calibration_finish(void);
+static calibration_state_t calibration_finish_gyro(void);
+static calibration_state_t calibration_finish_accel(void);
+static calibration_state_t calibration_finish_mag(void);
+static bool calibration_at_rest(float noise, float *mean);
+static bool calibration_solve(double matrix[6][6], double *vector);
+static void calibration_clear(calibration_sensor_t sensor);
+static void calibration_apply(const int32_t *offset, const int32_t *gain, int16_t *data, uint32_t samples);
+static uint32_t calibration_checksum(const calibration_record_t *record);
+static cy_rslt_t calibration_save(void);
+
+
+/*******************************************************************************
+* Function Name: calibration_init
+********************************************************************************
+* Summary:
+*  Loads the coefficients from flash. Without a valid record, no sensor is
+*  corrected.
+*
+* Return:
+*  The status of the initialization.
+*
+*******************************************************************************/
+cy_rslt_t calibration_init(void)
+{
+    cy_rslt_t result = cyhal_flash_init(&calibration_flash);
+
+    coefficients = calibration_storage.record;
+    if (coefficients.magic != CALIBRATION_MAGIC || coefficients.checksum != calibration_checksum(&coefficients))
+    {
+        coefficients.magic = CALIBRATION_MAGIC;
+        coefficients.valid = 0;
+    }
+
+    for (uint32_t sensor = 0; sensor < CALIBRATION_SENSORS; sensor++)
+    {
+        if (coefficients.valid & (1u << sensor))
+        {
+            states[sensor] = CALIBRATION_STATE_CALIBRATED;
+        }
+        else
+        {
+            calibration_clear((calibration_sensor_t) sensor);
+        }
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: calibration_start
+********************************************************************************
+* Summary:
+*  Starts the capture of a calibration. The samples passed to
+*  calibration_process afterwards are captured, and the coefficients are
+*  computed and saved once the capture is complete:
+*  - gyroscope: the bias, averaged over 2 s at rest
+*  - accelerometer: one of six positions with gravity along +x, -x, +y, -y,
+*    +z or -z, averaged over 1 s at rest; the offset and gain of each axis are
+*    computed once all six positions are captured
+*  - magnetometer: an ellipsoid fit to 30 s of samples taken while the board
+*    is rotated in all directions, giving the hard iron offset and the soft
+*    iron gain of each axis
+*
+* Parameters:
+*  sensor: the sensor to calibrate
+*
+* Return:
+*  The status; an error if another capture is in progress.
+*
+*******************************************************************************/
+cy_rslt_t calibration_start(calibration_sensor_t sensor)
+{
+    if (sensor >= CALIBRATION_SENSORS || capture_target != 0)
+    {
+        return -1;
+    }
+
+    switch (sensor)
+    {
+    case CALIBRATION_ACCEL:
+        capture_target = CALIBRATION_ACCEL_SECONDS * imu_get_rate();
+        break;
+    case CALIBRATION_GYRO:
+        capture_target = CALIBRATION_GYRO_SECONDS * imu_get_rate();
+        break;
+    default:
+        capture_target = CALIBRATION_MAG_SAMPLES;
+        memset(fit_matrix, 0, sizeof(fit_matrix));
+        memset(fit_vector, 0, sizeof(fit_vector));
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            fit_min[axis] = FLT_MAX;
+            fit_max[axis] = -FLT_MAX;
+        }
+        break;
+    }
+
+    capture_sensor = sensor;
+    capture_count = 0;
+    memset(capture_sum, 0, sizeof(capture_sum));
+    memset(capture_squares, 0, sizeof(capture_squares));
+    states[sensor] = CALIBRATION_STATE_CAPTURING;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: calibration_reset
+********************************************************************************
+* Summary:
+*  Removes the coefficients of a sensor, also from flash, and stops its
+*  capture.
+*
+* Parameters:
+*  sensor: the sensor to reset
+*
+* Return:
+*  The status of the flash write.
+*
+*******************************************************************************/
+cy_rslt_t calibration_reset(calibration_sensor_t sensor)
+{
+    if (sensor >= CALIBRATION_SENSORS)
+    {
+        return -1;
+    }
+
+    if (capture_target != 0 && capture_sensor == sensor)
+    {
+        capture_target = 0;
+    }
+    if (sensor == CALIBRATION_ACCEL)
+    {
+        accel_position_mask = 0;
+    }
+    calibration_clear(sensor);
+
+    return calibration_save();
+}
+
+/*******************************************************************************
+* Function Name: calibration_process
+********************************************************************************
+* Summary:
+*  Captures the samples of a sensor if its calibration is in progress, and
+*  corrects them with its coefficients. The capture sees the uncorrected
+*  samples. Completing a capture writes to flash, which stalls the CPU for a
+*  few milliseconds.
+*
+* Parameters:
+*  sensor: the sensor of the samples
+*  data: x, y and z counts of each sample; corrected in place
+*  samples: the number of samples
+*
+*******************************************************************************/
+void calibration_process(calibration_sensor_t sensor, int16_t *data, uint32_t samples)
+{
+    if (capture_target != 0 && capture_sensor == sensor)
+    {
+        calibration_capture(data, samples);
+    }
+
+    if (coefficients.valid & (1u << sensor))
+    {
+        calibration_apply(coefficients.offset[sensor], coefficients.gain[sensor], data, samples);
+    }
+}
+
+/*******************************************************************************
+* Function Name: calibration_describe
+********************************************************************************
+* Summary:
+*  Formats the calibration of a sensor as a line of the config? response: the
+*  status, the offsets in counts and the gains.
+*
+* Parameters:
+*  sensor: the sensor to describe
+*  buffer: receives the line
+*  size: the size of buffer
+*
+* Return:
+*  The length of the line, as returned by snprintf.
+*
+*******************************************************************************/
+int calibration_describe(calibration_sensor_t sensor, char *buffer, size_t size)
+{
+    const int32_t *offset = coefficients.offset[sensor];
+    unsigned long gain[3];
+    char positions[24] = "";
+
+    /* Gains with four decimals */
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        gain[axis] = ((unsigned long) coefficients.gain[sensor][axis] * 10000 + CALIBRATION_ONE / 2) >> CALIBRATION_Q;
+    }
+
+    /* The accelerometer positions captured towards the next calibration */
+    if (sensor == CALIBRATION_ACCEL && accel_position_mask != 0)
+    {
+        uint32_t count = 0;
+        for (uint32_t position = 0; position < CALIBRATION_ACCEL_POSITIONS; position++)
+        {
+            count += (accel_position_mask >> position) & 1;
+        }
+        snprintf(positions, sizeof(positions), "\"positions\": %lu, ", (unsigned long) count);
+    }
+
+    return snprintf(buffer, size, CALIBRATION_FORMAT, CALIBRATION_STATE_NAMES[states[sensor]], positions,
+                    (long) offset[0], (long) offset[1], (long) offset[2],
+                    gain[0] / 10000, gain[0] % 10000, gain[1] / 10000, gain[1] % 10000,
+                    gain[2] / 10000, gain[2] % 10000);
+}
+
+/*******************************************************************************
+* Function Name: calibration_capture
+********************************************************************************
+* Summary:
+*  Accumulates samples of the capture in progress and completes it once the
+*  target number of samples is reached.
+*
+* Parameters:
+*  data: x, y and z counts of each sample
+*  samples: the number of samples
+*
+*******************************************************************************/
+static void calibration_capture(const int16_t *data, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; i++, data += 3)
+    {
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            capture_sum[axis] += data[axis];
+            capture_squares[axis] += (int32_t) data[axis] * data[axis];
+        }
+
+        if (capture_sensor == CALIBRATION_MAG)
+        {
+            double v[6];
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                float value = data[axis] * BMM_SCALE;
+                v[axis] = (double) value * value;
+                v[axis + 3] = value;
+                fit_min[axis] = fminf(fit_min[axis], value);
+                fit_max[axis] = fmaxf(fit_max[axis], value);
+            }
+            /* The upper triangle; the matrix is symmetric */
+            for (uint32_t row = 0; row < 6; row++)
+            {
+                for (uint32_t column = row; column < 6; column++)
+                {
+                    fit_matrix[row][column] += v[row] * v[column];
+                }
+                fit_vector[row] += v[row];
+            }
+        }
+
+        if (++capture_count == capture_target)
+        {
+            calibration_finish();
+            return;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: calibration_finish
+********************************************************************************
+* Summary:
+*  Computes the coefficients from the completed capture and saves them.
+*
+*******************************************************************************/
+static void calibration_finish(void)
+{
+    calibration_sensor_t sensor = capture_sensor;
+    calibration_state_t state;
+
+    capture_target = 0;
+
+    switch (sensor)
+    {
+    case CALIBRATION_ACCEL:
+        state = calibration_finish_accel();
+        break;
+    case CALIBRATION_GYRO:
+        state = calibration_finish_gyro();
+        break;
+    default:
+        state = calibration_finish_mag();
+        break;
+    }
+
+    if (state == CALIBRATION_STATE_CALIBRATED && CY_RSLT_SUCCESS != calibration_save())
+    {
+        /* The coefficients are used but are lost on reset */
+        state = CALIBRATION_STATE_FAILED;
+    }
+    states[sensor] = state;
+}
+
+/*******************************************************************************
+* Function Name: calibration_finish_gyro
+********************************************************************************
+* Summary:
+*  Takes the mean of the capture at rest as the gyroscope bias.
+*
+* Return:
+*  The new state of the gyroscope calibration.
+*
+*******************************************************************************/
+static calibration_state_t calibration_finish_gyro(void)
+{
+    float mean[3];
+
+    if (!calibration_at_rest(CALIBRATION_GYRO_NOISE, mean))
+    {
+        return CALIBRATION_STATE_FAILED;
+    }
+
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        coefficients.offset[CALIBRATION_GYRO][axis] = lroundf(mean[axis]);
+        coefficients.gain[CALIBRATION_GYRO][axis] = CALIBRATION_ONE;
+    }
+    coefficients.valid |= 1u << CALIBRATION_GYRO;
+
+    return CALIBRATION_STATE_CALIBRATED;
+}
+
+/*******************************************************************************
+* Function Name: calibration_finish_accel
+********************************************************************************
+* Summary:
+*  Stores the accelerometer position of the capture at rest. Once all six
+*  positions are captured, the offset of each axis is the mean of its readings
+*  with gravity along and against it, and the gain scales their difference to
+*  2 g.
+*
+* Return:
+*  The new state of the accelerometer calibration.
+*
+*******************************************************************************/
+static calibration_state_t calibration_finish_accel(void)
+{
+    float mean[3];
+    float gain[3];
+    uint32_t axis = 0;
+
+    if (!calibration_at_rest(CALIBRATION_ACCEL_NOISE, mean))
+    {
+        return CALIBRATION_STATE_FAILED;
+    }
+
+    /* The axis with gravity */
+    for (uint32_t i = 1; i < 3; i++)
+    {
+        if (fabsf(mean[i]) > fabsf(mean[axis]))
+        {
+            axis = i;
+        }
+    }
+    if (fabsf(mean[axis]) < CALIBRATION_ACCEL_MIN_AXIS ||
+        fabsf(mean[(axis + 1) % 3]) > CALIBRATION_ACCEL_MAX_CROSS ||
+        fabsf(mean[(axis + 2) % 3]) > CALIBRATION_ACCEL_MAX_CROSS)
+    {
+        return CALIBRATION_STATE_FAILED;
+    }
+
+    accel_positions[2 * axis + (mean[axis] < 0.0f ? 1 : 0)] = lroundf(mean[axis]);
+    accel_position_mask |= 1u << (2 * axis + (mean[axis] < 0.0f ? 1 : 0));
+    if (accel_position_mask != (1u << CALIBRATION_ACCEL_POSITIONS) - 1)
+    {
+        return CALIBRATION_STATE_PARTIAL;
+    }
+    accel_position_mask = 0;
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        gain[axis] = 2.0f * CALIBRATION_ACCEL_ONE_G / (accel_positions[2 * axis] - accel_positions[2 * axis + 1]);
+        if (gain[axis] < CALIBRATION_GAIN_MIN || gain[axis] > CALIBRATION_GAIN_MAX)
+        {
+            return CALIBRATION_STATE_FAILED;
+        }
+    }
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        coefficients.offset[CALIBRATION_ACCEL][axis] = (accel_positions[2 * axis] + accel_positions[2 * axis + 1]) / 2;
+        coefficients.gain[CALIBRATION_ACCEL][axis] = lroundf(gain[axis] * CALIBRATION_ONE);
+    }
+    coefficients.valid |= 1u << CALIBRATION_ACCEL;
+
+    return CALIBRATION_STATE_CALIBRATED;
+}
+
+/*******************************************************************************
+* Function Name: calibration_finish_mag
+********************************************************************************
+* Summary:
+*  Fits an axis aligned ellipsoid to the magnetometer capture. Its center is
+*  the hard iron offset, and the gains scale its radii to their mean, which
+*  corrects the soft iron distortion along the axes. The capture must extend
+*  over at least the radius on every axis.
+*
+* Return:
+*  The new state of the magnetometer calibration.
+*
+*******************************************************************************/
+static calibration_state_t calibration_finish_mag(void)
+{
+    float center[3];
+    float radius[3];
+    float field;
+    double scale = 1.0;
+
+    if (!calibration_solve(fit_matrix, fit_vector))
+    {
+        return CALIBRATION_STATE_FAILED;
+    }
+
+    /* The ellipsoid (x - cx)^2 / rx^2 + ... = 1 */
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        if (!(fit_vector[axis] > 0.0))
+        {
+            return CALIBRATION_STATE_FAILED;
+        }
+        center[axis] = (float) (-fit_vector[axis + 3] / (2.0 * fit_vector[axis]));
+        scale += fit_vector[axis + 3] * fit_vector[axis + 3] / (4.0 * fit_vector[axis]);
+    }
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        radius[axis] = (float) sqrt(scale / fit_vector[axis]);
+        if (!(fit_max[axis] - fit_min[axis] >= radius[axis]))
+        {
+            return CALIBRATION_STATE_FAILED;
+        }
+    }
+    field = (radius[0] + radius[1] + radius[2]) / 3.0f;
+    if (field < CALIBRATION_MAG_MIN_FIELD || field > CALIBRATION_MAG_MAX_FIELD)
+    {
+        return CALIBRATION_STATE_FAILED;
+    }
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        float gain = field / radius[axis];
+        if (gain < CALIBRATION_GAIN_MIN || gain > CALIBRATION_GAIN_MAX ||
+            fabsf(center[axis] / BMM_SCALE) > INT16_MAX)
+        {
+            return CALIBRATION_STATE_FAILED;
+        }
+    }
+
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        coefficients.offset[CALIBRATION_MAG][axis] = lroundf(center[axis] / BMM_SCALE);
+        coefficients.gain[CALIBRATION_MAG][axis] = lroundf(field / radius[axis] * CALIBRATION_ONE);
+    }
+    coefficients.valid |= 1u << CALIBRATION_MAG;
+
+    return CALIBRATION_STATE_CALIBRATED;
+}
+
+/*******************************************************************************
+* Function Name: calibration_at_rest
+********************************************************************************
+* Summary:
+*  Computes the mean of the capture and checks that the sensor was at rest.
+*
+* Parameters:
+*  noise: the largest standard deviation of an axis, in counts
+*  mean: receives the mean counts of each axis
+*
+* Return:
+*  True if no axis varied more than the noise.
+*
+*******************************************************************************/
+static bool calibration_at_rest(float noise, float *mean)
+{
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        double average = (double) capture_sum[axis] / capture_count;
+        double variance = (double) capture_squares[axis] / capture_count - average * average;
+
+        mean[axis] = (float) average;
+        if (variance > (double) noise * noise)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: calibration_solve
+********************************************************************************
+* Summary:
+*  Solves the symmetric 6 x 6 linear system of the ellipsoid fit by Gaussian
+*  elimination with partial pivoting.
+*
+* Parameters:
+*  matrix: the upper triangle of the matrix; overwritten
+*  vector: the right hand side; receives the solution
+*
+* Return:
+*  False if the matrix is singular.
+*
+*******************************************************************************/
+static bool calibration_solve(double matrix[6][6], double *vector)
+{
+    for (uint32_t row = 1; row < 6; row++)
+    {
+        for (uint32_t column = 0; column < row; column++)
+        {
+            matrix[row][column] = matrix[column][row];
+        }
+    }
+
+    for (uint32_t pivot = 0; pivot < 6; pivot++)
+    {
+        uint32_t best = pivot;
+        for (uint32_t row = pivot + 1; row < 6; row++)
+        {
+            if (fabs(matrix[row][pivot]) > fabs(matrix[best][pivot]))
+            {
+                best = row;
+            }
+        }
+        if (matrix[best][pivot] == 0.0)
+        {
+            return false;
+        }
+        if (best != pivot)
+        {
+            double swap;
+            for (uint32_t column = 0; column < 6; column++)
+            {
+                swap = matrix[pivot][column];
+                matrix[pivot][column] = matrix[best][column];
+                matrix[best][column] = swap;
+            }
+            swap = vector[pivot];
+            vector[pivot] = vector[best];
+            vector[best] = swap;
+        }
+
+        for (uint32_t row = pivot + 1; row < 6; row++)
+        {
+            double factor = matrix[row][pivot] / matrix[pivot][pivot];
+            for (uint32_t column = pivot; column < 6; column++)
+            {
+                matrix[row][column] -= factor * matrix[pivot][column];
+            }
+            vector[row] -= factor * vector[pivot];
+        }
+    }
+
+    for (int32_t row = 5; row >= 0; row--)
+    {
+        for (uint32_t column = row + 1; column < 6; column++)
+        {
+            vector[row] -= matrix[row][column] * vector[column];
+        }
+        vector[row] /= matrix[row][row];
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: calibration_clear
+********************************************************************************
+* Summary:
+*  Sets the coefficients of a sensor to no correction.
+*
+* Parameters:
+*  sensor: the sensor to clear
+*
+*******************************************************************************/
+static void calibration_clear(calibration_sensor_t sensor)
+{
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        coefficients.offset[sensor][axis] = 0;
+        coefficients.gain[sensor][axis] = CALIBRATION_ONE;
+    }
+    coefficients.valid &= ~(1u << sensor);
+    states[sensor] = CALIBRATION_STATE_NONE;
+}
+
+/*******************************************************************************
+* Function Name: calibration_apply
+********************************************************************************
+* Summary:
+*  Corrects samples in place in Q14 fixed point, saturating to 16 bits. The
+*  coefficients are held in registers across the samples.
+*
+* Parameters:
+*  offset: the x, y and z offsets in counts
+*  gain: the x, y and z gains in Q14
+*  data: x, y and z counts of each sample
+*  samples: the number of samples
+*
+*******************************************************************************/
+static void calibration_apply(const int32_t *offset, const int32_t *gain, int16_t *data, uint32_t samples)
+{
+    const int32_t offset_x = offset[0], offset_y = offset[1], offset_z = offset[2];
+    const int32_t gain_x = gain[0], gain_y = gain[1], gain_z = gain[2];
+    const int32_t round = 1L << (CALIBRATION_Q - 1);
+
+    for (uint32_t i = 0; i < samples; i++, data += 3)
+    {
+        data[0] = (int16_t) __SSAT(((data[0] - offset_x) * gain_x + round) >> CALIBRATION_Q, 16);
+        data[1] = (int16_t) __SSAT(((data[1] - offset_y) * gain_y + round) >> CALIBRATION_Q, 16);
+        data[2] = (int16_t) __SSAT(((data[2] - offset_z) * gain_z + round) >> CALIBRATION_Q, 16);
+    }
+}
+
+/*******************************************************************************
+* Function Name: calibration_checksum
+********************************************************************************
+* Summary:
+*  Computes the checksum of a record, a rotating sum of its words up to the
+*  checksum.
+*
+* Parameters:
+*  record: the record
+*
+* Return:
+*  The checksum.
+*
+*******************************************************************************/
+static uint32_t calibration_checksum(const calibration_record_t *record)
+{
+    const uint32_t *words = (const uint32_t*) record;
+    uint32_t checksum = 0;
+
+    for (size_t i = 0; i < offsetof(calibration_record_t, checksum) / sizeof(uint32_t); i++)
+    {
+        checksum = ((checksum << 1) | (checksum >> 31)) + words[i];
+    }
+
+    return checksum;
+}
+
+/*******************************************************************************
+* Function Name: calibration_save
+********************************************************************************
+* Summary:
+*  Writes the coefficients to their flash row. The write blocks until the row
+*  is erased and programmed.
+*
+* Return:
+*  The status of the flash write.
+*
+*******************************************************************************/
+static cy_rslt_t calibration_save(void)
+{
+    coefficients.checksum = calibration_checksum(&coefficients);
+    memset(&calibration_row, 0, sizeof(calibration_row));
+    calibration_row.record = coefficients;
+
+    return cyhal_flash_write(&calibration_flash, (uint32_t) (uintptr_t) &calibration_storage, calibration_row.words);
+}
@@ -1,8 +1,9 @@
 /******************************************************************************
 * File Name:   clock.c
 *
-* Description: This file provides a simple millisecond clock.
-*
+* Description: This file provides a simple millisecond clock. Its tick also
+*              schedules the protocol, except in the RTOS build, where the
+*              transmit task checks for commands.
 *
 *******************************************************************************
 * Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
@@ -39,14 +40,32 @@
 
 #include "cyhal.h"
 #include "clock.h"
+#include "config.h"
+#include "events.h"
+#include "timebase.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* The protocol is serviced every 10 ms */
+#define CLOCK_TICK_MS       10
 
 
 /*******************************************************************************
 * Static Variables
 *******************************************************************************/
-static cyhal_timer_t timer_obj;
-static size_t last_t = 0;
-static size_t seconds = 0;
+#ifndef IM_ENABLE_RTOS
+static timebase_timer_t clock_timer;
+#endif
+
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+#ifndef IM_ENABLE_RTOS
+static void clock_tick_handler(void *arg);
+#endif
 
 
 /*******************************************************************************
@@ -55,58 +74,28 @@ static size_t seconds = 0;
 
 void clock_init()
 {
-    cy_rslt_t result;
-    /* Timer object used */
-    const cyhal_timer_cfg_t timer_cfg =
-    {
-        .compare_value = 0,                 /* Timer compare value, not used */
-        .period = 10000,                    /* Timer period set to a large enough value compared to event being measured */
-        .direction = CYHAL_TIMER_DIR_UP,    /* Timer counts up */
-        .is_compare = false,                /* Don't use compare mode */
-        .is_continuous = true,              /* Run timer indefinitely */
-        .value = 0                          /* Initial value of counter */
-    };
-    /* Initialize the timer object. Does not use pin output ('pin' is NC) and
-     * does not use a pre-configured clock source ('clk' is NULL). */
-    result = cyhal_timer_init(&timer_obj, NC, NULL);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
-    }
-
-    /* Apply timer configuration such as period, count direction, run mode, etc. */
-    result = cyhal_timer_configure(&timer_obj, &timer_cfg);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
-    }
-
-    /* Set the frequency of timer to 10000 counts in a second or 10000 Hz */
-    result = cyhal_timer_set_frequency(&timer_obj, 10000);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
-    }
-
-    /* Start the timer with the configured settings */
-    result = cyhal_timer_start(&timer_obj);
-    if (result != CY_RSLT_SUCCESS)
+#ifndef IM_ENABLE_RTOS
+    /* No handler takes EVENT_PROTOCOL in the RTOS build; its posts would only
+     * pile up as merged posts */
+    timebase_timer_init(&clock_timer, clock_tick_handler, NULL, false);
+    if (timebase_start(&clock_timer, TIMEBASE_FREQUENCY * CLOCK_TICK_MS, 1000, TIMEBASE_PHASE_CLOCK) != CY_RSLT_SUCCESS)
     {
         CY_ASSERT(0);
     }
+#endif
 }
 
-void clock_update()
+uint32_t clock_get_ms()
 {
-    size_t t = cyhal_timer_read(&timer_obj);
-    if (t < last_t)
-    {
-        seconds++;
-    }
-    last_t = t;
+    return (uint32_t) (timebase_get_ticks() / (TIMEBASE_FREQUENCY / 1000));
 }
 
-uint32_t clock_get_ms()
+#ifndef IM_ENABLE_RTOS
+/* Lets the protocol check for commands and timeouts */
+static void clock_tick_handler(void *arg)
 {
-    return 1000 * seconds + last_t / 10;
+    (void) arg;
+
+    events_post(EVENT_PROTOCOL);
 }
+#endif
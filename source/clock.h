@@ -43,7 +43,6 @@
 #include <stdint.h>
 
 void clock_init();
-void clock_update();
 uint32_t clock_get_ms();
 
 #endif /* SOURCE_CLOCK_H_ */
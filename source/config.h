@@ -47,6 +47,10 @@
  *****************************************************************************/
 extern cyhal_i2c_t i2c;
 extern cyhal_spi_t spi;
+extern cyhal_spi_t radar_spi;
+
+/* Frequency of the SPI buses of the IMU and radar sensor */
+#define SPI_FREQUENCY      (12000000UL)
 
 /* Set IMU_SAMPLE_RATE to one of the following
  * BMI160_ACCEL_ODR_400HZ / BMI2_ACC_ODR_400HZ
@@ -70,11 +74,63 @@ extern cyhal_spi_t spi;
 #define IMU_SAMPLE_RANGE BMI160_ACCEL_RANGE_8G
 #endif /* CONFIG_H */
 
+/* The orientation fusion channel needs the accelerometer and gyroscope */
+#if defined(IM_ENABLE_IMU) && defined(IM_ENABLE_GYRO)
+#define IM_ENABLE_FUSION 1
+#endif
+
+/* The motion sensors are calibrated on the device */
+#if defined(IM_ENABLE_IMU) || defined(IM_ENABLE_MAG)
+#define IM_ENABLE_CALIBRATION 1
+#endif
+
+/* Task priorities and stack sizes in bytes of the RTOS build (RTOS=FREERTOS in
+ * the Makefile). Each sensor handler runs in its own acquisition task; the
+ * transmit task sends the frames and executes the commands. */
+#ifdef IM_ENABLE_RTOS
+#define RTOS_PRIORITY_AUDIO        CY_RTOS_PRIORITY_REALTIME
+#define RTOS_PRIORITY_RADAR        CY_RTOS_PRIORITY_HIGH
+#define RTOS_PRIORITY_IMU          CY_RTOS_PRIORITY_ABOVENORMAL
+#define RTOS_PRIORITY_DPS          CY_RTOS_PRIORITY_NORMAL
+#define RTOS_PRIORITY_MAG          CY_RTOS_PRIORITY_NORMAL
+#define RTOS_PRIORITY_TRANSMIT     CY_RTOS_PRIORITY_LOW
+#define RTOS_STACK_SIZE            (2048u)
+#define RTOS_TRANSMIT_STACK_SIZE   (4096u)
+#endif
+
+/* Phase offsets of the periodic timers in timebase ticks of 10 us. A timer
+ * fires at its offset into each of its periods, so that sensors with the same
+ * or related periods start their bus transactions apart from each other. */
+#define TIMEBASE_PHASE_IMU         (0u)
+#define TIMEBASE_PHASE_RADAR       (125u)
+#define TIMEBASE_PHASE_MAG         (250u)
+#define TIMEBASE_PHASE_DPS         (500u)
+#define TIMEBASE_PHASE_CLOCK       (750u)
+
+/* Define TIMEBASE_DISCIPLINE_AUDIO to run the timers that set sample instants
+ * (the radar frame trigger and the magnetometer reads) at the rate of the PDM
+ * clock as measured against the timebase, so that long recordings stay
+ * aligned with the audio. The drift of the clocks is reported by drift?. */
+/* #define TIMEBASE_DISCIPLINE_AUDIO */
+
+/* Define IMU_INT_PIN as the pin connected to the INT1 pin of the IMU to read
+ * the IMU FIFO on its watermark interrupt. Without it the FIFO level is polled
+ * by a timer once per frame. */
+/* For example: #define IMU_INT_PIN P9_2 */
+
+/* Define BMM_INT_PIN as the pin connected to the INT pin of the BMM350 to read
+ * the magnetometer on its data ready interrupt, and DPS_INT_PIN as the pin
+ * connected to the SDO pin of the DPS368 to drain the pressure sensor FIFO on
+ * its result interrupt. Without them the sensors are read by timers. */
+
 /* PDM sample rates */
 #define SAMPLE_RATE_8_KHZ    8000u
 #define SAMPLE_RATE_16_KHZ   16000u
+#define SAMPLE_RATE_48_KHZ   48000u
 
-/* Change below to SAMPLE_RATE_8_KHZ or SAMPLE_RATE_16_KHZ */
-#define PDM_SAMPLE_RATE SAMPLE_RATE_16_KHZ
+/* Change below to SAMPLE_RATE_8_KHZ, SAMPLE_RATE_16_KHZ or SAMPLE_RATE_48_KHZ.
+ * Lower rates that divide PDM_SAMPLE_RATE by 2, 3 or 6 are derived in
+ * software, so 48 kHz capture serves 48, 24, 16 and 8 kHz subscriptions. */
+#define PDM_SAMPLE_RATE SAMPLE_RATE_48_KHZ
 
 #endif
@@ -0,0 +1,90 @@
+/******************************************************************************
+* File Name:   cycles.h
+*
+* Description: This file contains helpers to measure execution time with the
+*              Cortex-M4 DWT cycle counter, or with a stub clock when the
+*              measuring modules are built on the host (IM_HOST_BUILD).
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_CYCLES_H_
+#define SOURCE_CYCLES_H_
+
+#ifdef IM_HOST_BUILD
+#include <stdint.h>
+#include <time.h>
+
+/* One cycle of the stub clock is a nanosecond of the monotonic clock */
+static inline void cycles_init(void)
+{
+}
+
+static inline uint32_t cycles_get(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec);
+}
+#else
+#include "cyhal.h"
+
+/*******************************************************************************
+* Function Name: cycles_init
+********************************************************************************
+* Summary:
+*  Enables the DWT cycle counter. Safe to call more than once.
+*
+*******************************************************************************/
+static inline void cycles_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************************
+* Function Name: cycles_get
+********************************************************************************
+* Summary:
+*  Returns the free running CPU cycle count. Differences of two readings are
+*  correct across a wrap of the counter.
+*
+*******************************************************************************/
+static inline uint32_t cycles_get(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+#endif /* SOURCE_CYCLES_H_ */
@@ -0,0 +1,272 @@
+/******************************************************************************
+* File Name:   decimator.c
+*
+* Description: This file implements a polyphase FIR decimator used to derive
+*              lower audio sample rates from the PDM/PCM capture rate.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#ifndef IM_HOST_BUILD
+/* CMSIS intrinsics of the target; the host build uses the C dot product */
+#include "cyhal.h"
+#endif
+#include "decimator.h"
+
+
+/*******************************************************************************
+* Local Constants
+*******************************************************************************/
+/* Kaiser windowed sinc low-pass filters (beta 8) with the cut-off at 0.45 of
+ * the output sample rate. Pass band ripple is below 0.25 dB up to 0.38 of the
+ * output rate and the stop band is attenuated by more than 70 dB. */
+static const int16_t decimator_coefficients_2[48] =
+{
+         1,      1,     -6,     -8,     14,     29,    -20,    -73,
+         8,    148,     47,   -247,   -183,    344,    442,   -387,
+      -869,    280,   1536,    158,  -2666,  -1530,   5839,  13525,
+     13525,   5839,  -1530,  -2666,    158,   1536,    280,   -869,
+      -387,    442,    344,   -183,   -247,     47,    148,      8,
+       -73,    -20,     29,     14,     -8,     -6,      1,      1
+};
+
+static const int16_t decimator_coefficients_3[72] =
+{
+         1,      1,      0,     -3,     -7,     -4,      6,     19,
+        18,     -5,    -39,    -49,    -11,     61,    105,     59,
+       -72,   -187,   -160,     42,    284,    334,     69,   -366,
+      -599,   -323,    380,    975,    831,   -221,  -1544,  -1944,
+      -450,   2896,   6822,   9464,   9464,   6822,   2896,   -450,
+     -1944,  -1544,   -221,    831,    975,    380,   -323,   -599,
+      -366,     69,    334,    284,     42,   -160,   -187,    -72,
+        59,    105,     61,    -11,    -49,    -39,     -5,     18,
+        19,      6,     -4,     -7,     -3,      0,      1,      1
+};
+
+static const int16_t decimator_coefficients_6[144] =
+{
+         0,      1,      1,      1,      1,      0,     -1,     -2,
+        -3,     -4,     -3,     -1,      2,      5,      9,     11,
+        11,      7,      1,     -7,    -16,    -23,    -26,    -23,
+       -13,      3,     22,     40,     52,     53,     41,     16,
+       -18,    -55,    -85,   -100,    -94,    -63,    -10,     54,
+       117,    163,    177,    150,     82,    -18,   -131,   -231,
+      -292,   -293,   -223,    -87,     94,    284,    439,    515,
+       480,    322,     53,   -285,   -626,   -891,   -999,   -885,
+      -511,    122,    969,   1947,   2944,   3837,   4509,   4869,
+      4869,   4509,   3837,   2944,   1947,    969,    122,   -511,
+      -885,   -999,   -891,   -626,   -285,     53,    322,    480,
+       515,    439,    284,     94,    -87,   -223,   -293,   -292,
+      -231,   -131,    -18,     82,    150,    177,    163,    117,
+        54,    -10,    -63,    -94,   -100,    -85,    -55,    -18,
+        16,     41,     53,     52,     40,     22,      3,    -13,
+       -23,    -26,    -23,    -16,     -7,      1,      7,     11,
+        11,      9,      5,      2,     -1,     -3,     -4,     -3,
+        -2,     -1,      0,      1,      1,      1,      1,      0
+};
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static inline int32_t decimator_dot(const int16_t *x, const int16_t *h, uint32_t num_taps);
+
+
+/*******************************************************************************
+* Function Definitions
+*******************************************************************************/
+
+/*******************************************************************************
+* Function Name: decimator_init
+********************************************************************************
+* Summary:
+*  Initializes a decimator for the given factor and clears its history.
+*
+* Parameters:
+*  decimator: the decimator to initialize
+*  factor: the decimation factor; 1, 2, 3 or 6
+*
+* Return:
+*  True if the factor is supported.
+*
+*******************************************************************************/
+bool decimator_init(decimator_t *decimator, uint32_t factor)
+{
+    switch (factor)
+    {
+    case 1:
+        decimator->coefficients = NULL;
+        decimator->num_taps = 0;
+        break;
+    case 2:
+        decimator->coefficients = decimator_coefficients_2;
+        decimator->num_taps = sizeof(decimator_coefficients_2) / sizeof(int16_t);
+        break;
+    case 3:
+        decimator->coefficients = decimator_coefficients_3;
+        decimator->num_taps = sizeof(decimator_coefficients_3) / sizeof(int16_t);
+        break;
+    case 6:
+        decimator->coefficients = decimator_coefficients_6;
+        decimator->num_taps = sizeof(decimator_coefficients_6) / sizeof(int16_t);
+        break;
+    default:
+        return false;
+    }
+
+    decimator->factor = factor;
+    decimator_reset(decimator);
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: decimator_reset
+********************************************************************************
+* Summary:
+*  Clears the filter history, e.g. after a gap in the input signal.
+*
+* Parameters:
+*  decimator: the decimator to reset
+*
+*******************************************************************************/
+void decimator_reset(decimator_t *decimator)
+{
+    memset(decimator->state, 0, sizeof(decimator->state));
+}
+
+/*******************************************************************************
+* Function Name: decimator_process
+********************************************************************************
+* Summary:
+*  Low-pass filters and decimates a block of samples. Only every factor'th
+*  output of the filter is computed, so the cost per output sample is one
+*  num_taps long dot product. The filter history is kept between calls.
+*
+* Parameters:
+*  decimator: the decimator
+*  input: the input samples
+*  output: receives count / factor output samples; may be the same as input
+*  count: the number of input samples, a multiple of the factor
+*
+* Return:
+*  The number of output samples.
+*
+*******************************************************************************/
+size_t decimator_process(decimator_t *decimator, const int16_t *input, int16_t *output, size_t count)
+{
+    const uint32_t factor = decimator->factor;
+    const uint32_t history = decimator->num_taps - 1;
+    size_t produced = 0;
+
+    if (1 == factor)
+    {
+        memmove(output, input, count * sizeof(int16_t));
+        return count;
+    }
+
+    while (0 < count)
+    {
+        size_t block = (count < DECIMATOR_BLOCK_SIZE) ? count : DECIMATOR_BLOCK_SIZE;
+
+        /* Append the new samples after the history of the previous block */
+        memcpy(&decimator->state[history], input, block * sizeof(int16_t));
+
+        /* Output j is aligned with the last input sample of its group. Since
+         * the filter is symmetric, the reversed coefficients needed for the
+         * convolution are the coefficients themselves. */
+        for (size_t index = factor - 1; index < block; index += factor)
+        {
+            int32_t acc = decimator_dot(&decimator->state[index], decimator->coefficients, decimator->num_taps);
+            acc = (acc + (1 << 14)) >> 15;
+            output[produced++] = (int16_t) ((acc > INT16_MAX) ? INT16_MAX : (acc < INT16_MIN) ? INT16_MIN : acc);
+        }
+
+        /* Keep the last samples as history for the next block */
+        memmove(decimator->state, &decimator->state[block], history * sizeof(int16_t));
+
+        input += block;
+        count -= block;
+    }
+
+    return produced;
+}
+
+/*******************************************************************************
+* Function Name: decimator_dot
+********************************************************************************
+* Summary:
+*  Computes the dot product of samples and filter coefficients. Uses the dual
+*  16-bit multiply-accumulate instruction when the core has the DSP extension
+*  and portable C otherwise.
+*
+* Parameters:
+*  x: the samples
+*  h: the coefficients
+*  num_taps: the number of coefficients, a multiple of 4
+*
+* Return:
+*  The Q30 sum of products.
+*
+*******************************************************************************/
+static inline int32_t decimator_dot(const int16_t *x, const int16_t *h, uint32_t num_taps)
+{
+    int32_t acc = 0;
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    uint32_t x01, x23, h01, h23;
+    for (uint32_t tap = 0; tap < num_taps; tap += 4)
+    {
+        /* Sample pairs are not necessarily word aligned; memcpy compiles to
+         * unaligned word loads, which the Cortex-M4 supports. */
+        memcpy(&x01, &x[tap], sizeof(x01));
+        memcpy(&x23, &x[tap + 2], sizeof(x23));
+        memcpy(&h01, &h[tap], sizeof(h01));
+        memcpy(&h23, &h[tap + 2], sizeof(h23));
+        acc = (int32_t) __SMLAD(x01, h01, (uint32_t) acc);
+        acc = (int32_t) __SMLAD(x23, h23, (uint32_t) acc);
+    }
+#else
+    for (uint32_t tap = 0; tap < num_taps; tap++)
+    {
+        acc += (int32_t) x[tap] * h[tap];
+    }
+#endif
+
+    return acc;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,77 @@
+/******************************************************************************
+* File Name:   decimator.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in decimator.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_DECIMATOR_H_
+#define SOURCE_DECIMATOR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Supported decimation factors are 1 (pass-through), 2, 3 and 6 */
+#define DECIMATOR_MAX_FACTOR        (6)
+
+/* The filter for factor M has 24 * M taps */
+#define DECIMATOR_MAX_TAPS          (24 * DECIMATOR_MAX_FACTOR)
+
+/* Number of input samples filtered per block; a multiple of every factor */
+#define DECIMATOR_BLOCK_SIZE        (384)
+
+/******************************************************************************
+ * Types
+ *****************************************************************************/
+typedef struct
+{
+    const int16_t *coefficients;   /* Symmetric low-pass FIR, Q15 */
+    uint32_t num_taps;             /* Even number of taps */
+    uint32_t factor;               /* Decimation factor */
+    int16_t state[DECIMATOR_MAX_TAPS - 1 + DECIMATOR_BLOCK_SIZE];
+} decimator_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+bool decimator_init(decimator_t *decimator, uint32_t factor);
+void decimator_reset(decimator_t *decimator);
+size_t decimator_process(decimator_t *decimator, const int16_t *input, int16_t *output, size_t count);
+
+#endif /* SOURCE_DECIMATOR_H_ */
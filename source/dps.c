@@ -1,8 +1,9 @@
 /******************************************************************************
 * File Name:   dps.c
 *
-* Description: This file implements the interface with the Pressure sensor, as
-*              a timer to feed the pre-processor at 50Hz.
+* Description: This file implements the interface with the Pressure sensor. The
+*              sensor measures continuously in background mode into its result
+*              FIFO, which is drained by queued bus transactions.
 *
 * Related Document: See README.md
 *
@@ -42,15 +43,16 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "config.h"
+#include "bus.h"
+#include "events.h"
+#include "ring.h"
+#include "timebase.h"
 #include "xensiv_dps3xx_mtb.h"
 #include "dps.h"
 
 /*******************************************************************************
 * Macros
 *******************************************************************************/
-#define DPS_SCAN_RATE         50
-#define DPS_TIMER_FREQUENCY   100000
-#define DPS_TIMER_PERIOD      (DPS_TIMER_FREQUENCY/DPS_SCAN_RATE)
 #define DPS_TIMER_PRIORITY    6
 #ifdef IM_XSS_DPS368
 #define DPS368_ADDRESS (XENSIV_DPS3XX_I2C_ADDR_ALT)
@@ -58,26 +60,119 @@
 #define DPS368_ADDRESS (XENSIV_DPS3XX_I2C_ADDR_DEFAULT)
 #endif
 
+/* Registers */
+#define DPS_REG_PSR_B2        0x00
+#define DPS_REG_PRS_CFG       0x06
+#define DPS_REG_TMP_CFG       0x07
+#define DPS_REG_MEAS_CFG      0x08
+#define DPS_REG_CFG           0x09
+#define DPS_REG_INT_STS       0x0A
+#define DPS_REG_RESET         0x0C
+#define DPS_REG_COEF          0x10
+#define DPS_REG_COEF_SRCE     0x28
+#define DPS_MEAS_STANDBY      0x00
+#define DPS_MEAS_CONTINUOUS   0x07      /* Pressure and temperature */
+#define DPS_FIFO_FLUSH        0x80
+#define DPS_TMP_EXT           0x80
+#define DPS_CFG_INT_HL        0x80      /* Interrupt active high */
+#define DPS_CFG_INT_PRS       0x10      /* Interrupt on a pressure result */
+#define DPS_CFG_P_SHIFT       0x04      /* Required above 8 times oversampling */
+#define DPS_CFG_FIFO_EN       0x02
+#define DPS_COEF_SIZE         18
+
+/* Results read from the FIFO are 24 bit; the least significant bit is set for
+ * pressure, and an empty FIFO reads as DPS_FIFO_EMPTY */
+#define DPS_FIFO_EMPTY        0x800000
+#define DPS_FIFO_DEPTH        32
+
+/* Samples buffered between the bus interrupt and main; a power of two */
+#define DPS_SAMPLE_COUNT      32
+
+/* The FIFO is drained often enough to hold at most this many samples */
+#define DPS_DRAIN_SAMPLES     8
+
+/* Temperature is measured once per sample without oversampling; it is only
+ * used to compensate the pressure */
+#define DPS_TMP_PRC           0
+
 /*******************************************************************************
 * Global Variables
 *******************************************************************************/
 xensiv_dps3xx_t pressure_sensor;
-/* timer used for getting data */
-cyhal_timer_t dps_timer;
+
+/* Raw pressure and temperature results of one sample */
+typedef struct
+{
+    int32_t pressure;
+    int32_t temperature;
+} dps_sample_t;
+
+/* Calibration coefficients, read from the sensor */
+typedef struct
+{
+    int32_t c0, c1, c00, c10, c01, c11, c20, c21, c30;
+} dps_coefficients_t;
+
+/* Scale factors of the raw results for oversampling 1 to 128 */
+static const float dps_scale_factors[] =
+    { 524288.0f, 1572864.0f, 3670016.0f, 7864320.0f, 253952.0f, 516096.0f, 1040384.0f, 2088960.0f };
+
+/* Measurement times for oversampling 1 to 128, in units of 0.1 ms */
+static const uint16_t dps_measurement_times[] = { 36, 52, 84, 148, 276, 532, 1044, 2068 };
+
+static bus_device_t dps_device;
+static bus_transaction_t dps_entry_transaction;
+static const uint8_t dps_entry_command = DPS_REG_PSR_B2;
+static uint8_t dps_entry_buffer[3];
+static volatile bool dps_pending = false;
+static volatile bool dps_stopped = true;
+static uint32_t dps_entries;
+
+/* Samples are written by the bus interrupt and read by main in order; samples
+ * that do not fit are dropped and counted by the ring */
+static dps_sample_t dps_samples[DPS_SAMPLE_COUNT];
+static ring_t dps_ring;
+static int32_t dps_temperature;
+static bool dps_temperature_valid;
+
+static dps_coefficients_t dps_coefficients;
+static uint8_t dps_tmp_ext;
+static float dps_pressure_scale;
+
+#ifdef DPS_INT_PIN
+static bus_transaction_t dps_status_transaction;
+static const uint8_t dps_status_command = DPS_REG_INT_STS;
+static uint8_t dps_status_buffer;
+static cyhal_gpio_callback_data_t dps_pin_callback;
+#else
+/* timer used for draining the FIFO */
+static timebase_timer_t dps_timer;
+#endif
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-void dps_timer_intr_handler(void* callback_arg, cyhal_timer_event_t event);
+void dps_timer_intr_handler(void *arg);
+void dps_pin_handler(void* callback_arg, cyhal_gpio_event_t event);
+void dps_status_handler(bus_transaction_t *transaction, cy_rslt_t result);
+void dps_entry_handler(bus_transaction_t *transaction, cy_rslt_t result);
+void dps_start_read(void);
 cy_rslt_t dps_timer_init(void);
+cy_rslt_t dps_pin_init(void);
+cy_rslt_t dps_read_coefficients(void);
+cy_rslt_t dps_write_register(uint8_t reg, uint8_t value);
+static int32_t dps_sign_extend(uint32_t value, uint32_t bits);
 
 
 /*******************************************************************************
 * Function Name: dps_init
 ********************************************************************************
 * Summary:
-*    A function used to initialize the DPS368 Pressure sensor. Starts a timer 
-*    that triggers an interrupt at 50Hz.
+*    A function used to initialize the DPS368 Pressure sensor. Reads the
+*    calibration coefficients and starts continuous measurements at 16Hz with
+*    16 times pressure oversampling. With DPS_INT_PIN the interrupt of the
+*    sensor starts draining the FIFO on each pressure result; otherwise a
+*    timer drains it periodically.
 *
 * Parameters:
 *   None
@@ -90,102 +185,286 @@ cy_rslt_t dps_timer_init(void);
 cy_rslt_t dps_init(void)
 {
     cy_rslt_t result;
-    xensiv_dps3xx_config_t config;
-    /* Initialize pressure sensor */
-    result = xensiv_dps3xx_mtb_init_i2c(&pressure_sensor, &i2c, DPS368_ADDRESS);
+    /* Initialize pressure sensor. The IMU may already be polling the I2C
+     * bus. */
+    result = bus_acquire(&bus_i2c);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = xensiv_dps3xx_mtb_init_i2c(&pressure_sensor, &i2c, DPS368_ADDRESS);
+        bus_release(&bus_i2c);
+    }
     if (result != CY_RSLT_SUCCESS)
     {
         CY_ASSERT(0);
     }
-    result = xensiv_dps3xx_get_config(&pressure_sensor, &config);
-    config.pressure_oversample = XENSIV_DPS3XX_OVERSAMPLE_16;
-    config.pressure_rate = XENSIV_DPS3XX_RATE_16;
-    result = xensiv_dps3xx_set_config(&pressure_sensor, &config);
-    result = xensiv_dps3xx_get_config(&pressure_sensor, &config);
-    config.temperature_oversample = XENSIV_DPS3XX_OVERSAMPLE_16;
-    config.temperature_rate = XENSIV_DPS3XX_RATE_16;
-    result = xensiv_dps3xx_set_config(&pressure_sensor, &config);
-
-    dps_flag = false;
-    /* Timer for data collection */
+
+    bus_device_init_i2c(&dps_device, &bus_i2c, DPS368_ADDRESS);
+    dps_entry_transaction.device = &dps_device;
+    dps_entry_transaction.tx = &dps_entry_command;
+    dps_entry_transaction.tx_size = 1;
+    dps_entry_transaction.rx = dps_entry_buffer;
+    dps_entry_transaction.rx_size = sizeof(dps_entry_buffer);
+    dps_entry_transaction.callback = dps_entry_handler;
+
+    result = ring_init(&dps_ring, dps_samples, sizeof(dps_samples[0]), DPS_SAMPLE_COUNT);
+    if(CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    result = dps_read_coefficients();
+    if(CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+#ifdef DPS_INT_PIN
+    /* Result interrupt for draining the FIFO */
+    result = dps_pin_init();
+#else
+    /* Timer for draining the FIFO */
     result = dps_timer_init();
+#endif
     if(CY_RSLT_SUCCESS != result)
     {
         return result;
     }
-    return CY_RSLT_SUCCESS;
+    return dps_configure(16, 16);
 }
 
 
 /*******************************************************************************
-* Function Name: dps_timer_init
+* Function Name: dps_configure
 ********************************************************************************
 * Summary:
-*   Sets up an interrupt that triggers at the desired frequency.
+*   Selects the measurement rate and the pressure oversampling, flushes the
+*   FIFO and restarts continuous measurements. The pressure and the
+*   temperature are both measured at the rate, so a rate and oversampling are
+*   only accepted if both measurements fit in the measurement period.
 *
-* Returns:
-*   The status of the initialization.
+* Parameters:
+*   rate: samples per second; 1, 2, 4, 8, 16, 32, 64 or 128
+*   oversampling: pressure oversampling, a power of two from 1 to 128; 0 for
+*                 the highest oversampling up to 16 that fits the rate
+*
+* Return:
+*   The status of the configuration; an error if the rate or oversampling is
+*   not supported, or BUS_RSLT_ERR_TIMEOUT if an ongoing read did not finish.
+*   The sensor stays stopped after a failure.
 *
 *
 *******************************************************************************/
-cy_rslt_t dps_timer_init(void)
+cy_rslt_t dps_configure(uint32_t rate, uint32_t oversampling)
 {
-    cy_rslt_t rslt;
-    const cyhal_timer_cfg_t timer_cfg =
-    {
-        .compare_value = 0,                 /* Timer compare value, not used */
-        .period = DPS_TIMER_PERIOD,         /* Defines the timer period */
-        .direction = CYHAL_TIMER_DIR_UP,    /* Timer counts up */
-        .is_compare = false,                /* Don't use compare mode */
-        .is_continuous = true,              /* Run the timer indefinitely */
-        .value = 0                          /* Initial value of counter */
-    };
-
-    /* Initialize the timer object. Does not use pin output ('pin' is NC) and
-    * does not use a pre-configured clock source ('clk' is NULL). */
-    rslt = cyhal_timer_init(&dps_timer, NC, NULL);
-    if (CY_RSLT_SUCCESS != rslt)
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t rate_code = 0;
+    uint32_t prc = 0;
+
+    while (rate_code < 7 && (1u << rate_code) < rate)
     {
-        return rslt;
+        rate_code++;
+    }
+    if ((1u << rate_code) != rate)
+    {
+        return -1;
     }
 
-    /* Apply timer configuration such as period, count direction, run mode, etc. */
-    rslt = cyhal_timer_configure(&dps_timer, &timer_cfg);
-    if (CY_RSLT_SUCCESS != rslt)
+    if (0 == oversampling)
     {
-        return rslt;
+        prc = 4;
+        while (prc > 0 && rate * (dps_measurement_times[prc] + dps_measurement_times[DPS_TMP_PRC]) >= 10000)
+        {
+            prc--;
+        }
+    }
+    else
+    {
+        while (prc < 7 && (1u << prc) < oversampling)
+        {
+            prc++;
+        }
+        if ((1u << prc) != oversampling)
+        {
+            return -1;
+        }
+    }
+    if (rate * (dps_measurement_times[prc] + dps_measurement_times[DPS_TMP_PRC]) >= 10000)
+    {
+        return -1;
     }
 
-    /* Set the frequency of timer to 100KHz */
-    rslt = cyhal_timer_set_frequency(&dps_timer, DPS_TIMER_FREQUENCY);
-    if (CY_RSLT_SUCCESS != rslt)
+    /* Stop draining the FIFO and let an ongoing read finish */
+    dps_stopped = true;
+#ifndef DPS_INT_PIN
+    timebase_stop(&dps_timer);
+#endif
+    for (uint32_t waited = 0; dps_pending && waited < BUS_TIMEOUT_US; waited += BUS_POLL_US)
     {
-        return rslt;
+        cyhal_system_delay_us(BUS_POLL_US);
+    }
+    if (dps_pending)
+    {
+        return BUS_RSLT_ERR_TIMEOUT;
+    }
+
+    if (dps_write_register(DPS_REG_MEAS_CFG, DPS_MEAS_STANDBY) != CY_RSLT_SUCCESS ||
+        dps_write_register(DPS_REG_PRS_CFG, (uint8_t) ((rate_code << 4) | prc)) != CY_RSLT_SUCCESS ||
+        dps_write_register(DPS_REG_TMP_CFG, (uint8_t) (dps_tmp_ext | (rate_code << 4) | DPS_TMP_PRC)) != CY_RSLT_SUCCESS ||
+#ifdef DPS_INT_PIN
+        dps_write_register(DPS_REG_CFG, DPS_CFG_INT_HL | DPS_CFG_INT_PRS | DPS_CFG_FIFO_EN | (prc > 3 ? DPS_CFG_P_SHIFT : 0)) != CY_RSLT_SUCCESS ||
+#else
+        dps_write_register(DPS_REG_CFG, DPS_CFG_FIFO_EN | (prc > 3 ? DPS_CFG_P_SHIFT : 0)) != CY_RSLT_SUCCESS ||
+#endif
+        dps_write_register(DPS_REG_RESET, DPS_FIFO_FLUSH) != CY_RSLT_SUCCESS ||
+        dps_write_register(DPS_REG_MEAS_CFG, DPS_MEAS_CONTINUOUS) != CY_RSLT_SUCCESS)
+    {
+        return -1;
+    }
+
+#ifdef DPS_INT_PIN
+    /* Clear a pending interrupt, so that the next result raises the pin */
+    if (bus_transfer(&dps_device, &dps_status_command, 1, &dps_status_buffer, 1) != CY_RSLT_SUCCESS)
+    {
+        return -1;
     }
+#endif
+
+    dps_pressure_scale = dps_scale_factors[prc];
+    dps_temperature_valid = false;
+    ring_flush(&dps_ring);
+    dps_stopped = false;
+
+#ifndef DPS_INT_PIN
+    /* Drain the FIFO when it holds about DPS_DRAIN_SAMPLES samples, and at
+     * least once per second */
+    result = timebase_start(&dps_timer, TIMEBASE_FREQUENCY * (rate > DPS_DRAIN_SAMPLES ? DPS_DRAIN_SAMPLES : 1), rate,
+                            TIMEBASE_PHASE_DPS);
+#endif
+
+    return result;
+}
+
+
+/*******************************************************************************
+* Function Name: dps_read_coefficients
+********************************************************************************
+* Summary:
+*   Reads the calibration coefficients and the temperature sensor they were
+*   measured with.
+*
+* Return:
+*   The status of the read.
+*
+*
+*******************************************************************************/
+cy_rslt_t dps_read_coefficients(void)
+{
+    const uint8_t coef_command = DPS_REG_COEF;
+    const uint8_t source_command = DPS_REG_COEF_SRCE;
+    uint8_t c[DPS_COEF_SIZE];
+    uint8_t source;
+
+    if (bus_transfer(&dps_device, &coef_command, 1, c, sizeof(c)) != CY_RSLT_SUCCESS ||
+        bus_transfer(&dps_device, &source_command, 1, &source, 1) != CY_RSLT_SUCCESS)
+    {
+        return -1;
+    }
+
+    dps_tmp_ext = source & DPS_TMP_EXT;
+    dps_coefficients.c0 = dps_sign_extend(((uint32_t) c[0] << 4) | (c[1] >> 4), 12);
+    dps_coefficients.c1 = dps_sign_extend(((uint32_t) (c[1] & 0x0F) << 8) | c[2], 12);
+    dps_coefficients.c00 = dps_sign_extend(((uint32_t) c[3] << 12) | ((uint32_t) c[4] << 4) | (c[5] >> 4), 20);
+    dps_coefficients.c10 = dps_sign_extend(((uint32_t) (c[5] & 0x0F) << 16) | ((uint32_t) c[6] << 8) | c[7], 20);
+    dps_coefficients.c01 = dps_sign_extend(((uint32_t) c[8] << 8) | c[9], 16);
+    dps_coefficients.c11 = dps_sign_extend(((uint32_t) c[10] << 8) | c[11], 16);
+    dps_coefficients.c20 = dps_sign_extend(((uint32_t) c[12] << 8) | c[13], 16);
+    dps_coefficients.c21 = dps_sign_extend(((uint32_t) c[14] << 8) | c[15], 16);
+    dps_coefficients.c30 = dps_sign_extend(((uint32_t) c[16] << 8) | c[17], 16);
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name: dps_sign_extend
+********************************************************************************
+* Summary:
+*   Converts a two's complement value of the given number of bits.
+*
+*
+*******************************************************************************/
+static int32_t dps_sign_extend(uint32_t value, uint32_t bits)
+{
+    return (value & (1u << (bits - 1))) ? (int32_t) value - (int32_t) (1u << bits) : (int32_t) value;
+}
+
+
+/*******************************************************************************
+* Function Name: dps_write_register
+********************************************************************************
+* Summary:
+*   Writes a register of the sensor and waits until the write has completed.
+*
+* Parameters:
+*   reg: the register address
+*   value: the value to write
+*
+* Return:
+*   The status of the write.
+*
+*
+*******************************************************************************/
+cy_rslt_t dps_write_register(uint8_t reg, uint8_t value)
+{
+    const uint8_t command[2] = { reg, value };
+
+    return bus_transfer(&dps_device, command, sizeof(command), NULL, 0);
+}
+
+
+#ifdef DPS_INT_PIN
+/*******************************************************************************
+* Function Name: dps_pin_init
+********************************************************************************
+* Summary:
+*   Sets up the pressure result interrupt of the DPS368 on its SDO pin, which
+*   is connected to DPS_INT_PIN. The interrupt is enabled by dps_configure.
+*
+* Returns:
+*   The status of the initialization.
+*
+*
+*******************************************************************************/
+cy_rslt_t dps_pin_init(void)
+{
+    cy_rslt_t rslt;
 
-    /* Assign the ISR to execute on timer interrupt */
-    cyhal_timer_register_callback(&dps_timer, dps_timer_intr_handler, NULL);
+    dps_status_transaction.device = &dps_device;
+    dps_status_transaction.tx = &dps_status_command;
+    dps_status_transaction.tx_size = 1;
+    dps_status_transaction.rx = &dps_status_buffer;
+    dps_status_transaction.rx_size = 1;
+    dps_status_transaction.callback = dps_status_handler;
 
-    /* Set the event on which timer interrupt occurs and enable it */
-    cyhal_timer_enable_event(&dps_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, DPS_TIMER_PRIORITY, true);
-    
-    /* Start the timer with the configured settings */
-    rslt = cyhal_timer_start(&dps_timer);
+    rslt = cyhal_gpio_init(DPS_INT_PIN, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_NONE, false);
     if (CY_RSLT_SUCCESS != rslt)
     {
         return rslt;
     }
+    dps_pin_callback.callback = dps_pin_handler;
+    cyhal_gpio_register_callback(DPS_INT_PIN, &dps_pin_callback);
+    cyhal_gpio_enable_event(DPS_INT_PIN, CYHAL_GPIO_IRQ_RISE, DPS_TIMER_PRIORITY, true);
 
     return CY_RSLT_SUCCESS;
 }
 
 
 /*******************************************************************************
-* Function Name: dps_timer_intr_handler
+* Function Name: dps_pin_handler
 ********************************************************************************
 * Summary:
-*   Interrupt handler for timer. Interrupt handler will get called at 50Hz and
-*   sets a flag that can be checked in main.
+*   Interrupt handler for the pressure result interrupt. Called once per
+*   pressure result and starts draining the FIFO.
 *
 * Parameters:
 *     callback_arg: not used
@@ -193,12 +472,151 @@ cy_rslt_t dps_timer_init(void)
 *
 *
 *******************************************************************************/
-void dps_timer_intr_handler(void *callback_arg, cyhal_timer_event_t event)
+void dps_pin_handler(void *callback_arg, cyhal_gpio_event_t event)
 {
     (void) callback_arg;
     (void) event;
 
-    dps_flag = true;
+    dps_start_read();
+}
+
+
+/*******************************************************************************
+* Function Name: dps_status_handler
+********************************************************************************
+* Summary:
+*   Called from the bus interrupt when the interrupt status has been read,
+*   which clears the interrupt. Starts reading the FIFO.
+*
+* Parameters:
+*     transaction: not used
+*     result: the status of the read
+*
+*
+*******************************************************************************/
+void dps_status_handler(bus_transaction_t *transaction, cy_rslt_t result)
+{
+    (void) transaction;
+
+    if (CY_RSLT_SUCCESS != result || dps_stopped || CY_RSLT_SUCCESS != bus_submit(&dps_entry_transaction))
+    {
+        dps_pending = false;
+    }
+}
+#else
+/*******************************************************************************
+* Function Name: dps_timer_init
+********************************************************************************
+* Summary:
+*   Sets up the timer that drains the FIFO. It is started by dps_configure.
+*
+* Returns:
+*   The status of the initialization.
+*
+*
+*******************************************************************************/
+cy_rslt_t dps_timer_init(void)
+{
+    timebase_timer_init(&dps_timer, dps_timer_intr_handler, NULL, false);
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name: dps_timer_intr_handler
+********************************************************************************
+* Summary:
+*   Timebase callback. Starts draining the FIFO.
+*
+* Parameters:
+*     arg: not used
+*
+*
+*******************************************************************************/
+void dps_timer_intr_handler(void *arg)
+{
+    (void) arg;
+
+    dps_start_read();
+}
+#endif
+
+
+/*******************************************************************************
+* Function Name: dps_start_read
+********************************************************************************
+* Summary:
+*   Starts draining the FIFO unless a read is pending. With the interrupt pin
+*   the interrupt status is read first to clear it. Called from the
+*   interrupts.
+*
+*
+*******************************************************************************/
+void dps_start_read(void)
+{
+    if (dps_stopped || dps_pending)
+    {
+        return;
+    }
+
+    dps_pending = true;
+    dps_entries = 0;
+#ifdef DPS_INT_PIN
+    if (CY_RSLT_SUCCESS != bus_submit(&dps_status_transaction))
+#else
+    if (CY_RSLT_SUCCESS != bus_submit(&dps_entry_transaction))
+#endif
+    {
+        dps_pending = false;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: dps_entry_handler
+********************************************************************************
+* Summary:
+*   Called from the bus interrupt when a result has been read from the FIFO.
+*   A temperature result is kept for the next pressure result, which
+*   completes a sample. Reads the next result until the FIFO is empty.
+*
+* Parameters:
+*     transaction: not used
+*     result: the status of the read
+*
+*
+*******************************************************************************/
+void dps_entry_handler(bus_transaction_t *transaction, cy_rslt_t result)
+{
+    uint32_t value = ((uint32_t) dps_entry_buffer[0] << 16) | ((uint32_t) dps_entry_buffer[1] << 8) | dps_entry_buffer[2];
+    (void) transaction;
+
+    if (CY_RSLT_SUCCESS != result || DPS_FIFO_EMPTY == value || dps_stopped)
+    {
+        dps_pending = false;
+        return;
+    }
+
+    if (0 == (value & 1))
+    {
+        dps_temperature = dps_sign_extend(value, 24);
+        dps_temperature_valid = true;
+    }
+    else if (dps_temperature_valid)
+    {
+        dps_sample_t sample = { dps_sign_extend(value, 24), dps_temperature };
+        if (ring_push(&dps_ring, &sample))
+        {
+            events_post(EVENT_DPS);
+        }
+    }
+
+    /* The sensor keeps measuring; stop after one FIFO worth of results */
+    if (++dps_entries >= DPS_FIFO_DEPTH || CY_RSLT_SUCCESS != bus_submit(&dps_entry_transaction))
+    {
+        dps_pending = false;
+    }
 }
 
 
@@ -206,23 +624,66 @@ void dps_timer_intr_handler(void *callback_arg, cyhal_timer_event_t event)
 * Function Name: dps_get_data
 ********************************************************************************
 * Summary:
-*   Reads data from the Pressure sensor and stores it in a buffer.
+*   Takes the oldest sample drained from the FIFO and stores the compensated
+*   pressure and temperature in a buffer.
 *
 * Parameters:
-*     dps_data: Stores Pressure sensor data
+*     dps_data: Stores the pressure in hPa and the temperature in degrees
+*               Celsius
+*
+* Return:
+*     CY_RSLT_SUCCESS if a sample was stored; an error if no sample is
+*     available.
 *
 *
 *******************************************************************************/
 cy_rslt_t dps_get_data(float *dps_data)
 {
-    cy_rslt_t result;
+    const dps_coefficients_t *c = &dps_coefficients;
+    dps_sample_t sample;
     float pressure;
     float temperature;
-    result = xensiv_dps3xx_read(&pressure_sensor, &pressure, &temperature);
-    if (CY_RSLT_SUCCESS == result)
+
+    if (!ring_pop(&dps_ring, &sample))
     {
-        dps_data[0] = pressure;
-        dps_data[1] = temperature;
+        return -1;
     }
-    return result;
+
+    /* Compensation as specified in the data sheet */
+    temperature = sample.temperature / dps_scale_factors[DPS_TMP_PRC];
+    pressure = sample.pressure / dps_pressure_scale;
+    dps_data[0] = (c->c00 + pressure * (c->c10 + pressure * (c->c20 + pressure * c->c30)) +
+                   temperature * c->c01 + temperature * pressure * (c->c11 + pressure * c->c21)) / 100.0f;
+    dps_data[1] = c->c0 * 0.5f + c->c1 * temperature;
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name: dps_get_dropped
+********************************************************************************
+* Summary:
+*   Returns the number of samples drained from the FIFO but dropped because
+*   main had not consumed the buffered samples.
+*
+*
+*******************************************************************************/
+uint32_t dps_get_dropped(void)
+{
+    return ring_get_overflows(&dps_ring);
+}
+
+
+/*******************************************************************************
+* Function Name: dps_get_queue_max
+********************************************************************************
+* Summary:
+*   Returns the most samples that have waited in the DPS ring for main at once.
+*
+*
+*******************************************************************************/
+uint32_t dps_get_queue_max(void)
+{
+    return ring_get_high_water(&dps_ring);
 }
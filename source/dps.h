@@ -43,10 +43,9 @@
 #ifndef PRESSURE_H_
 #define PRESSURE_H_
 
-/******************************************************************************
- * Global Variables
- *****************************************************************************/
-extern volatile bool dps_flag;
+#include "cy_result.h"
+#include "stdbool.h"
+#include "stdint.h"
 
 /******************************************************************************
  * Macros
@@ -57,6 +56,9 @@ extern volatile bool dps_flag;
 * Function Prototypes
 *******************************************************************************/
 cy_rslt_t dps_init(void);
+cy_rslt_t dps_configure(uint32_t rate, uint32_t oversampling);
 cy_rslt_t dps_get_data(float *dps_data);
+uint32_t dps_get_dropped(void);
+uint32_t dps_get_queue_max(void);
 
 #endif /* PRESSURE_H_ */
@@ -0,0 +1,453 @@
+/******************************************************************************
+* File Name:   events.c
+*
+* Description: This file implements the run loop of the application:
+*              interrupts post events, and their handlers run in priority
+*              order in the main context.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "cyhal.h"
+#include "cycles.h"
+#include "stats.h"
+#include "events.h"
+#include "config.h"
+#include "profile.h"
+
+#ifdef IM_ENABLE_RTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cyabs_rtos.h"
+#endif
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+static event_handler_t handlers[EVENT_COUNT];
+
+/* One bit per pending event; bit 0 has the highest priority */
+static volatile uint32_t pending = 0;
+
+/* Cycle count when each pending event was posted first */
+static volatile uint32_t post_cycles[EVENT_COUNT];
+
+static event_stats_t stats[EVENT_COUNT];
+
+#ifdef IM_ENABLE_RTOS
+static const char* const EVENT_NAMES[EVENT_COUNT] =
+{
+    "audio", "radar", "imu", "dps", "mag", "protocol"
+};
+#endif
+
+#ifdef IM_ENABLE_RTOS
+static const cy_thread_priority_t EVENT_PRIORITIES[EVENT_COUNT] =
+{
+    RTOS_PRIORITY_AUDIO, RTOS_PRIORITY_RADAR, RTOS_PRIORITY_IMU, RTOS_PRIORITY_DPS, RTOS_PRIORITY_MAG,
+    RTOS_PRIORITY_TRANSMIT
+};
+
+/* One task per registered event, woken by the semaphore of the event */
+static cy_thread_t threads[EVENT_COUNT];
+static cy_semaphore_t semaphores[EVENT_COUNT];
+
+/* Held while a handler or a command runs */
+static cy_mutex_t lock;
+#endif
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static void events_dispatch(event_t event, uint32_t posted);
+#ifdef IM_ENABLE_RTOS
+static void events_task(cy_thread_arg_t arg);
+#else
+static bool events_take(event_t *event, uint32_t *posted);
+#endif
+
+
+/*******************************************************************************
+* Function Name: events_init
+********************************************************************************
+* Summary:
+*  Clears all handlers, pending events and statistics. Call this before any
+*  interrupt that posts events is enabled.
+*
+*******************************************************************************/
+void events_init(void)
+{
+    cycles_init();
+    pending = 0;
+    for (uint32_t event = 0; event < EVENT_COUNT; event++)
+    {
+        handlers[event] = NULL;
+        stats[event] = (event_stats_t) { 0 };
+#ifdef IM_ENABLE_RTOS
+        cy_rtos_init_semaphore(&semaphores[event], 1, 0);
+#endif
+    }
+#ifdef IM_ENABLE_RTOS
+    cy_rtos_init_mutex(&lock);
+#endif
+}
+
+/*******************************************************************************
+* Function Name: events_register
+********************************************************************************
+* Summary:
+*  Sets the handler of an event. Posts of an event without a handler are
+*  discarded.
+*
+* Parameters:
+*  event: the event
+*  handler: the function called in the main context for each post
+*
+*******************************************************************************/
+void events_register(event_t event, event_handler_t handler)
+{
+    handlers[event] = handler;
+}
+
+/*******************************************************************************
+* Function Name: events_post
+********************************************************************************
+* Summary:
+*  Marks an event as pending. Safe to call from interrupts and from handlers.
+*  Posts of an event that is already pending are merged, so a handler must
+*  process everything that is ready, not a single item. Merged posts are
+*  counted: for a sensor without a ring each is a lost sample.
+*
+* Parameters:
+*  event: the event
+*
+*******************************************************************************/
+void events_post(event_t event)
+{
+    uint32_t saved_intr_status = cyhal_system_critical_section_enter();
+    bool posted = false;
+
+    if (0 == (pending & (1u << event)))
+    {
+        post_cycles[event] = cycles_get();
+        pending |= 1u << event;
+        posted = true;
+    }
+    else
+    {
+        stats[event].coalesced++;
+    }
+
+    cyhal_system_critical_section_exit(saved_intr_status);
+
+#ifdef IM_ENABLE_RTOS
+    /* Wake the task of the event */
+    if (posted && NULL != handlers[event])
+    {
+        cy_rtos_set_semaphore(&semaphores[event], 0 != __get_IPSR());
+    }
+#else
+    (void) posted;
+#endif
+}
+
+#ifdef IM_ENABLE_RTOS
+/*******************************************************************************
+* Function Name: events_run
+********************************************************************************
+* Summary:
+*  Creates a task for each event with a handler and starts the scheduler. A
+*  task runs its handler once per post, holding the events lock, so handlers
+*  and commands do not run at the same time, but a handler of a higher
+*  priority preempts the transmission of data. Never returns.
+*
+*******************************************************************************/
+void events_run(void)
+{
+    for (uint32_t event = 0; event < EVENT_COUNT; event++)
+    {
+        if (NULL != handlers[event])
+        {
+            cy_rtos_create_thread(&threads[event], events_task, EVENT_NAMES[event], NULL, RTOS_STACK_SIZE,
+                                  EVENT_PRIORITIES[event], (cy_thread_arg_t) (uintptr_t) event);
+        }
+    }
+
+    vTaskStartScheduler();
+
+    /* Only reached if the scheduler could not allocate its tasks */
+    CY_ASSERT(0);
+    for (;;)
+    {
+    }
+}
+
+/*******************************************************************************
+* Function Name: events_lock
+********************************************************************************
+* Summary:
+*  Waits until no handler runs and keeps the handlers from running until
+*  events_unlock is called. Used by the transmit task for commands, which
+*  reconfigure the sensors. Handlers give up the lock while they wait for the
+*  transmit task in the pipeline. The lock is recursive.
+*
+*******************************************************************************/
+void events_lock(void)
+{
+    cy_rtos_get_mutex(&lock, CY_RTOS_NEVER_TIMEOUT);
+}
+
+/*******************************************************************************
+* Function Name: events_unlock
+********************************************************************************
+* Summary:
+*  Releases the lock taken by events_lock.
+*
+*******************************************************************************/
+void events_unlock(void)
+{
+    cy_rtos_set_mutex(&lock);
+}
+
+/*******************************************************************************
+* Function Name: vApplicationIdleHook
+********************************************************************************
+* Summary:
+*  Sleeps until the next interrupt while no task is ready.
+*
+*******************************************************************************/
+void vApplicationIdleHook(void)
+{
+    __WFI();
+}
+#else
+/*******************************************************************************
+* Function Name: events_run
+********************************************************************************
+* Summary:
+*  Runs the handlers of pending events, highest priority first, and sleeps
+*  until the next interrupt when no event is pending. Handlers are not
+*  preempted by other handlers, so the latency of an event is bounded by the
+*  longest handler. An iteration of the loop runs until no event is pending,
+*  including the events posted meanwhile and the command poll, and its
+*  duration goes to the loop histogram of stats?. Never returns.
+*
+*******************************************************************************/
+void events_run(void)
+{
+    for (;;)
+    {
+        uint32_t saved_intr_status = cyhal_system_critical_section_enter();
+        uint32_t start;
+        uint32_t posted;
+        event_t event;
+
+        if (0 == pending)
+        {
+            /* An interrupt that becomes pending after the check still ends
+             * the sleep, as interrupts are only masked */
+            __WFI();
+            cyhal_system_critical_section_exit(saved_intr_status);
+            continue;
+        }
+        cyhal_system_critical_section_exit(saved_intr_status);
+
+        start = cycles_get();
+        while (events_take(&event, &posted))
+        {
+            events_dispatch(event, posted);
+        }
+        stats_loop(cycles_get() - start);
+    }
+}
+
+/*******************************************************************************
+* Function Name: events_take
+********************************************************************************
+* Summary:
+*  Clears the pending event of the highest priority.
+*
+* Parameters:
+*  event: receives the event
+*  posted: receives the cycle count of its post
+*
+* Return:
+*  True if an event was pending.
+*
+*******************************************************************************/
+static bool events_take(event_t *event, uint32_t *posted)
+{
+    uint32_t saved_intr_status = cyhal_system_critical_section_enter();
+    uint32_t first;
+
+    if (0 == pending)
+    {
+        cyhal_system_critical_section_exit(saved_intr_status);
+        return false;
+    }
+
+    for (first = 0; 0 == (pending & (1u << first)); first++)
+    {
+    }
+    pending &= ~(1u << first);
+    *posted = post_cycles[first];
+    cyhal_system_critical_section_exit(saved_intr_status);
+
+    *event = (event_t) first;
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: events_lock
+********************************************************************************
+* Summary:
+*  Does nothing: handlers never run while another handler or a command runs.
+*
+*******************************************************************************/
+void events_lock(void)
+{
+}
+
+/*******************************************************************************
+* Function Name: events_unlock
+********************************************************************************
+* Summary:
+*  Does nothing; see events_lock.
+*
+*******************************************************************************/
+void events_unlock(void)
+{
+}
+#endif
+
+/*******************************************************************************
+* Function Name: events_get_stats
+********************************************************************************
+* Summary:
+*  Returns the latency and handler statistics of an event.
+*
+* Parameters:
+*  event: the event
+*  event_stats: receives the statistics
+*
+*******************************************************************************/
+void events_get_stats(event_t event, event_stats_t *event_stats)
+{
+    *event_stats = stats[event];
+}
+
+/*******************************************************************************
+* Function Name: events_dispatch
+********************************************************************************
+* Summary:
+*  Runs the handler of an event and updates its statistics and its handler
+*  and latency profiles.
+*
+* Parameters:
+*  event: the event
+*  posted: the cycle count of the post
+*
+*******************************************************************************/
+static void events_dispatch(event_t event, uint32_t posted)
+{
+    event_stats_t *event_stats = &stats[event];
+    uint32_t start;
+    uint32_t duration;
+
+    if (NULL == handlers[event])
+    {
+        return;
+    }
+
+    start = cycles_get();
+    PROFILE_SINCE((profile_region_t) (PROFILE_LATENCY_AUDIO + event), posted);
+    {
+        PROFILE_SCOPE((profile_region_t) (PROFILE_HANDLER_AUDIO + event));
+        handlers[event]();
+    }
+    duration = cycles_get() - start;
+
+    event_stats->count++;
+    event_stats->latency_last = start - posted;
+    if (event_stats->latency_last > event_stats->latency_max)
+    {
+        event_stats->latency_max = event_stats->latency_last;
+    }
+    if (duration > event_stats->duration_max)
+    {
+        event_stats->duration_max = duration;
+    }
+}
+
+#ifdef IM_ENABLE_RTOS
+/*******************************************************************************
+* Function Name: events_task
+********************************************************************************
+* Summary:
+*  Runs the handler of an event each time the event is posted. A run of the
+*  task, from taking the events lock to releasing it, counts as an iteration
+*  of the main loop for stats?.
+*
+* Parameters:
+*  arg: the event
+*
+*******************************************************************************/
+static void events_task(cy_thread_arg_t arg)
+{
+    event_t event = (event_t) (uintptr_t) arg;
+
+    for (;;)
+    {
+        uint32_t saved_intr_status;
+        uint32_t posted;
+        uint32_t start;
+
+        cy_rtos_get_semaphore(&semaphores[event], CY_RTOS_NEVER_TIMEOUT, false);
+
+        saved_intr_status = cyhal_system_critical_section_enter();
+        posted = post_cycles[event];
+        pending &= ~(1u << event);
+        cyhal_system_critical_section_exit(saved_intr_status);
+
+        events_lock();
+        start = cycles_get();
+        events_dispatch(event, posted);
+        stats_loop(cycles_get() - start);
+        events_unlock();
+    }
+}
+#endif
@@ -0,0 +1,87 @@
+/******************************************************************************
+* File Name:   events.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in events.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_EVENTS_H_
+#define SOURCE_EVENTS_H_
+
+#include <stdint.h>
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Events in priority order; the handler of the first pending event runs
+ * next. In the RTOS build each handler runs in its own task, with the
+ * priorities set in config.h. */
+typedef enum
+{
+    EVENT_AUDIO,        /* An audio frame is complete */
+    EVENT_RADAR,        /* A radar frame has been read */
+    EVENT_IMU,          /* IMU frames have been read from the FIFO */
+    EVENT_DPS,          /* Pressure samples have been drained from the FIFO */
+    EVENT_MAG,          /* A magnetometer sample is due */
+    EVENT_PROTOCOL,     /* The protocol is due to check for commands */
+    EVENT_COUNT
+} event_t;
+
+typedef void (*event_handler_t)(void);
+
+/* Latency of an event from the post to the start of its handler, and the
+ * time spent in the handler, in CPU cycles, and the posts merged into a post
+ * that was still pending */
+typedef struct
+{
+    uint32_t count;
+    uint32_t latency_last;
+    uint32_t latency_max;
+    uint32_t duration_max;
+    uint32_t coalesced;
+} event_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+void events_init(void);
+void events_register(event_t event, event_handler_t handler);
+void events_post(event_t event);
+void events_run(void);
+void events_get_stats(event_t event, event_stats_t *event_stats);
+void events_lock(void);
+void events_unlock(void);
+
+#endif /* SOURCE_EVENTS_H_ */
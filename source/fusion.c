@@ -0,0 +1,335 @@
+/******************************************************************************
+* File Name:   fusion.c
+*
+* Description: This file implements an orientation filter that fuses the
+*              accelerometer, gyroscope and magnetometer samples into a
+*              quaternion and the linear acceleration.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <math.h>
+#include "fusion.h"
+#include "imu.h"
+#include "bmm.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Gain of the gradient descent correction (Madgwick's beta), in rad/s. The
+ * larger gain is used for the first second so that the filter converges
+ * quickly from the initial orientation. */
+#define FUSION_BETA                 (0.1f)
+#define FUSION_BETA_INITIAL         (2.5f)
+
+#define FUSION_DEG_TO_RAD           (3.14159265f / 180.0f)
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+/* Orientation of the sensor relative to the earth frame, w, x, y, z */
+static float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
+
+/* Latest magnetometer sample, used with every IMU sample */
+static float mag[3];
+static bool mag_valid;
+
+/* Samples since start-up, to end the initial convergence */
+static uint32_t sample_count;
+
+/* Output decimation: the output rate is accumulated each sample and a result
+ * is due whenever the accumulator reaches the IMU rate */
+static uint32_t output_rate = 50;
+static uint32_t output_accumulator;
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static void fusion_update_imu(float gx, float gy, float gz, float ax, float ay, float az, float beta, float dt);
+static void fusion_update_marg(float gx, float gy, float gz, float ax, float ay, float az,
+                               float mx, float my, float mz, float beta, float dt);
+
+
+/*******************************************************************************
+* Function Name: fusion_configure
+********************************************************************************
+* Summary:
+*  Selects the rate of the fusion results. The filter itself runs at the IMU
+*  rate, so results are produced every few IMU samples.
+*
+* Parameters:
+*  rate: results per second; 25, 50, 100 or 200
+*
+* Return:
+*  True on success; false if the rate is not supported.
+*
+*******************************************************************************/
+bool fusion_configure(uint32_t rate)
+{
+    if (rate != 25 && rate != 50 && rate != 100 && rate != 200)
+    {
+        return false;
+    }
+
+    output_rate = rate;
+    output_accumulator = 0;
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: fusion_set_magnetometer
+********************************************************************************
+* Summary:
+*  Stores the latest magnetometer sample. It is used for the following IMU
+*  samples; without one the heading is not corrected.
+*
+* Parameters:
+*  data: x, y and z magnetometer counts in the axis order of the IMU
+*
+*******************************************************************************/
+void fusion_set_magnetometer(const int16_t *data)
+{
+    mag[0] = data[0] * BMM_SCALE;
+    mag[1] = data[1] * BMM_SCALE;
+    mag[2] = data[2] * BMM_SCALE;
+    mag_valid = (mag[0] != 0.0f || mag[1] != 0.0f || mag[2] != 0.0f);
+}
+
+/*******************************************************************************
+* Function Name: fusion_update
+********************************************************************************
+* Summary:
+*  Updates the orientation with one accelerometer and gyroscope sample and,
+*  when a result is due at the output rate, stores the orientation and the
+*  linear acceleration.
+*
+* Parameters:
+*  accel: x, y and z accelerometer counts
+*  gyro: x, y and z gyroscope counts
+*  rate: the IMU rate in samples per second
+*  result: receives w, x, y, z of the orientation quaternion followed by the
+*          x, y, z linear acceleration in g with gravity removed
+*
+* Return:
+*  True if a result was stored.
+*
+*******************************************************************************/
+bool fusion_update(const int16_t *accel, const int16_t *gyro, uint32_t rate, float *result)
+{
+    float ax = accel[0] * IMU_ACCEL_SCALE;
+    float ay = accel[1] * IMU_ACCEL_SCALE;
+    float az = accel[2] * IMU_ACCEL_SCALE;
+    float gx = gyro[0] * (GYRO_SCALE * FUSION_DEG_TO_RAD);
+    float gy = gyro[1] * (GYRO_SCALE * FUSION_DEG_TO_RAD);
+    float gz = gyro[2] * (GYRO_SCALE * FUSION_DEG_TO_RAD);
+    float beta = sample_count < rate ? FUSION_BETA_INITIAL : FUSION_BETA;
+    float dt = 1.0f / rate;
+
+    if (sample_count < rate)
+    {
+        sample_count++;
+    }
+
+    if (mag_valid)
+    {
+        fusion_update_marg(gx, gy, gz, ax, ay, az, mag[0], mag[1], mag[2], beta, dt);
+    }
+    else
+    {
+        fusion_update_imu(gx, gy, gz, ax, ay, az, beta, dt);
+    }
+
+    output_accumulator += output_rate;
+    if (output_accumulator < rate)
+    {
+        return false;
+    }
+    output_accumulator -= rate;
+
+    result[0] = q0;
+    result[1] = q1;
+    result[2] = q2;
+    result[3] = q3;
+
+    /* Gravity in the sensor frame is the third row of the rotation matrix */
+    result[4] = ax - 2.0f * (q1 * q3 - q0 * q2);
+    result[5] = ay - 2.0f * (q0 * q1 + q2 * q3);
+    result[6] = az - (q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3);
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: fusion_update_imu
+********************************************************************************
+* Summary:
+*  Madgwick update from the gyroscope, corrected towards the gravity direction
+*  measured by the accelerometer.
+*
+*******************************************************************************/
+static void fusion_update_imu(float gx, float gy, float gz, float ax, float ay, float az, float beta, float dt)
+{
+    float norm;
+    float s0, s1, s2, s3;
+    float qdot0, qdot1, qdot2, qdot3;
+
+    /* Rate of change of the quaternion from the gyroscope */
+    qdot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    qdot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    qdot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    qdot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    norm = sqrtf(ax * ax + ay * ay + az * az);
+    if (norm > 0.0f)
+    {
+        ax /= norm;
+        ay /= norm;
+        az /= norm;
+
+        /* Gradient of the error between measured and estimated gravity */
+        s0 = 4.0f * q0 * q2 * q2 + 2.0f * q2 * ax + 4.0f * q0 * q1 * q1 - 2.0f * q1 * ay;
+        s1 = 4.0f * q1 * q3 * q3 - 2.0f * q3 * ax + 4.0f * q0 * q0 * q1 - 2.0f * q0 * ay - 4.0f * q1
+             + 8.0f * q1 * q1 * q1 + 8.0f * q1 * q2 * q2 + 4.0f * q1 * az;
+        s2 = 4.0f * q0 * q0 * q2 + 2.0f * q0 * ax + 4.0f * q2 * q3 * q3 - 2.0f * q3 * ay - 4.0f * q2
+             + 8.0f * q2 * q1 * q1 + 8.0f * q2 * q2 * q2 + 4.0f * q2 * az;
+        s3 = 4.0f * q1 * q1 * q3 - 2.0f * q1 * ax + 4.0f * q2 * q2 * q3 - 2.0f * q2 * ay;
+        norm = sqrtf(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        if (norm > 0.0f)
+        {
+            qdot0 -= beta * s0 / norm;
+            qdot1 -= beta * s1 / norm;
+            qdot2 -= beta * s2 / norm;
+            qdot3 -= beta * s3 / norm;
+        }
+    }
+
+    q0 += qdot0 * dt;
+    q1 += qdot1 * dt;
+    q2 += qdot2 * dt;
+    q3 += qdot3 * dt;
+
+    norm = sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 /= norm;
+    q1 /= norm;
+    q2 /= norm;
+    q3 /= norm;
+}
+
+/*******************************************************************************
+* Function Name: fusion_update_marg
+********************************************************************************
+* Summary:
+*  Madgwick update from the gyroscope, corrected towards the gravity direction
+*  measured by the accelerometer and the earth's magnetic field measured by
+*  the magnetometer.
+*
+*******************************************************************************/
+static void fusion_update_marg(float gx, float gy, float gz, float ax, float ay, float az,
+                               float mx, float my, float mz, float beta, float dt)
+{
+    float norm;
+    float s0, s1, s2, s3;
+    float qdot0, qdot1, qdot2, qdot3;
+    float hx, hy, bx2, bz2, bx4, bz4;
+
+    qdot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    qdot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    qdot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    qdot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    norm = sqrtf(ax * ax + ay * ay + az * az);
+    if (norm > 0.0f)
+    {
+        ax /= norm;
+        ay /= norm;
+        az /= norm;
+
+        norm = sqrtf(mx * mx + my * my + mz * mz);
+        mx /= norm;
+        my /= norm;
+        mz /= norm;
+
+        /* Direction of the magnetic field in the earth frame, with the
+         * horizontal component along x */
+        hx = 2.0f * (mx * (0.5f - q2 * q2 - q3 * q3) + my * (q1 * q2 - q0 * q3) + mz * (q1 * q3 + q0 * q2));
+        hy = 2.0f * (mx * (q1 * q2 + q0 * q3) + my * (0.5f - q1 * q1 - q3 * q3) + mz * (q2 * q3 - q0 * q1));
+        bx2 = sqrtf(hx * hx + hy * hy);
+        bz2 = 2.0f * (mx * (q1 * q3 - q0 * q2) + my * (q2 * q3 + q0 * q1) + mz * (0.5f - q1 * q1 - q2 * q2));
+        bx4 = 2.0f * bx2;
+        bz4 = 2.0f * bz2;
+
+        /* Gradient of the error between the measured and estimated gravity
+         * and magnetic field */
+        {
+            float f1 = 2.0f * (q1 * q3 - q0 * q2) - ax;
+            float f2 = 2.0f * (q0 * q1 + q2 * q3) - ay;
+            float f3 = 1.0f - 2.0f * (q1 * q1 + q2 * q2) - az;
+            float f4 = bx2 * (0.5f - q2 * q2 - q3 * q3) + bz2 * (q1 * q3 - q0 * q2) - mx;
+            float f5 = bx2 * (q1 * q2 - q0 * q3) + bz2 * (q0 * q1 + q2 * q3) - my;
+            float f6 = bx2 * (q0 * q2 + q1 * q3) + bz2 * (0.5f - q1 * q1 - q2 * q2) - mz;
+
+            s0 = -2.0f * q2 * f1 + 2.0f * q1 * f2 - bz2 * q2 * f4 + (-bx2 * q3 + bz2 * q1) * f5 + bx2 * q2 * f6;
+            s1 = 2.0f * q3 * f1 + 2.0f * q0 * f2 - 4.0f * q1 * f3 + bz2 * q3 * f4 + (bx2 * q2 + bz2 * q0) * f5
+                 + (bx2 * q3 - bz4 * q1) * f6;
+            s2 = -2.0f * q0 * f1 + 2.0f * q3 * f2 - 4.0f * q2 * f3 + (-bx4 * q2 - bz2 * q0) * f4
+                 + (bx2 * q1 + bz2 * q3) * f5 + (bx2 * q0 - bz4 * q2) * f6;
+            s3 = 2.0f * q1 * f1 + 2.0f * q2 * f2 + (-bx4 * q3 + bz2 * q1) * f4 + (-bx2 * q0 + bz2 * q2) * f5
+                 + bx2 * q1 * f6;
+        }
+        norm = sqrtf(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        if (norm > 0.0f)
+        {
+            qdot0 -= beta * s0 / norm;
+            qdot1 -= beta * s1 / norm;
+            qdot2 -= beta * s2 / norm;
+            qdot3 -= beta * s3 / norm;
+        }
+    }
+
+    q0 += qdot0 * dt;
+    q1 += qdot1 * dt;
+    q2 += qdot2 * dt;
+    q3 += qdot3 * dt;
+
+    norm = sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 /= norm;
+    q1 /= norm;
+    q2 /= norm;
+    q3 /= norm;
+}
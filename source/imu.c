@@ -1,8 +1,9 @@
 /******************************************************************************
 * File Name:   imu.c
 *
-* Description: This file implements the interface with the motion sensor, as
-*              a timer to feed the pre-processor at 50Hz.
+* Description: This file implements the interface with the motion sensor. The
+*              accelerometer and gyroscope share the FIFO and are read
+*              together in one burst per frame.
 *
 * Related Document: See README.md
 *
@@ -50,6 +51,12 @@
 #include "mtb_bmi160.h"
 #endif
 #include "config.h"
+#include "bus.h"
+#include "calibration.h"
+#include "events.h"
+#include "profile.h"
+#include "ring.h"
+#include "timebase.h"
 
 
 /*******************************************************************************
@@ -57,8 +64,6 @@
 *******************************************************************************/
 
 #define IMU_SCAN_RATE         50
-#define IMU_TIMER_FREQUENCY   100000
-#define IMU_TIMER_PERIOD      (IMU_TIMER_FREQUENCY/IMU_SCAN_RATE)
 #define IMU_TIMER_PRIORITY    3
 
 #ifdef IM_XSS_BMI270
@@ -67,41 +72,149 @@
 #define BMI270_ADDRESS (MTB_BMI270_ADDRESS_DEFAULT)
 #endif
 
+/* Registers. The FIFO is used without headers, so each FIFO entry is one
+ * sample of little endian 16 bit x, y, z values; the gyroscope, when enabled,
+ * comes before the accelerometer. */
+#define IMU_REG_ACC_CONF      0x40
+#define IMU_REG_GYR_CONF      0x42
+#define IMU_REG_CMD           0x7E
+#define IMU_CMD_FIFO_FLUSH    0xB0
+#ifdef IM_BMI_270_IMU_I2C
+#define IMU_REG_FIFO_LENGTH   0x24
+#define IMU_REG_FIFO_DATA     0x26
+#define IMU_REG_FIFO_WTM_0    0x46
+#define IMU_REG_FIFO_WTM_1    0x47
+#define IMU_REG_FIFO_CONFIG_0 0x48
+#define IMU_REG_FIFO_CONFIG_1 0x49
+#define IMU_REG_INT1_IO_CTRL  0x53
+#define IMU_REG_INT_MAP_DATA  0x58
+#define IMU_FIFO_LENGTH_MASK  0x3FFF
+#define IMU_FIFO_SIZE         2048
+#define IMU_ACC_CONF          0xA0      /* Performance mode, normal filter */
+#define IMU_GYR_CONF          0xA0      /* Performance mode, normal filter */
+#else
+#define IMU_REG_FIFO_LENGTH   0x22
+#define IMU_REG_FIFO_DATA     0x24
+#define IMU_REG_FIFO_CONFIG_0 0x46
+#define IMU_REG_FIFO_CONFIG_1 0x47
+#define IMU_REG_INT_EN_1      0x51
+#define IMU_REG_INT_OUT_CTRL  0x53
+#define IMU_REG_INT_MAP_1     0x56
+#define IMU_FIFO_LENGTH_MASK  0x07FF
+#define IMU_FIFO_SIZE         1024
+#define IMU_ACC_CONF          0x20      /* Normal filter */
+#define IMU_GYR_CONF          0x20      /* Normal filter */
+#endif
+#define IMU_FIFO_ACC_EN       0x40
+#define IMU_FIFO_GYR_EN       0x80
+#ifdef IM_ENABLE_GYRO
+#define IMU_FIFO_CONFIG       (IMU_FIFO_GYR_EN | IMU_FIFO_ACC_EN)
+#define IMU_SAMPLE_SIZE       12
+#define IMU_ACC_OFFSET        6
+#else
+#define IMU_FIFO_CONFIG       IMU_FIFO_ACC_EN
+#define IMU_SAMPLE_SIZE       6
+#define IMU_ACC_OFFSET        0
+#endif
+#define IMU_INT1_OUTPUT_EN    0x0A      /* Push-pull, active high */
+#define IMU_INT_FWM           0x40      /* BMI160: watermark interrupt on INT1 */
+#define IMU_INT_MAP_FWM       0x02      /* BMI270: watermark interrupt on INT1 */
+
+/* Over SPI the register address has the read bit set, and the data follows
+ * the address byte */
+#if defined(IM_BMI_160_IMU_SPI) || (IM_BMX_160_IMU_SPI)
+#define IMU_READ_BIT          0x80
+#define IMU_READ_OFFSET       1
+#else
+#define IMU_READ_BIT          0x00
+#define IMU_READ_OFFSET       0
+#endif
+
+/* Number of frames buffered between the bus interrupt and main; a power of
+ * two */
+#define IMU_FRAME_COUNT       4
+
 /*******************************************************************************
 * Global Variables
 *******************************************************************************/
 #ifdef IM_BMX_160_IMU_SPI
     /* BMX160 driver structures */
-    mtb_bmx160_data_t data;
     mtb_bmx160_t sensor_bmx160;
 #endif
 
 #ifdef IM_BMI_160_IMU_SPI
     /* BMI160 driver structures */
-    mtb_bmi160_data_t data;
     mtb_bmi160_t sensor_bmi160;
 #endif
 
 #ifdef IM_BMI_160_IMU_I2C
     /* BMI160 driver structures */
-    mtb_bmi160_data_t data;
     mtb_bmi160_t sensor_bmi160;
 #endif
 
 #ifdef IM_BMI_270_IMU_I2C
     /* BMI270 driver structures */
-    mtb_bmi270_data_t data;
     mtb_bmi270_t sensor_bmi270;
 #endif
 
-/* timer used for getting data */
-cyhal_timer_t imu_timer;
+/* Rates and the matching output data rate codes of both sensors */
+static const uint32_t imu_rates[] = { 50, 100, 200, 400, 800, 1600 };
+static const uint8_t imu_odr_codes[] = { 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C };
+
+/* A frame as read from the FIFO, and the index of its first sample */
+typedef struct
+{
+    uint8_t raw[IMU_READ_OFFSET + IMU_SAMPLE_SIZE * IMU_FRAME_SIZE_MAX];
+    uint32_t first_sample;
+} imu_frame_t;
+
+/* The driver configures the sensor; the FIFO is drained by bus transactions
+ * started from the interrupt pin or timer */
+static bus_device_t imu_device;
+static bus_transaction_t imu_length_transaction;
+static bus_transaction_t imu_data_transaction;
+static const uint8_t imu_length_command = IMU_REG_FIFO_LENGTH | IMU_READ_BIT;
+static const uint8_t imu_data_command = IMU_REG_FIFO_DATA | IMU_READ_BIT;
+static uint8_t imu_length_buffer[IMU_READ_OFFSET + 2];
+static volatile bool imu_pending = false;
+static volatile bool imu_stopped = true;
+
+/* Frames are read in place by the bus interrupt and consumed by main in
+ * order; frames that do not fit are read into imu_discard and counted as
+ * overflows of the ring */
+static imu_frame_t imu_frames[IMU_FRAME_COUNT];
+static imu_frame_t imu_discard;
+static ring_t imu_ring;
+static imu_frame_t *imu_fill_frame;
+
+/* Current configuration; samples are counted to reconstruct timestamps */
+static uint32_t imu_rate = IMU_SCAN_RATE;
+static uint32_t imu_frame_size = 1;
+static uint32_t imu_sample_count = 0;
+static uint32_t imu_fifo_samples = 0;
+
+/* The measured rate of the oscillator of the sensor, from the samples it has
+ * written to the FIFO */
+static timebase_rate_t imu_clock;
+
+#ifdef IMU_INT_PIN
+static cyhal_gpio_callback_data_t imu_pin_callback;
+#endif
+
+/* timer used for polling the FIFO */
+static timebase_timer_t imu_timer;
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-void imu_interrupt_handler(void* callback_arg, cyhal_timer_event_t event);
-cy_rslt_t imu_timer_init(void);
+void imu_interrupt_handler(void *arg);
+void imu_pin_handler(void* callback_arg, cyhal_gpio_event_t event);
+void imu_length_handler(bus_transaction_t *transaction, cy_rslt_t result);
+void imu_data_handler(bus_transaction_t *transaction, cy_rslt_t result);
+void imu_start_read(void);
+void imu_read_frame(void);
+void imu_convert_sample(const uint8_t *data, int16_t *sample);
+cy_rslt_t imu_write_register(uint8_t reg, uint8_t value);
 
 
 /*******************************************************************************
@@ -109,7 +222,8 @@ cy_rslt_t imu_timer_init(void);
 ********************************************************************************
 * Summary:
 *    A function used to initialize the IMU based on the shield selected in the
-*    makefile. Starts a timer that triggers an interrupt at 50Hz.
+*    makefile. Enables the FIFO for the accelerometer and, with IM_ENABLE_GYRO,
+*    the gyroscope, and starts draining it at 50Hz, one sample per frame.
 *
 * Parameters:
 *   None
@@ -134,6 +248,10 @@ cy_rslt_t imu_init(void)
     /* Set the output data rate and range of the accelerometer */
     sensor_bmx160.sensor1.accel_cfg.odr = IMU_SAMPLE_RATE;
     sensor_bmx160.sensor1.accel_cfg.range = IMU_SAMPLE_RANGE;
+#ifdef IM_ENABLE_GYRO
+    sensor_bmx160.sensor1.gyro_cfg.odr = IMU_SAMPLE_RATE;
+    sensor_bmx160.sensor1.gyro_cfg.range = BMI160_GYRO_RANGE_500_DPS;
+#endif
 
     /* Set the sensor configuration */
     bmi160_set_sens_conf(&(sensor_bmx160.sensor1));
@@ -150,6 +268,10 @@ cy_rslt_t imu_init(void)
     /* Set the output data rate and range of the accelerometer */
     sensor_bmi160.sensor.accel_cfg.odr = IMU_SAMPLE_RATE;
     sensor_bmi160.sensor.accel_cfg.range = IMU_SAMPLE_RANGE;
+#ifdef IM_ENABLE_GYRO
+    sensor_bmi160.sensor.gyro_cfg.odr = IMU_SAMPLE_RATE;
+    sensor_bmi160.sensor.gyro_cfg.range = BMI160_GYRO_RANGE_500_DPS;
+#endif
 
     /* Set the sensor configuration */
     bmi160_set_sens_conf(&(sensor_bmi160.sensor));
@@ -173,13 +295,17 @@ cy_rslt_t imu_init(void)
     /* Set the output data rate and range of the accelerometer */
     sensor_bmi160.sensor.accel_cfg.odr = IMU_SAMPLE_RATE;
     sensor_bmi160.sensor.accel_cfg.range = IMU_SAMPLE_RANGE;
+#ifdef IM_ENABLE_GYRO
+    sensor_bmi160.sensor.gyro_cfg.odr = IMU_SAMPLE_RATE;
+    sensor_bmi160.sensor.gyro_cfg.range = BMI160_GYRO_RANGE_500_DPS;
+#endif
 
     /* Set the sensor configuration */
     bmi160_set_sens_conf(&(sensor_bmi160.sensor));
 #endif
 
 #ifdef IM_BMI_270_IMU_I2C
-    struct bmi2_sens_config config = {0};
+    struct bmi2_sens_config config[2] = {0};
 
     /* Initialize the IMU */
     result = mtb_bmi270_init_i2c(&sensor_bmi270, &i2c, BMI270_ADDRESS);
@@ -195,84 +321,173 @@ cy_rslt_t imu_init(void)
         return result;
     }
 
-    /* Set the output data rate and range of the accelerometer */
-    config.type = BMI2_ACCEL;
-    config.cfg.acc.odr = BMI2_ACC_ODR_50HZ;
-    config.cfg.acc.range = BMI2_ACC_RANGE_8G;
-    result = bmi2_set_sensor_config(&config, 1, &(sensor_bmi270.sensor));
+    /* Set the output data rate and range of the accelerometer and gyroscope */
+    config[0].type = BMI2_ACCEL;
+    config[0].cfg.acc.odr = BMI2_ACC_ODR_50HZ;
+    config[0].cfg.acc.range = BMI2_ACC_RANGE_8G;
+    config[1].type = BMI2_GYRO;
+    config[1].cfg.gyr.odr = BMI2_GYR_ODR_50HZ;
+    config[1].cfg.gyr.range = BMI2_GYR_RANGE_500;
+    result = bmi2_set_sensor_config(config, 2, &(sensor_bmi270.sensor));
 #endif
 
-    imu_flag = false;
 
-    /* Timer for data collection */
-    result = imu_timer_init();
+#if defined(IM_BMI_160_IMU_SPI) || (IM_BMX_160_IMU_SPI)
+    bus_device_init_spi(&imu_device, &bus_spi, CYBSP_SPI_CS);
+#elif defined(IM_BMI_270_IMU_I2C)
+    bus_device_init_i2c(&imu_device, &bus_i2c, BMI270_ADDRESS);
+#else
+    bus_device_init_i2c(&imu_device, &bus_i2c, MTB_BMI160_DEFAULT_ADDRESS);
+#endif
+    imu_length_transaction.device = &imu_device;
+    imu_length_transaction.tx = &imu_length_command;
+    imu_length_transaction.tx_size = 1;
+    imu_length_transaction.rx = imu_length_buffer;
+    imu_length_transaction.rx_size = sizeof(imu_length_buffer);
+    imu_length_transaction.callback = imu_length_handler;
+    imu_data_transaction.device = &imu_device;
+    imu_data_transaction.tx = &imu_data_command;
+    imu_data_transaction.tx_size = 1;
+    imu_data_transaction.callback = imu_data_handler;
+
+    result = ring_init(&imu_ring, imu_frames, sizeof(imu_frames[0]), IMU_FRAME_COUNT);
     if(CY_RSLT_SUCCESS != result)
     {
         return result;
     }
 
-    return CY_RSLT_SUCCESS;
+#ifdef IMU_INT_PIN
+    /* The FIFO watermark interrupt starts the reads */
+    result = cyhal_gpio_init(IMU_INT_PIN, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_NONE, false);
+    if(CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+    imu_pin_callback.callback = imu_pin_handler;
+    cyhal_gpio_register_callback(IMU_INT_PIN, &imu_pin_callback);
+    cyhal_gpio_enable_event(IMU_INT_PIN, CYHAL_GPIO_IRQ_RISE, IMU_TIMER_PRIORITY, true);
+#endif
+
+    /* Timer for polling the FIFO */
+    timebase_timer_init(&imu_timer, imu_interrupt_handler, NULL, false);
+
+    return imu_configure(IMU_SCAN_RATE, 1);
 }
 
 
 /*******************************************************************************
-* Function Name: imu_timer_init
+* Function Name: imu_configure
 ********************************************************************************
 * Summary:
-*   Sets up an interrupt that triggers at the desired frequency.
+*   Selects the output data rate of the accelerometer and gyroscope and the
+*   number of samples per frame, shared by both. The FIFO watermark is set to
+*   one frame, so a full frame is read in a single burst. The FIFO is flushed
+*   and buffered frames are dropped.
 *
-* Returns:
-*   The status of the initialization.
+* Parameters:
+*   rate: samples per second; 50, 100, 200, 400, 800 or 1600
+*   frame_size: samples per frame, a power of two from 1 to IMU_FRAME_SIZE_MAX
+*
+* Return:
+*   The status of the configuration; an error if the rate or frame size is not
+*   supported, or BUS_RSLT_ERR_TIMEOUT if an ongoing read did not finish. The
+*   IMU stays stopped after a failure.
 *
 *
 *******************************************************************************/
-cy_rslt_t imu_timer_init(void)
+cy_rslt_t imu_configure(uint32_t rate, uint32_t frame_size)
 {
-    cy_rslt_t rslt;
-    const cyhal_timer_cfg_t timer_cfg =
+    uint32_t watermark = IMU_SAMPLE_SIZE * frame_size;
+    uint32_t index;
+
+    for (index = 0; index < sizeof(imu_rates) / sizeof(imu_rates[0]); index++)
     {
-        .compare_value = 0,                 /* Timer compare value, not used */
-        .period = IMU_TIMER_PERIOD,         /* Defines the timer period */
-        .direction = CYHAL_TIMER_DIR_UP,    /* Timer counts up */
-        .is_compare = false,                /* Don't use compare mode */
-        .is_continuous = true,              /* Run the timer indefinitely */
-        .value = 0                          /* Initial value of counter */
-    };
-
-    /* Initialize the timer object. Does not use pin output ('pin' is NC) and
-     * does not use a pre-configured clock source ('clk' is NULL). */
-    rslt = cyhal_timer_init(&imu_timer, NC, NULL);
-    if (CY_RSLT_SUCCESS != rslt)
+        if (imu_rates[index] == rate)
+        {
+            break;
+        }
+    }
+    if (index == sizeof(imu_rates) / sizeof(imu_rates[0]) ||
+        frame_size < 1 || frame_size > IMU_FRAME_SIZE_MAX || 0 != (frame_size & (frame_size - 1)))
     {
-        return rslt;
+        return -1;
     }
 
-    /* Apply timer configuration such as period, count direction, run mode, etc. */
-    rslt = cyhal_timer_configure(&imu_timer, &timer_cfg);
-    if (CY_RSLT_SUCCESS != rslt)
+    /* Stop draining the FIFO and let an ongoing read finish */
+    imu_stopped = true;
+    timebase_stop(&imu_timer);
+    for (uint32_t waited = 0; imu_pending && waited < BUS_TIMEOUT_US; waited += BUS_POLL_US)
     {
-        return rslt;
+        cyhal_system_delay_us(BUS_POLL_US);
     }
-
-    /* Set the frequency of timer to 100KHz */
-    rslt = cyhal_timer_set_frequency(&imu_timer, IMU_TIMER_FREQUENCY);
-    if (CY_RSLT_SUCCESS != rslt)
+    if (imu_pending)
     {
-        return rslt;
+        return BUS_RSLT_ERR_TIMEOUT;
     }
 
-    /* Assign the ISR to execute on timer interrupt */
-    cyhal_timer_register_callback(&imu_timer, imu_interrupt_handler, NULL);
-    /* Set the event on which timer interrupt occurs and enable it */
-    cyhal_timer_enable_event(&imu_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, IMU_TIMER_PRIORITY, true);
-    /* Start the timer with the configured settings */
-    rslt = cyhal_timer_start(&imu_timer);
-    if (CY_RSLT_SUCCESS != rslt)
+#ifdef IM_BMI_270_IMU_I2C
+    if (imu_write_register(IMU_REG_FIFO_CONFIG_0, 0x00) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_FIFO_CONFIG_1, IMU_FIFO_CONFIG) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_FIFO_WTM_0, (uint8_t) watermark) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_FIFO_WTM_1, (uint8_t) (watermark >> 8)) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_INT1_IO_CTRL, IMU_INT1_OUTPUT_EN) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_INT_MAP_DATA, IMU_INT_MAP_FWM) != CY_RSLT_SUCCESS)
+#else
+    /* The watermark is set in units of 4 bytes */
+    if (imu_write_register(IMU_REG_FIFO_CONFIG_0, (uint8_t) ((watermark + 3) / 4)) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_FIFO_CONFIG_1, IMU_FIFO_CONFIG) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_INT_OUT_CTRL, IMU_INT1_OUTPUT_EN) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_INT_MAP_1, IMU_INT_FWM) != CY_RSLT_SUCCESS ||
+        imu_write_register(IMU_REG_INT_EN_1, IMU_INT_FWM) != CY_RSLT_SUCCESS)
+#endif
     {
-        return rslt;
+        return -1;
     }
+    if (imu_write_register(IMU_REG_ACC_CONF, IMU_ACC_CONF | imu_odr_codes[index]) != CY_RSLT_SUCCESS ||
+#ifdef IM_ENABLE_GYRO
+        imu_write_register(IMU_REG_GYR_CONF, IMU_GYR_CONF | imu_odr_codes[index]) != CY_RSLT_SUCCESS ||
+#endif
+        imu_write_register(IMU_REG_CMD, IMU_CMD_FIFO_FLUSH) != CY_RSLT_SUCCESS)
+    {
+        return -1;
+    }
+
+    imu_rate = rate;
+    imu_frame_size = frame_size;
+    imu_sample_count = 0;
+    imu_fifo_samples = 0;
+    timebase_rate_init(&imu_clock, rate);
+    ring_flush(&imu_ring);
+    imu_stopped = false;
 
+#ifndef IMU_INT_PIN
+    return timebase_start(&imu_timer, TIMEBASE_FREQUENCY * frame_size, rate, TIMEBASE_PHASE_IMU);
+#else
     return CY_RSLT_SUCCESS;
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: imu_write_register
+********************************************************************************
+* Summary:
+*   Writes a register of the IMU and waits until the write has completed.
+*
+* Parameters:
+*   reg: the register address
+*   value: the value to write
+*
+* Return:
+*   The status of the write.
+*
+*
+*******************************************************************************/
+cy_rslt_t imu_write_register(uint8_t reg, uint8_t value)
+{
+    const uint8_t command[2] = { reg, value };
+
+    return bus_transfer(&imu_device, command, sizeof(command), NULL, 0);
 }
 
 
@@ -280,8 +495,28 @@ cy_rslt_t imu_timer_init(void)
 * Function Name: imu_interrupt_handler
 ********************************************************************************
 * Summary:
-*   Interrupt handler for timer. Interrupt handler will get called at 50Hz and
-*   sets a flag that can be checked in main.
+*   Timebase callback. Called once per frame period and queues a read of the
+*   FIFO level on the bus.
+*
+* Parameters:
+*     arg: not used
+*
+*
+*******************************************************************************/
+void imu_interrupt_handler(void *arg)
+{
+    (void) arg;
+
+    imu_start_read();
+}
+
+
+/*******************************************************************************
+* Function Name: imu_pin_handler
+********************************************************************************
+* Summary:
+*   Interrupt handler for the FIFO watermark interrupt of the IMU. Queues a
+*   read of one frame on the bus.
 *
 * Parameters:
 *     callback_arg: not used
@@ -289,12 +524,146 @@ cy_rslt_t imu_timer_init(void)
 *
 *
 *******************************************************************************/
-void imu_interrupt_handler(void *callback_arg, cyhal_timer_event_t event)
+void imu_pin_handler(void *callback_arg, cyhal_gpio_event_t event)
 {
     (void) callback_arg;
     (void) event;
 
-    imu_flag = true;
+    imu_start_read();
+}
+
+
+/*******************************************************************************
+* Function Name: imu_start_read
+********************************************************************************
+* Summary:
+*   Starts draining the FIFO unless a read is pending. With the watermark
+*   interrupt at least one frame is in the FIFO; otherwise the FIFO level is
+*   read first. Called from the interrupts.
+*
+*
+*******************************************************************************/
+void imu_start_read(void)
+{
+    if (imu_stopped || imu_pending)
+    {
+        return;
+    }
+
+    imu_pending = true;
+#ifdef IMU_INT_PIN
+    imu_read_frame();
+#else
+    if (CY_RSLT_SUCCESS != bus_submit(&imu_length_transaction))
+    {
+        imu_pending = false;
+    }
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: imu_read_frame
+********************************************************************************
+* Summary:
+*   Queues a burst read of one frame from the FIFO into the next free frame,
+*   or into imu_discard if main has not consumed the buffered frames.
+*
+*
+*******************************************************************************/
+void imu_read_frame(void)
+{
+    imu_fill_frame = ring_reserve(&imu_ring);
+    if (NULL == imu_fill_frame)
+    {
+        imu_fill_frame = &imu_discard;
+    }
+
+    imu_data_transaction.rx = imu_fill_frame->raw;
+    imu_data_transaction.rx_size = IMU_READ_OFFSET + IMU_SAMPLE_SIZE * imu_frame_size;
+    if (CY_RSLT_SUCCESS != bus_submit(&imu_data_transaction))
+    {
+        imu_pending = false;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: imu_length_handler
+********************************************************************************
+* Summary:
+*   Called from the bus interrupt when the FIFO level has been read. Starts
+*   reading the complete frames in the FIFO.
+*
+* Parameters:
+*     transaction: not used
+*     result: the status of the read
+*
+*
+*******************************************************************************/
+void imu_length_handler(bus_transaction_t *transaction, cy_rslt_t result)
+{
+    const uint8_t *data = imu_length_buffer + IMU_READ_OFFSET;
+    (void) transaction;
+
+    if (CY_RSLT_SUCCESS == result && !imu_stopped)
+    {
+        imu_fifo_samples = ((data[0] | (data[1] << 8)) & IMU_FIFO_LENGTH_MASK) / IMU_SAMPLE_SIZE;
+        timebase_rate_update(&imu_clock, imu_sample_count + imu_fifo_samples);
+        if (imu_fifo_samples >= imu_frame_size)
+        {
+            imu_read_frame();
+            return;
+        }
+    }
+    imu_pending = false;
+}
+
+
+/*******************************************************************************
+* Function Name: imu_data_handler
+********************************************************************************
+* Summary:
+*   Called from the bus interrupt when a frame has been read. Hands the frame
+*   to main through the ring, and reads the next frame if one is in the FIFO.
+*
+* Parameters:
+*     transaction: not used
+*     result: the status of the read
+*
+*
+*******************************************************************************/
+void imu_data_handler(bus_transaction_t *transaction, cy_rslt_t result)
+{
+    (void) transaction;
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        imu_pending = false;
+        return;
+    }
+
+    imu_fill_frame->first_sample = imu_sample_count;
+    imu_sample_count += imu_frame_size;
+    if (imu_fill_frame != &imu_discard)
+    {
+        ring_commit(&imu_ring);
+        events_post(EVENT_IMU);
+    }
+
+    /* With the interrupt pin, the line stays high while the FIFO holds at least
+     * a frame */
+#ifdef IMU_INT_PIN
+    if (!imu_stopped && cyhal_gpio_read(IMU_INT_PIN))
+#else
+    imu_fifo_samples -= imu_frame_size;
+    if (!imu_stopped && imu_fifo_samples >= imu_frame_size)
+#endif
+    {
+        imu_read_frame();
+        return;
+    }
+    imu_pending = false;
 }
 
 
@@ -302,42 +671,184 @@ void imu_interrupt_handler(void *callback_arg, cyhal_timer_event_t event)
 * Function Name: imu_get_data
 ********************************************************************************
 * Summary:
-*   Reads accelerometer data from the IMU and stores it in a buffer.
+*   Takes the oldest frame read from the FIFO and stores the raw accelerometer
+*   and gyroscope counts in buffers; IMU_ACCEL_SCALE and GYRO_SCALE convert
+*   them to physical units. Both come from the same FIFO entries, so sample i
+*   of either buffer was taken at the same time. The counts are corrected with
+*   the calibration coefficients. The time of the first sample is reconstructed
+*   from its number and the output data rate measured against the timebase, so
+*   it follows the drift of the sensor oscillator; the following samples are
+*   one period of that rate apart.
 *
 * Parameters:
-*     imu_data: Stores IMU accelerometer data
+*     imu_data: Stores IMU accelerometer counts, x, y and z of each sample
+*     gyro_data: Stores gyroscope counts, x, y and z of each sample; may be NULL
+*     timestamp: Stores the number and time of the first sample; may be NULL
+*
+* Return:
+*     The number of samples stored; 0 if no frame is available.
 *
 *
 *******************************************************************************/
-void imu_get_data(float *imu_data)
+uint32_t imu_get_data(int16_t *imu_data, int16_t *gyro_data, imu_timestamp_t *timestamp)
 {
-    /* Read data from IMU sensor */
-    cy_rslt_t result;
-#ifdef IM_BMX_160_IMU_SPI
-    result = mtb_bmx160_read(&sensor_bmx160, &data);
+    PROFILE_SCOPE(PROFILE_IMU_GET_DATA);
+    const imu_frame_t *frame;
+    const uint8_t *data;
+#ifdef IM_ENABLE_CALIBRATION
+    int16_t *accel_samples = imu_data;
+#ifdef IM_ENABLE_GYRO
+    int16_t *gyro_samples = gyro_data;
 #endif
-#if defined(IM_BMI_160_IMU_SPI) || (IM_BMI_160_IMU_I2C)
-    result = mtb_bmi160_read(&sensor_bmi160, &data);
 #endif
-#ifdef IM_BMI_270_IMU_I2C
-    result = mtb_bmi270_read(&sensor_bmi270, &data);
+
+    frame = ring_peek(&imu_ring);
+    if (NULL == frame)
+    {
+        return 0;
+    }
+    data = frame->raw + IMU_READ_OFFSET;
+
+    for (uint32_t i = 0; i < imu_frame_size; i++)
+    {
+#ifdef IM_ENABLE_GYRO
+        if (NULL != gyro_data)
+        {
+            imu_convert_sample(data, gyro_data);
+            gyro_data += GYRO_AXIS;
+        }
 #endif
-    if (CY_RSLT_SUCCESS == result)
+        imu_convert_sample(data + IMU_ACC_OFFSET, imu_data);
+        data += IMU_SAMPLE_SIZE;
+        imu_data += IMU_AXIS;
+    }
+
+    /* The sensor had produced first_sample + 1 samples once it was taken */
+    if (NULL != timestamp)
     {
-        #if defined(IM_BMI_160_IMU_SPI) || (IM_BMX_160_IMU_SPI)
-            imu_data[0] = ((float)data.accel.y) / (float)0x1000;
-            imu_data[1] = ((float)data.accel.x) / (float)0x1000;
-            imu_data[2] = ((float)data.accel.z) / (float)0x1000;
-        #endif
-        #if defined(IM_IMU_BMI270) || (IM_XSS_BMI270)
-            imu_data[0] = ((float)data.sensor_data.acc.x) / (float)0x1000;
-            imu_data[1] = ((float)data.sensor_data.acc.y) / (float)0x1000;
-            imu_data[2] = ((float)data.sensor_data.acc.z) / (float)0x1000;
-        #endif
-        #ifdef IM_BMI_160_IMU_I2C
-            imu_data[0] = ((float)data.accel.x) / (float)0x1000;
-            imu_data[1] = ((float)data.accel.y) / (float)0x1000;
-            imu_data[2] = ((float)data.accel.z) / (float)0x1000;
-        #endif
+        timestamp->sample = frame->first_sample;
+        timestamp->time_us = (uint32_t) (timebase_rate_get_ticks(&imu_clock, frame->first_sample + 1) *
+                                         (1000000u / TIMEBASE_FREQUENCY));
     }
+
+#ifdef IM_ENABLE_CALIBRATION
+    calibration_process(CALIBRATION_ACCEL, accel_samples, imu_frame_size);
+#ifdef IM_ENABLE_GYRO
+    if (NULL != gyro_samples)
+    {
+        calibration_process(CALIBRATION_GYRO, gyro_samples, imu_frame_size);
+    }
+#endif
+#endif
+
+    ring_release(&imu_ring);
+    return imu_frame_size;
+}
+
+
+/*******************************************************************************
+* Function Name: imu_convert_sample
+********************************************************************************
+* Summary:
+*   Converts one x, y, z sample from the FIFO to counts in the axis order of
+*   the board.
+*
+* Parameters:
+*     data: the little endian 16 bit values from the FIFO
+*     sample: Stores x, y and z
+*
+*
+*******************************************************************************/
+void imu_convert_sample(const uint8_t *data, int16_t *sample)
+{
+    int16_t x = (int16_t) (data[0] | (data[1] << 8));
+    int16_t y = (int16_t) (data[2] | (data[3] << 8));
+
+#if defined(IM_BMI_160_IMU_SPI) || (IM_BMX_160_IMU_SPI)
+    sample[0] = y;
+    sample[1] = x;
+#else
+    sample[0] = x;
+    sample[1] = y;
+#endif
+    sample[2] = (int16_t) (data[4] | (data[5] << 8));
+}
+
+
+/*******************************************************************************
+* Function Name: imu_get_rate
+********************************************************************************
+* Summary:
+*   Returns the configured output data rate in samples per second.
+*
+*
+*******************************************************************************/
+uint32_t imu_get_rate(void)
+{
+    return imu_rate;
+}
+
+
+/*******************************************************************************
+* Function Name: imu_get_frame_size
+********************************************************************************
+* Summary:
+*   Returns the configured number of samples per frame.
+*
+*
+*******************************************************************************/
+uint32_t imu_get_frame_size(void)
+{
+    return imu_frame_size;
+}
+
+
+/*******************************************************************************
+* Function Name: imu_get_dropped
+********************************************************************************
+* Summary:
+*   Returns the number of frames read from the FIFO but dropped because main
+*   had not consumed the buffered frames.
+*
+*
+*******************************************************************************/
+uint32_t imu_get_dropped(void)
+{
+    return ring_get_overflows(&imu_ring);
+}
+
+
+/*******************************************************************************
+* Function Name: imu_get_queue_max
+********************************************************************************
+* Summary:
+*   Returns the most frames that have waited in the IMU ring for main at once.
+*
+*
+*******************************************************************************/
+uint32_t imu_get_queue_max(void)
+{
+    return ring_get_high_water(&imu_ring);
+}
+
+
+/*******************************************************************************
+* Function Name: imu_get_drift
+********************************************************************************
+* Summary:
+*   Returns the drift of the output data rate of the sensor against the
+*   timebase, measured since the last configuration.
+*
+* Parameters:
+*   ppb: receives the drift in parts per billion
+*   seconds: receives the length of the measurement
+*
+* Return:
+*   True if the sensor ran long enough to measure the drift.
+*
+*
+*******************************************************************************/
+bool imu_get_drift(int32_t *ppb, uint32_t *seconds)
+{
+    return timebase_rate_get_drift(&imu_clock, ppb, seconds);
 }
@@ -44,21 +44,47 @@
 
 #include "cy_result.h"
 #include "stdbool.h"
+#include "stdint.h"
 
 /******************************************************************************
- * Global Variables
+ * Macros
  *****************************************************************************/
-extern volatile bool imu_flag;
+#define IMU_AXIS 3
+#define GYRO_AXIS 3
+
+/* Physical units per count: g at the 8 G accelerometer range and degrees per
+ * second at the 500 dps gyroscope range, as a value and as reported in the
+ * config? response */
+#define IMU_ACCEL_SCALE         (8.0f / 32768.0f)
+#define IMU_ACCEL_SCALE_STRING  "0.000244140625"
+#define GYRO_SCALE              (500.0f / 32768.0f)
+#define GYRO_SCALE_STRING       "0.0152587890625"
+
+/* Largest number of samples per frame */
+#define IMU_FRAME_SIZE_MAX 32
 
 /******************************************************************************
- * Macros
+ * Types
  *****************************************************************************/
-#define IMU_AXIS 3
+/* Timing of an IMU frame, sent as is on the timestamp channel: the number of
+ * the first sample since the last configuration, and the time it was taken on
+ * the timebase in microseconds, wrapping after about 71 minutes */
+typedef struct
+{
+    uint32_t sample;
+    uint32_t time_us;
+} imu_timestamp_t;
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 cy_rslt_t imu_init(void);
-void imu_get_data(float *imu_data);
+cy_rslt_t imu_configure(uint32_t rate, uint32_t frame_size);
+uint32_t imu_get_data(int16_t *imu_data, int16_t *gyro_data, imu_timestamp_t *timestamp);
+uint32_t imu_get_rate(void);
+uint32_t imu_get_frame_size(void);
+uint32_t imu_get_dropped(void);
+uint32_t imu_get_queue_max(void);
+bool imu_get_drift(int32_t *ppb, uint32_t *seconds);
 
 #endif /* IMU_H */
@@ -44,55 +44,115 @@
 #include "cy_retarget_io.h"
 #include "stdlib.h"
 #include "audio.h"
+#include "bus.h"
+#include "calibration.h"
 #ifdef IM_ENABLE_IMU
   #include "imu.h"
 #endif
 #include "bmm.h"
-#include "gyro.h"
 #include "dps.h"
+#include "events.h"
+#include "fusion.h"
+#include "pipeline.h"
 #include "radar.h"
+#include "radar_dsp.h"
+#include "radar_presence.h"
 #include "protocol.h"
+#include "timebase.h"
+#include "config.h"
 
 /*******************************************************************************
-* Global Variables
+* Local Variables
 ********************************************************************************/
 
-volatile bool pdm_pcm_flag;
-volatile bool imu_flag;
-volatile bool bmm_flag;
-volatile bool dps_flag;
-volatile bool radar_flag;
-volatile bool gyro_flag;
-cyhal_i2c_t i2c;
-cyhal_spi_t spi;
+/* Frame buffers of the handlers, transmitted from the pools without copies */
+static int16_t audio_buffers[PIPELINE_BUFFERS][FRAME_SIZE_MAX];
+static pipeline_pool_t audio_pool;
+
+#ifdef IM_ENABLE_IMU
+/* Accelerometer frames */
+static int16_t accel_buffers[PIPELINE_BUFFERS][IMU_AXIS * IMU_FRAME_SIZE_MAX];
+static pipeline_pool_t accel_pool;
+
+/* Number and time of the first sample of each accelerometer frame */
+static imu_timestamp_t timestamp_buffers[PIPELINE_BUFFERS];
+static pipeline_pool_t timestamp_pool;
+
+#ifdef IM_ENABLE_GYRO
+/* Gyroscope frames; the gyroscope is read with the accelerometer */
+static int16_t gyro_buffers[PIPELINE_BUFFERS][GYRO_AXIS * IMU_FRAME_SIZE_MAX];
+static pipeline_pool_t gyro_pool;
+#endif
+
+#ifdef IM_ENABLE_FUSION
+/* Orientation and linear acceleration; fusion_data is the buffer receiving
+ * the next result */
+static float fusion_buffers[PIPELINE_BUFFERS][FUSION_AXIS];
+static pipeline_pool_t fusion_pool;
+static float *fusion_data = NULL;
+#endif
+#endif
+
+#ifdef IM_ENABLE_MAG
+/* Magnetometer samples */
+static int16_t bmm_buffers[PIPELINE_BUFFERS][BMM_AXIS];
+static pipeline_pool_t bmm_pool;
+#endif
+
+#ifdef IM_ENABLE_DPS
+/* Pressure and temperature samples */
+static float dps_buffers[PIPELINE_BUFFERS][DPS_AXIS];
+static pipeline_pool_t dps_pool;
+#endif
+
+#if IM_ENABLE_RADAR
+/* Derived radar channel packets; the raw frames stay in the radar pool */
+static uint16_t range_buffers[PIPELINE_BUFFERS][(PROTOCOL_HEADER_SIZE + RADAR_DSP_MAX_FRAME + PROTOCOL_TRAILER_SIZE) / 2];
+static pipeline_pool_t range_pool;
+static uint16_t doppler_buffers[PIPELINE_BUFFERS][(PROTOCOL_HEADER_SIZE + RADAR_DSP_MAX_FRAME + PROTOCOL_TRAILER_SIZE) / 2];
+static pipeline_pool_t doppler_pool;
+static float presence_buffers[PIPELINE_BUFFERS][RADAR_PRESENCE_AXIS];
+static pipeline_pool_t presence_pool;
+#endif
+
 
 /*******************************************************************************
-* Macros
-*******************************************************************************/
+* Function Prototypes
+********************************************************************************/
+static cy_rslt_t stream_init(void);
+static void stream_audio(void);
+#ifdef IM_ENABLE_IMU
+static void stream_imu(void);
+#endif
+#ifdef IM_ENABLE_MAG
+static void stream_mag(void);
+#endif
+#ifdef IM_ENABLE_DPS
+static void stream_dps(void);
+#endif
+#if IM_ENABLE_RADAR
+static void stream_radar(void);
+#endif
+#ifndef IM_ENABLE_RTOS
+static void handle_protocol(void);
+#endif
 
-#define SPI_FREQUENCY      (12000000UL)
 
 /*******************************************************************************
 * Function Name: main
 ********************************************************************************
 * Summary:
 *  This is the main function. It sets up either the PDM or IMU based on the
-*  config.h file. main continuously checks flags, signaling that data is ready
-*  to be streamed over UART or USB and initiates the transfer.
+*  config.h file. The interrupts signaling that data is ready post events, and
+*  main runs their handlers, which stream the data over UART or USB, in
+*  priority order. The CPU sleeps while no event is pending. In the RTOS build
+*  the handlers run in tasks and a transmit task streams the data.
 *
 *******************************************************************************/
 int main(void)
 {
     cy_rslt_t result;
 
-    /* I2C config structure */
-    cyhal_i2c_cfg_t i2c_config =
-    {
-         .is_slave = false,
-         .address = 0,
-         .frequencyhal_hz = 400000
-    };
-
     /* Initialize the device and board peripherals */
     result = cybsp_init() ;
     if (result != CY_RSLT_SUCCESS)
@@ -100,54 +160,25 @@ int main(void)
         CY_ASSERT(0);
     }
 
+    /* Initialize the run loop before any interrupt posts an event */
+    events_init();
+
     /* Enable global interrupts */
     __enable_irq();
-    
-    /* Initialize I2C for IMU communication */
-    result = cyhal_i2c_init(&i2c, CYBSP_I2C_SDA, CYBSP_I2C_SCL, NULL);
-    if(CY_RSLT_SUCCESS != result)
-    {
-        return result;
-    }
-
-    /* Configure the I2C */
-    result = cyhal_i2c_configure(&i2c, &i2c_config);
-    if(CY_RSLT_SUCCESS != result)
-    {
-        return result;
-    }
 
-#if defined(IM_BMI_160_IMU_SPI) || (IM_BMX_160_IMU_SPI)
-    result = cyhal_spi_init(&spi, CYBSP_SPI_MOSI, CYBSP_SPI_MISO, CYBSP_SPI_CLK, NC, NULL, 8, CYHAL_SPI_MODE_00_MSB, false);
-    if(CY_RSLT_SUCCESS != result)
-    {
-        return result;
-    }
-    result = cyhal_spi_set_frequency(&spi, SPI_FREQUENCY);
-    if(CY_RSLT_SUCCESS != result)
+    /* Start the counter that drives all periodic timers */
+    result = timebase_init();
+    if (CY_RSLT_SUCCESS != result)
     {
-        return result;
+        CY_ASSERT(0);
     }
 
-     /* Initialize the chip select line */
-    result = cyhal_gpio_init(CYBSP_SPI_CS, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, 1);
-    if(CY_RSLT_SUCCESS != result)
-    {
-        return result;
-    }
-#endif
-#ifdef IM_ENABLE_RADAR
-    result = cyhal_spi_init(&spi, CYBSP_RSPI_MOSI, CYBSP_RSPI_MISO, CYBSP_RSPI_CLK, NC, NULL, 8, CYHAL_SPI_MODE_00_MSB, false);
-    if(CY_RSLT_SUCCESS != result)
-    {
-      return result;
-    }
-    result = cyhal_spi_set_frequency(&spi, SPI_FREQUENCY);
+    /* Initialize the I2C and SPI buses */
+    result = bus_init();
     if(CY_RSLT_SUCCESS != result)
     {
         return result;
     }
-#endif
 
     /* Initialize retarget-io to use the debug UART port */
     cy_retarget_io_init(CYBSP_DEBUG_UART_TX, CYBSP_DEBUG_UART_RX, CY_RETARGET_IO_BAUDRATE);
@@ -167,55 +198,38 @@ int main(void)
     /* Initialize protocol (start timer) */
     protocol_init();
 
-    /* Initialize PDM transmit buffers */
-    uint8_t transmit_pdm[2 * FRAME_SIZE] = {0};
-    int16_t *pdm_raw_data = (int16_t *) transmit_pdm;
+    /* Fill the frame pools and start the transmit task */
+    result = stream_init();
+    if (CY_RSLT_SUCCESS != result)
+    {
+        CY_ASSERT(0);
+    }
 
     /* Configure PDM, PDM clocks, and PDM event */
     result = pdm_init();
 
-#ifdef IM_ENABLE_IMU
-    /* Initialize  accelerometer transmit buffers */
-    uint8_t transmit_imu[4 * IMU_AXIS] = {0};
-    float *imu_raw_data = (float*) transmit_imu;
-
-    /* Start the imu and timer */
-    result = imu_init();
+#ifdef IM_ENABLE_CALIBRATION
+    /* Load the motion sensor calibration from flash */
+    result = calibration_init();
 #endif
 
-#ifdef IM_ENABLE_GYRO
-    /* Initialize gyroscope transmit buffers */
-    uint8_t transmit_gyro[4 * GYRO_AXIS] = {0};
-    float *gyro_raw_data = (float*) transmit_gyro;
-
+#ifdef IM_ENABLE_IMU
     /* Start the imu and timer */
-    result = gyro_init();
+    result = imu_init();
 #endif
 
 #ifdef IM_ENABLE_MAG
-    /* Initialize magnetometer transmit buffers */
-    uint8_t transmit_bmm[4 * BMM_AXIS] = {0};
-    float *bmm_raw_data = (float*) transmit_bmm;
-
     /* Start the magnetometer and timer */
     result = mag_sensor_init();
 #endif
 
 #ifdef IM_ENABLE_DPS
-    int8 val = 0;
-    /* Initialize pressure transmit buffers */
-    uint8_t transmit_dps[4 * DPS_AXIS] = {0};
-    float *dps_raw_data = (float*) transmit_dps;
     /* Configure DPS sensor */
     result = dps_init();
 #endif
 
 #if IM_ENABLE_RADAR
-     /* Initialize Radar transmit buffers */
-    uint8_t transmit_radar[2 * RADAR_AXIS] = {0};
-    int16_t *radar_raw_data = (int16_t*) transmit_radar;
-
-    /* Start the imu and timer */
+    /* Start the radar and its FIFO interrupt */
     result = radar_init();
 #endif
 
@@ -226,80 +240,315 @@ int main(void)
         NVIC_SystemReset();
     }
 
+    /* Handle the events; never returns */
+    events_register(EVENT_AUDIO, stream_audio);
+#ifdef IM_ENABLE_IMU
+    events_register(EVENT_IMU, stream_imu);
+#endif
+#ifdef IM_ENABLE_MAG
+    events_register(EVENT_MAG, stream_mag);
+#endif
+#ifdef IM_ENABLE_DPS
+    events_register(EVENT_DPS, stream_dps);
+#endif
+#if IM_ENABLE_RADAR
+    events_register(EVENT_RADAR, stream_radar);
+#endif
+#ifndef IM_ENABLE_RTOS
+    /* The transmit task checks for commands in the RTOS build */
+    events_register(EVENT_PROTOCOL, handle_protocol);
+#endif
+    events_run();
+}
+
+/*******************************************************************************
+* Function Name: stream_init
+********************************************************************************
+* Summary:
+*  Fills the frame pools of the handlers and starts the transmit pipeline.
+*
+* Return:
+*  The status of the initialization.
+*
+*******************************************************************************/
+static cy_rslt_t stream_init(void)
+{
+    cy_rslt_t result = pipeline_pool_init(&audio_pool, audio_buffers, sizeof(audio_buffers[0]), PIPELINE_BUFFERS);
+
+#ifdef IM_ENABLE_IMU
+    result |= pipeline_pool_init(&accel_pool, accel_buffers, sizeof(accel_buffers[0]), PIPELINE_BUFFERS);
+    result |= pipeline_pool_init(&timestamp_pool, timestamp_buffers, sizeof(timestamp_buffers[0]), PIPELINE_BUFFERS);
+#ifdef IM_ENABLE_GYRO
+    result |= pipeline_pool_init(&gyro_pool, gyro_buffers, sizeof(gyro_buffers[0]), PIPELINE_BUFFERS);
+#endif
+#ifdef IM_ENABLE_FUSION
+    result |= pipeline_pool_init(&fusion_pool, fusion_buffers, sizeof(fusion_buffers[0]), PIPELINE_BUFFERS);
+#endif
+#endif
+#ifdef IM_ENABLE_MAG
+    result |= pipeline_pool_init(&bmm_pool, bmm_buffers, sizeof(bmm_buffers[0]), PIPELINE_BUFFERS);
+#endif
+#ifdef IM_ENABLE_DPS
+    result |= pipeline_pool_init(&dps_pool, dps_buffers, sizeof(dps_buffers[0]), PIPELINE_BUFFERS);
+#endif
+#if IM_ENABLE_RADAR
+    result |= pipeline_pool_init(&range_pool, range_buffers, sizeof(range_buffers[0]), PIPELINE_BUFFERS);
+    result |= pipeline_pool_init(&doppler_pool, doppler_buffers, sizeof(doppler_buffers[0]), PIPELINE_BUFFERS);
+    result |= pipeline_pool_init(&presence_pool, presence_buffers, sizeof(presence_buffers[0]), PIPELINE_BUFFERS);
+#endif
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+    return pipeline_init();
+}
+
+/*******************************************************************************
+* Function Name: stream_audio
+********************************************************************************
+* Summary:
+*  Decimates and transmits the completed audio frames.
+*
+*******************************************************************************/
+static void stream_audio(void)
+{
     for (;;)
     {
-        /* Handle incoming characters */
-        protocol_repl();
+        /* Store PDM data; frames may have been dropped by a configuration
+         * change */
+        int16_t *pdm_data = pipeline_acquire(&audio_pool);
+        size_t pdm_samples = pdm_preprocessing_feed(pdm_data);
 
+        if (0 == pdm_samples)
+        {
+            pipeline_release(&audio_pool, pdm_data);
+            return;
+        }
         /* Transmit data */
-#if IM_ENABLE_IMU
-        if (true == imu_flag)
+        pipeline_send(PROTOCOL_AUDIO_CHANNEL, pdm_data, 2 * pdm_samples, &audio_pool);
+    }
+}
+
+#ifdef IM_ENABLE_IMU
+/*******************************************************************************
+* Function Name: stream_imu
+********************************************************************************
+* Summary:
+*  Transmits the accelerometer and gyroscope frames read from the FIFO with
+*  their timestamp and updates the orientation with each sample. The filter
+*  runs before the frames are submitted, as their buffers may be reused once
+*  sent.
+*
+*******************************************************************************/
+static void stream_imu(void)
+{
+    for (;;)
+    {
+        int16_t *accel_data = pipeline_acquire(&accel_pool);
+        imu_timestamp_t *timestamp = pipeline_acquire(&timestamp_pool);
+        int16_t *gyro_data = NULL;
+        uint32_t imu_samples;
+
+#ifdef IM_ENABLE_GYRO
+        gyro_data = pipeline_acquire(&gyro_pool);
+#endif
+#ifdef IM_ENABLE_FUSION
+        if (NULL == fusion_data)
         {
-            imu_flag = false;
-            /* Store accelerometer data */
-            imu_get_data(imu_raw_data);
-            /* Transmit data */
-            protocol_send(PROTOCOL_IMU_CHANNEL, transmit_imu, sizeof(transmit_imu));
+            fusion_data = pipeline_acquire(&fusion_pool);
         }
 #endif
 
+        imu_samples = imu_get_data(accel_data, gyro_data, timestamp);
+        if (0 == imu_samples)
+        {
+            pipeline_release(&accel_pool, accel_data);
+            pipeline_release(&timestamp_pool, timestamp);
 #ifdef IM_ENABLE_GYRO
-        if (true == gyro_flag)
+            pipeline_release(&gyro_pool, gyro_data);
+#endif
+            return;
+        }
+
+#ifdef IM_ENABLE_FUSION
+        /* The filter runs on every sample, whether subscribed or not */
+        for (uint32_t i = 0; i < imu_samples; i++)
         {
-            gyro_flag = false;
-            /* Store gyroscope data */
-            gyro_get_data(gyro_raw_data);
-            /* Transmit data */
-            protocol_send(PROTOCOL_GYRO_CHANNEL, transmit_gyro, sizeof(transmit_gyro));
+            if (fusion_update(&accel_data[IMU_AXIS * i], &gyro_data[GYRO_AXIS * i], imu_get_rate(), fusion_data))
+            {
+                pipeline_send(PROTOCOL_FUSION_CHANNEL, fusion_data, sizeof(float) * FUSION_AXIS, &fusion_pool);
+                fusion_data = pipeline_acquire(&fusion_pool);
+            }
         }
 #endif
 
+        pipeline_send_counts(PROTOCOL_IMU_CHANNEL, accel_data, IMU_AXIS * imu_samples, IMU_ACCEL_SCALE, &accel_pool);
+        pipeline_send(PROTOCOL_IMU_TIMESTAMP_CHANNEL, timestamp, sizeof(*timestamp), &timestamp_pool);
+#ifdef IM_ENABLE_GYRO
+        pipeline_send_counts(PROTOCOL_GYRO_CHANNEL, gyro_data, GYRO_AXIS * imu_samples, GYRO_SCALE, &gyro_pool);
+#endif
+    }
+}
+#endif
+
 #ifdef IM_ENABLE_MAG
-        if(true == bmm_flag)
-        {
-            bmm_flag = false;
-            /* Store magnetometer data */
-            bmm350_get_data(bmm_raw_data);
+/*******************************************************************************
+* Function Name: stream_mag
+********************************************************************************
+* Summary:
+*  Reads and transmits a magnetometer sample.
+*
+*******************************************************************************/
+static void stream_mag(void)
+{
+    int16_t *bmm_data = pipeline_acquire(&bmm_pool);
 
-            /* Transmit data */
-            protocol_send(PROTOCOL_BMM_CHANNEL, transmit_bmm, sizeof(transmit_bmm));
-        }
+    /* Store magnetometer data */
+    bmm350_get_data(bmm_data);
+#ifdef IM_ENABLE_FUSION
+    fusion_set_magnetometer(bmm_data);
+#endif
+
+    /* Transmit data */
+    pipeline_send_counts(PROTOCOL_BMM_CHANNEL, bmm_data, BMM_AXIS, BMM_SCALE, &bmm_pool);
+}
 #endif
 
 #ifdef IM_ENABLE_DPS
-        if(true == dps_flag)
+/*******************************************************************************
+* Function Name: stream_dps
+********************************************************************************
+* Summary:
+*  Transmits the pressure samples drained from the FIFO.
+*
+*******************************************************************************/
+static void stream_dps(void)
+{
+    for (;;)
+    {
+        float *dps_data = pipeline_acquire(&dps_pool);
+
+        if (CY_RSLT_SUCCESS != dps_get_data(dps_data))
         {
-            dps_flag = false;
-            /* Store Pressure data */
-            val = dps_get_data(dps_raw_data);
-            if(CY_RSLT_SUCCESS == val)
-            {
-                /* Transmit data */
-                protocol_send(PROTOCOL_DPS_CHANNEL, transmit_dps, sizeof(transmit_dps));
-            }
+            pipeline_release(&dps_pool, dps_data);
+            return;
         }
+        pipeline_send(PROTOCOL_DPS_CHANNEL, dps_data, sizeof(float) * DPS_AXIS, &dps_pool);
+    }
+}
 #endif
 
 #if IM_ENABLE_RADAR
-        if (true == radar_flag)
+/*******************************************************************************
+* Function Name: stream_radar
+********************************************************************************
+* Summary:
+*  Computes the derived channels of the radar frame read by DMA and transmits
+*  them with the frame. The raw packet returns to the radar pool once sent.
+*
+*******************************************************************************/
+static void stream_radar(void)
+{
+    uint8_t *radar_packet;
+    const uint16_t *radar_frame;
+    const radar_config_t *radar_config;
+    size_t radar_bins;
+    uint16_t *range_packet = NULL;
+    uint16_t *doppler_packet = NULL;
+    float *radar_presence = NULL;
+
+    /* Take the buffers of the subscribed derived channels first: commands may
+     * reconfigure the radar while waiting for them */
+    if (protocol_is_subscribed(PROTOCOL_RADAR_RANGE_CHANNEL) || protocol_is_subscribed(PROTOCOL_RADAR_DOPPLER_CHANNEL))
+    {
+        range_packet = pipeline_acquire(&range_pool);
+    }
+    if (protocol_is_subscribed(PROTOCOL_RADAR_DOPPLER_CHANNEL))
+    {
+        doppler_packet = pipeline_acquire(&doppler_pool);
+    }
+    if (protocol_is_subscribed(PROTOCOL_RADAR_PRESENCE_CHANNEL))
+    {
+        radar_presence = pipeline_acquire(&presence_pool);
+    }
+
+    /* Take the frame read by DMA; frames skipped for the selected rate are not returned */
+    if (CY_RSLT_SUCCESS != radar_get_packet(&radar_packet))
+    {
+        if (NULL != range_packet)
         {
-            radar_flag = false;
-            /* Store radar data */
-            radar_get_data(radar_raw_data);
-            /* Transmit data */
-            protocol_send(PROTOCOL_RADAR_CHANNEL, transmit_radar, sizeof(transmit_radar));
+            pipeline_release(&range_pool, range_packet);
         }
-#endif
+        if (NULL != doppler_packet)
+        {
+            pipeline_release(&doppler_pool, doppler_packet);
+        }
+        if (NULL != radar_presence)
+        {
+            pipeline_release(&presence_pool, radar_presence);
+        }
+        return;
+    }
 
-        if (true == pdm_pcm_flag)
+    /* Compute the range profile and range-Doppler map of the first antenna if
+     * subscribed */
+    radar_config = radar_get_config();
+    radar_frame = (const uint16_t*) (radar_packet + PROTOCOL_HEADER_SIZE);
+    radar_bins = radar_config->chirps * radar_config->samples / 2;
+    if (NULL != range_packet)
+    {
+        radar_dsp_range(radar_frame, range_packet + PROTOCOL_HEADER_SIZE / 2);
+        if (NULL != doppler_packet)
         {
-            pdm_pcm_flag = false;
-            /* Store PDM data */
-            pdm_preprocessing_feed(pdm_raw_data);
-            /* Transmit data */
-            protocol_send(PROTOCOL_AUDIO_CHANNEL, transmit_pdm, sizeof(transmit_pdm));
+            radar_dsp_doppler(doppler_packet + PROTOCOL_HEADER_SIZE / 2);
         }
     }
+    /* Update the presence detector from the first antenna if subscribed */
+    if (NULL != radar_presence)
+    {
+        radar_presence_process(radar_frame, radar_presence);
+    }
+    /* Transmit data from the packet, which is handed back to the radar pool
+     * when sent */
+    pipeline_send_packet(PROTOCOL_RADAR_CHANNEL, radar_packet,
+                         2 * radar_config->samples * radar_config->chirps * radar_config->rx, NULL,
+                         radar_release_packet);
+    if (NULL != range_packet)
+    {
+        pipeline_send_packet(PROTOCOL_RADAR_RANGE_CHANNEL, (uint8_t*) range_packet, 2 * radar_bins, &range_pool,
+                             NULL);
+    }
+    if (NULL != doppler_packet)
+    {
+        pipeline_send_packet(PROTOCOL_RADAR_DOPPLER_CHANNEL, (uint8_t*) doppler_packet, 2 * radar_bins,
+                             &doppler_pool, NULL);
+    }
+    if (NULL != radar_presence)
+    {
+        pipeline_send(PROTOCOL_RADAR_PRESENCE_CHANNEL, radar_presence, sizeof(float) * RADAR_PRESENCE_AXIS,
+                      &presence_pool);
+    }
 }
+#endif
+
+#ifndef IM_ENABLE_RTOS
+/*******************************************************************************
+* Function Name: handle_protocol
+********************************************************************************
+* Summary:
+*  Handles incoming characters on each clock tick. While characters arrive, the
+*  event is posted again, so a command is read completely without holding off
+*  the sensor events.
+*
+*******************************************************************************/
+static void handle_protocol(void)
+{
+    if (protocol_repl())
+    {
+        events_post(EVENT_PROTOCOL);
+    }
+}
+#endif
 
 /* [] END OF FILE */
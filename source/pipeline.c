@@ -0,0 +1,418 @@
+/******************************************************************************
+* File Name:   pipeline.c
+*
+* Description: This file implements the frame pools and the transmit queue
+*              between the sensor handlers and the streaming interface.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "clock.h"
+#include "events.h"
+#include "protocol.h"
+#include "pipeline.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Frames waiting for the transmit task */
+#define PIPELINE_QUEUE_LENGTH       (16u)
+
+/* Interval of the transmit task to check for commands, in ms */
+#define PIPELINE_POLL_MS            (10u)
+
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef enum
+{
+    PIPELINE_FORMAT_BYTES,      /* protocol_send */
+    PIPELINE_FORMAT_COUNTS,     /* protocol_send_counts */
+    PIPELINE_FORMAT_PACKET      /* protocol_send_packet */
+} pipeline_format_t;
+
+/* A submitted frame; the data stays in the buffer of the producer */
+typedef struct
+{
+    uint8_t channel;
+    pipeline_format_t format;
+    float scale;
+    void *data;
+    size_t size;
+    pipeline_pool_t *pool;
+    void (*release)(void);
+} pipeline_frame_t;
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+#ifdef IM_ENABLE_RTOS
+static cy_queue_t transmit_queue;
+static cy_thread_t transmit_thread;
+#endif
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static void pipeline_submit(const pipeline_frame_t *frame);
+static void pipeline_transmit(const pipeline_frame_t *frame);
+#ifdef IM_ENABLE_RTOS
+static void pipeline_transmit_task(cy_thread_arg_t arg);
+#endif
+
+
+/*******************************************************************************
+* Function Name: pipeline_init
+********************************************************************************
+* Summary:
+*  Creates the transmit queue and the transmit task in the RTOS build. Call
+*  this before events_run.
+*
+* Return:
+*  The status of the initialization.
+*
+*******************************************************************************/
+cy_rslt_t pipeline_init(void)
+{
+#ifdef IM_ENABLE_RTOS
+    cy_rslt_t result = cy_rtos_init_queue(&transmit_queue, PIPELINE_QUEUE_LENGTH, sizeof(pipeline_frame_t));
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    return cy_rtos_create_thread(&transmit_thread, pipeline_transmit_task, "transmit", NULL,
+                                 RTOS_TRANSMIT_STACK_SIZE, RTOS_PRIORITY_TRANSMIT, NULL);
+#else
+    return CY_RSLT_SUCCESS;
+#endif
+}
+
+/*******************************************************************************
+* Function Name: pipeline_pool_init
+********************************************************************************
+* Summary:
+*  Fills a pool with buffers.
+*
+* Parameters:
+*  pool: the pool
+*  buffers: count consecutive buffers of size bytes each
+*  size: the size of a buffer in bytes
+*  count: the number of buffers, at most PIPELINE_BUFFERS
+*
+* Return:
+*  The status of the initialization.
+*
+*******************************************************************************/
+cy_rslt_t pipeline_pool_init(pipeline_pool_t *pool, void *buffers, size_t size, uint32_t count)
+{
+    if (count > PIPELINE_BUFFERS)
+    {
+        return PIPELINE_RSLT_ERR_BUFFERS;
+    }
+
+#ifdef IM_ENABLE_RTOS
+    cy_rslt_t result = cy_rtos_init_queue(&pool->free, count, sizeof(void*));
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+#else
+    pool->count = 0;
+#endif
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        pipeline_release(pool, (uint8_t*) buffers + i * size);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: pipeline_acquire
+********************************************************************************
+* Summary:
+*  Takes a buffer from a pool. In the RTOS build this waits until the transmit
+*  task returns a buffer, without holding the events lock, so commands may run
+*  meanwhile; otherwise a buffer is always available, as frames are sent when
+*  submitted.
+*
+* Parameters:
+*  pool: the pool
+*
+* Return:
+*  The buffer.
+*
+*******************************************************************************/
+void* pipeline_acquire(pipeline_pool_t *pool)
+{
+#ifdef IM_ENABLE_RTOS
+    void *buffer = NULL;
+    if (CY_RSLT_SUCCESS != cy_rtos_get_queue(&pool->free, &buffer, 0, false))
+    {
+        events_unlock();
+        cy_rtos_get_queue(&pool->free, &buffer, CY_RTOS_NEVER_TIMEOUT, false);
+        events_lock();
+    }
+    return buffer;
+#else
+    return pool->free[--pool->count];
+#endif
+}
+
+/*******************************************************************************
+* Function Name: pipeline_release
+********************************************************************************
+* Summary:
+*  Returns a buffer that was not submitted to its pool.
+*
+* Parameters:
+*  pool: the pool
+*  buffer: the buffer
+*
+*******************************************************************************/
+void pipeline_release(pipeline_pool_t *pool, void *buffer)
+{
+#ifdef IM_ENABLE_RTOS
+    /* The queue holds all buffers of the pool, so it is never full */
+    cy_rtos_put_queue(&pool->free, &buffer, 0, false);
+#else
+    pool->free[pool->count++] = buffer;
+#endif
+}
+
+/*******************************************************************************
+* Function Name: pipeline_flush
+********************************************************************************
+* Summary:
+*  Sends the queued frames. Called by the transmit task holding the events
+*  lock before a command, so that no frame of the previous configuration, and
+*  no radar packet, is left in the queue.
+*
+*******************************************************************************/
+void pipeline_flush(void)
+{
+#ifdef IM_ENABLE_RTOS
+    pipeline_frame_t frame;
+
+    while (CY_RSLT_SUCCESS == cy_rtos_get_queue(&transmit_queue, &frame, 0, false))
+    {
+        pipeline_transmit(&frame);
+    }
+#endif
+}
+
+/*******************************************************************************
+* Function Name: pipeline_send
+********************************************************************************
+* Summary:
+*  Submits a frame for protocol_send. The buffer returns to the pool when sent.
+*
+* Parameters:
+*  channel: the channel
+*  data: the frame, in a buffer of the pool
+*  size: the number of bytes
+*  pool: the pool of the buffer
+*
+*******************************************************************************/
+void pipeline_send(uint8_t channel, void *data, size_t size, pipeline_pool_t *pool)
+{
+    pipeline_frame_t frame =
+    {
+        .channel = channel, .format = PIPELINE_FORMAT_BYTES, .data = data, .size = size, .pool = pool
+    };
+    pipeline_submit(&frame);
+}
+
+/*******************************************************************************
+* Function Name: pipeline_send_counts
+********************************************************************************
+* Summary:
+*  Submits a frame of raw counts for protocol_send_counts. The buffer returns
+*  to the pool when sent.
+*
+* Parameters:
+*  channel: the channel
+*  data: the counts, in a buffer of the pool
+*  count: the number of counts
+*  scale: the physical unit per count
+*  pool: the pool of the buffer
+*
+*******************************************************************************/
+void pipeline_send_counts(uint8_t channel, int16_t *data, size_t count, float scale, pipeline_pool_t *pool)
+{
+    pipeline_frame_t frame =
+    {
+        .channel = channel, .format = PIPELINE_FORMAT_COUNTS, .scale = scale, .data = data, .size = count,
+        .pool = pool
+    };
+    pipeline_submit(&frame);
+}
+
+/*******************************************************************************
+* Function Name: pipeline_send_packet
+********************************************************************************
+* Summary:
+*  Submits a packet for protocol_send_packet. When sent, the buffer returns to
+*  the pool if there is one, and release is called if given, holding the
+*  events lock.
+*
+* Parameters:
+*  channel: the channel
+*  packet: the packet with room for the header and trailer
+*  size: the number of payload bytes
+*  pool: the pool of the buffer, or NULL
+*  release: called when the packet is sent, or NULL
+*
+*******************************************************************************/
+void pipeline_send_packet(uint8_t channel, uint8_t *packet, size_t size, pipeline_pool_t *pool,
+                          void (*release)(void))
+{
+    pipeline_frame_t frame =
+    {
+        .channel = channel, .format = PIPELINE_FORMAT_PACKET, .data = packet, .size = size, .pool = pool,
+        .release = release
+    };
+    pipeline_submit(&frame);
+}
+
+/*******************************************************************************
+* Function Name: pipeline_submit
+********************************************************************************
+* Summary:
+*  Queues a frame for the transmit task in the RTOS build, waiting without the
+*  events lock while the queue is full; otherwise sends it. Frames of channels
+*  without a subscriber are released right away.
+*
+* Parameters:
+*  frame: the frame
+*
+*******************************************************************************/
+static void pipeline_submit(const pipeline_frame_t *frame)
+{
+#ifdef IM_ENABLE_RTOS
+    if (protocol_is_subscribed(frame->channel))
+    {
+        if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&transmit_queue, frame, 0, false))
+        {
+            events_unlock();
+            cy_rtos_put_queue(&transmit_queue, frame, CY_RTOS_NEVER_TIMEOUT, false);
+            events_lock();
+        }
+        return;
+    }
+#endif
+    pipeline_transmit(frame);
+}
+
+/*******************************************************************************
+* Function Name: pipeline_transmit
+********************************************************************************
+* Summary:
+*  Sends a frame and releases its buffer.
+*
+* Parameters:
+*  frame: the frame
+*
+*******************************************************************************/
+static void pipeline_transmit(const pipeline_frame_t *frame)
+{
+    switch (frame->format)
+    {
+        case PIPELINE_FORMAT_COUNTS:
+            protocol_send_counts(frame->channel, frame->data, frame->size, frame->scale);
+            break;
+        case PIPELINE_FORMAT_PACKET:
+            protocol_send_packet(frame->channel, frame->data, frame->size);
+            break;
+        default:
+            protocol_send(frame->channel, frame->data, frame->size);
+            break;
+    }
+
+    if (NULL != frame->pool)
+    {
+        pipeline_release(frame->pool, frame->data);
+    }
+    if (NULL != frame->release)
+    {
+        events_lock();
+        frame->release();
+        events_unlock();
+    }
+}
+
+#ifdef IM_ENABLE_RTOS
+/*******************************************************************************
+* Function Name: pipeline_transmit_task
+********************************************************************************
+* Summary:
+*  Owns the streaming interface: sends the queued frames in submission order
+*  and checks for commands every PIPELINE_POLL_MS.
+*
+* Parameters:
+*  arg: unused
+*
+*******************************************************************************/
+static void pipeline_transmit_task(cy_thread_arg_t arg)
+{
+    pipeline_frame_t frame;
+    uint32_t last_poll = clock_get_ms();
+
+    (void) arg;
+
+    for (;;)
+    {
+        if (CY_RSLT_SUCCESS == cy_rtos_get_queue(&transmit_queue, &frame, PIPELINE_POLL_MS, false))
+        {
+            pipeline_transmit(&frame);
+        }
+
+        if (clock_get_ms() - last_poll >= PIPELINE_POLL_MS)
+        {
+            /* Read the command completely */
+            while (protocol_repl())
+            {
+            }
+            last_poll = clock_get_ms();
+        }
+    }
+}
+#endif
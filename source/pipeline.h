@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name:   pipeline.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in pipeline.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_PIPELINE_H_
+#define SOURCE_PIPELINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cy_result.h"
+#include "config.h"
+
+#ifdef IM_ENABLE_RTOS
+#include "cyabs_rtos.h"
+#endif
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Buffers per pool. In the RTOS build a frame is filled while the previous
+ * ones wait for the transmit task; otherwise frames are sent when submitted. */
+#ifdef IM_ENABLE_RTOS
+#define PIPELINE_BUFFERS    (3u)
+#else
+#define PIPELINE_BUFFERS    (1u)
+#endif
+
+/* Module of the pipeline results, next to the bus results */
+#define PIPELINE_RSLT_MODULE        (CY_RSLT_MODULE_MIDDLEWARE_BASE + 0xF2u)
+
+/* A pool was given more buffers than PIPELINE_BUFFERS */
+#define PIPELINE_RSLT_ERR_BUFFERS   CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, PIPELINE_RSLT_MODULE, 1u)
+
+/* Frame buffers of one producer; frames are transmitted from the buffers
+ * without copies and the buffers return to the pool when sent */
+typedef struct
+{
+#ifdef IM_ENABLE_RTOS
+    cy_queue_t free;
+#else
+    void *free[PIPELINE_BUFFERS];
+    uint32_t count;
+#endif
+} pipeline_pool_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+cy_rslt_t pipeline_init(void);
+cy_rslt_t pipeline_pool_init(pipeline_pool_t *pool, void *buffers, size_t size, uint32_t count);
+void* pipeline_acquire(pipeline_pool_t *pool);
+void pipeline_release(pipeline_pool_t *pool, void *buffer);
+void pipeline_flush(void);
+void pipeline_send(uint8_t channel, void *data, size_t size, pipeline_pool_t *pool);
+void pipeline_send_counts(uint8_t channel, int16_t *data, size_t count, float scale, pipeline_pool_t *pool);
+void pipeline_send_packet(uint8_t channel, uint8_t *packet, size_t size, pipeline_pool_t *pool,
+                          void (*release)(void));
+
+#endif /* SOURCE_PIPELINE_H_ */
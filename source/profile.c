@@ -0,0 +1,271 @@
+/******************************************************************************
+* File Name:   profile.c
+*
+* Description: This file implements the cycle profiles of the hot paths:
+*              the count, minimum, average, maximum and a histogram of the
+*              cycles spent in each region, reported by the profile? command.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#include "profile.h"
+
+#ifdef IM_ENABLE_PROFILE
+
+/* Regions are recorded from interrupts and tasks; in the host build the
+ * critical section of tests/hal is a lock shared by all threads */
+#include "cyhal.h"
+#define profile_lock()          cyhal_system_critical_section_enter()
+#define profile_unlock(status)  cyhal_system_critical_section_exit(status)
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[PROFILE_BUCKETS];
+} profile_t;
+
+static const char* PROFILE_NAMES[PROFILE_REGION_COUNT] =
+{
+    "protocol_repl",
+    "imu_get_data",
+    "radar_get_packet",
+    "pdm_preprocessing_feed",
+    "streaming_send",
+    "decimator_process",
+    "radar_transfer_handler",
+    "radar_start_transfer",
+    "radar_dsp_range",
+    "radar_dsp_doppler",
+    "handler_audio",
+    "handler_radar",
+    "handler_imu",
+    "handler_dps",
+    "handler_mag",
+    "handler_protocol",
+    "latency_audio",
+    "latency_radar",
+    "latency_imu",
+    "latency_dps",
+    "latency_mag",
+    "latency_protocol",
+};
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+static profile_t profiles[PROFILE_REGION_COUNT];
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static uint32_t profile_bucket(uint32_t cycles);
+static uint32_t profile_bucket_max(uint32_t bucket);
+
+
+/*******************************************************************************
+* Function Definitions
+*******************************************************************************/
+
+/*******************************************************************************
+* Function Name: profile_end
+********************************************************************************
+* Summary:
+*  Records the cycles since the start of a scope; called by the cleanup of
+*  PROFILE_SCOPE and by PROFILE_SINCE.
+*
+* Parameters:
+*  scope: the scope being left
+*
+*******************************************************************************/
+void profile_end(const profile_scope_t *scope)
+{
+    uint32_t cycles = cycles_get() - scope->start;
+    profile_t *profile = &profiles[scope->region];
+    uint32_t saved_intr_status = profile_lock();
+
+    if (0 == profile->count || cycles < profile->min)
+    {
+        profile->min = cycles;
+    }
+    if (cycles > profile->max)
+    {
+        profile->max = cycles;
+    }
+    profile->count++;
+    profile->total += cycles;
+    profile->histogram[profile_bucket(cycles)]++;
+
+    profile_unlock(saved_intr_status);
+}
+
+/*******************************************************************************
+* Function Name: profile_get
+********************************************************************************
+* Summary:
+*  Summarizes the samples of a region since the last reset.
+*
+* Parameters:
+*  region: the region
+*  summary: receives the summary; all zero if the region has no samples
+*
+*******************************************************************************/
+void profile_get(profile_region_t region, profile_summary_t *summary)
+{
+    static profile_t profile;   /* Too large for the stack of the caller */
+    uint32_t saved_intr_status = profile_lock();
+    uint32_t rank;
+    uint32_t seen = 0;
+    uint32_t bucket;
+
+    memcpy(&profile, &profiles[region], sizeof(profile));
+    profile_unlock(saved_intr_status);
+
+    memset(summary, 0, sizeof(*summary));
+    if (0 == profile.count)
+    {
+        return;
+    }
+
+    summary->count = profile.count;
+    summary->min = profile.min;
+    summary->avg = (uint32_t) (profile.total / profile.count);
+    summary->max = profile.max;
+
+    /* The sample at or above which 1% of the samples lie */
+    rank = profile.count - profile.count / 100;
+    for (bucket = 0; bucket < PROFILE_BUCKETS - 1; bucket++)
+    {
+        seen += profile.histogram[bucket];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    summary->p99 = profile_bucket_max(bucket);
+    if (summary->p99 > profile.max)
+    {
+        summary->p99 = profile.max;
+    }
+}
+
+/*******************************************************************************
+* Function Name: profile_get_name
+********************************************************************************
+* Summary:
+*  Returns the name of a region, the function it measures.
+*
+* Parameters:
+*  region: the region
+*
+*******************************************************************************/
+const char* profile_get_name(profile_region_t region)
+{
+    return PROFILE_NAMES[region];
+}
+
+/*******************************************************************************
+* Function Name: profile_reset
+********************************************************************************
+* Summary:
+*  Discards the samples of all regions.
+*
+*******************************************************************************/
+void profile_reset(void)
+{
+    uint32_t saved_intr_status = profile_lock();
+
+    memset(profiles, 0, sizeof(profiles));
+    profile_unlock(saved_intr_status);
+}
+
+/*******************************************************************************
+* Function Name: profile_bucket
+********************************************************************************
+* Summary:
+*  Returns the histogram bucket of a cycle count. Counts below
+*  PROFILE_SUB_BUCKETS have a bucket each; above, each power of two is split
+*  into PROFILE_SUB_BUCKETS buckets by the bits below the leading one.
+*
+* Parameters:
+*  cycles: the cycle count
+*
+*******************************************************************************/
+static uint32_t profile_bucket(uint32_t cycles)
+{
+    uint32_t msb;
+
+    if (cycles < PROFILE_SUB_BUCKETS)
+    {
+        return cycles;
+    }
+
+    msb = 31u - (uint32_t) __builtin_clz(cycles);
+    return ((msb - PROFILE_SUB_BITS + 1u) << PROFILE_SUB_BITS) +
+           ((cycles >> (msb - PROFILE_SUB_BITS)) & (PROFILE_SUB_BUCKETS - 1u));
+}
+
+/*******************************************************************************
+* Function Name: profile_bucket_max
+********************************************************************************
+* Summary:
+*  Returns the largest cycle count of a histogram bucket.
+*
+* Parameters:
+*  bucket: the bucket
+*
+*******************************************************************************/
+static uint32_t profile_bucket_max(uint32_t bucket)
+{
+    uint32_t shift;
+
+    if (bucket < PROFILE_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    shift = (bucket >> PROFILE_SUB_BITS) - 1u;
+    return ((PROFILE_SUB_BUCKETS + (bucket & (PROFILE_SUB_BUCKETS - 1u))) << shift) + ((1u << shift) - 1u);
+}
+
+#endif /* IM_ENABLE_PROFILE */
@@ -0,0 +1,126 @@
+/******************************************************************************
+* File Name:   profile.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in profile.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_PROFILE_H_
+#define SOURCE_PROFILE_H_
+
+#include <stdint.h>
+#include "cycles.h"
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Profiled regions; the names are listed in profile.c. The handler and the
+ * latency regions of the events follow the order of event_t in events.h. */
+typedef enum
+{
+    PROFILE_PROTOCOL_REPL,
+    PROFILE_IMU_GET_DATA,
+    PROFILE_RADAR_GET_PACKET,
+    PROFILE_PDM_PREPROCESSING_FEED,
+    PROFILE_STREAMING_SEND,
+    PROFILE_DECIMATOR,
+    PROFILE_RADAR_TRANSFER_HANDLER,
+    PROFILE_RADAR_START_TRANSFER,
+    PROFILE_RADAR_DSP_RANGE,
+    PROFILE_RADAR_DSP_DOPPLER,
+    PROFILE_HANDLER_AUDIO,
+    PROFILE_HANDLER_RADAR,
+    PROFILE_HANDLER_IMU,
+    PROFILE_HANDLER_DPS,
+    PROFILE_HANDLER_MAG,
+    PROFILE_HANDLER_PROTOCOL,
+    PROFILE_LATENCY_AUDIO,
+    PROFILE_LATENCY_RADAR,
+    PROFILE_LATENCY_IMU,
+    PROFILE_LATENCY_DPS,
+    PROFILE_LATENCY_MAG,
+    PROFILE_LATENCY_PROTOCOL,
+    PROFILE_REGION_COUNT
+} profile_region_t;
+
+/* The cycle histogram of a region has PROFILE_SUB_BUCKETS buckets per power
+ * of two, so a percentile is exact to 1/PROFILE_SUB_BUCKETS of its value,
+ * and spans the whole 32 bit range of the cycle counter */
+#define PROFILE_SUB_BITS        (3u)
+#define PROFILE_SUB_BUCKETS     (1u << PROFILE_SUB_BITS)
+#define PROFILE_BUCKETS         ((32u - PROFILE_SUB_BITS + 1u) * PROFILE_SUB_BUCKETS)
+
+/* Summary of a region in cycles */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+    uint32_t p99;   /* Upper bound of the histogram bucket of the 99th percentile */
+} profile_summary_t;
+
+/* A region being measured, ended when the scope is left */
+typedef struct
+{
+    profile_region_t region;
+    uint32_t start;
+} profile_scope_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+#ifdef IM_ENABLE_PROFILE
+void profile_end(const profile_scope_t *scope);
+void profile_get(profile_region_t region, profile_summary_t *summary);
+const char* profile_get_name(profile_region_t region);
+void profile_reset(void);
+
+/* Measures the cycles from this statement to the end of the enclosing scope,
+ * including early returns, as one sample of the region */
+#define PROFILE_SCOPE(region) \
+    profile_scope_t profile_scope __attribute__((cleanup(profile_end))) = { (region), cycles_get() }
+
+/* Records the cycles from start, a cycle count taken earlier, e.g. in an
+ * interrupt, to this statement as one sample of the region */
+#define PROFILE_SINCE(region, start) \
+    profile_end(&(profile_scope_t) { (region), (start) })
+#else
+/* Without IM_ENABLE_PROFILE the markers compile to nothing */
+#define PROFILE_SCOPE(region)
+#define PROFILE_SINCE(region, start)
+#endif
+
+#endif /* SOURCE_PROFILE_H_ */
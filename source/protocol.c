@@ -41,7 +41,19 @@
 #include <stdio.h>
 #include "clock.h"
 #include "config.h"
+#include "audio.h"
+#include "imu.h"
+#include "bmm.h"
+#include "dps.h"
+#include "events.h"
+#include "fusion.h"
+#include "calibration.h"
+#include "pipeline.h"
+#include "radar.h"
+#include "profile.h"
 #include "protocol.h"
+#include "stats.h"
+#include "timebase.h"
 
 
 /******************************************************************************
@@ -66,34 +78,74 @@ static const char* CONFIG_MESSAGE =
         "            \"type\": \"microphone\",\r\n"
         "            \"datatype\": \"s16\",\r\n"
         "            \"shape\": [ 1024, 1 ],\r\n"
-        "            \"rates\": [ 16000 ]\r\n"
+#if PDM_SAMPLE_RATE == SAMPLE_RATE_48_KHZ
+        "            \"rates\": [ 8000, 16000, 24000, 48000 ],\r\n"
+#elif PDM_SAMPLE_RATE == SAMPLE_RATE_16_KHZ
+        "            \"rates\": [ 8000, 16000 ],\r\n"
+#else
+        "            \"rates\": [ 8000 ],\r\n"
+#endif
+        "            \"frame_sizes\": [ 128, 256, 512, 1024, 2048 ]\r\n";
+/* The motion sensor entries depend on the selected datatype; an s16 entry
+ * reports the scale of a count in physical units. Each entry also reports
+ * the calibration of the sensor. */
 #if IM_ENABLE_IMU
+static const char* IMU_CONFIG_FORMAT =
         "        },\r\n"
         "        {\r\n"
         "            \"channel\": 2,\r\n"
         "            \"type\": \"accelerometer\",\r\n"
-        "            \"datatype\": \"f32\",\r\n"
+        "            \"datatype\": \"%s\",\r\n"
+        "%s"
+        "%s"
         "            \"shape\": [ 1, 3 ],\r\n"
-        "            \"rates\": [ 50 ]\r\n"
+        "            \"rates\": [ 50, 100, 200, 400, 800, 1600 ],\r\n"
+        "            \"frame_sizes\": [ 1, 2, 4, 8, 16, 32 ]\r\n";
+/* One entry per accelerometer frame: the number of its first sample since
+ * the configuration and the time of that sample on the device clock in
+ * microseconds, corrected for the measured drift of the sensor oscillator */
+static const char* IMU_TIMESTAMP_CONFIG_MESSAGE =
+        "        },\r\n"
+        "        {\r\n"
+        "            \"channel\": 11,\r\n"
+        "            \"type\": \"accelerometer timestamp\",\r\n"
+        "            \"datatype\": \"u32\",\r\n"
+        "            \"shape\": [ 1, 2 ],\r\n"
+        "            \"rates\": [ 50, 100, 200, 400, 800, 1600 ],\r\n"
+        "            \"frame_sizes\": [ 1, 2, 4, 8, 16, 32 ]\r\n";
 #endif
 #if IM_ENABLE_MAG
+static const char* BMM_CONFIG_FORMAT =
         "        },\r\n"
         "        {\r\n"
         "            \"channel\": 3,\r\n"
         "            \"type\": \"Magnetometer\",\r\n"
-        "            \"datatype\": \"f32\",\r\n"
+        "            \"datatype\": \"%s\",\r\n"
+        "%s"
+        "%s"
         "            \"shape\": [ 1, 3 ],\r\n"
-        "            \"rates\": [ 50 ]\r\n"
+        "            \"rates\": [ 50 ]\r\n";
 #endif
-#if IM_ENABLE_RADAR
+#if IM_ENABLE_GYRO
+static const char* GYRO_CONFIG_FORMAT =
         "        },\r\n"
         "        {\r\n"
-        "            \"channel\": 4,\r\n"
-        "            \"type\": \"RADAR\",\r\n"
-        "            \"datatype\": \"s16\",\r\n"
-        "            \"shape\": [ 1, 2048 ],\r\n"
-        "            \"rates\": [ 16 ]\r\n"
+        "            \"channel\": 6,\r\n"
+        "            \"type\": \"gyroscope\",\r\n"
+        "            \"datatype\": \"%s\",\r\n"
+        "%s"
+        "%s"
+        "            \"shape\": [ 1, 3 ],\r\n"
+        "            \"rates\": [ 50, 100, 200, 400, 800, 1600 ],\r\n"
+        "            \"frame_sizes\": [ 1, 2, 4, 8, 16, 32 ]\r\n";
 #endif
+static const char* SCALE_FORMAT =
+        "            \"scale\": %s,\r\n"
+        "            \"offset\": 0,\r\n";
+/* The radar entries depend on the runtime configuration; they are sent
+ * between the motion sensor entries and CONFIG_MESSAGE_END */
+static const char* CONFIG_MESSAGE_END =
+        ""
 #if IM_ENABLE_DPS
         "        },\r\n"
         "        {\r\n"
@@ -101,22 +153,68 @@ static const char* CONFIG_MESSAGE =
         "            \"type\": \"DPS\",\r\n"
         "            \"datatype\": \"f32\",\r\n"
         "            \"shape\": [ 1, 2 ],\r\n"
-        "            \"rates\": [ 50 ]\r\n"
+        "            \"rates\": [ 1, 2, 4, 8, 16, 32, 64, 128 ]\r\n"
 #endif
-#if IM_ENABLE_GYRO
+#if IM_ENABLE_FUSION
         "        },\r\n"
         "        {\r\n"
-        "            \"channel\": 6,\r\n"
-        "            \"type\": \"gyroscope\",\r\n"
+        "            \"channel\": 10,\r\n"
+        "            \"type\": \"orientation\",\r\n"
         "            \"datatype\": \"f32\",\r\n"
-        "            \"shape\": [ 1, 3 ],\r\n"
-        "            \"rates\": [ 50 ]\r\n"
+        "            \"shape\": [ 1, 7 ],\r\n"
+        "            \"rates\": [ 25, 50, 100, 200 ]\r\n"
 #endif
         "        }\r\n"
         "    ]\r\n"
         "}\r\n\0";
+#if IM_ENABLE_RADAR
+static const char* RADAR_CONFIG_FORMAT =
+        "        },\r\n"
+        "        {\r\n"
+        "            \"channel\": 4,\r\n"
+        "            \"type\": \"RADAR\",\r\n"
+        "            \"datatype\": \"s16\",\r\n"
+        "            \"shape\": [ %lu, %lu, %lu ],\r\n"
+        "            \"rates\": [ %s ]\r\n"
+        "        },\r\n"
+        "        {\r\n"
+        "            \"channel\": 7,\r\n"
+        "            \"type\": \"RADAR range profile\",\r\n"
+        "            \"datatype\": \"u16\",\r\n"
+        "            \"shape\": [ %lu, %lu ],\r\n"
+        "            \"rates\": [ %s ]\r\n"
+        "        },\r\n"
+        "        {\r\n"
+        "            \"channel\": 8,\r\n"
+        "            \"type\": \"RADAR range-Doppler map\",\r\n"
+        "            \"datatype\": \"u16\",\r\n"
+        "            \"shape\": [ %lu, %lu ],\r\n"
+        "            \"rates\": [ %s ]\r\n"
+        "        },\r\n"
+        "        {\r\n"
+        "            \"channel\": 9,\r\n"
+        "            \"type\": \"RADAR presence\",\r\n"
+        "            \"datatype\": \"f32\",\r\n"
+        "            \"shape\": [ 1, 2 ],\r\n"
+        "            \"rates\": [ %s ]\r\n";
+#endif
 static const char* OK_MESSAGE = "OK\r\n\0";
 static const char* UNRECOGNIZED_COMMAND_MESSAGE = "ERROR:Unrecognized command\r\n\0";
+static const char* INVALID_ARGUMENT_MESSAGE = "ERROR:Invalid argument\r\n\0";
+static const char* DRIFT_FORMAT = ", \"%s\": { \"ppm\": %s, \"seconds\": %lu }";
+#if IM_ENABLE_STATS
+static const char* STATS_MESSAGE_START = "{ \"channels\": {";
+static const char* STATS_CHANNEL_FORMAT = "%s \"%u\": { \"frames\": %lu, \"bytes\": %lu";
+static const char* STATS_DROPS_FORMAT = ", \"drops\": %lu";
+static const char* STATS_QUEUE_FORMAT = ", \"queue_max\": %lu";
+static const char* STATS_FORMAT = " }, \"transmit\": { \"calls\": %lu, \"blocked_ms\": %lu, \"max_us\": %lu }, \"pdm_overruns\": %lu, \"loop_us\": { \"bounds\": [";
+static const char* STATS_COMMANDS_FORMAT = " ] }, \"commands\": { \"unrecognized\": %lu, \"too_long\": %lu } }\r\n";
+#endif
+#if IM_ENABLE_PROFILE
+static const char* PROFILE_MESSAGE_START = "{ \"unit\": \"cycles\", \"cpu_hz\": %lu, \"regions\": {";
+static const char* PROFILE_REGION_FORMAT = "%s \"%s\": { \"count\": %lu, \"min\": %lu, \"avg\": %lu, \"max\": %lu, \"p99\": %lu }";
+static const char* PROFILE_MESSAGE_END = " } }\r\n";
+#endif
 static const uint8_t CRLF[2] = { '\r', '\n' };
 
 
@@ -131,9 +229,39 @@ static volatile bool subscribe_bmm = false;
 static volatile bool subscribe_dps = false;
 static volatile bool subscribe_radar = false;
 static volatile bool subscribe_gyro = false;
+static volatile bool subscribe_range = false;
+static volatile bool subscribe_doppler = false;
+static volatile bool subscribe_presence = false;
+static volatile bool subscribe_fusion = false;
+static volatile bool subscribe_imu_timestamp = false;
+/* Whether the motion sensor channels send raw s16 counts instead of f32 */
+static bool raw_imu = false;
+static bool raw_bmm = false;
+static bool raw_gyro = false;
+/* f32 values of a motion sensor packet */
+static float scaled_buffer[IMU_AXIS * IMU_FRAME_SIZE_MAX];
 static uint32_t last_receive_time = 0;
 
 
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static size_t protocol_parse_arguments(const char* arguments, uint32_t* values, size_t max_count);
+static bool protocol_parse_datatype(const char* argument, bool* raw);
+static bool protocol_calibrate(const char* arguments);
+static void protocol_send_motion_config(const char* format, bool raw, const char* scale, calibration_sensor_t sensor);
+static void protocol_send_config(void);
+static void protocol_send_drift(void);
+static void protocol_format_ppm(char* buffer, size_t size, int32_t ppb);
+#if IM_ENABLE_STATS
+static void protocol_send_stats(void);
+static void protocol_send_channel_stats(const stats_t* stats, uint8_t channel, const uint32_t* drops, const uint32_t* queue_max);
+#endif
+#if IM_ENABLE_PROFILE
+static void protocol_send_profile(void);
+#endif
+
+
 /*******************************************************************************
 * Function Definitions
 *******************************************************************************/
@@ -159,11 +287,13 @@ void protocol_init()
 *  in a read-eval-print loop. This function may block until a response
 *  transmission is complete.
 *
+* Return:
+*  Whether bytes were received; more may be available.
+*
 *******************************************************************************/
-void protocol_repl()
+bool protocol_repl()
 {
-    /* Update clock */
-    clock_update();
+    PROFILE_SCOPE(PROFILE_PROTOCOL_REPL);
 
     /* Read and handle data if any bytes are available */
     size_t bytes_read = streaming_receive(receive_p, RECEIVE_BUFFER_SIZE - (receive_p - receive_buffer));
@@ -187,6 +317,11 @@ void protocol_repl()
             /* Remove \r\n */
             *(receive_p - 2) = 0;
 
+            /* Commands reconfigure the sensors; hold off their handlers and
+             * send the frames of the previous configuration */
+            events_lock();
+            pipeline_flush();
+
             /* config? */
             if (strcmp(receive_buffer, "config?") == 0)
             {
@@ -196,12 +331,51 @@ void protocol_repl()
                 subscribe_radar = false;
                 subscribe_dps = false;
                 subscribe_gyro = false;
-                streaming_send(CONFIG_MESSAGE, strlen(CONFIG_MESSAGE));
+                subscribe_range = false;
+                subscribe_doppler = false;
+                subscribe_presence = false;
+                subscribe_fusion = false;
+                subscribe_imu_timestamp = false;
+                protocol_send_config();
+            }
+            /* drift? */
+            else if (strcmp(receive_buffer, "drift?") == 0)
+            {
+                protocol_send_drift();
             }
-            /* subscribe,1,16000 */
-            else if (strcmp(receive_buffer, "subscribe,1,16000") == 0)
+#if IM_ENABLE_STATS
+            /* stats? */
+            else if (strcmp(receive_buffer, "stats?") == 0)
             {
-                subscribe_audio = true;
+                protocol_send_stats();
+            }
+#endif
+#if IM_ENABLE_PROFILE
+            /* profile? */
+            else if (strcmp(receive_buffer, "profile?") == 0)
+            {
+                protocol_send_profile();
+            }
+            /* profile,reset */
+            else if (strcmp(receive_buffer, "profile,reset") == 0)
+            {
+                profile_reset();
+                streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+            }
+#endif
+            /* subscribe,1,<rate>[,<frame size>] */
+            else if (strncmp(receive_buffer, "subscribe,1,", 12) == 0)
+            {
+                uint32_t arguments[2] = { 0, FRAME_SIZE };
+                size_t count = protocol_parse_arguments(receive_buffer + 12, arguments, 2);
+                if (count > 0 && CY_RSLT_SUCCESS == pdm_configure(arguments[0], arguments[1]))
+                {
+                    subscribe_audio = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
             }
             /* unsubscribe,1 */
             else if (strcmp(receive_buffer, "unsubscribe,1") == 0)
@@ -210,10 +384,19 @@ void protocol_repl()
                 streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
             }
 #if IM_ENABLE_IMU
-            /* subscribe,2,50 */
-            else if (strcmp(receive_buffer, "subscribe,2,50") == 0)
+            /* subscribe,2,<rate>[,<frame size>] */
+            else if (strncmp(receive_buffer, "subscribe,2,", 12) == 0)
             {
-                subscribe_imu = true;
+                uint32_t arguments[2] = { 0, 1 };
+                size_t count = protocol_parse_arguments(receive_buffer + 12, arguments, 2);
+                if (count > 0 && CY_RSLT_SUCCESS == imu_configure(arguments[0], arguments[1]))
+                {
+                    subscribe_imu = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
             }
             /* unsubscribe,2 */
             else if (strcmp(receive_buffer, "unsubscribe,2") == 0)
@@ -221,6 +404,41 @@ void protocol_repl()
                 subscribe_imu = false;
                 streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
             }
+            /* subscribe,11,<rate>[,<frame size>]; the timestamps follow the
+             * accelerometer frames, so channels 2 and 11 share the
+             * configuration */
+            else if (strncmp(receive_buffer, "subscribe,11,", 13) == 0)
+            {
+                uint32_t arguments[2] = { 0, 1 };
+                size_t count = protocol_parse_arguments(receive_buffer + 13, arguments, 2);
+                if (count > 0 && CY_RSLT_SUCCESS == imu_configure(arguments[0], arguments[1]))
+                {
+                    subscribe_imu_timestamp = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
+            /* unsubscribe,11 */
+            else if (strcmp(receive_buffer, "unsubscribe,11") == 0)
+            {
+                subscribe_imu_timestamp = false;
+                streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+            }
+            /* configure,2,<datatype> */
+            else if (strncmp(receive_buffer, "configure,2,", 12) == 0)
+            {
+                subscribe_imu = false;
+                if (protocol_parse_datatype(receive_buffer + 12, &raw_imu))
+                {
+                    streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
 #endif
 #if IM_ENABLE_MAG
             /* subscribe,3,50 */
@@ -234,12 +452,63 @@ void protocol_repl()
                 subscribe_bmm = false;
                 streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
             }
+            /* configure,3,<datatype> */
+            else if (strncmp(receive_buffer, "configure,3,", 12) == 0)
+            {
+                subscribe_bmm = false;
+                if (protocol_parse_datatype(receive_buffer + 12, &raw_bmm))
+                {
+                    streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
 #endif
 #if IM_ENABLE_RADAR
-            /* subscribe,4,100000 */
-            else if (strcmp(receive_buffer, "subscribe,4,16") == 0)
+            /* configure,4,<samples per chirp>,<chirps per frame>,<rx antennas>,<bandwidth MHz>,<frame rate> */
+            else if (strncmp(receive_buffer, "configure,4,", 12) == 0)
+            {
+                uint32_t arguments[5];
+                radar_config_t config;
+                bool configured = false;
+
+                if (protocol_parse_arguments(receive_buffer + 12, arguments, 5) == 5)
+                {
+                    config.samples = arguments[0];
+                    config.chirps = arguments[1];
+                    config.rx = arguments[2];
+                    config.bandwidth = arguments[3];
+                    config.rate = arguments[4];
+                    configured = CY_RSLT_SUCCESS == radar_configure(&config);
+                }
+                if (configured)
+                {
+                    /* The shapes changed; the host reads them again with config? */
+                    subscribe_radar = false;
+                    subscribe_range = false;
+                    subscribe_doppler = false;
+                    subscribe_presence = false;
+                    streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
+            /* subscribe,4,<rate> */
+            else if (strncmp(receive_buffer, "subscribe,4,", 12) == 0)
             {
-                subscribe_radar = true;
+                uint32_t rate;
+                if (protocol_parse_arguments(receive_buffer + 12, &rate, 1) == 1 && CY_RSLT_SUCCESS == radar_set_rate(rate))
+                {
+                    subscribe_radar = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
             }
             /* unsubscribe,4 */
             else if (strcmp(receive_buffer, "unsubscribe,4") == 0)
@@ -247,12 +516,78 @@ void protocol_repl()
                 subscribe_radar = false;
                 streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
             }
+            /* subscribe,7,<rate> */
+            else if (strncmp(receive_buffer, "subscribe,7,", 12) == 0)
+            {
+                uint32_t rate;
+                if (protocol_parse_arguments(receive_buffer + 12, &rate, 1) == 1 && CY_RSLT_SUCCESS == radar_set_rate(rate))
+                {
+                    subscribe_range = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
+            /* unsubscribe,7 */
+            else if (strcmp(receive_buffer, "unsubscribe,7") == 0)
+            {
+                subscribe_range = false;
+                streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+            }
+            /* subscribe,8,<rate> */
+            else if (strncmp(receive_buffer, "subscribe,8,", 12) == 0)
+            {
+                uint32_t rate;
+                if (protocol_parse_arguments(receive_buffer + 12, &rate, 1) == 1 && CY_RSLT_SUCCESS == radar_set_rate(rate))
+                {
+                    subscribe_doppler = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
+            /* unsubscribe,8 */
+            else if (strcmp(receive_buffer, "unsubscribe,8") == 0)
+            {
+                subscribe_doppler = false;
+                streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+            }
+            /* subscribe,9,<rate> */
+            else if (strncmp(receive_buffer, "subscribe,9,", 12) == 0)
+            {
+                uint32_t rate;
+                if (protocol_parse_arguments(receive_buffer + 12, &rate, 1) == 1 && CY_RSLT_SUCCESS == radar_set_rate(rate))
+                {
+                    subscribe_presence = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
+            /* unsubscribe,9 */
+            else if (strcmp(receive_buffer, "unsubscribe,9") == 0)
+            {
+                subscribe_presence = false;
+                streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+            }
 #endif
 #if IM_ENABLE_DPS
-            /* subscribe,5,50 */
-            else if (strcmp(receive_buffer, "subscribe,5,50") == 0)
+            /* subscribe,5,<rate>[,<oversampling>] */
+            else if (strncmp(receive_buffer, "subscribe,5,", 12) == 0)
             {
-                subscribe_dps = true;
+                uint32_t arguments[2] = { 0, 0 };
+                size_t count = protocol_parse_arguments(receive_buffer + 12, arguments, 2);
+                if (count > 0 && CY_RSLT_SUCCESS == dps_configure(arguments[0], arguments[1]))
+                {
+                    subscribe_dps = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
             }
             /* unsubscribe,5 */
             else if (strcmp(receive_buffer, "unsubscribe,5") == 0)
@@ -262,10 +597,20 @@ void protocol_repl()
             }
 #endif
 #if IM_ENABLE_GYRO
-            /* subscribe,6,50 */
-            else if (strcmp(receive_buffer, "subscribe,6,50") == 0)
+            /* subscribe,6,<rate>[,<frame size>]; the gyroscope is read with
+             * the accelerometer, so channels 2 and 6 share the configuration */
+            else if (strncmp(receive_buffer, "subscribe,6,", 12) == 0)
             {
-                subscribe_gyro = true;
+                uint32_t arguments[2] = { 0, 1 };
+                size_t count = protocol_parse_arguments(receive_buffer + 12, arguments, 2);
+                if (count > 0 && CY_RSLT_SUCCESS == imu_configure(arguments[0], arguments[1]))
+                {
+                    subscribe_gyro = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
             }
             /* unsubscribe,6 */
             else if (strcmp(receive_buffer, "unsubscribe,6") == 0)
@@ -273,6 +618,57 @@ void protocol_repl()
                 subscribe_gyro = false;
                 streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
             }
+            /* configure,6,<datatype> */
+            else if (strncmp(receive_buffer, "configure,6,", 12) == 0)
+            {
+                subscribe_gyro = false;
+                if (protocol_parse_datatype(receive_buffer + 12, &raw_gyro))
+                {
+                    streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
+#endif
+#if IM_ENABLE_FUSION
+            /* subscribe,10,<rate> */
+            else if (strncmp(receive_buffer, "subscribe,10,", 13) == 0)
+            {
+                uint32_t rate;
+                /* Raising the IMU rate keeps the frame size of channels 2, 6 and 11 */
+                if (protocol_parse_arguments(receive_buffer + 13, &rate, 1) == 1 && fusion_configure(rate) &&
+                    (imu_get_rate() >= FUSION_IMU_RATE ||
+                     CY_RSLT_SUCCESS == imu_configure(FUSION_IMU_RATE, imu_get_frame_size())))
+                {
+                    subscribe_fusion = true;
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
+            /* unsubscribe,10 */
+            else if (strcmp(receive_buffer, "unsubscribe,10") == 0)
+            {
+                subscribe_fusion = false;
+                streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+            }
+#endif
+#if IM_ENABLE_CALIBRATION
+            /* calibrate,<channel>[,reset] */
+            else if (strncmp(receive_buffer, "calibrate,", 10) == 0)
+            {
+                if (protocol_calibrate(receive_buffer + 10))
+                {
+                    streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
+                }
+                else
+                {
+                    streaming_send(INVALID_ARGUMENT_MESSAGE, strlen(INVALID_ARGUMENT_MESSAGE));
+                }
+            }
 #endif
             /* unsubscribe */
             else if (strcmp(receive_buffer, "unsubscribe") == 0)
@@ -283,6 +679,11 @@ void protocol_repl()
                 subscribe_radar = false;
                 subscribe_dps = false;
                 subscribe_gyro = false;
+                subscribe_range = false;
+                subscribe_doppler = false;
+                subscribe_presence = false;
+                subscribe_fusion = false;
+                subscribe_imu_timestamp = false;
                 streaming_send(OK_MESSAGE, strlen(OK_MESSAGE));
             }
             /* empty command or heartbeat */
@@ -292,9 +693,12 @@ void protocol_repl()
             }
             else
             {
+                stats_unrecognized();
                 streaming_send(UNRECOGNIZED_COMMAND_MESSAGE, strlen(UNRECOGNIZED_COMMAND_MESSAGE));
             }
 
+            events_unlock();
+
             /* Reset receive pointer; ready for new command */
             receive_p = receive_buffer;
         }
@@ -302,13 +706,14 @@ void protocol_repl()
         /* Check end of buffer */
         if (receive_p == receive_buffer + RECEIVE_BUFFER_SIZE)
         {
+            stats_too_long();
             streaming_send(TOO_LONG_COMMAND_MESSAGE, strlen(TOO_LONG_COMMAND_MESSAGE));
             receive_p = receive_buffer;
         }
     }
 
     /* Check receive timeout: If no message for 5 seconds, stop streaming */
-    if ((subscribe_audio || subscribe_imu || subscribe_bmm || subscribe_radar || subscribe_dps || subscribe_gyro) && clock_get_ms() - last_receive_time > HEARTBEAT_TIMEOUT_MS)
+    if ((subscribe_audio || subscribe_imu || subscribe_bmm || subscribe_radar || subscribe_dps || subscribe_gyro || subscribe_range || subscribe_doppler || subscribe_presence || subscribe_fusion || subscribe_imu_timestamp) && clock_get_ms() - last_receive_time > HEARTBEAT_TIMEOUT_MS)
     {
         subscribe_audio = false;
         subscribe_imu = false;
@@ -316,7 +721,434 @@ void protocol_repl()
         subscribe_radar = false;
         subscribe_dps = false;
         subscribe_gyro = false;
+        subscribe_range = false;
+        subscribe_doppler = false;
+        subscribe_presence = false;
+        subscribe_fusion = false;
+        subscribe_imu_timestamp = false;
+    }
+
+    return bytes_read > 0;
+}
+
+/*******************************************************************************
+* Function Name: protocol_parse_arguments
+********************************************************************************
+* Summary:
+*  Parses the comma separated unsigned integer arguments of a command, e.g.
+*  "16000,256" of "subscribe,1,16000,256".
+*
+* Parameters:
+*  arguments: the argument string
+*  values: array receiving the parsed values
+*  max_count: the number of elements in values
+*
+* Return:
+*  The number of values parsed; 0 if the string is malformed or holds more than
+*  max_count values.
+*
+*******************************************************************************/
+static size_t protocol_parse_arguments(const char* arguments, uint32_t* values, size_t max_count)
+{
+    size_t count = 0;
+    char* end;
+
+    while (count < max_count)
+    {
+        if (*arguments < '0' || *arguments > '9')
+        {
+            return 0;
+        }
+        values[count++] = strtoul(arguments, &end, 10);
+        if (*end == 0)
+        {
+            return count;
+        }
+        if (*end != ',')
+        {
+            return 0;
+        }
+        arguments = end + 1;
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+* Function Name: protocol_parse_datatype
+********************************************************************************
+* Summary:
+*  Parses the datatype argument of a motion sensor configure command, "s16"
+*  for raw counts or "f32" for physical units.
+*
+* Parameters:
+*  argument: the argument string
+*  raw: receives whether raw counts are selected; unchanged on error
+*
+* Return:
+*  Whether the argument is a supported datatype.
+*
+*******************************************************************************/
+static bool protocol_parse_datatype(const char* argument, bool* raw)
+{
+    if (strcmp(argument, "s16") == 0)
+    {
+        *raw = true;
+        return true;
+    }
+    if (strcmp(argument, "f32") == 0)
+    {
+        *raw = false;
+        return true;
+    }
+    return false;
+}
+
+/*******************************************************************************
+* Function Name: protocol_calibrate
+********************************************************************************
+* Summary:
+*  Handles the arguments of a calibrate command: a motion sensor channel, 2, 3
+*  or 6, to start a capture of its calibration, optionally followed by
+*  "reset" to remove its calibration.
+*
+* Parameters:
+*  arguments: the argument string
+*
+* Return:
+*  Whether the command was accepted.
+*
+*******************************************************************************/
+static bool protocol_calibrate(const char* arguments)
+{
+    calibration_sensor_t sensor;
+
+    switch (arguments[0])
+    {
+#if IM_ENABLE_IMU
+    case '0' + PROTOCOL_IMU_CHANNEL:
+        sensor = CALIBRATION_ACCEL;
+        break;
+#endif
+#if IM_ENABLE_MAG
+    case '0' + PROTOCOL_BMM_CHANNEL:
+        sensor = CALIBRATION_MAG;
+        break;
+#endif
+#if IM_ENABLE_GYRO
+    case '0' + PROTOCOL_GYRO_CHANNEL:
+        sensor = CALIBRATION_GYRO;
+        break;
+#endif
+    default:
+        return false;
+    }
+
+    if (arguments[1] == 0)
+    {
+        return CY_RSLT_SUCCESS == calibration_start(sensor);
+    }
+    if (strcmp(arguments + 1, ",reset") == 0)
+    {
+        return CY_RSLT_SUCCESS == calibration_reset(sensor);
+    }
+    return false;
+}
+
+/*******************************************************************************
+* Function Name: protocol_send_motion_config
+********************************************************************************
+* Summary:
+*  Sends the config? entry of a motion sensor channel with its datatype, the
+*  scale of a count for raw counts, and its calibration.
+*
+* Parameters:
+*  format: the entry with datatype, scale and calibration placeholders
+*  raw: whether the channel sends raw counts
+*  scale: the physical units per count
+*  sensor: the sensor of the channel
+*
+*******************************************************************************/
+static void protocol_send_motion_config(const char* format, bool raw, const char* scale, calibration_sensor_t sensor)
+{
+    char scale_message[64] = "";
+    char calibration_message[192];
+    char message[576];
+    int length;
+
+    if (raw)
+    {
+        snprintf(scale_message, sizeof(scale_message), SCALE_FORMAT, scale);
+    }
+    calibration_describe(sensor, calibration_message, sizeof(calibration_message));
+    length = snprintf(message, sizeof(message), format, raw ? "s16" : "f32", scale_message, calibration_message);
+    streaming_send(message, length);
+}
+
+/*******************************************************************************
+* Function Name: protocol_send_config
+********************************************************************************
+* Summary:
+*  Sends the config? response. The motion sensor entries are generated from
+*  the selected datatypes and the radar entries from the current radar
+*  configuration.
+*
+*******************************************************************************/
+static void protocol_send_config(void)
+{
+#if IM_ENABLE_RADAR
+    const radar_config_t *config = radar_get_config();
+    char rates[48];
+    char* rates_p = rates;
+    char radar_message[1024];
+    int length;
+
+    /* The configured frame rate divided by 8, 4, 2 and 1 */
+    for (uint32_t divider = 8; divider > 0; divider >>= 1)
+    {
+        if (config->rate % divider == 0 && config->rate / divider > 0)
+        {
+            rates_p += sprintf(rates_p, rates_p == rates ? "%lu" : ", %lu", (unsigned long) (config->rate / divider));
+        }
+    }
+
+    length = snprintf(radar_message, sizeof(radar_message), RADAR_CONFIG_FORMAT,
+                      (unsigned long) config->rx, (unsigned long) config->chirps, (unsigned long) config->samples, rates,
+                      (unsigned long) config->chirps, (unsigned long) (config->samples / 2), rates,
+                      (unsigned long) config->chirps, (unsigned long) (config->samples / 2), rates,
+                      rates);
+#endif
+
+    streaming_send(CONFIG_MESSAGE, strlen(CONFIG_MESSAGE));
+#if IM_ENABLE_IMU
+    protocol_send_motion_config(IMU_CONFIG_FORMAT, raw_imu, IMU_ACCEL_SCALE_STRING, CALIBRATION_ACCEL);
+    streaming_send(IMU_TIMESTAMP_CONFIG_MESSAGE, strlen(IMU_TIMESTAMP_CONFIG_MESSAGE));
+#endif
+#if IM_ENABLE_MAG
+    protocol_send_motion_config(BMM_CONFIG_FORMAT, raw_bmm, BMM_SCALE_STRING, CALIBRATION_MAG);
+#endif
+#if IM_ENABLE_GYRO
+    protocol_send_motion_config(GYRO_CONFIG_FORMAT, raw_gyro, GYRO_SCALE_STRING, CALIBRATION_GYRO);
+#endif
+#if IM_ENABLE_RADAR
+    streaming_send(radar_message, length);
+#endif
+    streaming_send(CONFIG_MESSAGE_END, strlen(CONFIG_MESSAGE_END));
+}
+
+/*******************************************************************************
+* Function Name: protocol_send_drift
+********************************************************************************
+* Summary:
+*  Sends the drift? response: the correction applied to the disciplined sensor
+*  timers, and the drift of the audio and IMU clocks against the timebase with
+*  the length of each measurement. A clock that has not run long enough is
+*  left out. Subscriptions are kept, so the drift can be followed while
+*  streaming.
+*
+*******************************************************************************/
+static void protocol_send_drift(void)
+{
+    char message[192];
+    char ppm[16];
+    int32_t ppb;
+    uint32_t seconds;
+    int length;
+
+    protocol_format_ppm(ppm, sizeof(ppm), timebase_get_correction());
+    length = snprintf(message, sizeof(message), "{ \"correction\": %s", ppm);
+    if (pdm_get_drift(&ppb, &seconds))
+    {
+        protocol_format_ppm(ppm, sizeof(ppm), ppb);
+        length += snprintf(message + length, sizeof(message) - length, DRIFT_FORMAT, "audio", ppm, (unsigned long) seconds);
+    }
+#if IM_ENABLE_IMU
+    if (imu_get_drift(&ppb, &seconds))
+    {
+        protocol_format_ppm(ppm, sizeof(ppm), ppb);
+        length += snprintf(message + length, sizeof(message) - length, DRIFT_FORMAT, "imu", ppm, (unsigned long) seconds);
+    }
+#endif
+    length += snprintf(message + length, sizeof(message) - length, " }\r\n");
+    streaming_send(message, length);
+}
+
+#if IM_ENABLE_STATS
+/*******************************************************************************
+* Function Name: protocol_send_stats
+********************************************************************************
+* Summary:
+*  Sends the stats? response: the frames, bytes, drops and queue high-water
+*  marks of the enabled channels, the time spent blocked in streaming_send,
+*  the PDM overruns, the histogram of the main loop iteration times and the
+*  rejected commands. Subscriptions are kept, so the counters can be followed
+*  while streaming.
+*
+*******************************************************************************/
+static void protocol_send_stats(void)
+{
+    char message[320];
+    uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+    uint32_t drops;
+    uint32_t queue_max;
+#if IM_ENABLE_MAG
+    event_stats_t event_stats;
+#endif
+    stats_t stats;
+    int length;
+
+    stats_get(&stats);
+
+    /* The channels of a sensor share its drops and ring, which are reported
+     * with its first channel only */
+    streaming_send(STATS_MESSAGE_START, strlen(STATS_MESSAGE_START));
+    drops = pdm_get_overruns();
+    queue_max = pdm_get_queue_max();
+    protocol_send_channel_stats(&stats, PROTOCOL_AUDIO_CHANNEL, &drops, &queue_max);
+#if IM_ENABLE_IMU
+    drops = imu_get_dropped();
+    queue_max = imu_get_queue_max();
+    protocol_send_channel_stats(&stats, PROTOCOL_IMU_CHANNEL, &drops, &queue_max);
+#endif
+#if IM_ENABLE_MAG
+    /* The magnetometer is read once per post, so a merged post is a lost
+     * sample */
+    events_get_stats(EVENT_MAG, &event_stats);
+    protocol_send_channel_stats(&stats, PROTOCOL_BMM_CHANNEL, &event_stats.coalesced, NULL);
+#endif
+#if IM_ENABLE_RADAR
+    drops = radar_get_dropped();
+    protocol_send_channel_stats(&stats, PROTOCOL_RADAR_CHANNEL, &drops, NULL);
+#endif
+#if IM_ENABLE_DPS
+    drops = dps_get_dropped();
+    queue_max = dps_get_queue_max();
+    protocol_send_channel_stats(&stats, PROTOCOL_DPS_CHANNEL, &drops, &queue_max);
+#endif
+#if IM_ENABLE_GYRO
+    protocol_send_channel_stats(&stats, PROTOCOL_GYRO_CHANNEL, NULL, NULL);
+#endif
+#if IM_ENABLE_RADAR
+    protocol_send_channel_stats(&stats, PROTOCOL_RADAR_RANGE_CHANNEL, NULL, NULL);
+    protocol_send_channel_stats(&stats, PROTOCOL_RADAR_DOPPLER_CHANNEL, NULL, NULL);
+    protocol_send_channel_stats(&stats, PROTOCOL_RADAR_PRESENCE_CHANNEL, NULL, NULL);
+#endif
+#if IM_ENABLE_FUSION
+    /* The filter runs on the IMU frames, so it misses the frames the IMU ring
+     * lost */
+    protocol_send_channel_stats(&stats, PROTOCOL_FUSION_CHANNEL, NULL, NULL);
+#endif
+#if IM_ENABLE_IMU
+    protocol_send_channel_stats(&stats, PROTOCOL_IMU_TIMESTAMP_CHANNEL, NULL, NULL);
+#endif
+
+    length = snprintf(message, sizeof(message), STATS_FORMAT, (unsigned long) stats.transmit_count,
+                      (unsigned long) (stats.transmit_cycles / (cycles_per_us * 1000u)),
+                      (unsigned long) (stats.transmit_max / cycles_per_us), (unsigned long) pdm_get_overruns());
+    for (uint32_t i = 0; i < STATS_LOOP_BUCKETS - 1; i++)
+    {
+        length += snprintf(message + length, sizeof(message) - length, "%s %lu", i > 0 ? "," : "",
+                           (unsigned long) (STATS_LOOP_MIN_US << i));
+    }
+    length += snprintf(message + length, sizeof(message) - length, " ], \"counts\": [");
+    streaming_send(message, length);
+
+    length = 0;
+    for (uint32_t i = 0; i < STATS_LOOP_BUCKETS; i++)
+    {
+        length += snprintf(message + length, sizeof(message) - length, "%s %lu", i > 0 ? "," : "",
+                           (unsigned long) stats.loop[i]);
     }
+    length += snprintf(message + length, sizeof(message) - length, STATS_COMMANDS_FORMAT,
+                       (unsigned long) stats.unrecognized, (unsigned long) stats.too_long);
+    streaming_send(message, length);
+}
+
+/*******************************************************************************
+* Function Name: protocol_send_channel_stats
+********************************************************************************
+* Summary:
+*  Sends the counters of a channel as part of the stats? response.
+*
+* Parameters:
+*  stats: the counters
+*  channel: the channel (1-11); all but the audio channel are preceded by a comma
+*  drops: frames or samples of the channel's sensor that were lost, or NULL if
+*         they are reported with another channel of the sensor
+*  queue_max: high-water mark of the sensor's ring, or NULL if it has none or
+*             it is reported with another channel of the sensor
+*
+*******************************************************************************/
+static void protocol_send_channel_stats(const stats_t* stats, uint8_t channel, const uint32_t* drops, const uint32_t* queue_max)
+{
+    char message[128];
+    int length;
+
+    length = snprintf(message, sizeof(message), STATS_CHANNEL_FORMAT, channel == PROTOCOL_AUDIO_CHANNEL ? "" : ",",
+                      channel, (unsigned long) stats->frames[channel - 1], (unsigned long) stats->bytes[channel - 1]);
+    if (NULL != drops)
+    {
+        length += snprintf(message + length, sizeof(message) - length, STATS_DROPS_FORMAT, (unsigned long) *drops);
+    }
+    if (NULL != queue_max)
+    {
+        length += snprintf(message + length, sizeof(message) - length, STATS_QUEUE_FORMAT, (unsigned long) *queue_max);
+    }
+    length += snprintf(message + length, sizeof(message) - length, " }");
+    streaming_send(message, length);
+}
+#endif
+
+#if IM_ENABLE_PROFILE
+/*******************************************************************************
+* Function Name: protocol_send_profile
+********************************************************************************
+* Summary:
+*  Sends the profile? response: the number of calls and the minimum, average,
+*  maximum and 99th percentile cycles of each profiled function since start-up
+*  or the last profile,reset. Subscriptions are kept, so the functions can be
+*  profiled while streaming.
+*
+*******************************************************************************/
+static void protocol_send_profile(void)
+{
+    char message[192];
+    profile_summary_t summary;
+    int length;
+
+    length = snprintf(message, sizeof(message), PROFILE_MESSAGE_START, (unsigned long) SystemCoreClock);
+    streaming_send(message, length);
+    for (uint32_t region = 0; region < PROFILE_REGION_COUNT; region++)
+    {
+        profile_get((profile_region_t) region, &summary);
+        length = snprintf(message, sizeof(message), PROFILE_REGION_FORMAT, region > 0 ? "," : "",
+                          profile_get_name((profile_region_t) region), (unsigned long) summary.count,
+                          (unsigned long) summary.min, (unsigned long) summary.avg, (unsigned long) summary.max,
+                          (unsigned long) summary.p99);
+        streaming_send(message, length);
+    }
+    streaming_send(PROFILE_MESSAGE_END, strlen(PROFILE_MESSAGE_END));
+}
+#endif
+
+/*******************************************************************************
+* Function Name: protocol_format_ppm
+********************************************************************************
+* Summary:
+*  Formats parts per billion as parts per million with three decimals.
+*
+* Parameters:
+*  buffer: receives the text
+*  size: size of the buffer
+*  ppb: the value in parts per billion
+*
+*******************************************************************************/
+static void protocol_format_ppm(char* buffer, size_t size, int32_t ppb)
+{
+    uint32_t magnitude = ppb < 0 ? -(uint32_t) ppb : (uint32_t) ppb;
+
+    snprintf(buffer, size, "%s%lu.%03lu", ppb < 0 ? "-" : "",
+             (unsigned long) (magnitude / 1000000), (unsigned long) (magnitude % 1000000 / 1000));
 }
 
 /*******************************************************************************
@@ -327,14 +1159,19 @@ void protocol_repl()
 *  transmission is complete.
 *
 * Parameters:
-*  channel: the channel (1-9) to send the packet on
+*  channel: the channel (1-11) to send the packet on
 *  data: pointer to data to send
 *  size: number of bytes to send
 *
 *******************************************************************************/
 void protocol_send(uint8_t channel, const uint8_t* data, size_t size)
 {
-    uint8_t header[2] = { 'B', '0' + channel };
+    uint8_t header[2] = { 'B', PROTOCOL_CHANNEL_CHAR(channel) };
+
+    if (protocol_is_subscribed(channel))
+    {
+        stats_frame(channel, PROTOCOL_HEADER_SIZE + size + PROTOCOL_TRAILER_SIZE);
+    }
     switch (channel)
     {
     case PROTOCOL_AUDIO_CHANNEL:
@@ -385,5 +1222,136 @@ void protocol_send(uint8_t channel, const uint8_t* data, size_t size)
             streaming_send(CRLF, 2);
         }
         break;
+    case PROTOCOL_RADAR_PRESENCE_CHANNEL:
+        if (subscribe_presence)
+        {
+            streaming_send(header, 2);
+            streaming_send(data, size);
+            streaming_send(CRLF, 2);
+        }
+        break;
+    case PROTOCOL_FUSION_CHANNEL:
+        if (subscribe_fusion)
+        {
+            streaming_send(header, 2);
+            streaming_send(data, size);
+            streaming_send(CRLF, 2);
+        }
+        break;
+    case PROTOCOL_IMU_TIMESTAMP_CHANNEL:
+        if (subscribe_imu_timestamp)
+        {
+            streaming_send(header, 2);
+            streaming_send(data, size);
+            streaming_send(CRLF, 2);
+        }
+        break;
+    }
+}
+
+/*******************************************************************************
+* Function Name: protocol_send_counts
+********************************************************************************
+* Summary:
+*  Sends a packet of motion sensor counts to the host, as they are if the
+*  channel is configured for s16 and otherwise multiplied by the scale as f32.
+*  This function may block until the transmission is complete.
+*
+* Parameters:
+*  channel: the motion sensor channel (2, 3 or 6) to send the packet on
+*  data: pointer to the counts to send
+*  count: number of counts, at most IMU_AXIS * IMU_FRAME_SIZE_MAX
+*  scale: the physical units per count
+*
+*******************************************************************************/
+void protocol_send_counts(uint8_t channel, const int16_t* data, size_t count, float scale)
+{
+    bool raw = (channel == PROTOCOL_IMU_CHANNEL && raw_imu) ||
+               (channel == PROTOCOL_BMM_CHANNEL && raw_bmm) ||
+               (channel == PROTOCOL_GYRO_CHANNEL && raw_gyro);
+
+    if (!protocol_is_subscribed(channel))
+    {
+        return;
+    }
+
+    if (raw)
+    {
+        protocol_send(channel, (const uint8_t*) data, count * sizeof(int16_t));
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        scaled_buffer[i] = data[i] * scale;
+    }
+    protocol_send(channel, (const uint8_t*) scaled_buffer, count * sizeof(float));
+}
+
+/*******************************************************************************
+* Function Name: protocol_send_packet
+********************************************************************************
+* Summary:
+*  Sends a packet of data to the host in a single transfer. The caller reserves
+*  PROTOCOL_HEADER_SIZE bytes before and PROTOCOL_TRAILER_SIZE bytes after the
+*  data, which this function fills in. This function may block until the
+*  transmission is complete.
+*
+* Parameters:
+*  channel: the channel (1-11) to send the packet on
+*  packet: pointer to the packet, starting with the reserved header
+*  size: number of data bytes, excluding header and trailer
+*
+*******************************************************************************/
+void protocol_send_packet(uint8_t channel, uint8_t* packet, size_t size)
+{
+    if (protocol_is_subscribed(channel))
+    {
+        packet[0] = 'B';
+        packet[1] = PROTOCOL_CHANNEL_CHAR(channel);
+        memcpy(packet + PROTOCOL_HEADER_SIZE + size, CRLF, PROTOCOL_TRAILER_SIZE);
+        stats_frame(channel, PROTOCOL_HEADER_SIZE + size + PROTOCOL_TRAILER_SIZE);
+        streaming_send(packet, PROTOCOL_HEADER_SIZE + size + PROTOCOL_TRAILER_SIZE);
+    }
+}
+
+/*******************************************************************************
+* Function Name: protocol_is_subscribed
+********************************************************************************
+* Summary:
+*  Returns whether the host is subscribed to the given channel.
+*
+* Parameters:
+*  channel: the channel (1-11)
+*
+*******************************************************************************/
+bool protocol_is_subscribed(uint8_t channel)
+{
+    switch (channel)
+    {
+    case PROTOCOL_AUDIO_CHANNEL:
+        return subscribe_audio;
+    case PROTOCOL_IMU_CHANNEL:
+        return subscribe_imu;
+    case PROTOCOL_BMM_CHANNEL:
+        return subscribe_bmm;
+    case PROTOCOL_RADAR_CHANNEL:
+        return subscribe_radar;
+    case PROTOCOL_DPS_CHANNEL:
+        return subscribe_dps;
+    case PROTOCOL_GYRO_CHANNEL:
+        return subscribe_gyro;
+    case PROTOCOL_RADAR_RANGE_CHANNEL:
+        return subscribe_range;
+    case PROTOCOL_RADAR_DOPPLER_CHANNEL:
+        return subscribe_doppler;
+    case PROTOCOL_RADAR_PRESENCE_CHANNEL:
+        return subscribe_presence;
+    case PROTOCOL_FUSION_CHANNEL:
+        return subscribe_fusion;
+    case PROTOCOL_IMU_TIMESTAMP_CHANNEL:
+        return subscribe_imu_timestamp;
+    default:
+        return false;
     }
 }
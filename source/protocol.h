@@ -49,9 +49,24 @@
 #define PROTOCOL_RADAR_CHANNEL 4
 #define PROTOCOL_DPS_CHANNEL 5
 #define PROTOCOL_GYRO_CHANNEL 6
+#define PROTOCOL_RADAR_RANGE_CHANNEL 7
+#define PROTOCOL_RADAR_DOPPLER_CHANNEL 8
+#define PROTOCOL_RADAR_PRESENCE_CHANNEL 9
+#define PROTOCOL_FUSION_CHANNEL 10
+#define PROTOCOL_IMU_TIMESTAMP_CHANNEL 11
+
+/* Channels above 9 are sent as 'A', 'B', ... */
+#define PROTOCOL_CHANNEL_CHAR(channel) ((channel) < 10 ? '0' + (channel) : 'A' + (channel) - 10)
+
+/* Size of the header ('B' and channel) and trailer (CRLF) of a data packet */
+#define PROTOCOL_HEADER_SIZE 2
+#define PROTOCOL_TRAILER_SIZE 2
 
 void protocol_init();
-void protocol_repl();
+bool protocol_repl();
 void protocol_send(uint8_t channel, const uint8_t* data, size_t count);
+void protocol_send_counts(uint8_t channel, const int16_t* data, size_t count, float scale);
+void protocol_send_packet(uint8_t channel, uint8_t* packet, size_t count);
+bool protocol_is_subscribed(uint8_t channel);
 
 #endif /* SOURCE_PROTOCOL_H_ */
@@ -1,8 +1,10 @@
 /******************************************************************************
 * File Name:   radar.c
 *
-* Description: This file implements the interface with the radar sensor, as
-*              a timer to feed the pre-processor at 100000Hz.
+* Description: This file implements the interface with the radar sensor. Frames
+*              are read by DMA as soon as the sensor signals a full frame in
+*              its FIFO, and unpacked into a pool of transmit packets. The frame
+*              geometry and rate can be reconfigured at runtime.
 *
 * Related Document: See README.md
 *
@@ -47,23 +49,39 @@
 #include <stdlib.h>
 #include "cy_pdl.h"
 #include "xensiv_bgt60trxx_mtb.h"
-#include "radar_settings.h"
+#include "radar_dsp.h"
+#include "radar_presence.h"
+#include "bus.h"
+#include "events.h"
+#include "profile.h"
+#include "protocol.h"
 #include "config.h"
+#include "timebase.h"
 
 /*******************************************************************************
 * Macros
 *******************************************************************************/
 
-#define NUM_SAMPLES_PER_FRAME               (XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP *\
-                                             XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME *\
-                                             XENSIV_BGT60TRXX_CONF_NUM_RX_ANTENNAS)
+#define RADAR_INTERRUPT_PRIORITY            7
 
-#define NUM_CHIRPS_PER_FRAME                XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME
-#define NUM_SAMPLES_PER_CHIRP               XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP
-#define RADAR_SCAN_RATE                     16
-#define RADAR_TIMER_FREQUENCY               100000
-#define RADAR_TIMER_PERIOD                  (RADAR_TIMER_FREQUENCY/RADAR_SCAN_RATE)
-#define RADAR_TIMER_PRIORITY                7
+/* The FIFO is read with a single burst: a 4 byte command, during which the
+ * sensor returns its GSR0 status, followed by the samples packed as two 12 bit
+ * samples in 3 bytes. With more than one antenna the FIFO interleaves the
+ * antennas sample by sample. The burst lands next to the packet and is
+ * unpacked and de-interleaved into the payload in a single pass. */
+#define RADAR_BURST_COMMAND_SIZE            4
+#define RADAR_BURST_MAX_SIZE                (RADAR_BURST_COMMAND_SIZE + RADAR_MAX_FRAME_SAMPLES * 3 / 2)
+#define RADAR_PACKET_SIZE                   (PROTOCOL_HEADER_SIZE + 2 * RADAR_MAX_FRAME_SAMPLES + PROTOCOL_TRAILER_SIZE)
+
+/* Number of packets in the pool; one can be filled by DMA while the other one
+ * is transmitted */
+#define RADAR_POOL_SIZE                     2
+
+/* States of a packet in the pool */
+#define RADAR_PACKET_FREE                   0
+#define RADAR_PACKET_FILLING                1
+#define RADAR_PACKET_READY                  2
+#define RADAR_PACKET_IN_USE                 3
 
 /*******************************************************************************
 * Global Variables
@@ -71,15 +89,65 @@
 #ifdef IM_ENABLE_RADAR
 static xensiv_bgt60trxx_mtb_t bgt60_obj;
 #endif
-uint16_t bgt60_buffer[NUM_SAMPLES_PER_FRAME] __attribute__((aligned(2)));
-/* timer used for getting data */
-cyhal_timer_t radar_timer;
+
+/* Current configuration, and the sizes of a frame derived from it */
+static radar_config_t radar_config;
+static uint32_t frame_samples;
+static uint32_t burst_size;
+
+/* A transmit packet and the burst it is unpacked from */
+typedef struct
+{
+    uint8_t packet[RADAR_PACKET_SIZE];
+    uint8_t burst[RADAR_BURST_MAX_SIZE];
+} radar_buffer_t;
+
+/* Buffers are filled and consumed in order, so two indices suffice */
+static radar_buffer_t radar_buffers[RADAR_POOL_SIZE] __attribute__((aligned(4)));
+static volatile uint8_t packet_state[RADAR_POOL_SIZE];
+static volatile uint32_t fill_index = 0;
+static uint32_t read_index = 0;
+
+/* FIFO burst read command, in transmission order */
+static uint8_t burst_command[RADAR_BURST_COMMAND_SIZE];
+
+/* The sensor on the radar bus, and the burst read queued on it */
+static bus_device_t radar_device;
+static bus_transaction_t radar_transaction;
+
+/* Set while recovering from an overflow or reconfiguring; no transfers or
+ * frames are started */
+static volatile bool stopped = false;
+
+/* After a runtime configuration the sensor acquires a single frame each time
+ * it is started, and radar_timer starts the frames */
+static bool triggered = false;
+static timebase_timer_t radar_timer;
+
+/* Only every frame_divider'th frame is passed on, see radar_set_rate */
+static uint32_t frame_divider = 1;
+static uint32_t frame_count = 0;
+
+/* Number of FIFO overflows the sensor has been recovered from */
+static uint32_t overflows = 0;
+
+/* Frames the timer did not start because no packet was free, and frames
+ * dropped from the pool by an overflow recovery */
+static volatile uint32_t skipped = 0;
+static uint32_t flushed = 0;
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-void radar_interrupt_handler(void* callback_arg, cyhal_timer_event_t event);
-cy_rslt_t radar_timer_init(void);
+void radar_interrupt_handler(void* callback_arg, cyhal_gpio_event_t event);
+void radar_transfer_handler(bus_transaction_t *transaction, cy_rslt_t result);
+void radar_timer_handler(void *arg);
+void radar_start_transfer(void);
+void radar_set_geometry(void);
+cy_rslt_t radar_stop(void);
+void radar_pool_reset(void);
+void radar_unpack(const uint8_t *in, uint16_t *out);
+cy_rslt_t radar_fifo_recover(void);
 
 
 /*******************************************************************************
@@ -88,7 +156,9 @@ cy_rslt_t radar_timer_init(void);
 * Summary:
 *    A function used to initialize the Radar sensor Present in 
 *    Ai Evaluation Kit(CY8CKIT-062S2-AI).
-*    Starts a timer that triggers an interrupt at 100000Hz.
+*    Sets up DMA transfers on the radar bus, enables the FIFO interrupt, which
+*    triggers each time a complete frame is in the sensor FIFO, and starts the
+*    frame generation in the default configuration.
 *
 * Parameters:
 *   None
@@ -100,8 +170,13 @@ cy_rslt_t radar_timer_init(void);
 *******************************************************************************/
 cy_rslt_t radar_init(void)
 {
-    cy_rslt_t result;
 #ifdef IM_ENABLE_RADAR
+        uint32_t command = XENSIV_BGT60TRXX_SPI_BURST_MODE_CMD |
+                           (XENSIV_BGT60TRXX_REG_FIFO_TR13C << XENSIV_BGT60TRXX_SPI_BURST_MODE_SADR_POS);
+
+        radar_config_get_default(&radar_config);
+        radar_set_geometry();
+
         /* Reduce drive strength to improve EMI */
         Cy_GPIO_SetSlewRate(CYHAL_GET_PORTADDR(CYBSP_RSPI_MOSI), CYHAL_GET_PIN(CYBSP_RSPI_MOSI), CY_GPIO_SLEW_FAST);
         Cy_GPIO_SetDriveSel(CYHAL_GET_PORTADDR(CYBSP_RSPI_MOSI), CYHAL_GET_PIN(CYBSP_RSPI_MOSI), CY_GPIO_DRIVE_1_8);
@@ -109,132 +184,631 @@ cy_rslt_t radar_init(void)
         Cy_GPIO_SetDriveSel(CYHAL_GET_PORTADDR(CYBSP_RSPI_CLK), CYHAL_GET_PIN(CYBSP_RSPI_CLK), CY_GPIO_DRIVE_1_8);
 
         if (xensiv_bgt60trxx_mtb_init(&bgt60_obj,
-                                      &spi,
+                                      &radar_spi,
                                       CYBSP_RSPI_CS,
                                       CYBSP_RXRES_L,
-                                      register_lst,
-                                      XENSIV_BGT60TRXX_CONF_NUM_REGS) != CY_RSLT_SUCCESS)
+                                      radar_config_get_default_registers(),
+                                      RADAR_CONFIG_NUM_REGS) != CY_RSLT_SUCCESS)
         {
             printf("ERROR: xensiv_bgt60trxx_mtb_init failed\n");
             return -1;
         }
-        radar_flag = false;
-#endif
-        result = radar_timer_init();
-        if(CY_RSLT_SUCCESS != result)
+
+        /* The command is sent MSB first */
+        burst_command[0] = (uint8_t) (command >> 24);
+        burst_command[1] = (uint8_t) (command >> 16);
+        burst_command[2] = (uint8_t) (command >> 8);
+        burst_command[3] = (uint8_t) command;
+
+        /* FIFO reads are queued on the bus and done by DMA; register accesses
+         * by the driver stay blocking */
+        bus_device_init_spi(&radar_device, &bus_radar, CYBSP_RSPI_CS);
+        radar_transaction.device = &radar_device;
+        radar_transaction.tx = burst_command;
+        radar_transaction.tx_size = RADAR_BURST_COMMAND_SIZE;
+        radar_transaction.callback = radar_transfer_handler;
+
+        /* The sensor raises its IRQ line once a complete frame is in the FIFO */
+        if (xensiv_bgt60trxx_mtb_interrupt_init(&bgt60_obj,
+                                                frame_samples,
+                                                CYBSP_RSPI_IRQ,
+                                                RADAR_INTERRUPT_PRIORITY,
+                                                radar_interrupt_handler,
+                                                NULL) != CY_RSLT_SUCCESS)
         {
-            return result;
+            printf("ERROR: xensiv_bgt60trxx_mtb_interrupt_init failed\n");
+            return -1;
+        }
+
+        if (!radar_dsp_init(radar_config.samples, radar_config.chirps))
+        {
+            printf("ERROR: radar_dsp_init failed\n");
+            return -1;
         }
 
+        if (!radar_presence_init(radar_config.samples, radar_config.chirps))
+        {
+            printf("ERROR: radar_presence_init failed\n");
+            return -1;
+        }
+
+        /* The timer is only started by a runtime configuration; it sets the
+         * frame instants, so it follows the audio clock when disciplined */
+        timebase_timer_init(&radar_timer, radar_timer_handler, NULL, true);
+
+        if (xensiv_bgt60trxx_start_frame(&bgt60_obj.dev, true) != XENSIV_BGT60TRXX_STATUS_OK)
+        {
+            printf("ERROR: xensiv_bgt60trxx_start_frame failed\n");
+            return -1;
+        }
+#endif
+
         return CY_RSLT_SUCCESS;
 }
 
 
 /*******************************************************************************
-* Function Name: radar_timer_init
+* Function Name: radar_timer_handler
 ********************************************************************************
 * Summary:
-*   Sets up an interrupt that triggers at the desired frequency.
+*   Timebase callback of the frame timer. Starts the acquisition of a frame,
+*   unless no packet is free to read it into, because the SPI is busy reading
+*   the previous frame or the pool is full. That frame is skipped and counted,
+*   rather than left to accumulate in the sensor FIFO.
 *
-* Returns:
-*   The status of the initialization.
+* Parameters:
+*     arg: not used
 *
 *
 *******************************************************************************/
-cy_rslt_t radar_timer_init(void)
+void radar_timer_handler(void *arg)
 {
-    cy_rslt_t result;
-    const cyhal_timer_cfg_t timer_cfg =
-    {
-        .compare_value = 0,                 /* Timer compare value, not used */
-        .period = RADAR_TIMER_PERIOD,       /* Defines the timer period */
-        .direction = CYHAL_TIMER_DIR_UP,    /* Timer counts up */
-        .is_compare = false,                /* Don't use compare mode */
-        .is_continuous = true,              /* Run the timer indefinitely */
-        .value = 0                          /* Initial value of counter */
-    };
-
-    /* Initialize the timer object. Does not use pin output ('pin' is NC) and
-    * does not use a pre-configured clock source ('clk' is NULL). */
-    result = cyhal_timer_init(&radar_timer, NC, NULL);
+    (void) arg;
+
+#ifdef IM_ENABLE_RADAR
+    if (stopped)
+    {
+        return;
+    }
+    if (RADAR_PACKET_FREE == packet_state[fill_index])
+    {
+        xensiv_bgt60trxx_start_frame(&bgt60_obj.dev, true);
+    }
+    else
+    {
+        skipped++;
+    }
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: radar_interrupt_handler
+********************************************************************************
+* Summary:
+*   Interrupt handler for the sensor IRQ line. Interrupt handler will get called
+*   at the frame rate of the sensor and starts reading the frame.
+*
+* Parameters:
+*     callback_arg: not used
+*     event: not used
+*
+*
+*******************************************************************************/
+void radar_interrupt_handler(void *callback_arg, cyhal_gpio_event_t event)
+{
+    (void) callback_arg;
+    (void) event;
+
+    radar_start_transfer();
+}
+
+
+/*******************************************************************************
+* Function Name: radar_transfer_handler
+********************************************************************************
+* Summary:
+*   Called from the bus interrupt at the end of a FIFO burst read. Hands the
+*   packet to main by setting a flag, and starts reading the next frame if one
+*   is waiting.
+*
+* Parameters:
+*     transaction: not used
+*     result: the status of the burst read
+*
+*
+*******************************************************************************/
+void radar_transfer_handler(bus_transaction_t *transaction, cy_rslt_t result)
+{
+    (void) transaction;
+
+#ifdef IM_ENABLE_RADAR
+    PROFILE_SCOPE(PROFILE_RADAR_TRANSFER_HANDLER);
+
+    /* A failed read leaves the frame in the sensor FIFO */
     if (CY_RSLT_SUCCESS != result)
     {
-        return result;
+        packet_state[fill_index] = RADAR_PACKET_FREE;
+        return;
+    }
+
+    packet_state[fill_index] = RADAR_PACKET_READY;
+    fill_index = (fill_index + 1) % RADAR_POOL_SIZE;
+    events_post(EVENT_RADAR);
+
+    /* The IRQ line is only edge sensitive; if another frame is already waiting
+     * the line stays high */
+    if (cyhal_gpio_read(CYBSP_RSPI_IRQ))
+    {
+        radar_start_transfer();
     }
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: radar_start_transfer
+********************************************************************************
+* Summary:
+*   Starts a DMA burst read of a frame from the sensor FIFO into the next
+*   packet of the pool, unless a transfer is ongoing or no packet is free. In
+*   that case the frame stays in the sensor FIFO and is read once a packet is
+*   released. Must be called from the radar interrupts or with interrupts
+*   disabled.
+*
+*
+*******************************************************************************/
+void radar_start_transfer(void)
+{
+#ifdef IM_ENABLE_RADAR
+    PROFILE_SCOPE(PROFILE_RADAR_START_TRANSFER);
+    uint8_t *burst = radar_buffers[fill_index].burst;
 
-    /* Apply timer configuration such as period, count direction, run mode, etc. */
-    result = cyhal_timer_configure(&radar_timer, &timer_cfg);
+    if (!stopped && RADAR_PACKET_FREE == packet_state[fill_index])
+    {
+        packet_state[fill_index] = RADAR_PACKET_FILLING;
+        radar_transaction.rx = burst;
+        radar_transaction.rx_size = burst_size;
+        if (bus_submit(&radar_transaction) != CY_RSLT_SUCCESS)
+        {
+            packet_state[fill_index] = RADAR_PACKET_FREE;
+        }
+    }
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: radar_set_geometry
+********************************************************************************
+* Summary:
+*   Derives the frame and burst sizes from the current configuration.
+*
+*
+*******************************************************************************/
+void radar_set_geometry(void)
+{
+    frame_samples = radar_config.samples * radar_config.chirps * radar_config.rx;
+    burst_size = RADAR_BURST_COMMAND_SIZE + frame_samples * 3 / 2;
+}
+
+
+/*******************************************************************************
+* Function Name: radar_configure
+********************************************************************************
+* Summary:
+*   Reconfigures the sensor at runtime. The register set is computed from the
+*   configuration and written to the sensor, after which radar_timer starts a
+*   frame at the configured rate. Frames in flight are dropped and the rate
+*   divider is reset. An unsupported configuration leaves the sensor and the
+*   processing running unchanged.
+*
+* Parameters:
+*     config: the new configuration
+*
+* Return:
+*     CY_RSLT_SUCCESS, or an error if the configuration is not supported.
+*
+*******************************************************************************/
+cy_rslt_t radar_configure(const radar_config_t *config)
+{
+#ifdef IM_ENABLE_RADAR
+    uint32_t registers[RADAR_CONFIG_NUM_REGS];
+    cy_rslt_t result;
+
+    if (!radar_config_get_registers(config, registers))
+    {
+        return -1;
+    }
+
+    result = radar_stop();
     if (CY_RSLT_SUCCESS != result)
     {
         return result;
     }
 
-    /* Set the frequency of timer to 100KHz */
-    result = cyhal_timer_set_frequency(&radar_timer, RADAR_TIMER_FREQUENCY);
+    /* The processing follows the geometry only once no frame of the old one
+     * can arrive. Every configuration accepted above is supported by both. */
+    if (!radar_dsp_init(config->samples, config->chirps) ||
+        !radar_presence_init(config->samples, config->chirps))
+    {
+        bus_release(&bus_radar);
+        return -1;
+    }
+
+    radar_config = *config;
+    radar_set_geometry();
+    frame_divider = 1;
+    frame_count = 0;
+
+    if (xensiv_bgt60trxx_config(&bgt60_obj.dev, registers, RADAR_CONFIG_NUM_REGS) != XENSIV_BGT60TRXX_STATUS_OK ||
+        xensiv_bgt60trxx_set_fifo_limit(&bgt60_obj.dev, frame_samples) != XENSIV_BGT60TRXX_STATUS_OK ||
+        xensiv_bgt60trxx_soft_reset(&bgt60_obj.dev, XENSIV_BGT60TRXX_RESET_FIFO) != XENSIV_BGT60TRXX_STATUS_OK)
+    {
+        bus_release(&bus_radar);
+        return -1;
+    }
+
+    triggered = true;
+    radar_pool_reset();
+    bus_release(&bus_radar);
+
+    return timebase_start(&radar_timer, TIMEBASE_FREQUENCY, radar_config.rate, TIMEBASE_PHASE_RADAR);
+#else
+    (void) config;
+    return -1;
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: radar_get_config
+********************************************************************************
+* Summary:
+*   Returns the current configuration.
+*
+*******************************************************************************/
+const radar_config_t* radar_get_config(void)
+{
+    return &radar_config;
+}
+
+
+/*******************************************************************************
+* Function Name: radar_set_rate
+********************************************************************************
+* Summary:
+*   Selects the rate at which frames are passed on. The sensor keeps running at
+*   the configured frame rate and every frame is read from the FIFO, but only
+*   every frame rate / rate'th frame is returned by radar_get_packet.
+*
+* Parameters:
+*     rate: frames per second; the configured rate divided by 1, 2, 4 or 8
+*
+* Return:
+*     CY_RSLT_SUCCESS, or an error if the rate is not supported.
+*
+*******************************************************************************/
+cy_rslt_t radar_set_rate(uint32_t rate)
+{
+    uint32_t divider;
+
+    if (0 == rate || 0 != radar_config.rate % rate)
+    {
+        return -1;
+    }
+    divider = radar_config.rate / rate;
+    if (divider > 8 || 0 != (divider & (divider - 1)))
+    {
+        return -1;
+    }
+
+    frame_divider = divider;
+    frame_count = 0;
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name: radar_get_overflows
+********************************************************************************
+* Summary:
+*   Returns the number of sensor FIFO overflows recovered from so far.
+*
+*******************************************************************************/
+uint32_t radar_get_overflows(void)
+{
+    return overflows;
+}
+
+
+/*******************************************************************************
+* Function Name: radar_get_dropped
+********************************************************************************
+* Summary:
+*   Returns the number of frames lost so far: the frames the timer skipped for
+*   want of a free packet and the frames read into the pool that an overflow
+*   recovery dropped. The frames flushed from the sensor FIFO by a recovery are
+*   not known; each recovery adds at least the frame that overflowed.
+*
+*******************************************************************************/
+uint32_t radar_get_dropped(void)
+{
+    return skipped + flushed;
+}
+
+
+/*******************************************************************************
+* Function Name: radar_stop
+********************************************************************************
+* Summary:
+*   Stops starting transfers and frames, lets an ongoing burst finish, and
+*   stops the frame generation. The radar bus is held for the driver; the
+*   caller releases it.
+*
+* Returns:
+*   CY_RSLT_SUCCESS, or the error of bus_acquire; the transfers stay stopped
+*   but the bus is not held then.
+*
+*
+*******************************************************************************/
+cy_rslt_t radar_stop(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+#ifdef IM_ENABLE_RADAR
+    stopped = true;
+    if (triggered)
+    {
+        timebase_stop(&radar_timer);
+    }
+    result = bus_acquire(&bus_radar);
     if (CY_RSLT_SUCCESS != result)
     {
         return result;
     }
 
-    /* Assign the ISR to execute on timer interrupt */
-    cyhal_timer_register_callback(&radar_timer, radar_interrupt_handler, NULL);
-    /* Set the event on which timer interrupt occurs and enable it */
-    cyhal_timer_enable_event(&radar_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, RADAR_TIMER_PRIORITY, true);
-    /* Start the timer with the configured settings */
-    result = cyhal_timer_start(&radar_timer);
+    xensiv_bgt60trxx_start_frame(&bgt60_obj.dev, false);
+#endif
+
+    return result;
+}
+
+
+/*******************************************************************************
+* Function Name: radar_pool_reset
+********************************************************************************
+* Summary:
+*   Drops all packets in the pool and allows transfers again.
+*
+*
+*******************************************************************************/
+void radar_pool_reset(void)
+{
+    for (uint32_t i = 0; i < RADAR_POOL_SIZE; i++)
+    {
+        packet_state[i] = RADAR_PACKET_FREE;
+    }
+    fill_index = 0;
+    read_index = 0;
+    stopped = false;
+}
+
+
+/*******************************************************************************
+* Function Name: radar_fifo_recover
+********************************************************************************
+* Summary:
+*   Recovers from a FIFO overflow by stopping the frame generation, flushing
+*   the FIFO and restarting. The frames in the FIFO and in the packet pool are
+*   lost.
+*
+* Returns:
+*   The status of the recovery.
+*
+*
+*******************************************************************************/
+cy_rslt_t radar_fifo_recover(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+#ifdef IM_ENABLE_RADAR
+    overflows++;
+
+    result = radar_stop();
     if (CY_RSLT_SUCCESS != result)
     {
         return result;
     }
 
+    if (xensiv_bgt60trxx_soft_reset(&bgt60_obj.dev, XENSIV_BGT60TRXX_RESET_FIFO) != XENSIV_BGT60TRXX_STATUS_OK)
+    {
+        result = -1;
+    }
+
+    /* Drop the frames read before the overflow. The read of the frame that
+     * overflowed is among them. */
+    for (uint32_t i = 0; i < RADAR_POOL_SIZE; i++)
+    {
+        flushed += RADAR_PACKET_READY == packet_state[i] ? 1u : 0u;
+    }
+    radar_pool_reset();
+
+    /* Restart the frame generation, or the timer that starts the frames,
+     * unless the reset failed; that error is the one reported */
+    if (CY_RSLT_SUCCESS == result)
+    {
+        if (triggered)
+        {
+            result = timebase_start(&radar_timer, TIMEBASE_FREQUENCY, radar_config.rate, TIMEBASE_PHASE_RADAR);
+        }
+        else if (xensiv_bgt60trxx_start_frame(&bgt60_obj.dev, true) != XENSIV_BGT60TRXX_STATUS_OK)
+        {
+            result = -1;
+        }
+    }
+
+    bus_release(&bus_radar);
+#endif
+
     return result;
 }
 
 
 /*******************************************************************************
-* Function Name: radar_interrupt_handler
+* Function Name: radar_unpack_rx
 ********************************************************************************
 * Summary:
-*   Interrupt handler for timer. Interrupt handler will get called at 100000Hz and
-*   sets a flag that can be checked in main.
+*   Unpacks the 12 bit samples of a FIFO burst into 16 bit samples and
+*   de-interleaves the antennas. Each step unpacks two samples of every antenna
+*   from 3 * rx bytes, and stores them in the [rx, chirp, sample] layout. Always
+*   inlined, so that the loops are specialized for a constant rx.
 *
 * Parameters:
-*     callback_arg: not used
-*     event: not used
+*     in: the samples of the burst
+*     out: the payload of the packet
+*     positions: samples per antenna
+*     rx: number of antennas
 *
 *
 *******************************************************************************/
-void radar_interrupt_handler(void *callback_arg, cyhal_timer_event_t event)
+static inline __attribute__((always_inline)) void radar_unpack_rx(const uint8_t *in, uint16_t *out,
+                                                                  uint32_t positions, uint32_t rx)
 {
-    (void) callback_arg;
-    (void) event;
+    uint16_t samples[2 * RADAR_MAX_RX];
+
+    for (uint32_t j = 0; j < positions; j += 2)
+    {
+        for (uint32_t i = 0; i < 2 * rx; i += 2)
+        {
+            samples[i] = ((uint16_t) in[0] << 4) | (in[1] >> 4);
+            samples[i + 1] = ((uint16_t) (in[1] & 0x0F) << 8) | in[2];
+            in += 3;
+        }
+
+        /* Samples j of all antennas come first, then samples j + 1 */
+        for (uint32_t a = 0; a < rx; a++)
+        {
+            out[a * positions + j] = samples[a];
+            out[a * positions + j + 1] = samples[rx + a];
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: radar_unpack
+********************************************************************************
+* Summary:
+*   Unpacks and de-interleaves a FIFO burst into the payload of a packet,
+*   using a kernel specialized for the number of antennas.
+*
+* Parameters:
+*     in: the samples of the burst
+*     out: the payload of the packet
+*
+*
+*******************************************************************************/
+void radar_unpack(const uint8_t *in, uint16_t *out)
+{
+    const uint32_t positions = radar_config.samples * radar_config.chirps;
 
-    radar_flag = true;
+    switch (radar_config.rx)
+    {
+    case 1:
+        radar_unpack_rx(in, out, positions, 1);
+        break;
+    case 2:
+        radar_unpack_rx(in, out, positions, 2);
+        break;
+    default:
+        radar_unpack_rx(in, out, positions, 3);
+        break;
+    }
 }
 
 
 /*******************************************************************************
-* Function Name: radar_get_data
+* Function Name: radar_get_packet
 ********************************************************************************
 * Summary:
-*   Reads data from the radar sensor and stores it in a buffer.
+*   Takes the next frame read from the sensor, if it is due according to the
+*   selected rate. The frame is returned as a packet with room for the protocol
+*   header and trailer around the 16 bit samples in [rx, chirp, sample]
+*   layout; see protocol_send_packet. The packet must be handed back with
+*   radar_release_packet. Recovers from FIFO overflows.
 *
 * Parameters:
-*     radar_data: Stores RADAR sensor data
+*     packet: receives a pointer to the packet
 *
+* Return:
+*     CY_RSLT_SUCCESS if a packet was returned.
 *
 *******************************************************************************/
-void radar_get_data(int16_t *radar_data)
+cy_rslt_t radar_get_packet(uint8_t **packet)
 {
+    PROFILE_SCOPE(PROFILE_RADAR_GET_PACKET);
 #ifdef IM_ENABLE_RADAR
-    cy_rslt_t result;
-    result = xensiv_bgt60trxx_get_fifo_data(&bgt60_obj.dev, bgt60_buffer, NUM_SAMPLES_PER_FRAME);
-    if (CY_RSLT_SUCCESS == result)
+    radar_buffer_t *current = &radar_buffers[read_index];
+
+    if (RADAR_PACKET_READY != packet_state[read_index])
     {
-        for(uint32_t i =0; i < RADAR_AXIS; i++)
-        {
-            radar_data[i] = bgt60_buffer[i];
-        }
+        return -1;
+    }
+
+    /* The first byte received during the burst command is the GSR0 status */
+    if (0 != (current->burst[0] & XENSIV_BGT60TRXX_REG_GSR0_FOU_ERR_MSK))
+    {
+        /* FIFO overflow: the frame boundaries are lost, start over */
+        radar_fifo_recover();
+        return -1;
+    }
+
+    packet_state[read_index] = RADAR_PACKET_IN_USE;
+    if (0 != frame_count++ % frame_divider)
+    {
+        radar_release_packet();
+        return -1;
+    }
+
+    radar_unpack(current->burst + RADAR_BURST_COMMAND_SIZE, (uint16_t*) (current->packet + PROTOCOL_HEADER_SIZE));
+    *packet = current->packet;
+
+    return CY_RSLT_SUCCESS;
+#else
+    (void) packet;
+    return -1;
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: radar_release_packet
+********************************************************************************
+* Summary:
+*   Hands the packet returned by radar_get_packet back to the pool, and starts
+*   reading a frame that waits in the sensor FIFO for want of a free packet.
+*
+*
+*******************************************************************************/
+void radar_release_packet(void)
+{
+#ifdef IM_ENABLE_RADAR
+    uint32_t saved_intr_status;
+
+    packet_state[read_index] = RADAR_PACKET_FREE;
+    read_index = (read_index + 1) % RADAR_POOL_SIZE;
+
+    /* More frames may have been read meanwhile */
+    if (RADAR_PACKET_READY == packet_state[read_index])
+    {
+        events_post(EVENT_RADAR);
+    }
+
+    saved_intr_status = cyhal_system_critical_section_enter();
+    if (cyhal_gpio_read(CYBSP_RSPI_IRQ))
+    {
+        radar_start_transfer();
     }
+    cyhal_system_critical_section_exit(saved_intr_status);
 #endif
 }
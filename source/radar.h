@@ -44,21 +44,23 @@
 
 #include "cy_result.h"
 #include "stdbool.h"
+#include "stdint.h"
+#include "radar_config.h"
 
 /******************************************************************************
  * Global Variables
  *****************************************************************************/
 cy_rslt_t radar_init(void);
 
-/******************************************************************************
- * Macros
- *****************************************************************************/
-#define RADAR_AXIS 2048
-
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-extern volatile bool radar_flag;
-void radar_get_data(int16_t *radar_data);
+cy_rslt_t radar_configure(const radar_config_t *config);
+const radar_config_t* radar_get_config(void);
+cy_rslt_t radar_set_rate(uint32_t rate);
+uint32_t radar_get_overflows(void);
+uint32_t radar_get_dropped(void);
+cy_rslt_t radar_get_packet(uint8_t **packet);
+void radar_release_packet(void);
 
 #endif /* RADAR_H_ */
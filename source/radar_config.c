@@ -0,0 +1,272 @@
+/******************************************************************************
+* File Name:   radar_config.c
+*
+* Description: This file computes the radar sensor register set for a frame
+*              geometry, bandwidth and frame rate chosen at runtime.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "cyhal.h"
+#include "radar_config.h"
+#include "radar_settings.h"
+#include "config.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#if XENSIV_BGT60TRXX_CONF_NUM_REGS != RADAR_CONFIG_NUM_REGS
+#error "radar_settings.h does not match RADAR_CONFIG_NUM_REGS"
+#endif
+
+/* A register word holds the address in bits 31:25 and the data in bits 23:0 */
+#define REG_ADDRESS_POS             (25)
+#define REG_DATA_MSK                (0x00FFFFFFUL)
+
+/* Registers and fields changed at runtime, from the BGT60TR13C register map */
+#define REG_CS1_U_1                 (0x11)
+#define CS1_U_1_BBCH_SEL_POS        (20)            /* Enabled RX channels */
+#define CS1_U_1_BBCH_SEL_MSK        (0x00F00000UL)
+
+#define REG_CCR2                    (0x2E)
+#define CCR2_MAX_FRAME_CNT_POS      (0)             /* Frames per start, 0 is endless */
+#define CCR2_MAX_FRAME_CNT_MSK      (0x00000FFFUL)
+#define CCR2_FRAME_LEN_POS          (12)            /* Chirps per frame minus one */
+#define CCR2_FRAME_LEN_MSK          (0x0001F000UL)
+
+#define REG_PLL1_1                  (0x31)
+#define PLL1_1_RSU_MSK              (0x00FFFFFFUL)  /* Ramp step, signed */
+
+#define REG_PLL1_2                  (0x32)
+#define PLL1_2_RTU_MSK              (0x00003FFFUL)  /* Ramp time in 8 clock cycles */
+
+#define REG_PLL1_3                  (0x33)
+#define PLL1_3_APU_MSK              (0x00000FFFUL)  /* Samples per chirp */
+
+/* Sensor system clock */
+#define RADAR_SYSTEM_CLOCK_HZ       (80000000.0)
+
+/* Highest end frequency of a chirp */
+#define RADAR_MAX_END_FREQ_HZ       (63500000000.0)
+
+/* Time for the sensor to wake up before a frame, plus safety margin */
+#define RADAR_FRAME_MARGIN_S        (0.001)
+
+/* RX antenna masks for 1, 2 and 3 antennas; a single antenna uses the one
+ * of the default configuration */
+static const uint32_t rx_masks[RADAR_MAX_RX] = { 0x4, 0x5, 0x7 };
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static uint32_t* radar_config_find(uint32_t *registers, uint32_t address);
+static void radar_config_set_field(uint32_t *registers, uint32_t address, uint32_t mask, uint32_t value);
+static bool radar_config_is_power_of_two(uint32_t value);
+
+
+/*******************************************************************************
+* Function Name: radar_config_get_default
+********************************************************************************
+* Summary:
+*  Returns the configuration described by radar_settings.h, which the sensor
+*  runs after initialization.
+*
+* Parameters:
+*  config: receives the configuration
+*
+*******************************************************************************/
+void radar_config_get_default(radar_config_t *config)
+{
+    config->samples = XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP;
+    config->chirps = XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME;
+    config->rx = XENSIV_BGT60TRXX_CONF_NUM_RX_ANTENNAS;
+    config->bandwidth = (uint32_t) ((XENSIV_BGT60TRXX_CONF_END_FREQ_HZ - XENSIV_BGT60TRXX_CONF_START_FREQ_HZ + 500000) / 1000000);
+    config->rate = (uint32_t) (1.0 / XENSIV_BGT60TRXX_CONF_FRAME_REPETITION_TIME_S + 0.5);
+}
+
+/*******************************************************************************
+* Function Name: radar_config_get_default_registers
+********************************************************************************
+* Summary:
+*  Returns the register set of the default configuration. The sensor generates
+*  frames continuously at the default rate.
+*
+*******************************************************************************/
+const uint32_t* radar_config_get_default_registers(void)
+{
+    return register_lst;
+}
+
+/*******************************************************************************
+* Function Name: radar_config_get_registers
+********************************************************************************
+* Summary:
+*  Computes the register set for a configuration by adjusting the default
+*  register set. The number of ADC samples and the ramp time scale with the
+*  samples per chirp, and the ramp step is scaled so that the ramp covers the
+*  requested bandwidth from the default start frequency. The sensor generates a
+*  single frame each time it is started, so the caller starts every frame at
+*  the configured rate.
+*
+* Parameters:
+*  config: the configuration
+*  registers: receives RADAR_CONFIG_NUM_REGS register words
+*
+* Return:
+*  True on success; false if the configuration is not supported, including
+*  when a frame cannot be acquired and read within the frame period.
+*
+*******************************************************************************/
+bool radar_config_get_registers(const radar_config_t *config, uint32_t *registers)
+{
+    const double default_bandwidth = XENSIV_BGT60TRXX_CONF_END_FREQ_HZ - XENSIV_BGT60TRXX_CONF_START_FREQ_HZ;
+    uint32_t default_rtu;
+    int32_t default_rsu;
+    uint32_t rtu;
+    int32_t rsu;
+    double default_ramp_time;
+    double chirp_time;
+    double frame_time;
+    uint32_t frame_samples;
+
+    if (config->samples < RADAR_MIN_SAMPLES || config->samples > RADAR_MAX_SAMPLES || !radar_config_is_power_of_two(config->samples) ||
+        config->chirps < RADAR_MIN_CHIRPS || config->chirps > RADAR_MAX_CHIRPS || !radar_config_is_power_of_two(config->chirps) ||
+        config->rx < 1 || config->rx > RADAR_MAX_RX || config->bandwidth == 0 || config->rate == 0)
+    {
+        return false;
+    }
+
+    frame_samples = config->samples * config->chirps * config->rx;
+    if (frame_samples > RADAR_MAX_FRAME_SAMPLES ||
+        XENSIV_BGT60TRXX_CONF_START_FREQ_HZ + config->bandwidth * 1e6 > RADAR_MAX_END_FREQ_HZ)
+    {
+        return false;
+    }
+
+    memcpy(registers, register_lst, sizeof(register_lst));
+
+    /* Ramp time and ADC samples per chirp */
+    default_rtu = *radar_config_find(registers, REG_PLL1_2) & PLL1_2_RTU_MSK;
+    rtu = default_rtu * config->samples / XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP;
+    if (rtu > PLL1_2_RTU_MSK)
+    {
+        return false;
+    }
+    radar_config_set_field(registers, REG_PLL1_2, PLL1_2_RTU_MSK, rtu);
+    radar_config_set_field(registers, REG_PLL1_3, PLL1_3_APU_MSK, config->samples);
+
+    /* The bandwidth is the ramp step times the ramp time */
+    default_rsu = (int32_t) ((*radar_config_find(registers, REG_PLL1_1) & PLL1_1_RSU_MSK) << 8) >> 8;
+    rsu = (int32_t) lround(default_rsu * (config->bandwidth * 1e6 / default_bandwidth) * ((double) default_rtu / rtu));
+    if (rsu < -0x800000 || rsu > 0x7FFFFF)
+    {
+        return false;
+    }
+    radar_config_set_field(registers, REG_PLL1_1, PLL1_1_RSU_MSK, (uint32_t) rsu & PLL1_1_RSU_MSK);
+
+    /* Frame length, and a single frame per start */
+    radar_config_set_field(registers, REG_CCR2, CCR2_FRAME_LEN_MSK, (config->chirps - 1) << CCR2_FRAME_LEN_POS);
+    radar_config_set_field(registers, REG_CCR2, CCR2_MAX_FRAME_CNT_MSK, 1 << CCR2_MAX_FRAME_CNT_POS);
+
+    /* Receive antennas */
+    radar_config_set_field(registers, REG_CS1_U_1, CS1_U_1_BBCH_SEL_MSK, rx_masks[config->rx - 1] << CS1_U_1_BBCH_SEL_POS);
+
+    /* Only the ramp of a chirp scales with the samples, the rest of the chirp
+     * repetition time is fixed. The frame is read after it is acquired. */
+    default_ramp_time = default_rtu * 8 / RADAR_SYSTEM_CLOCK_HZ;
+    chirp_time = XENSIV_BGT60TRXX_CONF_CHIRP_REPETITION_TIME_S - default_ramp_time + rtu * 8 / RADAR_SYSTEM_CLOCK_HZ;
+    frame_time = config->chirps * chirp_time + (4 + frame_samples * 3 / 2) * 8.0 / SPI_FREQUENCY + RADAR_FRAME_MARGIN_S;
+    if (frame_time * config->rate > 1.0)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: radar_config_find
+********************************************************************************
+* Summary:
+*  Returns the register word of the given address. All registers changed at
+*  runtime are part of the default register set.
+*
+*******************************************************************************/
+static uint32_t* radar_config_find(uint32_t *registers, uint32_t address)
+{
+    for (uint32_t i = 0; i < RADAR_CONFIG_NUM_REGS; i++)
+    {
+        if ((registers[i] >> REG_ADDRESS_POS) == address)
+        {
+            return &registers[i];
+        }
+    }
+
+    /* Not reached; the addresses are checked against radar_settings.h */
+    CY_ASSERT(0);
+    return &registers[0];
+}
+
+/*******************************************************************************
+* Function Name: radar_config_set_field
+********************************************************************************
+* Summary:
+*  Replaces a field of a register word.
+*
+*******************************************************************************/
+static void radar_config_set_field(uint32_t *registers, uint32_t address, uint32_t mask, uint32_t value)
+{
+    uint32_t *reg = radar_config_find(registers, address);
+
+    *reg = (*reg & ~(mask & REG_DATA_MSK)) | (value & mask);
+}
+
+/*******************************************************************************
+* Function Name: radar_config_is_power_of_two
+********************************************************************************
+* Summary:
+*  Returns whether a value is a power of two.
+*
+*******************************************************************************/
+static bool radar_config_is_power_of_two(uint32_t value)
+{
+    return value != 0 && 0 == (value & (value - 1));
+}
+
+/* [] END OF FILE */
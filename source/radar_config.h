@@ -0,0 +1,81 @@
+/******************************************************************************
+* File Name:   radar_config.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in radar_config.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_RADAR_CONFIG_H_
+#define SOURCE_RADAR_CONFIG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Number of registers in a radar configuration */
+#define RADAR_CONFIG_NUM_REGS       (38)
+
+/* Largest frame, in samples over all antennas */
+#define RADAR_MAX_FRAME_SAMPLES     (8192)
+
+/* Supported ranges of the configuration parameters */
+#define RADAR_MIN_SAMPLES           (32)
+#define RADAR_MAX_SAMPLES           (256)
+#define RADAR_MIN_CHIRPS            (2)
+#define RADAR_MAX_CHIRPS            (32)
+#define RADAR_MAX_RX                (3)
+
+/******************************************************************************
+ * Types
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t samples;              /* Samples per chirp, a power of two */
+    uint32_t chirps;               /* Chirps per frame, a power of two */
+    uint32_t rx;                   /* Number of receive antennas, 1 to 3 */
+    uint32_t bandwidth;            /* Chirp bandwidth in MHz */
+    uint32_t rate;                 /* Frames per second */
+} radar_config_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+void radar_config_get_default(radar_config_t *config);
+const uint32_t* radar_config_get_default_registers(void);
+bool radar_config_get_registers(const radar_config_t *config, uint32_t *registers);
+
+#endif /* SOURCE_RADAR_CONFIG_H_ */
@@ -0,0 +1,322 @@
+/******************************************************************************
+* File Name:   radar_dsp.c
+*
+* Description: This file implements the range FFT and range-Doppler map
+*              computed from raw radar frames.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <math.h>
+#include "profile.h"
+#include "radar_dsp.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#ifndef M_PI
+#define M_PI                        (3.14159265358979323846)
+#endif
+
+/* Mean removed samples are scaled up by this shift before the FFT, so the
+ * 12 bit samples use the full 16 bit range */
+#define RADAR_DSP_INPUT_SHIFT       (3)
+
+/* Largest value of a magnitude */
+#define RADAR_DSP_MAX_MAGNITUDE     (65535.0f)
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+static uint32_t num_samples;
+static uint32_t num_chirps;
+static uint32_t num_bins;
+
+/* Twiddle factors exp(-2 pi j k / twiddle_size) in Q15, for k below
+ * twiddle_size / 2. An FFT of size n uses every twiddle_size / n'th entry. */
+static int16_t twiddle_cos[RADAR_DSP_MAX_SAMPLES / 2];
+static int16_t twiddle_sin[RADAR_DSP_MAX_SAMPLES / 2];
+static uint32_t twiddle_size;
+
+/* Hann windows in Q15 */
+static int16_t range_window[RADAR_DSP_MAX_SAMPLES];
+static int16_t doppler_window[RADAR_DSP_MAX_CHIRPS];
+
+/* Range spectra of the last frame, [chirp][bin] with interleaved real and
+ * imaginary parts, kept for the Doppler FFT */
+static int32_t spectra[RADAR_DSP_MAX_FRAME];
+
+/* FFT work buffer with interleaved real and imaginary parts */
+static int32_t work[2 * RADAR_DSP_MAX_SAMPLES];
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static void radar_dsp_hann(int16_t *window, uint32_t size);
+static void radar_dsp_fft(int32_t *data, uint32_t size);
+static uint16_t radar_dsp_magnitude(int32_t re, int32_t im, float scale);
+
+
+/*******************************************************************************
+* Function Name: radar_dsp_init
+********************************************************************************
+* Summary:
+*  Prepares the windows and twiddle factors for the given frame geometry.
+*
+* Parameters:
+*  samples: number of samples per chirp, a power of two
+*  chirps: number of chirps per frame, a power of two
+*
+* Return:
+*  True on success; false if the geometry is not supported.
+*
+*******************************************************************************/
+bool radar_dsp_init(uint32_t samples, uint32_t chirps)
+{
+    if (samples < 2 || samples > RADAR_DSP_MAX_SAMPLES || 0 != (samples & (samples - 1)) ||
+        chirps < 2 || chirps > RADAR_DSP_MAX_CHIRPS || 0 != (chirps & (chirps - 1)) ||
+        samples * chirps > RADAR_DSP_MAX_FRAME)
+    {
+        return false;
+    }
+
+    num_samples = samples;
+    num_chirps = chirps;
+    num_bins = samples / 2;
+
+    twiddle_size = samples > chirps ? samples : chirps;
+    for (uint32_t k = 0; k < twiddle_size / 2; k++)
+    {
+        double angle = 2.0 * M_PI * k / twiddle_size;
+        twiddle_cos[k] = (int16_t) lround(cos(angle) * 32767.0);
+        twiddle_sin[k] = (int16_t) lround(sin(angle) * 32767.0);
+    }
+
+    radar_dsp_hann(range_window, samples);
+    radar_dsp_hann(doppler_window, chirps);
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: radar_dsp_range
+********************************************************************************
+* Summary:
+*  Computes the range profile of every chirp in a frame: the mean of the chirp
+*  is removed, a Hann window applied and a real FFT computed. The magnitudes of
+*  the lower half of the spectrum are stored; the complex spectra are kept for
+*  radar_dsp_doppler.
+*
+* Parameters:
+*  frame: the raw 12 bit samples, [chirp][sample]
+*  profile: receives the magnitudes scaled by 1 / samples, [chirp][bin]. A full
+*           scale sinusoid results in a magnitude of about 4096.
+*
+*******************************************************************************/
+void radar_dsp_range(const uint16_t *frame, uint16_t *profile)
+{
+    PROFILE_SCOPE(PROFILE_RADAR_DSP_RANGE);
+    const float scale = 1.0f / num_samples;
+
+    for (uint32_t chirp = 0; chirp < num_chirps; chirp++)
+    {
+        const uint16_t *input = frame + chirp * num_samples;
+        int32_t *spectrum = spectra + chirp * 2 * num_bins;
+        int32_t mean = 0;
+
+        for (uint32_t i = 0; i < num_samples; i++)
+        {
+            mean += input[i];
+        }
+        mean /= (int32_t) num_samples;
+
+        for (uint32_t i = 0; i < num_samples; i++)
+        {
+            int32_t sample = (input[i] - mean) << RADAR_DSP_INPUT_SHIFT;
+            work[2 * i] = (sample * range_window[i]) >> 15;
+            work[2 * i + 1] = 0;
+        }
+
+        radar_dsp_fft(work, num_samples);
+
+        for (uint32_t bin = 0; bin < num_bins; bin++)
+        {
+            spectrum[2 * bin] = work[2 * bin];
+            spectrum[2 * bin + 1] = work[2 * bin + 1];
+            *profile++ = radar_dsp_magnitude(work[2 * bin], work[2 * bin + 1], scale);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: radar_dsp_doppler
+********************************************************************************
+* Summary:
+*  Computes the range-Doppler map of the frame last passed to
+*  radar_dsp_range: for every range bin a Hann window is applied across the
+*  chirps and an FFT computed. Zero velocity is moved to the middle row.
+*
+* Parameters:
+*  map: receives the magnitudes scaled by 1 / (samples * chirps),
+*       [Doppler bin][range bin]
+*
+*******************************************************************************/
+void radar_dsp_doppler(uint16_t *map)
+{
+    PROFILE_SCOPE(PROFILE_RADAR_DSP_DOPPLER);
+    const float scale = 1.0f / (num_samples * num_chirps);
+
+    for (uint32_t bin = 0; bin < num_bins; bin++)
+    {
+        for (uint32_t chirp = 0; chirp < num_chirps; chirp++)
+        {
+            const int32_t *spectrum = spectra + chirp * 2 * num_bins;
+            work[2 * chirp] = (int32_t) (((int64_t) spectrum[2 * bin] * doppler_window[chirp]) >> 15);
+            work[2 * chirp + 1] = (int32_t) (((int64_t) spectrum[2 * bin + 1] * doppler_window[chirp]) >> 15);
+        }
+
+        radar_dsp_fft(work, num_chirps);
+
+        for (uint32_t doppler = 0; doppler < num_chirps; doppler++)
+        {
+            uint32_t row = (doppler + num_chirps / 2) & (num_chirps - 1);
+            map[row * num_bins + bin] = radar_dsp_magnitude(work[2 * doppler], work[2 * doppler + 1], scale);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: radar_dsp_hann
+********************************************************************************
+* Summary:
+*  Fills a periodic Hann window in Q15. Unlike the symmetric window, it does
+*  not vanish for a size of 2, the smallest number of chirps.
+*
+*******************************************************************************/
+static void radar_dsp_hann(int16_t *window, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        double value = 0.5 * (1.0 - cos(2.0 * M_PI * i / size));
+        window[i] = (int16_t) lround(value * 32767.0);
+    }
+}
+
+/*******************************************************************************
+* Function Name: radar_dsp_fft
+********************************************************************************
+* Summary:
+*  In place radix-2 decimation in time FFT with Q15 twiddle factors. The data
+*  is not scaled; the output grows by up to a factor size, which fits for
+*  16 bit input and size * chirps up to RADAR_DSP_MAX_FRAME.
+*
+* Parameters:
+*  data: interleaved real and imaginary parts
+*  size: the FFT size, a power of two not larger than twiddle_size
+*
+*******************************************************************************/
+static void radar_dsp_fft(int32_t *data, uint32_t size)
+{
+    /* Bit reversed reordering */
+    for (uint32_t i = 1, j = 0; i < size; i++)
+    {
+        uint32_t bit = size >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j |= bit;
+
+        if (i < j)
+        {
+            int32_t re = data[2 * i];
+            int32_t im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+
+    for (uint32_t half = 1; half < size; half <<= 1)
+    {
+        uint32_t step = twiddle_size / (2 * half);
+
+        for (uint32_t k = 0; k < half; k++)
+        {
+            int32_t wr = twiddle_cos[k * step];
+            int32_t wi = twiddle_sin[k * step];
+
+            for (uint32_t i = k; i < size; i += 2 * half)
+            {
+                int32_t *a = data + 2 * i;
+                int32_t *b = data + 2 * (i + half);
+
+                /* t = b * exp(-2 pi j k / (2 * half)) */
+                int32_t tr = (int32_t) (((int64_t) b[0] * wr + (int64_t) b[1] * wi) >> 15);
+                int32_t ti = (int32_t) (((int64_t) b[1] * wr - (int64_t) b[0] * wi) >> 15);
+
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: radar_dsp_magnitude
+********************************************************************************
+* Summary:
+*  Returns the scaled magnitude of a complex value, saturated to 16 bits.
+*
+*******************************************************************************/
+static uint16_t radar_dsp_magnitude(int32_t re, int32_t im, float scale)
+{
+    float magnitude = sqrtf((float) re * re + (float) im * im) * scale;
+
+    if (magnitude > RADAR_DSP_MAX_MAGNITUDE)
+    {
+        return UINT16_MAX;
+    }
+
+    return (uint16_t) (magnitude + 0.5f);
+}
+
+/* [] END OF FILE */
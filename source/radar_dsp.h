@@ -0,0 +1,64 @@
+/******************************************************************************
+* File Name:   radar_dsp.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in radar_dsp.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_RADAR_DSP_H_
+#define SOURCE_RADAR_DSP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Largest supported number of samples per chirp and chirps per frame; both
+ * must be powers of two */
+#define RADAR_DSP_MAX_SAMPLES       (256)
+#define RADAR_DSP_MAX_CHIRPS        (64)
+
+/* Largest supported frame, in samples */
+#define RADAR_DSP_MAX_FRAME         (8192)
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+bool radar_dsp_init(uint32_t samples, uint32_t chirps);
+void radar_dsp_range(const uint16_t *frame, uint16_t *profile);
+void radar_dsp_doppler(uint16_t *map);
+
+#endif /* SOURCE_RADAR_DSP_H_ */
@@ -0,0 +1,225 @@
+/******************************************************************************
+* File Name:   radar_presence.c
+*
+* Description: This file implements a lightweight presence detector computed
+*              from raw radar frames.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "radar_config.h"
+#include "radar_presence.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* The score is the motion energy relative to the noise floor. Presence is
+ * reported once the score exceeds the upper threshold and cleared once it
+ * stayed below the lower threshold for the hold time. */
+#define PRESENCE_THRESHOLD_ON       (4.0f)
+#define PRESENCE_THRESHOLD_OFF      (2.0f)
+#define PRESENCE_HOLD_FRAMES        (32u)
+
+/* Clutter map update weights; a target that stops moving is absorbed into the
+ * clutter map much more slowly while presence is reported */
+#define PRESENCE_CLUTTER_ALPHA      (1.0f / 16.0f)
+#define PRESENCE_CLUTTER_ALPHA_HOLD (1.0f / 128.0f)
+
+/* Noise floor update weights; the floor follows decreasing energy quickly and
+ * increasing energy slowly */
+#define PRESENCE_NOISE_ALPHA_DOWN   (1.0f / 8.0f)
+#define PRESENCE_NOISE_ALPHA_UP     (1.0f / 1024.0f)
+
+/* Lower bound of the noise floor, in squared ADC counts */
+#define PRESENCE_NOISE_MIN          (1.0f)
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+static uint32_t num_samples;
+static uint32_t num_chirps;
+
+/* Mean of the chirps of the current frame */
+static float chirp_mean[RADAR_MAX_SAMPLES];
+
+/* Slowly adapting estimate of the static reflections */
+static float clutter[RADAR_MAX_SAMPLES];
+
+static float noise_floor;
+static bool present;
+static uint32_t hold_count;
+static bool initialized;
+
+
+/*******************************************************************************
+* Function Name: radar_presence_init
+********************************************************************************
+* Summary:
+*  Resets the detector for the given frame geometry. The clutter map and noise
+*  floor are learned again from the following frames.
+*
+* Parameters:
+*  samples: number of samples per chirp
+*  chirps: number of chirps per frame
+*
+* Return:
+*  True on success; false if the geometry is not supported.
+*
+*******************************************************************************/
+bool radar_presence_init(uint32_t samples, uint32_t chirps)
+{
+    if (samples == 0 || samples > RADAR_MAX_SAMPLES || chirps == 0)
+    {
+        return false;
+    }
+
+    num_samples = samples;
+    num_chirps = chirps;
+    present = false;
+    hold_count = 0;
+    initialized = false;
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: radar_presence_process
+********************************************************************************
+* Summary:
+*  Updates the detector with a frame. Two kinds of motion are measured:
+*  - the variation between the chirps of the frame, which equals the energy in
+*    all but the zero Doppler bin, for movement faster than a frame
+*  - the change of the chirp mean against the clutter map, for slow movement
+*    and for targets entering or leaving the scene
+*  The sum of both, relative to the noise floor, is the score.
+*
+* Parameters:
+*  frame: the raw 12 bit samples of one antenna, [chirp][sample]
+*  result: receives RADAR_PRESENCE_AXIS values: the score and the state, 1 if
+*          presence is reported and 0 otherwise
+*
+*******************************************************************************/
+void radar_presence_process(const uint16_t *frame, float *result)
+{
+    float offset = 0.0f;
+    float motion = 0.0f;
+    float change = 0.0f;
+    float energy;
+    float score;
+    float alpha;
+
+    /* Mean of the chirps */
+    for (uint32_t i = 0; i < num_samples; i++)
+    {
+        uint32_t sum = 0;
+        for (uint32_t chirp = 0; chirp < num_chirps; chirp++)
+        {
+            sum += frame[chirp * num_samples + i];
+        }
+        chirp_mean[i] = (float) sum / num_chirps;
+        offset += chirp_mean[i];
+    }
+    offset /= num_samples;
+
+    /* Variation between the chirps */
+    for (uint32_t chirp = 0; chirp < num_chirps; chirp++)
+    {
+        const uint16_t *input = frame + chirp * num_samples;
+        for (uint32_t i = 0; i < num_samples; i++)
+        {
+            float difference = input[i] - chirp_mean[i];
+            motion += difference * difference;
+        }
+    }
+    motion /= num_samples * num_chirps;
+
+    /* Change against the clutter map; the offset is removed so that drift of
+     * the ADC level is not taken as motion */
+    if (!initialized)
+    {
+        for (uint32_t i = 0; i < num_samples; i++)
+        {
+            clutter[i] = chirp_mean[i] - offset;
+        }
+        noise_floor = motion > PRESENCE_NOISE_MIN ? motion : PRESENCE_NOISE_MIN;
+        initialized = true;
+    }
+
+    alpha = present ? PRESENCE_CLUTTER_ALPHA_HOLD : PRESENCE_CLUTTER_ALPHA;
+    for (uint32_t i = 0; i < num_samples; i++)
+    {
+        float difference = chirp_mean[i] - offset - clutter[i];
+        change += difference * difference;
+        clutter[i] += alpha * difference;
+    }
+    change /= num_samples;
+
+    energy = motion + change;
+    score = energy / noise_floor;
+
+    /* Hysteresis */
+    if (score > PRESENCE_THRESHOLD_ON)
+    {
+        present = true;
+        hold_count = 0;
+    }
+    else if (present && score < PRESENCE_THRESHOLD_OFF)
+    {
+        if (++hold_count >= PRESENCE_HOLD_FRAMES)
+        {
+            present = false;
+            hold_count = 0;
+        }
+    }
+    else
+    {
+        hold_count = 0;
+    }
+
+    /* The noise floor is only learned while nothing is present */
+    if (!present)
+    {
+        noise_floor += (energy < noise_floor ? PRESENCE_NOISE_ALPHA_DOWN : PRESENCE_NOISE_ALPHA_UP) * (energy - noise_floor);
+        if (noise_floor < PRESENCE_NOISE_MIN)
+        {
+            noise_floor = PRESENCE_NOISE_MIN;
+        }
+    }
+
+    result[0] = score;
+    result[1] = present ? 1.0f : 0.0f;
+}
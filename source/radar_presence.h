@@ -1,11 +1,8 @@
 /******************************************************************************
-* File Name:   gyro.h
+* File Name:   radar_presence.h
 *
 * Description: This file contains the function prototypes and constants used
-*   in gyro.c.
-*
-* Related Document: See README.md
-*
+*   in radar_presence.c.
 *
 *******************************************************************************
 * Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
@@ -40,26 +37,22 @@
 * so agrees to indemnify Cypress against all liability.
 *******************************************************************************/
 
-#ifndef SOURCE_GYRO_H_
-#define SOURCE_GYRO_H_
+#ifndef SOURCE_RADAR_PRESENCE_H_
+#define SOURCE_RADAR_PRESENCE_H_
 
-#include "cy_result.h"
-#include "stdbool.h"
-/******************************************************************************
- * Global Variables
- *****************************************************************************/
-extern volatile bool gyro_flag;
+#include <stdbool.h>
+#include <stdint.h>
 
 /******************************************************************************
- * Macros
+ * Constants
  *****************************************************************************/
-#define GYRO_AXIS 3
+/* Number of values in a presence result: score and state */
+#define RADAR_PRESENCE_AXIS         (2)
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-cy_rslt_t gyro_init(void);
-void gyro_get_data(float *imu_data);
-
+bool radar_presence_init(uint32_t samples, uint32_t chirps);
+void radar_presence_process(const uint16_t *frame, float *result);
 
-#endif /* SOURCE_GYRO_H_ */
+#endif /* SOURCE_RADAR_PRESENCE_H_ */
@@ -0,0 +1,304 @@
+/******************************************************************************
+* File Name:   ring.c
+*
+* Description: This file implements a lock-free single-producer single-consumer
+*              ring that carries samples and frames from interrupts to the
+*              main loop.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#ifdef IM_HOST_BUILD
+/* The host build orders the accesses with a full fence of the compiler */
+#define __DMB()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#include "cyhal.h"
+#endif
+#include "ring.h"
+
+
+/*******************************************************************************
+* Function Name: ring_init
+********************************************************************************
+* Summary:
+*  Sets up an empty ring on caller provided storage. Call it before the
+*  producer and consumer use the ring.
+*
+* Parameters:
+*  ring: the ring
+*  items: storage for capacity items
+*  item_size: the size of an item in bytes
+*  capacity: the number of items, a power of two
+*
+* Return:
+*  CY_RSLT_SUCCESS, or RING_RSLT_ERR_CAPACITY if the capacity is not a power
+*  of two.
+*
+*******************************************************************************/
+cy_rslt_t ring_init(ring_t *ring, void *items, size_t item_size, uint32_t capacity)
+{
+    if (0 == capacity || 0 != (capacity & (capacity - 1)))
+    {
+        return RING_RSLT_ERR_CAPACITY;
+    }
+
+    ring->items = items;
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->overflows = 0;
+    ring->high_water = 0;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ring_reserve
+********************************************************************************
+* Summary:
+*  Returns the slot the producer writes next, for items that are filled in
+*  place, e.g. by a bus transaction. The item is published with ring_commit.
+*  Counts an overflow if the ring is full.
+*
+* Parameters:
+*  ring: the ring
+*
+* Return:
+*  The slot, or NULL if the ring is full.
+*
+*******************************************************************************/
+void* ring_reserve(ring_t *ring)
+{
+    uint32_t head = ring->head;
+
+    if (head - ring->tail > ring->mask)
+    {
+        ring->overflows++;
+        return NULL;
+    }
+
+    return ring->items + (head & ring->mask) * ring->item_size;
+}
+
+/*******************************************************************************
+* Function Name: ring_commit
+********************************************************************************
+* Summary:
+*  Publishes the slot returned by ring_reserve to the consumer and records
+*  the high-water mark.
+*
+* Parameters:
+*  ring: the ring
+*
+*******************************************************************************/
+void ring_commit(ring_t *ring)
+{
+    uint32_t count = ring->head + 1 - ring->tail;
+
+    /* The item is written before the consumer can see it */
+    __DMB();
+    ring->head++;
+
+    if (count > ring->high_water)
+    {
+        ring->high_water = count;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ring_push
+********************************************************************************
+* Summary:
+*  Copies an item into the ring. Counts an overflow if the ring is full.
+*
+* Parameters:
+*  ring: the ring
+*  item: the item
+*
+* Return:
+*  True if the item was stored; false if it was dropped.
+*
+*******************************************************************************/
+bool ring_push(ring_t *ring, const void *item)
+{
+    void *slot = ring_reserve(ring);
+
+    if (NULL == slot)
+    {
+        return false;
+    }
+
+    memcpy(slot, item, ring->item_size);
+    ring_commit(ring);
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ring_peek
+********************************************************************************
+* Summary:
+*  Returns the oldest item without removing it, so the consumer can process
+*  it in place. The slot is handed back with ring_release.
+*
+* Parameters:
+*  ring: the ring
+*
+* Return:
+*  The item, or NULL if the ring is empty.
+*
+*******************************************************************************/
+void* ring_peek(ring_t *ring)
+{
+    uint32_t tail = ring->tail;
+
+    if (tail == ring->head)
+    {
+        return NULL;
+    }
+
+    /* The item is read after the producer published it */
+    __DMB();
+    return ring->items + (tail & ring->mask) * ring->item_size;
+}
+
+/*******************************************************************************
+* Function Name: ring_release
+********************************************************************************
+* Summary:
+*  Removes the item returned by ring_peek, handing its slot back to the
+*  producer.
+*
+* Parameters:
+*  ring: the ring
+*
+*******************************************************************************/
+void ring_release(ring_t *ring)
+{
+    /* The item is read before the producer can overwrite it */
+    __DMB();
+    ring->tail++;
+}
+
+/*******************************************************************************
+* Function Name: ring_pop
+********************************************************************************
+* Summary:
+*  Copies the oldest item out of the ring and removes it.
+*
+* Parameters:
+*  ring: the ring
+*  item: receives the item
+*
+* Return:
+*  True if an item was copied; false if the ring is empty.
+*
+*******************************************************************************/
+bool ring_pop(ring_t *ring, void *item)
+{
+    const void *slot = ring_peek(ring);
+
+    if (NULL == slot)
+    {
+        return false;
+    }
+
+    memcpy(item, slot, ring->item_size);
+    ring_release(ring);
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ring_flush
+********************************************************************************
+* Summary:
+*  Removes all items; called by the consumer, e.g. after a configuration
+*  change.
+*
+* Parameters:
+*  ring: the ring
+*
+*******************************************************************************/
+void ring_flush(ring_t *ring)
+{
+    ring->tail = ring->head;
+}
+
+/*******************************************************************************
+* Function Name: ring_count
+********************************************************************************
+* Summary:
+*  Returns the number of items in the ring.
+*
+* Parameters:
+*  ring: the ring
+*
+*******************************************************************************/
+uint32_t ring_count(const ring_t *ring)
+{
+    return ring->head - ring->tail;
+}
+
+/*******************************************************************************
+* Function Name: ring_get_overflows
+********************************************************************************
+* Summary:
+*  Returns the number of items dropped because the ring was full.
+*
+* Parameters:
+*  ring: the ring
+*
+*******************************************************************************/
+uint32_t ring_get_overflows(const ring_t *ring)
+{
+    return ring->overflows;
+}
+
+/*******************************************************************************
+* Function Name: ring_get_high_water
+********************************************************************************
+* Summary:
+*  Returns the most items the ring has held since ring_init, which shows how
+*  close the consumer came to falling behind. Flushing does not reset it.
+*
+* Parameters:
+*  ring: the ring
+*
+*******************************************************************************/
+uint32_t ring_get_high_water(const ring_t *ring)
+{
+    return ring->high_water;
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+* File Name:   ring.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in ring.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_RING_H_
+#define SOURCE_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cy_result.h"
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Module of the ring results, next to the bus results */
+#define RING_RSLT_MODULE            (CY_RSLT_MODULE_MIDDLEWARE_BASE + 0xF1u)
+
+/* The capacity of a ring is not a power of two */
+#define RING_RSLT_ERR_CAPACITY      CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, RING_RSLT_MODULE, 1u)
+
+/* A lock-free ring of fixed size items between one producer, typically an
+ * interrupt, and one consumer. Only the producer advances head and only the
+ * consumer advances tail; both count items since the start, so the number of
+ * items held is head - tail. */
+typedef struct
+{
+    uint8_t *items;
+    size_t item_size;
+    uint32_t mask;                  /* Capacity - 1; the capacity is a power of two */
+    volatile uint32_t head;         /* Items written */
+    volatile uint32_t tail;         /* Items read */
+    volatile uint32_t overflows;    /* Items dropped because the ring was full */
+    volatile uint32_t high_water;   /* Most items ever held */
+} ring_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+cy_rslt_t ring_init(ring_t *ring, void *items, size_t item_size, uint32_t capacity);
+
+/* Producer */
+void* ring_reserve(ring_t *ring);
+void ring_commit(ring_t *ring);
+bool ring_push(ring_t *ring, const void *item);
+
+/* Consumer */
+void* ring_peek(ring_t *ring);
+void ring_release(ring_t *ring);
+bool ring_pop(ring_t *ring, void *item);
+void ring_flush(ring_t *ring);
+
+uint32_t ring_count(const ring_t *ring);
+uint32_t ring_get_overflows(const ring_t *ring);
+uint32_t ring_get_high_water(const ring_t *ring);
+
+#endif /* SOURCE_RING_H_ */
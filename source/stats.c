@@ -0,0 +1,171 @@
+/******************************************************************************
+* File Name:   stats.c
+*
+* Description: This file implements the counters reported by the stats?
+*              command. They are plain increments, cheap enough to leave
+*              enabled; building without IM_ENABLE_STATS removes them.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#include "cyhal.h"
+#include "stats.h"
+
+#ifdef IM_ENABLE_STATS
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+static stats_t counters;
+
+
+/*******************************************************************************
+* Function Definitions
+*******************************************************************************/
+
+/*******************************************************************************
+* Function Name: stats_frame
+********************************************************************************
+* Summary:
+*  Counts a frame sent to the host.
+*
+* Parameters:
+*  channel: the channel (1-11) of the frame
+*  size: number of bytes sent, including header and trailer
+*
+*******************************************************************************/
+void stats_frame(uint8_t channel, size_t size)
+{
+    if (channel >= 1 && channel <= STATS_CHANNELS)
+    {
+        counters.frames[channel - 1]++;
+        counters.bytes[channel - 1] += size;
+    }
+}
+
+/*******************************************************************************
+* Function Name: stats_transmit
+********************************************************************************
+* Summary:
+*  Counts a call of streaming_send and the time it blocked.
+*
+* Parameters:
+*  start: the cycle count returned by stats_now at the start of the call
+*
+*******************************************************************************/
+void stats_transmit(uint32_t start)
+{
+    uint32_t cycles = cycles_get() - start;
+
+    counters.transmit_count++;
+    counters.transmit_cycles += cycles;
+    if (cycles > counters.transmit_max)
+    {
+        counters.transmit_max = cycles;
+    }
+}
+
+/*******************************************************************************
+* Function Name: stats_loop
+********************************************************************************
+* Summary:
+*  Adds an iteration of the main loop to the histogram.
+*
+* Parameters:
+*  cycles: the duration of the iteration in CPU cycles
+*
+*******************************************************************************/
+void stats_loop(uint32_t cycles)
+{
+    uint32_t us = cycles / (SystemCoreClock / 1000000u);
+    uint32_t bucket = 0;
+
+    /* The bucket bounds are powers of two */
+    if (us >= STATS_LOOP_MIN_US)
+    {
+        bucket = __CLZ(STATS_LOOP_MIN_US) - __CLZ(us) + 1;
+        if (bucket >= STATS_LOOP_BUCKETS)
+        {
+            bucket = STATS_LOOP_BUCKETS - 1;
+        }
+    }
+    counters.loop[bucket]++;
+}
+
+/*******************************************************************************
+* Function Name: stats_unrecognized
+********************************************************************************
+* Summary:
+*  Counts an unrecognized command.
+*
+*******************************************************************************/
+void stats_unrecognized(void)
+{
+    counters.unrecognized++;
+}
+
+/*******************************************************************************
+* Function Name: stats_too_long
+********************************************************************************
+* Summary:
+*  Counts a command that did not fit the receive buffer.
+*
+*******************************************************************************/
+void stats_too_long(void)
+{
+    counters.too_long++;
+}
+
+/*******************************************************************************
+* Function Name: stats_get
+********************************************************************************
+* Summary:
+*  Returns a consistent copy of the counters. The counters run from reset and
+*  wrap around.
+*
+* Parameters:
+*  stats: receives the counters
+*
+*******************************************************************************/
+void stats_get(stats_t *stats)
+{
+    uint32_t saved_intr_status = cyhal_system_critical_section_enter();
+
+    memcpy(stats, &counters, sizeof(counters));
+    cyhal_system_critical_section_exit(saved_intr_status);
+}
+
+#endif /* IM_ENABLE_STATS */
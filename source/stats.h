@@ -0,0 +1,104 @@
+/******************************************************************************
+* File Name:   stats.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in stats.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_STATS_H_
+#define SOURCE_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cycles.h"
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Channels 1 to STATS_CHANNELS are counted */
+#define STATS_CHANNELS          (11u)
+
+/* Buckets of the main loop iteration time histogram. Bucket 0 counts the
+ * iterations shorter than STATS_LOOP_MIN_US, each following bucket those up
+ * to twice as long as the previous bound, and the last one all longer ones. */
+#define STATS_LOOP_BUCKETS      (14u)
+#define STATS_LOOP_MIN_US       (16u)
+
+/* Counters reported by stats? */
+typedef struct
+{
+    uint32_t frames[STATS_CHANNELS];    /* Frames sent per channel */
+    uint32_t bytes[STATS_CHANNELS];     /* Bytes sent per channel, with header and trailer */
+    uint32_t transmit_count;            /* Calls of streaming_send */
+    uint64_t transmit_cycles;           /* Cycles spent blocked in streaming_send */
+    uint32_t transmit_max;              /* Longest streaming_send in cycles */
+    uint32_t loop[STATS_LOOP_BUCKETS];  /* Main loop iteration time histogram */
+    uint32_t unrecognized;              /* Unrecognized commands */
+    uint32_t too_long;                  /* Commands longer than the receive buffer */
+} stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+#ifdef IM_ENABLE_STATS
+void stats_frame(uint8_t channel, size_t size);
+void stats_transmit(uint32_t start);
+void stats_loop(uint32_t cycles);
+void stats_unrecognized(void);
+void stats_too_long(void);
+void stats_get(stats_t *stats);
+
+/*******************************************************************************
+* Function Name: stats_now
+********************************************************************************
+* Summary:
+*  Returns the start of a measured section, passed on to stats_transmit.
+*
+*******************************************************************************/
+static inline uint32_t stats_now(void)
+{
+    return cycles_get();
+}
+#else
+/* Without IM_ENABLE_STATS the counters compile to nothing */
+static inline void stats_frame(uint8_t channel, size_t size) { (void) channel; (void) size; }
+static inline void stats_transmit(uint32_t start) { (void) start; }
+static inline void stats_loop(uint32_t cycles) { (void) cycles; }
+static inline void stats_unrecognized(void) { }
+static inline void stats_too_long(void) { }
+static inline uint32_t stats_now(void) { return 0; }
+#endif
+
+#endif /* SOURCE_STATS_H_ */
@@ -40,6 +40,8 @@
 *******************************************************************************/
 
 #include "streaming.h"
+#include "profile.h"
+#include "stats.h"
 
 /* SUPPORT FOR USB CDC AND DEBUG UART
  * ==================================
@@ -167,9 +169,13 @@ size_t streaming_receive(void* data, size_t size)
 *******************************************************************************/
 void streaming_send(const void* data, size_t size)
 {
+    PROFILE_SCOPE(PROFILE_STREAMING_SEND);
+    uint32_t start = stats_now();
+
     /* Write and block until write is complete */
     USBD_CDC_Write(usb_cdcHandle, data, size, 0);
     USBD_CDC_WaitForTX(usb_cdcHandle, 0);
+    stats_transmit(start);
 }
 
 /*******************************************************************************
@@ -344,6 +350,9 @@ size_t streaming_receive(void* data, size_t size)
 *******************************************************************************/
 void streaming_send(const void* data, size_t size)
 {
+    PROFILE_SCOPE(PROFILE_STREAMING_SEND);
+    uint32_t start = stats_now();
+
     /* Ensure UART available */
     while (uart_busy)
         cyhal_system_delay_ms(1);
@@ -351,6 +360,7 @@ void streaming_send(const void* data, size_t size)
 
     /* Do write */
     cyhal_uart_write_async(&uart_obj, (void*)data, size);
+    stats_transmit(start);
 }
 
 #endif
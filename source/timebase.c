@@ -0,0 +1,730 @@
+/******************************************************************************
+* File Name:   timebase.c
+*
+* Description: This file implements the timebase of the periodic timers. A
+*              single hardware counter runs freely at TIMEBASE_FREQUENCY and its
+*              compare interrupt is set to the next due software timer. It
+*              also measures the drift of independent clocks, which the
+*              timers that set sample instants may follow.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "cyhal.h"
+#include "cy_pdl.h"
+#include "timebase.h"
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* The counter wraps at 16 bits, which is supported by every TCPWM counter;
+ * the wraps are counted in software */
+#define TIMEBASE_COUNT_BITS     (16u)
+#define TIMEBASE_COUNT_MASK     ((1u << TIMEBASE_COUNT_BITS) - 1u)
+
+/* The callbacks run at the priority of the bus interrupts, since they start
+ * bus transactions and the radar trigger writes to its sensor synchronously */
+#define TIMEBASE_PRIORITY       (7u)
+
+/* The compare value is set at least this many ticks ahead of the counter, so
+ * that it is written before the counter gets there */
+#define TIMEBASE_MARGIN         (2u)
+
+/* Fractional bits of the timer periods and due times */
+#define TIMEBASE_FRACTION_BITS  (32u)
+
+/* A rate is measured over at least one second before its drift is reported,
+ * and a reference that is off by more than TIMEBASE_CORRECTION_MAX parts per
+ * billion is not followed */
+#define TIMEBASE_RATE_MIN_TICKS ((uint64_t) TIMEBASE_FREQUENCY)
+#define TIMEBASE_CORRECTION_MAX (1000000)
+
+
+/*******************************************************************************
+* Static Variables
+*******************************************************************************/
+static cyhal_timer_t timebase_obj;
+
+/* Upper bits of the tick count and the count when it was last read */
+static uint64_t timebase_high = 0;
+static uint32_t timebase_last = 0;
+
+/* Active timers ordered by due time */
+static timebase_timer_t *timebase_timers = NULL;
+
+/* The clock that the disciplined timers follow, and its drift in parts per
+ * billion as applied to their periods */
+static const timebase_rate_t *timebase_reference = NULL;
+static int32_t timebase_correction = 0;
+
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static void timebase_handler(void *callback_arg, cyhal_timer_event_t event);
+static timebase_timer_t *timebase_next(void);
+static void timebase_insert(timebase_timer_t *timer);
+static void timebase_remove(timebase_timer_t *timer);
+static void timebase_arm(void);
+static void timebase_discipline(void);
+static uint64_t timebase_step(const timebase_timer_t *timer);
+static uint32_t timebase_due(const timebase_timer_t *timer);
+
+
+/*******************************************************************************
+* Function Name: timebase_init
+********************************************************************************
+* Summary:
+*   Starts the counter of the timebase. It counts up to the 16 bit wrap and
+*   interrupts on the wrap and when the compare value is reached.
+*
+* Return:
+*   The status of the initialization.
+*
+*******************************************************************************/
+cy_rslt_t timebase_init(void)
+{
+    cy_rslt_t result;
+    const cyhal_timer_cfg_t timer_cfg =
+    {
+        .compare_value = TIMEBASE_COUNT_MASK, /* Set by the timers */
+        .period = TIMEBASE_COUNT_MASK,      /* Wrap after 2^16 counts */
+        .direction = CYHAL_TIMER_DIR_UP,    /* Timer counts up */
+        .is_compare = true,                 /* Interrupt on the compare value */
+        .is_continuous = true,              /* Run the timer indefinitely */
+        .value = 0                          /* Initial value of counter */
+    };
+
+    /* Initialize the timer object. Does not use pin output ('pin' is NC) and
+     * does not use a pre-configured clock source ('clk' is NULL). */
+    result = cyhal_timer_init(&timebase_obj, NC, NULL);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    /* Apply timer configuration such as period, count direction, run mode, etc. */
+    result = cyhal_timer_configure(&timebase_obj, &timer_cfg);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    result = cyhal_timer_set_frequency(&timebase_obj, TIMEBASE_FREQUENCY);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+
+    /* The wrap interrupt guarantees that the count is read at least once per
+     * wrap, which timebase_get_ticks relies on */
+    cyhal_timer_register_callback(&timebase_obj, timebase_handler, NULL);
+    cyhal_timer_enable_event(&timebase_obj,
+                             (cyhal_timer_event_t) (CYHAL_TIMER_IRQ_TERMINAL_COUNT | CYHAL_TIMER_IRQ_CAPTURE_COMPARE),
+                             TIMEBASE_PRIORITY, true);
+
+    return cyhal_timer_start(&timebase_obj);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_get_ticks
+********************************************************************************
+* Summary:
+*   Returns the ticks since timebase_init. A wrap is detected as a count that
+*   is lower than the previous one.
+*
+* Return:
+*   The number of ticks at TIMEBASE_FREQUENCY.
+*
+*******************************************************************************/
+uint64_t timebase_get_ticks(void)
+{
+    uint64_t ticks;
+    uint32_t state = cyhal_system_critical_section_enter();
+    uint32_t count = cyhal_timer_read(&timebase_obj) & TIMEBASE_COUNT_MASK;
+
+    if (count < timebase_last)
+    {
+        timebase_high += 1u << TIMEBASE_COUNT_BITS;
+    }
+    timebase_last = count;
+    ticks = timebase_high | count;
+
+    cyhal_system_critical_section_exit(state);
+
+    return ticks;
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_timer_init
+********************************************************************************
+* Summary:
+*   Sets up a stopped software timer.
+*
+* Parameters:
+*   timer: the timer
+*   callback: called from the timebase interrupt each time the timer is due
+*   arg: passed to the callback
+*   disciplined: whether the timer follows the reference clock set by
+*                timebase_set_reference; for timers that set sample instants
+*
+*******************************************************************************/
+void timebase_timer_init(timebase_timer_t *timer, timebase_callback_t callback, void *arg, bool disciplined)
+{
+    timer->next = NULL;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->period = 0;
+    timer->step = 0;
+    timer->position = 0;
+    timer->disciplined = disciplined;
+    timer->active = false;
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_start
+********************************************************************************
+* Summary:
+*   Starts or restarts a timer that is called a number of times in a number
+*   of ticks, e.g. 1600 times in TIMEBASE_FREQUENCY ticks for 1600 Hz. The
+*   period need not be a whole number of ticks; the fraction is accumulated,
+*   so the average rate is exact. The timer is due at phase ticks past each
+*   multiple of the period, counted from timebase_init, so timers with the
+*   same period and different phases never fire together. A timer that is
+*   late is not called again for the periods it missed.
+*
+* Parameters:
+*   timer: the timer, set up by timebase_timer_init
+*   ticks: ticks in which the timer is called calls times
+*   calls: number of calls in ticks; the period is at least one tick and below
+*          2^31 ticks
+*   phase: offset into the period in ticks; reduced modulo the period
+*
+* Return:
+*   The status; TIMEBASE_RSLT_ERR_PERIOD if the period is out of range.
+*
+*******************************************************************************/
+cy_rslt_t timebase_start(timebase_timer_t *timer, uint32_t ticks, uint32_t calls, uint32_t phase)
+{
+    uint32_t state;
+    uint64_t now;
+    uint64_t index;
+    uint64_t offset;
+
+    if (0 == calls || ticks < calls || ticks / calls >= (1u << 31))
+    {
+        return TIMEBASE_RSLT_ERR_PERIOD;
+    }
+    phase %= ticks / calls;
+
+    state = cyhal_system_critical_section_enter();
+
+    if (timer->active)
+    {
+        timebase_remove(timer);
+    }
+
+    /* The first call after now; call index is due at phase + index * ticks / calls */
+    now = timebase_get_ticks();
+    index = now > phase ? (now - phase) * calls / ticks : 0;
+    while (phase + index * ticks / calls <= now)
+    {
+        index++;
+    }
+    offset = index * ticks;
+
+    timer->period = ((uint64_t) ticks << TIMEBASE_FRACTION_BITS) / calls;
+    timer->step = timebase_step(timer);
+    timer->position = ((uint64_t) (uint32_t) (phase + offset / calls) << TIMEBASE_FRACTION_BITS) |
+                      (((offset % calls) << TIMEBASE_FRACTION_BITS) / calls);
+    timer->active = true;
+    timebase_insert(timer);
+    timebase_arm();
+
+    cyhal_system_critical_section_exit(state);
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_stop
+********************************************************************************
+* Summary:
+*   Stops a timer. The callback is not called after this returns, unless it
+*   is called from a higher priority interrupt than the timebase.
+*
+* Parameters:
+*   timer: the timer
+*
+*******************************************************************************/
+void timebase_stop(timebase_timer_t *timer)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+
+    if (timer->active)
+    {
+        timebase_remove(timer);
+        timer->active = false;
+        timebase_arm();
+    }
+
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_set_reference
+********************************************************************************
+* Summary:
+*   Sets the clock that the disciplined timers follow, or none. Without a
+*   reference the timers run at their nominal periods.
+*
+* Parameters:
+*   reference: the measured rate of the reference clock, or NULL
+*
+*******************************************************************************/
+void timebase_set_reference(const timebase_rate_t *reference)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+
+    timebase_reference = reference;
+    if (NULL == reference)
+    {
+        timebase_correction = 0;
+        for (timebase_timer_t *timer = timebase_timers; NULL != timer; timer = timer->next)
+        {
+            timer->step = timer->period;
+        }
+    }
+
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_get_correction
+********************************************************************************
+* Summary:
+*   Returns the correction applied to the disciplined timers.
+*
+* Return:
+*   The drift of the reference clock in parts per billion, 0 without one.
+*
+*******************************************************************************/
+int32_t timebase_get_correction(void)
+{
+    return timebase_correction;
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_rate_init
+********************************************************************************
+* Summary:
+*   Starts a new measurement of a clock.
+*
+* Parameters:
+*   rate: the measurement
+*   nominal: the nominal rate of the clock in samples per second
+*
+*******************************************************************************/
+void timebase_rate_init(timebase_rate_t *rate, uint32_t nominal)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+
+    rate->nominal = nominal;
+    rate->count = 0;
+    rate->samples = 0;
+    rate->first_ticks = 0;
+    rate->last_ticks = 0;
+    rate->started = false;
+
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_rate_update
+********************************************************************************
+* Summary:
+*   Records the number of samples the clock has produced by now. The first
+*   update starts the measurement. The count may wrap.
+*
+* Parameters:
+*   rate: the measurement
+*   count: a running count of the samples
+*
+*******************************************************************************/
+void timebase_rate_update(timebase_rate_t *rate, uint32_t count)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+    uint64_t now = timebase_get_ticks();
+
+    if (rate->started)
+    {
+        rate->samples += count - rate->count;
+    }
+    else
+    {
+        rate->first_ticks = now;
+        rate->started = true;
+    }
+    rate->count = count;
+    rate->last_ticks = now;
+
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_rate_get_drift
+********************************************************************************
+* Summary:
+*   Returns the drift of a clock against the timebase: how much faster than
+*   nominal it produced samples, over the whole measurement.
+*
+* Parameters:
+*   rate: the measurement
+*   ppb: receives the drift in parts per billion
+*   seconds: receives the length of the measurement
+*
+* Return:
+*   True if the measurement is long enough to report a drift.
+*
+*******************************************************************************/
+bool timebase_rate_get_drift(const timebase_rate_t *rate, int32_t *ppb, uint32_t *seconds)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+    uint64_t samples = rate->samples;
+    uint64_t ticks = rate->last_ticks - rate->first_ticks;
+    uint32_t nominal = rate->nominal;
+    bool started = rate->started;
+    double drift;
+
+    cyhal_system_critical_section_exit(state);
+
+    if (!started || 0 == nominal || ticks < TIMEBASE_RATE_MIN_TICKS)
+    {
+        return false;
+    }
+
+    drift = ((double) samples * TIMEBASE_FREQUENCY / ((double) ticks * nominal) - 1.0) * 1e9;
+    if (drift > INT32_MAX || drift < INT32_MIN)
+    {
+        return false;
+    }
+    *ppb = (int32_t) drift;
+    *seconds = (uint32_t) (ticks / TIMEBASE_FREQUENCY);
+
+    return true;
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_rate_get_ticks
+********************************************************************************
+* Summary:
+*   Returns the time on the timebase at which a clock reached a sample count:
+*   the time of the last update, moved by the samples in between at the
+*   measured rate, or at the nominal rate until the measurement is long enough
+*   to report a drift.
+*
+* Parameters:
+*   rate: the measurement
+*   count: the running count of the samples, as passed to timebase_rate_update
+*
+* Return:
+*   The time in ticks of the timebase; 0 before the first update.
+*
+*******************************************************************************/
+uint64_t timebase_rate_get_ticks(const timebase_rate_t *rate, uint32_t count)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+    uint64_t samples = rate->samples;
+    uint64_t ticks = rate->last_ticks - rate->first_ticks;
+    uint64_t last_ticks = rate->last_ticks;
+    int32_t offset = (int32_t) (count - rate->count);
+    uint32_t nominal = rate->nominal;
+    bool started = rate->started;
+    double ticks_per_sample;
+
+    cyhal_system_critical_section_exit(state);
+
+    if (!started || 0 == nominal)
+    {
+        return 0;
+    }
+
+    if (ticks >= TIMEBASE_RATE_MIN_TICKS && samples > 0)
+    {
+        ticks_per_sample = (double) ticks / samples;
+    }
+    else
+    {
+        ticks_per_sample = (double) TIMEBASE_FREQUENCY / nominal;
+    }
+
+    return last_ticks + (int64_t) (offset * ticks_per_sample + (offset < 0 ? -0.5 : 0.5));
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_handler
+********************************************************************************
+* Summary:
+*   Interrupt handler of the counter. Calls the timers that are due, in order
+*   of their due time, and sets the compare value to the next one. The
+*   discipline is updated on each wrap.
+*
+* Parameters:
+*     callback_arg: not used
+*     event: the wrap, the compare match or both
+*
+*******************************************************************************/
+static void timebase_handler(void *callback_arg, cyhal_timer_event_t event)
+{
+    timebase_timer_t *timer;
+
+    (void) callback_arg;
+
+    if (0 != (event & CYHAL_TIMER_IRQ_TERMINAL_COUNT))
+    {
+        timebase_discipline();
+    }
+
+    while (NULL != (timer = timebase_next()))
+    {
+        timer->callback(timer->arg);
+    }
+
+    timebase_arm();
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_next
+********************************************************************************
+* Summary:
+*   Takes the first timer if it is due and moves it to its next due time. The
+*   periods that were missed are skipped.
+*
+* Return:
+*   The timer that is due, or NULL.
+*
+*******************************************************************************/
+static timebase_timer_t *timebase_next(void)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+    uint32_t now = (uint32_t) timebase_get_ticks();
+    timebase_timer_t *timer = timebase_timers;
+
+    if (NULL != timer && (int32_t) (timebase_due(timer) - now) <= 0)
+    {
+        timebase_timers = timer->next;
+        do
+        {
+            timer->position += timer->step;
+        } while ((int32_t) (timebase_due(timer) - now) <= 0);
+        timebase_insert(timer);
+    }
+    else
+    {
+        timer = NULL;
+    }
+
+    cyhal_system_critical_section_exit(state);
+
+    return timer;
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_arm
+********************************************************************************
+* Summary:
+*   Sets the compare value to the first timer, or shortly ahead of the counter
+*   if that timer is already due. The compare value only holds the lower bits,
+*   so a timer more than one wrap ahead causes interrupts before it is due,
+*   which find nothing to do.
+*
+*******************************************************************************/
+static void timebase_arm(void)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+    uint32_t now;
+    uint32_t due;
+
+    if (NULL != timebase_timers)
+    {
+        now = (uint32_t) timebase_get_ticks();
+        due = timebase_due(timebase_timers);
+        if ((int32_t) (due - now) < (int32_t) TIMEBASE_MARGIN)
+        {
+            due = now + TIMEBASE_MARGIN;
+        }
+        Cy_TCPWM_Counter_SetCompare0(timebase_obj.tcpwm.base, timebase_obj.tcpwm.resource.channel_num,
+                                     due & TIMEBASE_COUNT_MASK);
+    }
+
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_discipline
+********************************************************************************
+* Summary:
+*   Takes over the drift of the reference clock and applies it to the periods
+*   of the active disciplined timers. The drift is measured since the start of
+*   the reference, so it converges as the measurement grows longer; the last
+*   correction is kept while a new measurement is too short.
+*
+*******************************************************************************/
+static void timebase_discipline(void)
+{
+    timebase_timer_t *timer;
+    uint32_t seconds;
+    uint32_t state;
+    int32_t ppb;
+
+    if (NULL == timebase_reference || !timebase_rate_get_drift(timebase_reference, &ppb, &seconds) ||
+        ppb > TIMEBASE_CORRECTION_MAX || ppb < -TIMEBASE_CORRECTION_MAX || ppb == timebase_correction)
+    {
+        return;
+    }
+
+    state = cyhal_system_critical_section_enter();
+    timebase_correction = ppb;
+    for (timer = timebase_timers; NULL != timer; timer = timer->next)
+    {
+        timer->step = timebase_step(timer);
+    }
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_step
+********************************************************************************
+* Summary:
+*   Returns the period of a timer after the discipline. A reference clock that
+*   runs fast shortens the periods of the disciplined timers by the same
+*   ratio, so that they keep in step with it.
+*
+* Parameters:
+*   timer: the timer
+*
+*******************************************************************************/
+static uint64_t timebase_step(const timebase_timer_t *timer)
+{
+    if (!timer->disciplined || 0 == timebase_correction)
+    {
+        return timer->period;
+    }
+
+    return (uint64_t) ((double) timer->period / (1.0 + timebase_correction * 1e-9));
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_due
+********************************************************************************
+* Summary:
+*   Returns the tick at which a timer is due, which wraps with the lower 32
+*   bits of the ticks.
+*
+* Parameters:
+*   timer: the timer
+*
+*******************************************************************************/
+static uint32_t timebase_due(const timebase_timer_t *timer)
+{
+    return (uint32_t) (timer->position >> TIMEBASE_FRACTION_BITS);
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_insert
+********************************************************************************
+* Summary:
+*   Inserts a timer into the list of active timers after the timers that are
+*   due at the same time or earlier.
+*
+* Parameters:
+*   timer: the timer, not in the list
+*
+*******************************************************************************/
+static void timebase_insert(timebase_timer_t *timer)
+{
+    timebase_timer_t **link = &timebase_timers;
+
+    while (NULL != *link && (int32_t) (timebase_due(*link) - timebase_due(timer)) <= 0)
+    {
+        link = &(*link)->next;
+    }
+    timer->next = *link;
+    *link = timer;
+}
+
+
+/*******************************************************************************
+* Function Name: timebase_remove
+********************************************************************************
+* Summary:
+*   Removes a timer from the list of active timers.
+*
+* Parameters:
+*   timer: the timer, in the list
+*
+*******************************************************************************/
+static void timebase_remove(timebase_timer_t *timer)
+{
+    timebase_timer_t **link = &timebase_timers;
+
+    while (NULL != *link && timer != *link)
+    {
+        link = &(*link)->next;
+    }
+    if (NULL != *link)
+    {
+        *link = timer->next;
+    }
+    timer->next = NULL;
+}
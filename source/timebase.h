@@ -0,0 +1,107 @@
+/******************************************************************************
+* File Name:   timebase.h
+*
+* Description: This file contains the function prototypes and constants used
+*   in timebase.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_TIMEBASE_H_
+#define SOURCE_TIMEBASE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cy_result.h"
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Ticks per second of the timebase */
+#define TIMEBASE_FREQUENCY          (100000u)
+
+/* Module of the timebase results, next to the bus results */
+#define TIMEBASE_RSLT_MODULE        (CY_RSLT_MODULE_MIDDLEWARE_BASE + 0xF3u)
+
+/* The period of a timer is below one tick or not below 2^31 ticks */
+#define TIMEBASE_RSLT_ERR_PERIOD    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, TIMEBASE_RSLT_MODULE, 1u)
+
+/*******************************************************************************
+* Types
+*******************************************************************************/
+typedef void (*timebase_callback_t)(void *arg);
+
+/* A periodic software timer. The fields are owned by the timebase; a timer is
+ * set up once by timebase_timer_init and then started and stopped. Times are
+ * kept in ticks with 32 fractional bits, so periods that are not a whole
+ * number of ticks do not accumulate rounding errors. */
+typedef struct timebase_timer
+{
+    struct timebase_timer *next;
+    timebase_callback_t callback;
+    void *arg;
+    uint64_t period;        /* Nominal period */
+    uint64_t step;          /* Period after the discipline */
+    uint64_t position;      /* Due time; the integer part wraps with the ticks */
+    bool disciplined;
+    bool active;
+} timebase_timer_t;
+
+/* The measured rate of a clock that is independent of the timebase, such as
+ * the PDM clock or the oscillator of a sensor */
+typedef struct
+{
+    uint32_t nominal;       /* Nominal samples per second */
+    uint32_t count;         /* Sample count at the last update */
+    uint64_t samples;       /* Samples since the first update */
+    uint64_t first_ticks;
+    uint64_t last_ticks;
+    bool started;
+} timebase_rate_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+cy_rslt_t timebase_init(void);
+uint64_t timebase_get_ticks(void);
+void timebase_timer_init(timebase_timer_t *timer, timebase_callback_t callback, void *arg, bool disciplined);
+cy_rslt_t timebase_start(timebase_timer_t *timer, uint32_t ticks, uint32_t calls, uint32_t phase);
+void timebase_stop(timebase_timer_t *timer);
+void timebase_rate_init(timebase_rate_t *rate, uint32_t nominal);
+void timebase_rate_update(timebase_rate_t *rate, uint32_t count);
+bool timebase_rate_get_drift(const timebase_rate_t *rate, int32_t *ppb, uint32_t *seconds);
+uint64_t timebase_rate_get_ticks(const timebase_rate_t *rate, uint32_t count);
+void timebase_set_reference(const timebase_rate_t *reference);
+int32_t timebase_get_correction(void);
+
+#endif /* SOURCE_TIMEBASE_H_ */
@@ -0,0 +1,454 @@
+/******************************************************************************
+* File Name:   bench_events.c
+*
+* Description: This file benchmarks the event loop and the transmit pipeline
+*              on the host: events.c and pipeline.c, built with or without
+*              IM_ENABLE_RTOS, run stub sensors whose timer interrupts post
+*              frames at the rates of the firmware, and a stub protocol sends
+*              them over a link of the bandwidth of the USB interface. It
+*              reports the throughput and the latencies of each channel and
+*              event.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "clock.h"
+#include "cyabs_rtos.h"
+#include "cycles.h"
+#include "events.h"
+#include "hal.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "protocol.h"
+#include "ring.h"
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+#define BENCH_SECONDS               (5u)
+
+/* Bytes per second of the link; full speed USB CDC reaches about 1 MB/s */
+#define BENCH_LINK_RATE             (1000000u)
+
+/* Time for the queued frames to drain after the timers stop */
+#define BENCH_DRAIN_MS              (500u)
+
+/* Interval of the clock tick that polls for commands in the bare-metal
+ * build; the transmit task polls in the RTOS build */
+#define BENCH_PROTOCOL_US           (10000u)
+
+/* Samples a sensor interrupt can queue for its handler */
+#define BENCH_RING_CAPACITY         (16u)
+
+/* Latencies kept per channel for the percentiles */
+#define BENCH_LATENCIES             (1u << 16)
+
+#define BENCH_FRAME_MAX             (PROTOCOL_HEADER_SIZE + 4096u + PROTOCOL_TRAILER_SIZE)
+
+#ifdef IM_ENABLE_RTOS
+#define BENCH_BUILD                 "RTOS"
+#else
+#define BENCH_BUILD                 "bare-metal"
+#endif
+
+typedef enum
+{
+    BENCH_SEND,                     /* pipeline_send */
+    BENCH_SEND_COUNTS,              /* pipeline_send_counts */
+    BENCH_SEND_PACKET               /* pipeline_send_packet */
+} bench_format_t;
+
+/* What an interrupt hands to the handler, and the start of each frame */
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t cycles;
+} bench_sample_t;
+
+/* A stub sensor: each timer interrupt queues a sample and posts the event;
+ * the handler sends a frame per sample */
+typedef struct
+{
+    const char *name;
+    event_t event;
+    uint8_t channel;
+    bench_format_t format;
+    uint32_t period_us;
+    size_t size;                    /* Payload bytes per frame */
+
+    ring_t ring;
+    bench_sample_t samples[BENCH_RING_CAPACITY];
+    pipeline_pool_t pool;
+    uint8_t buffers[PIPELINE_BUFFERS][BENCH_FRAME_MAX];
+
+    volatile uint32_t generated;    /* Samples of the interrupt */
+    uint32_t sent;                  /* Frames that reached the link */
+    uint32_t next;                  /* Sequence number expected next */
+    uint32_t missing;               /* Frames that never reached the link */
+    uint64_t bytes;
+    uint32_t latencies[BENCH_LATENCIES];
+    uint32_t latency_count;
+} bench_sensor_t;
+
+/* The rates and frame sizes of the firmware: 16 kHz audio in frames of 256
+ * samples, raw radar frames every 5 ms, IMU frames of 8 samples at 400 Hz,
+ * pressure at 32 Hz and the magnetometer at 50 Hz */
+static bench_sensor_t sensors[] =
+{
+    { .name = "audio", .event = EVENT_AUDIO, .channel = PROTOCOL_AUDIO_CHANNEL, .format = BENCH_SEND,
+      .period_us = 16000u, .size = 512u },
+    { .name = "radar", .event = EVENT_RADAR, .channel = PROTOCOL_RADAR_CHANNEL, .format = BENCH_SEND_PACKET,
+      .period_us = 5000u, .size = 4096u },
+    { .name = "imu", .event = EVENT_IMU, .channel = PROTOCOL_IMU_CHANNEL, .format = BENCH_SEND_COUNTS,
+      .period_us = 20000u, .size = 48u },
+    { .name = "dps", .event = EVENT_DPS, .channel = PROTOCOL_DPS_CHANNEL, .format = BENCH_SEND,
+      .period_us = 31250u, .size = 8u },
+    { .name = "mag", .event = EVENT_MAG, .channel = PROTOCOL_BMM_CHANNEL, .format = BENCH_SEND_COUNTS,
+      .period_us = 20000u, .size = 6u },
+};
+
+#define BENCH_SENSORS               (sizeof(sensors) / sizeof(sensors[0]))
+
+static uint32_t link_rate = BENCH_LINK_RATE;
+static uint32_t protocol_polls = 0;
+static cy_thread_t main_thread;
+
+
+/*******************************************************************************
+* Function Name: bench_interrupt
+********************************************************************************
+* Summary:
+*  The timer interrupt of a sensor: queues a numbered, timestamped sample and
+*  posts the event of the sensor. A sample that does not fit is counted by
+*  the ring.
+*
+*******************************************************************************/
+static void bench_interrupt(bench_sensor_t *sensor)
+{
+    bench_sample_t sample = { sensor->generated++, cycles_get() };
+
+    ring_push(&sensor->ring, &sample);
+    events_post(sensor->event);
+}
+
+/*******************************************************************************
+* Function Name: bench_handle
+********************************************************************************
+* Summary:
+*  The handler of a sensor: sends a frame for each queued sample, starting
+*  with the sample, through the pipeline like the handlers of main.c.
+*
+*******************************************************************************/
+static void bench_handle(bench_sensor_t *sensor)
+{
+    bench_sample_t sample;
+
+    while (ring_pop(&sensor->ring, &sample))
+    {
+        uint8_t *buffer = pipeline_acquire(&sensor->pool);
+
+        switch (sensor->format)
+        {
+            case BENCH_SEND_COUNTS:
+                memcpy(buffer, &sample, sizeof(sample));
+                pipeline_send_counts(sensor->channel, (int16_t*) buffer, sensor->size / sizeof(int16_t), 1.0f,
+                                     &sensor->pool);
+                break;
+            case BENCH_SEND_PACKET:
+                memcpy(buffer + PROTOCOL_HEADER_SIZE, &sample, sizeof(sample));
+                pipeline_send_packet(sensor->channel, buffer, sensor->size, &sensor->pool, NULL);
+                break;
+            default:
+                memcpy(buffer, &sample, sizeof(sample));
+                pipeline_send(sensor->channel, buffer, sensor->size, &sensor->pool);
+                break;
+        }
+    }
+}
+
+/* Interrupt handlers and event handlers take no arguments */
+static void interrupt_audio(void) { bench_interrupt(&sensors[0]); }
+static void interrupt_radar(void) { bench_interrupt(&sensors[1]); }
+static void interrupt_imu(void) { bench_interrupt(&sensors[2]); }
+static void interrupt_dps(void) { bench_interrupt(&sensors[3]); }
+static void interrupt_mag(void) { bench_interrupt(&sensors[4]); }
+static void handle_audio(void) { bench_handle(&sensors[0]); }
+static void handle_radar(void) { bench_handle(&sensors[1]); }
+static void handle_imu(void) { bench_handle(&sensors[2]); }
+static void handle_dps(void) { bench_handle(&sensors[3]); }
+static void handle_mag(void) { bench_handle(&sensors[4]); }
+
+static void (* const interrupts[])(void) =
+{
+    interrupt_audio, interrupt_radar, interrupt_imu, interrupt_dps, interrupt_mag
+};
+static void (* const handlers[])(void) =
+{
+    handle_audio, handle_radar, handle_imu, handle_dps, handle_mag
+};
+
+#ifndef IM_ENABLE_RTOS
+static void interrupt_clock(void)
+{
+    events_post(EVENT_PROTOCOL);
+}
+
+static void handle_protocol(void)
+{
+    while (protocol_repl())
+    {
+    }
+}
+#endif
+
+/*******************************************************************************
+* Function Name: bench_transmit
+********************************************************************************
+* Summary:
+*  Sends a frame over the link: blocks for the time the link takes for the
+*  packet, then records the latency from the interrupt of the sample and
+*  checks the sequence number.
+*
+*******************************************************************************/
+static void bench_transmit(uint8_t channel, const void *payload, size_t size)
+{
+    uint64_t ns = (uint64_t) (PROTOCOL_HEADER_SIZE + size + PROTOCOL_TRAILER_SIZE) * 1000000000u / link_rate;
+    struct timespec delay = { (time_t) (ns / 1000000000u), (long) (ns % 1000000000u) };
+    bench_sample_t sample;
+
+    nanosleep(&delay, NULL);
+    memcpy(&sample, payload, sizeof(sample));
+
+    for (uint32_t i = 0; i < BENCH_SENSORS; i++)
+    {
+        bench_sensor_t *sensor = &sensors[i];
+        if (sensor->channel != channel)
+        {
+            continue;
+        }
+        if (sensor->latency_count < BENCH_LATENCIES)
+        {
+            sensor->latencies[sensor->latency_count++] = cycles_get() - sample.cycles;
+        }
+        if (sample.sequence >= sensor->next)
+        {
+            sensor->missing += sample.sequence - sensor->next;
+            sensor->next = sample.sequence + 1;
+        }
+        sensor->sent++;
+        sensor->bytes += size;
+    }
+}
+
+/* The protocol of the benchmark: every channel is subscribed, frames go to
+ * the link and there are no commands */
+void protocol_send(uint8_t channel, const uint8_t* data, size_t count)
+{
+    bench_transmit(channel, data, count);
+}
+
+void protocol_send_counts(uint8_t channel, const int16_t* data, size_t count, float scale)
+{
+    (void) scale;
+    bench_transmit(channel, data, count * sizeof(int16_t));
+}
+
+void protocol_send_packet(uint8_t channel, uint8_t* packet, size_t count)
+{
+    bench_transmit(channel, packet + PROTOCOL_HEADER_SIZE, count);
+}
+
+bool protocol_is_subscribed(uint8_t channel)
+{
+    (void) channel;
+    return true;
+}
+
+bool protocol_repl()
+{
+    protocol_polls++;
+    return false;
+}
+
+uint32_t clock_get_ms()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((uint64_t) now.tv_sec * 1000u + (uint64_t) now.tv_nsec / 1000000u);
+}
+
+static int compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_main(cy_thread_arg_t arg)
+{
+    (void) arg;
+    events_run();
+}
+
+/*******************************************************************************
+* Function Name: bench_report
+********************************************************************************
+* Summary:
+*  Prints the throughput and latencies of the channels, from the interrupt to
+*  the end of the transmission, and the latencies and handler times of the
+*  events, from profile.c, in microseconds.
+*
+* Return:
+*  The number of sensors whose samples are not all accounted for, as sent or
+*  as ring overflows.
+*
+*******************************************************************************/
+static int bench_report(uint32_t seconds)
+{
+    static const char* const EVENT_NAMES[EVENT_COUNT] = { "audio", "radar", "imu", "dps", "mag", "protocol" };
+    int failures = 0;
+
+    printf("%s build, %u s, link %u bytes/s, task priorities %s\n", BENCH_BUILD, seconds, link_rate,
+           cy_rtos_priorities_applied() ? "applied" : "not applied (no real-time scheduling)");
+    printf("%-9s %8s %8s %9s %10s %10s %10s\n", "channel", "frames", "lost", "bytes/s", "p50 us", "p99 us",
+           "max us");
+    for (uint32_t i = 0; i < BENCH_SENSORS; i++)
+    {
+        bench_sensor_t *sensor = &sensors[i];
+        uint32_t overflows = ring_get_overflows(&sensor->ring);
+        uint32_t count = sensor->latency_count;
+
+        /* The samples lost after the last frame sent */
+        sensor->missing += sensor->generated - sensor->next;
+
+        qsort(sensor->latencies, count, sizeof(uint32_t), compare);
+        printf("%-9s %8u %8u %9llu %10.1f %10.1f %10.1f\n", sensor->name, sensor->sent, overflows,
+               (unsigned long long) (sensor->bytes / seconds),
+               count ? sensor->latencies[count / 2] / 1000.0 : 0.0,
+               count ? sensor->latencies[count - 1 - count / 100] / 1000.0 : 0.0,
+               count ? sensor->latencies[count - 1] / 1000.0 : 0.0);
+
+        if (sensor->sent + overflows != sensor->generated || sensor->missing != overflows)
+        {
+            printf("%s: %u samples, %u sent, %u missing, %u overflows\n", sensor->name, sensor->generated,
+                   sensor->sent, sensor->missing, overflows);
+            failures++;
+        }
+    }
+
+    printf("%-9s %8s %9s %10s %10s %10s %10s\n", "event", "runs", "merged", "latency", "p99 us", "handler",
+           "p99 us");
+    for (uint32_t event = 0; event < EVENT_COUNT; event++)
+    {
+        profile_summary_t latency;
+        profile_summary_t handler;
+        event_stats_t stats;
+
+        events_get_stats((event_t) event, &stats);
+        profile_get((profile_region_t) (PROFILE_LATENCY_AUDIO + event), &latency);
+        profile_get((profile_region_t) (PROFILE_HANDLER_AUDIO + event), &handler);
+        if (0 == stats.count)
+        {
+            continue;
+        }
+        printf("%-9s %8u %9u %10.1f %10.1f %10.1f %10.1f\n", EVENT_NAMES[event], stats.count, stats.coalesced,
+               latency.avg / 1000.0, latency.p99 / 1000.0, handler.avg / 1000.0, handler.p99 / 1000.0);
+    }
+    printf("command polls: %u\n", protocol_polls);
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t seconds = argc > 1 ? (uint32_t) atoi(argv[1]) : BENCH_SECONDS;
+    struct timespec drain = { 0, BENCH_DRAIN_MS * 1000000L };
+
+    if (argc > 2)
+    {
+        link_rate = (uint32_t) atoi(argv[2]);
+    }
+    if (0 == seconds || 0 == link_rate)
+    {
+        printf("usage: %s [seconds] [link bytes/s]\n", argv[0]);
+        return 2;
+    }
+
+    events_init();
+    for (uint32_t i = 0; i < BENCH_SENSORS; i++)
+    {
+        bench_sensor_t *sensor = &sensors[i];
+        if (CY_RSLT_SUCCESS != ring_init(&sensor->ring, sensor->samples, sizeof(bench_sample_t),
+                                         BENCH_RING_CAPACITY) ||
+            CY_RSLT_SUCCESS != pipeline_pool_init(&sensor->pool, sensor->buffers, sizeof(sensor->buffers[0]),
+                                                  PIPELINE_BUFFERS))
+        {
+            return 2;
+        }
+        events_register(sensor->event, handlers[i]);
+    }
+#ifndef IM_ENABLE_RTOS
+    events_register(EVENT_PROTOCOL, handle_protocol);
+#endif
+    if (CY_RSLT_SUCCESS != pipeline_init())
+    {
+        return 2;
+    }
+
+    /* The main context of the firmware runs the event loop, or creates the
+     * tasks and waits, in a thread of its own */
+    cy_rtos_create_thread(&main_thread, bench_main, "main", NULL, 0, CY_RTOS_PRIORITY_NORMAL, NULL);
+
+    for (uint32_t i = 0; i < BENCH_SENSORS; i++)
+    {
+        hal_timer_start(sensors[i].period_us, interrupts[i]);
+    }
+#ifndef IM_ENABLE_RTOS
+    hal_timer_start(BENCH_PROTOCOL_US, interrupt_clock);
+#endif
+
+    for (uint32_t remaining = seconds; remaining > 0; )
+    {
+        remaining = sleep(remaining);
+    }
+    hal_timer_stop();
+    nanosleep(&drain, NULL);
+
+    return bench_report(seconds) ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+/* Generated by radar_two_targets.py; do not edit */
+
+#define RADAR_TEST_SAMPLES          (64)
+#define RADAR_TEST_CHIRPS           (32)
+
+/* Range bin, Doppler bin relative to zero velocity, amplitude in counts */
+static const int32_t radar_test_targets[2][3] =
+{
+    { 10, 5, 600 },
+    { 21, -3, 300 },
+};
+
+/* [chirp][sample] */
+static const uint16_t radar_test_frame[2048] =
+{
+    2736, 1707, 1548, 1766, 1731, 2522, 2879, 1963, 1635, 1729, 1540, 2279, 2929, 2204, 1785, 1762,
+    1400, 2007, 2880, 2402, 1959, 1880, 1334, 1722, 2729, 2528, 2134, 2050, 1357, 1463, 2519, 2558,
+    2277, 2258, 1478, 1273, 2263, 2509, 2359, 2469, 1691, 1180, 2009, 2392, 2358, 2639, 1946, 1179,
+    1783, 2227, 2280, 2747, 2238, 1280, 1620, 2042, 2139, 2765, 2512, 1465, 1545, 1886, 1942, 2689,
+    2277, 1343, 1383, 2293, 2371, 2456, 2517, 1544, 1268, 2069, 2249, 2438, 2708, 1805, 1242, 1869,
+    2081, 2331, 2839, 2094, 1318, 1727, 1906, 2155, 2877, 2383, 1470, 1661, 1759, 1940, 2815, 2621,
+    1685, 1683, 1664, 1696, 2661, 2781, 1916, 1781, 1635, 1473, 2429, 2854, 2136, 1931, 1697, 1310,
+    2148, 2829, 2310, 2102, 1846, 1226, 1858, 2713, 2411, 2271, 2047, 1239, 1589, 2526, 2429, 2396,
+    1782, 1518, 1734, 2770, 2641, 1941, 1894, 1504, 1486, 2553, 2730, 2128, 2064, 1587, 1289, 2282,
+    2719, 2273, 2243, 1746, 1173, 2000, 2621, 2347, 2415, 1966, 1158, 1738, 2460, 2347, 2542, 2227,
+    1253, 1524, 2261, 2265, 2595, 2493, 1424, 1398, 2058, 2119, 2565, 2717, 1674, 1364, 1888, 1944,
+    2446, 2876, 1952, 1420, 1776, 1761, 2244, 2938, 2237, 1546, 1738, 1611, 2003, 2905, 2474, 1736,
+    1670, 2156, 2214, 2742, 2403, 1363, 1540, 1985, 2052, 2708, 2649, 1584, 1504, 1832, 1844, 2582,
+    2835, 1844, 1550, 1756, 1643, 2381, 2934, 2107, 1676, 1740, 1477, 2119, 2923, 2336, 1843, 1812,
+    1375, 1831, 2814, 2504, 2030, 1952, 1363, 1566, 2622, 2588, 2197, 2148, 1438, 1339, 2380, 2580,
+    2308, 2353, 1606, 1196, 2116, 2486, 2362, 2538, 1842, 1156, 1864, 2343, 2328, 2678, 2119, 1216,
+    1972, 2790, 2385, 2164, 1944, 1241, 1690, 2629, 2454, 2315, 2166, 1305, 1449, 2412, 2437, 2413,
+    2399, 1462, 1286, 2177, 2340, 2434, 2611, 1692, 1225, 1956, 2194, 2381, 2774, 1978, 1252, 1775,
+    2020, 2244, 2857, 2266, 1379, 1664, 1853, 2040, 2839, 2538, 1566, 1642, 1730, 1813, 2726, 2740,
+    1802, 1698, 1667, 1586, 2527, 2858, 2040, 1822, 1679, 1394, 2262, 2871, 2240, 1986, 1781, 1270,
+    2330, 2915, 2126, 1453, 1739, 1709, 2105, 2926, 2390, 1623, 1740, 1589, 1855, 2828, 2597, 1826,
+    1812, 1530, 1599, 2649, 2727, 2027, 1948, 1565, 1377, 2402, 2759, 2211, 2129, 1676, 1222, 2114,
+    2706, 2325, 2302, 1871, 1166, 1837, 2571, 2368, 2456, 2117, 1208, 1589, 2378, 2327, 2552, 2372,
+    1348, 1425, 2166, 2223, 2557, 2620, 1564, 1336, 1969, 2062, 2482, 2808, 1841, 1354, 1825, 1877,
+    2335, 2432, 1748, 1162, 1961, 2453, 2352, 2597, 2002, 1168, 1733, 2280, 2284, 2689, 2283, 1282,
+    1565, 2091, 2144, 2710, 2557, 1483, 1486, 1920, 1963, 2632, 2774, 1730, 1490, 1794, 1760, 2465,
+    2906, 2000, 1578, 1743, 1576, 2223, 2943, 2253, 1731, 1774, 1445, 1955, 2884, 2458, 1913, 1876,
+    1382, 1673, 2723, 2579, 2094, 2039, 1413, 1424, 2496, 2621, 2244, 2237, 1543, 1249, 2232, 2569,
+    1930, 1726, 1684, 1492, 2367, 2896, 2157, 1869, 1732, 1340, 2090, 2855, 2342, 2040, 1865, 1257,
+    1797, 2726, 2455, 2217, 2055, 1280, 1534, 2532, 2476, 2343, 2278, 1400, 1337, 2295, 2424, 2414,
+    2506, 1600, 1225, 2050, 2307, 2398, 2689, 1861, 1213, 1845, 2143, 2308, 2806, 2156, 1294, 1689,
+    1965, 2137, 2839, 2435, 1464, 1617, 1815, 1932, 2773, 2666, 1686, 1633, 1706, 1704, 2611, 2828,
+    1466, 1341, 2067, 2166, 2509, 2722, 1721, 1312, 1890, 1999, 2390, 2871, 2006, 1369, 1766, 1821,
+    2201, 2924, 2287, 1508, 1721, 1673, 1967, 2874, 2528, 1706, 1754, 1581, 1708, 2733, 2704, 1925,
+    1859, 1567, 1471, 2507, 2781, 2123, 2008, 1636, 1290, 2236, 2766, 2277, 2189, 1790, 1189, 1939,
+    2665, 2363, 2361, 2002, 1180, 1675, 2491, 2370, 2478, 2260, 1278, 1467, 2283, 2298, 2535, 2505,
+    1418, 1529, 2601, 2641, 2157, 2121, 1499, 1311, 2353, 2633, 2285, 2317, 1661, 1181, 2076, 2550,
+    2347, 2495, 1899, 1146, 1816, 2394, 2328, 2626, 2171, 1219, 1614, 2208, 2228, 2678, 2448, 1384,
+    1482, 2023, 2068, 2646, 2688, 1617, 1450, 1865, 1878, 2529, 2860, 1882, 1498, 1766, 1687, 2319,
+    2941, 2153, 1620, 1747, 1529, 2067, 2920, 2388, 1791, 1808, 1431, 1790, 2808, 2554, 1986, 1936,
+    1908, 2036, 2789, 2583, 1570, 1588, 1775, 1817, 2673, 2779, 1812, 1640, 1710, 1605, 2464, 2888,
+    2060, 1760, 1711, 1420, 2205, 2902, 2275, 1925, 1801, 1307, 1916, 2808, 2423, 2103, 1958, 1286,
+    1635, 2642, 2500, 2261, 2169, 1352, 1405, 2406, 2487, 2362, 2386, 1515, 1248, 2158, 2402, 2393,
+    2586, 1756, 1191, 1925, 2258, 2351, 2741, 2032, 1228, 1735, 2076, 2223, 2811, 2323, 1365, 1624,
+    2601, 2398, 2395, 2140, 1241, 1532, 2402, 2362, 2492, 2389, 1388, 1367, 2182, 2267, 2504, 2627,
+    1610, 1287, 1968, 2115, 2438, 2805, 1889, 1303, 1814, 1934, 2288, 2898, 2182, 1413, 1719, 1768,
+    2073, 2897, 2448, 1587, 1703, 1646, 1830, 2794, 2654, 1806, 1776, 1584, 1584, 2608, 2785, 2020,
+    1905, 1612, 1373, 2344, 2810, 2211, 2076, 1728, 1233, 2055, 2745, 2343, 2247, 1905, 1184, 1775,
+    2942, 2300, 1676, 1767, 1494, 1907, 2867, 2514, 1870, 1855, 1446, 1633, 2699, 2638, 2062, 2009,
+    1476, 1397, 2464, 2676, 2217, 2198, 1596, 1233, 2193, 2626, 2319, 2384, 1799, 1155, 1920, 2503,
+    2351, 2542, 2056, 1179, 1679, 2321, 2297, 2638, 2325, 1299, 1508, 2130, 2167, 2648, 2588, 1511,
+    1425, 1951, 1992, 2566, 2789, 1763, 1434, 1820, 1808, 2402, 2917, 2046, 1526, 1748, 1624, 2172,
+    2655, 1922, 1187, 1800, 2200, 2286, 2765, 2207, 1285, 1646, 2020, 2136, 2792, 2485, 1461, 1566,
+    1862, 1931, 2712, 2713, 1694, 1580, 1748, 1718, 2547, 2867, 1944, 1661, 1714, 1516, 2312, 2923,
+    2191, 1815, 1754, 1375, 2028, 2872, 2379, 1987, 1882, 1302, 1744, 2732, 2500, 2165, 2059, 1335,
+    1482, 2524, 2534, 2299, 2268, 1457, 1292, 2279, 2485, 2374, 2485, 1659, 1187, 2025, 2367, 2368,
+    1959, 1681, 1299, 2181, 2811, 2296, 2134, 1830, 1212, 1882, 2694, 2396, 2297, 2032, 1219, 1616,
+    2518, 2413, 2419, 2277, 1323, 1407, 2293, 2345, 2484, 2518, 1520, 1287, 2073, 2220, 2455, 2718,
+    1775, 1263, 1876, 2050, 2347, 2851, 2067, 1330, 1746, 1880, 2169, 2893, 2347, 1487, 1686, 1726,
+    1947, 2837, 2593, 1690, 1711, 1635, 1702, 2684, 2758, 1919, 1807, 1618, 1473, 2460, 2832, 2131,
+    1387, 1885, 1917, 2473, 2875, 1933, 1445, 1780, 1738, 2275, 2947, 2208, 1573, 1745, 1586, 2023,
+    2910, 2445, 1754, 1796, 1491, 1746, 2783, 2615, 1948, 1910, 1476, 1498, 2568, 2704, 2137, 2078,
+    1551, 1299, 2305, 2694, 2275, 2270, 1720, 1179, 2029, 2595, 2349, 2446, 1948, 1152, 1766, 2440,
+    2334, 2569, 2215, 1234, 1560, 2248, 2251, 2622, 2482, 1408, 1423, 2047, 2105, 2587, 2709, 1651,
+    1359, 2396, 2544, 2322, 2362, 1575, 1213, 2130, 2464, 2369, 2558, 1813, 1168, 1892, 2311, 2330,
+    2699, 2094, 1216, 1695, 2136, 2218, 2762, 2377, 1363, 1573, 1955, 2044, 2733, 2632, 1582, 1536,
+    1823, 1840, 2617, 2819, 1835, 1582, 1742, 1634, 2406, 2922, 2089, 1705, 1739, 1460, 2146, 2915,
+    2310, 1872, 1817, 1356, 1862, 2817, 2474, 2050, 1964, 1337, 1588, 2635, 2554, 2214, 2151, 1408,
+    1813, 2754, 2713, 1803, 1725, 1636, 1582, 2550, 2836, 2031, 1851, 1660, 1386, 2288, 2858, 2227,
+    2019, 1759, 1259, 2004, 2782, 2369, 2187, 1941, 1214, 1719, 2626, 2432, 2339, 2159, 1277, 1474,
+    2416, 2414, 2438, 2395, 1437, 1314, 2178, 2316, 2453, 2618, 1664, 1239, 1958, 2170, 2397, 2782,
+    1947, 1264, 1786, 1989, 2253, 2873, 2238, 1385, 1690, 1826, 2052, 2860, 2509, 1577, 1669, 1696,
+    2313, 2580, 2363, 1329, 1452, 2159, 2203, 2586, 2611, 1546, 1366, 1968, 2033, 2513, 2804, 1809,
+    1376, 1824, 1852, 2354, 2920, 2095, 1477, 1748, 1684, 2126, 2933, 2364, 1635, 1752, 1555, 1868,
+    2847, 2567, 1834, 1829, 1498, 1609, 2669, 2702, 2036, 1970, 1537, 1378, 2424, 2736, 2210, 2148,
+    1651, 1225, 2142, 2680, 2319, 2337, 1853, 1160, 1862, 2547, 2355, 2486, 2098, 1192, 1619, 2364,
+    2426, 1934, 1876, 1354, 1692, 2733, 2554, 2114, 2044, 1388, 1448, 2504, 2592, 2264, 2246, 1509,
+    1258, 2248, 2541, 2346, 2453, 1720, 1170, 1985, 2424, 2350, 2620, 1980, 1178, 1758, 2256, 2278,
+    2720, 2264, 1276, 1596, 2067, 2141, 2734, 2530, 1467, 1514, 1907, 1950, 2661, 2751, 1716, 1520,
+    1785, 1742, 2490, 2894, 1980, 1605, 1734, 1559, 2251, 2937, 2232, 1759, 1771, 1421, 1976, 2882,
+    2122, 1300, 1711, 1932, 2145, 2859, 2408, 1467, 1645, 1781, 1935, 2795, 2646, 1678, 1656, 1686,
+    1696, 2635, 2807, 1920, 1748, 1657, 1481, 2401, 2879, 2143, 1900, 1722, 1325, 2116, 2843, 2325,
+    2073, 1852, 1240, 1822, 2719, 2429, 2242, 2051, 1259, 1565, 2525, 2450, 2372, 2279, 1372, 1363,
+    2299, 2394, 2430, 2510, 1575, 1242, 2063, 2279, 2419, 2705, 1837, 1220, 1851, 2112, 2317, 2829,
+    1763, 1185, 1968, 2640, 2356, 2383, 1986, 1168, 1706, 2478, 2358, 2515, 2242, 1264, 1499, 2276,
+    2281, 2568, 2500, 1447, 1370, 2064, 2146, 2536, 2725, 1699, 1335, 1891, 1969, 2418, 2872, 1980,
+    1396, 1772, 1786, 2226, 2935, 2265, 1529, 1732, 1644, 1983, 2895, 2500, 1715, 1764, 1546, 1724,
+    2752, 2675, 1931, 1878, 1532, 1477, 2528, 2755, 2126, 2036, 1613, 1289, 2260, 2741, 2274, 2219,
+    1763, 1666, 2355, 2941, 2132, 1651, 1745, 1502, 2094, 2926, 2358, 1820, 1818, 1405, 1811, 2816,
+    2529, 2002, 1951, 1389, 1540, 2617, 2617, 2171, 2132, 1467, 1323, 2368, 2607, 2300, 2332, 1630,
+    1187, 2092, 2518, 2347, 2518, 1867, 1156, 1844, 2371, 2325, 2651, 2144, 1216, 1645, 2185, 2218,
+    2714, 2423, 1369, 1510, 2003, 2056, 2679, 2672, 1603, 1478, 1851, 1863, 2554, 2852, 1869, 1522,
+    2170, 2371, 2419, 2601, 1721, 1206, 1944, 2230, 2360, 2758, 2009, 1242, 1758, 2053, 2231, 2839,
+    2295, 1371, 1642, 1883, 2035, 2817, 2565, 1571, 1615, 1752, 1815, 2698, 2759, 1804, 1666, 1683,
+    1595, 2498, 2877, 2042, 1791, 1700, 1407, 2230, 2884, 2259, 1958, 1795, 1286, 1941, 2802, 2405,
+    2127, 1955, 1254, 1657, 2638, 2474, 2287, 2167, 1328, 1424, 2414, 2459, 2383, 2396, 1489, 1267,
+    2625, 2754, 2023, 1931, 1586, 1376, 2375, 2785, 2205, 2098, 1705, 1225, 2090, 2725, 2329, 2281,
+    1894, 1169, 1804, 2589, 2381, 2425, 2125, 1216, 1563, 2386, 2350, 2519, 2386, 1363, 1389, 2178,
+    2244, 2534, 2619, 1587, 1312, 1971, 2086, 2458, 2804, 1866, 1328, 1814, 1909, 2311, 2907, 2154,
+    1429, 1729, 1738, 2092, 2910, 2423, 1608, 1725, 1611, 1841, 2813, 2630, 1817, 1798, 1557, 1591,
+    2680, 2571, 1496, 1458, 1934, 1974, 2603, 2779, 1749, 1458, 1809, 1779, 2436, 2916, 2019, 1548,
+    1754, 1606, 2200, 2946, 2279, 1700, 1771, 1474, 1929, 2876, 2487, 1891, 1867, 1414, 1649, 2713,
+    2613, 2080, 2025, 1442, 1411, 2482, 2653, 2228, 2213, 1566, 1239, 2216, 2597, 2329, 2406, 1775,
+    1155, 1943, 2480, 2346, 2566, 2029, 1171, 1704, 2300, 2289, 2665, 2305, 1291, 1540, 2109, 2152,
+    2189, 2056, 1306, 1513, 2530, 2510, 2323, 2278, 1429, 1317, 2281, 2458, 2394, 2492, 1626, 1205,
+    2036, 2336, 2380, 2671, 1893, 1200, 1824, 2168, 2298, 2788, 2182, 1286, 1665, 1991, 2134, 2813,
+    2458, 1454, 1599, 1836, 1932, 2742, 2694, 1686, 1604, 1728, 1705, 2583, 2848, 1932, 1699, 1702,
+    1510, 2344, 2913, 2169, 1838, 1748, 1354, 2060, 2865, 2363, 2013, 1876, 1283, 1768, 2735, 2477,
+    1498, 1701, 1701, 1953, 2855, 2559, 1695, 1730, 1606, 1700, 2713, 2732, 1920, 1830, 1586, 1473,
+    2484, 2810, 2122, 1981, 1657, 1298, 2208, 2787, 2289, 2164, 1807, 1200, 1912, 2682, 2379, 2326,
+    2020, 1199, 1649, 2508, 2394, 2455, 2270, 1301, 1443, 2287, 2319, 2511, 2509, 1489, 1313, 2068,
+    2194, 2484, 2722, 1746, 1286, 1882, 2025, 2369, 2861, 2033, 1353, 1752, 1845, 2190, 2913, 2317,
+    1154, 1793, 2417, 2326, 2599, 2192, 1226, 1589, 2224, 2239, 2650, 2466, 1391, 1459, 2039, 2082,
+    2619, 2698, 1635, 1420, 1877, 1899, 2498, 2871, 1909, 1472, 1771, 1715, 2297, 2945, 2183, 1591,
+    1753, 1557, 2038, 2915, 2416, 1772, 1799, 1458, 1770, 2792, 2591, 1966, 1932, 1452, 1510, 2593,
+    2675, 2147, 2099, 1530, 1302, 2326, 2660, 2277, 2289, 1689, 1182, 2048, 2569, 2340, 2472, 1920,
+    1437, 2172, 2910, 2294, 1902, 1805, 1328, 1884, 2816, 2447, 2078, 1960, 1310, 1610, 2632, 2526,
+    2239, 2163, 1380, 1383, 2402, 2517, 2343, 2378, 1545, 1227, 2147, 2434, 2384, 2574, 1780, 1176,
+    1906, 2281, 2335, 2719, 2063, 1218, 1715, 2107, 2219, 2786, 2357, 1357, 1597, 1937, 2043, 2768,
+    2610, 1568, 1558, 1796, 1830, 2647, 2806, 1820, 1612, 1721, 1612, 2439, 2907, 2071, 1732, 1725,
+    2141, 2415, 2791, 1920, 1283, 1805, 1965, 2268, 2890, 2214, 1397, 1701, 1794, 2064, 2879, 2478,
+    1582, 1687, 1675, 1817, 2778, 2684, 1799, 1751, 1613, 1584, 2583, 2810, 2027, 1878, 1642, 1379,
+    2316, 2831, 2218, 2040, 1749, 1241, 2032, 2762, 2352, 2223, 1926, 1202, 1750, 2614, 2413, 2371,
+    2149, 1254, 1503, 2405, 2384, 2458, 2400, 1407, 1334, 2182, 2294, 2477, 2626, 1637, 1267, 1967,
+    2710, 2215, 2175, 1626, 1225, 2164, 2658, 2316, 2364, 1825, 1152, 1893, 2521, 2349, 2513, 2076,
+    1183, 1652, 2344, 2299, 2610, 2342, 1310, 1482, 2142, 2180, 2619, 2598, 1524, 1397, 1957, 2018,
+    2543, 2801, 1785, 1402, 1819, 1827, 2383, 2923, 2068, 1501, 1749, 1654, 2147, 2939, 2329, 1658,
+    1762, 1526, 1886, 2861, 2543, 1852, 1850, 1475, 1621, 2690, 2670, 2050, 1995, 1509, 1387, 2447,
+};
+
+/* Range profile in hundredths, [chirp][bin] */
+static const uint32_t radar_test_profile[1024] =
+{
+    112, 178, 250, 312, 215, 153, 223, 218, 252, 60117, 119882, 59828, 24, 53, 91, 131,
+    107, 151, 67, 129, 29901, 59938, 30060, 101, 133, 153, 118, 150, 113, 290, 185, 38,
+    44, 88, 85, 238, 127, 94, 69, 27, 61, 60075, 120030, 60000, 46, 252, 228, 100,
+    84, 123, 232, 309, 29795, 59928, 30080, 223, 239, 160, 71, 96, 198, 108, 42, 38,
+    66, 120, 94, 117, 193, 80, 24, 92, 144, 60083, 120037, 60034, 98, 106, 60, 58,
+    151, 82, 49, 110, 29950, 60161, 30167, 72, 292, 273, 239, 166, 141, 139, 154, 76,
+    206, 242, 130, 225, 223, 22, 92, 59, 95, 60254, 120251, 60064, 47, 77, 26, 63,
+    212, 227, 141, 202, 29987, 59974, 29786, 388, 210, 118, 187, 147, 53, 144, 129, 31,
+    121, 49, 74, 228, 153, 62, 104, 235, 195, 60082, 120057, 59978, 87, 87, 77, 168,
+    158, 136, 97, 204, 30156, 60034, 29856, 302, 186, 60, 213, 266, 189, 97, 103, 130,
+    170, 121, 116, 44, 137, 239, 212, 95, 118, 60091, 119932, 59941, 63, 184, 316, 351,
+    145, 127, 124, 153, 30042, 59874, 29914, 57, 189, 217, 65, 235, 188, 88, 192, 110,
+    138, 65, 157, 387, 220, 149, 214, 127, 149, 60103, 120223, 60143, 123, 184, 183, 55,
+    51, 43, 45, 10, 29982, 60068, 30033, 124, 130, 50, 56, 126, 92, 13, 71, 33,
+    280, 267, 176, 62, 30, 233, 258, 17, 153, 59865, 119951, 59944, 56, 150, 278, 166,
+    76, 11, 49, 78, 30021, 59911, 29955, 123, 78, 10, 113, 126, 211, 308, 204, 181,
+    424, 341, 190, 154, 162, 164, 178, 175, 87, 59861, 119693, 59728, 228, 286, 224, 50,
+    138, 103, 64, 71, 30089, 60224, 30091, 99, 19, 88, 14, 118, 98, 172, 205, 229,
+    413, 292, 70, 128, 126, 154, 65, 94, 147, 59969, 119980, 59889, 220, 170, 102, 24,
+    134, 230, 126, 135, 30015, 60182, 30238, 287, 240, 211, 138, 23, 47, 161, 87, 62,
+    343, 249, 155, 195, 237, 227, 218, 130, 92, 59909, 119835, 59903, 153, 200, 159, 94,
+    113, 62, 27, 140, 29974, 59911, 30056, 161, 84, 188, 169, 185, 218, 196, 188, 18,
+    323, 141, 94, 116, 136, 43, 72, 115, 136, 60053, 120039, 59980, 75, 62, 126, 281,
+    179, 194, 229, 174, 30012, 60130, 30123, 22, 69, 74, 75, 90, 178, 257, 64, 167,
+    512, 383, 234, 182, 164, 187, 113, 114, 308, 60064, 119868, 59945, 179, 191, 163, 124,
+    172, 146, 194, 109, 29969, 59887, 29822, 212, 65, 92, 58, 36, 55, 203, 105, 32,
+    164, 177, 140, 104, 119, 212, 263, 180, 194, 60148, 120010, 59942, 52, 141, 37, 122,
+    155, 185, 125, 31, 30041, 59999, 30009, 82, 14, 142, 313, 379, 227, 114, 170, 46,
+    13, 90, 141, 150, 131, 194, 165, 65, 183, 59841, 119816, 59926, 106, 86, 57, 245,
+    195, 66, 83, 104, 30012, 60052, 30254, 147, 144, 103, 152, 236, 104, 74, 99, 23,
+    119, 150, 307, 179, 61, 122, 150, 128, 167, 60073, 119992, 59976, 88, 199, 154, 138,
+    198, 97, 204, 326, 29765, 59932, 29946, 71, 89, 160, 145, 38, 154, 220, 269, 206,
+    320, 223, 165, 217, 140, 136, 220, 159, 46, 59838, 119666, 59875, 88, 87, 95, 133,
+    87, 82, 84, 19, 29939, 59887, 29826, 244, 159, 49, 139, 215, 191, 208, 154, 117,
+    46, 255, 144, 83, 100, 163, 157, 201, 71, 60089, 120175, 60110, 56, 91, 199, 196,
+    118, 188, 148, 221, 30012, 59992, 29970, 120, 77, 89, 126, 115, 352, 316, 62, 73,
+    17, 58, 133, 135, 156, 76, 99, 109, 146, 59964, 119977, 60090, 165, 110, 125, 38,
+    111, 189, 146, 25, 30037, 60030, 29965, 44, 143, 264, 264, 182, 53, 217, 142, 79,
+    139, 229, 199, 222, 159, 89, 111, 74, 231, 59789, 119939, 60095, 204, 205, 141, 75,
+    76, 77, 84, 59, 30059, 60063, 30210, 248, 86, 92, 119, 108, 300, 347, 179, 168,
+    289, 136, 80, 190, 233, 196, 153, 121, 211, 60073, 120036, 59995, 28, 154, 133, 220,
+    231, 35, 205, 293, 29814, 59934, 30041, 80, 91, 106, 97, 98, 58, 61, 65, 130,
+    299, 243, 50, 101, 162, 259, 163, 165, 229, 59918, 120038, 60052, 170, 128, 191, 153,
+    115, 150, 167, 103, 30085, 60070, 30049, 68, 77, 210, 184, 92, 113, 141, 34, 30,
+    130, 160, 201, 189, 218, 195, 142, 227, 221, 60097, 120110, 60089, 151, 86, 52, 21,
+    91, 178, 32, 265, 29947, 60193, 30118, 81, 147, 86, 68, 207, 265, 164, 89, 175,
+    59, 96, 81, 129, 133, 79, 298, 250, 55, 60029, 120051, 60050, 259, 322, 234, 119,
+    203, 205, 84, 48, 30001, 60034, 29944, 93, 49, 66, 154, 125, 91, 201, 209, 102,
+    286, 107, 41, 72, 172, 217, 70, 96, 76, 60170, 120223, 60134, 203, 144, 180, 301,
+    142, 132, 118, 54, 29991, 59895, 29832, 80, 111, 173, 144, 197, 207, 97, 25, 120,
+    139, 111, 141, 123, 79, 73, 140, 153, 165, 60079, 120147, 60173, 298, 325, 164, 164,
+    83, 99, 84, 220, 29852, 59963, 30061, 129, 117, 31, 120, 196, 222, 119, 66, 79,
+    142, 224, 198, 120, 139, 355, 239, 60, 21, 59932, 119986, 60047, 65, 82, 272, 238,
+    93, 188, 75, 130, 29892, 59944, 30099, 122, 48, 85, 207, 282, 171, 25, 64, 110,
+    475, 343, 169, 154, 249, 335, 179, 39, 37, 60092, 120090, 59960, 83, 139, 250, 83,
+    93, 128, 103, 29, 29800, 59747, 29930, 225, 263, 186, 45, 135, 143, 69, 42, 59,
+    197, 138, 245, 369, 226, 136, 82, 83, 40, 59935, 119891, 60060, 91, 178, 231, 203,
+    187, 246, 145, 121, 30006, 59976, 29830, 151, 154, 260, 266, 325, 123, 167, 147, 156,
+    174, 54, 252, 194, 179, 171, 70, 203, 86, 59923, 120107, 60113, 95, 212, 105, 91,
+    204, 254, 162, 74, 30079, 59945, 29891, 96, 101, 101, 48, 90, 171, 125, 217, 168,
+    123, 148, 35, 266, 339, 236, 130, 188, 114, 59899, 119918, 59843, 192, 116, 68, 121,
+    121, 44, 131, 182, 30017, 60115, 30087, 127, 306, 323, 127, 75, 212, 196, 101, 137,
+    60, 138, 73, 143, 47, 145, 234, 185, 207, 60118, 120053, 60105, 140, 155, 157, 54,
+    101, 84, 66, 43, 30011, 60004, 29867, 115, 123, 175, 135, 89, 176, 24, 144, 156,
+};
+
+/* Range-Doppler map in hundredths, [Doppler bin][range bin] */
+static const uint32_t radar_test_map[1024] =
+{
+    4, 14, 12, 24, 14, 9, 7, 7, 18, 22, 18, 5, 18, 23, 27, 9,
+    10, 14, 20, 26, 23, 13, 5, 7, 5, 18, 29, 30, 24, 10, 2, 2,
+    12, 8, 21, 16, 12, 14, 15, 26, 33, 23, 16, 9, 12, 11, 7, 10,
+    11, 23, 31, 30, 33, 24, 20, 2, 4, 13, 21, 19, 18, 15, 16, 6,
+    9, 14, 21, 8, 7, 7, 6, 23, 29, 15, 14, 16, 9, 9, 14, 14,
+    6, 13, 23, 22, 20, 19, 20, 8, 6, 6, 7, 12, 15, 11, 22, 11,
+    3, 15, 22, 14, 11, 4, 17, 25, 17, 13, 18, 8, 6, 8, 6, 11,
+    9, 13, 7, 23, 16, 1, 2, 5, 4, 13, 14, 7, 7, 8, 21, 18,
+    10, 10, 15, 17, 13, 6, 17, 15, 7, 11, 33, 23, 15, 23, 9, 17,
+    29, 26, 6, 10, 8, 9, 22, 11, 10, 19, 23, 17, 11, 1, 14, 15,
+    19, 20, 13, 10, 2, 14, 29, 16, 7, 10, 30, 13, 9, 17, 13, 13,
+    31, 29, 14, 7, 7, 12, 33, 23, 7, 16, 25, 15, 16, 29, 18, 5,
+    11, 16, 8, 7, 10, 26, 37, 27, 9, 22, 20, 7, 16, 12, 19, 22,
+    19, 17, 10, 7, 23, 29, 28, 30, 21, 22, 26, 17, 12, 32, 16, 7,
+    20, 15, 7, 13, 17, 22, 25, 26, 28, 37, 27, 3, 8, 15, 19, 32,
+    29, 9, 4, 10, 25, 17, 27, 35, 28, 28, 21, 24, 16, 12, 11, 14,
+    40, 25, 13, 24, 29, 27, 19, 14, 28, 25, 19, 14, 7, 6, 0, 21,
+    27, 9, 6, 10, 3, 15, 29, 28, 16, 11, 18, 22, 15, 8, 9, 9,
+    28, 16, 11, 18, 19, 21, 11, 14, 13, 4, 14, 14, 5, 16, 14, 5,
+    15, 16, 15, 7, 14, 19, 15, 11, 19, 12, 6, 24, 38, 30, 18, 3,
+    12, 0, 6, 21, 11, 10, 14, 6, 13, 2, 12, 11, 6, 12, 11, 5,
+    5, 7, 4, 13, 5, 20, 20, 13, 15, 15, 16, 36, 43, 38, 27, 11,
+    6, 14, 15, 26, 7, 18, 22, 17, 20, 16, 5, 11, 11, 6, 8, 9,
+    23, 40, 25, 11, 2, 14, 13, 9, 24, 27, 14, 28, 33, 24, 19, 15,
+    16, 33, 20, 17, 21, 28, 22, 23, 34, 22, 4, 12, 15, 8, 5, 12,
+    23, 31, 29, 33, 7497, 15002, 7513, 10, 16, 24, 19, 28, 35, 27, 3, 9,
+    21, 38, 26, 15, 22, 8, 8, 22, 31, 13, 10, 2, 17, 18, 21, 14,
+    3, 4, 19, 32, 14988, 30002, 15009, 4, 9, 6, 12, 24, 34, 27, 5, 14,
+    26, 28, 14, 20, 26, 12, 11, 14, 7, 17, 17, 10, 24, 14, 12, 20,
+    9, 11, 11, 15, 7487, 14998, 7499, 6, 8, 6, 12, 7, 12, 12, 5, 9,
+    49, 20, 14, 16, 12, 11, 17, 1, 11, 24, 29, 20, 6, 16, 19, 12,
+    7, 10, 3, 9, 10, 17, 13, 9, 2, 12, 15, 10, 13, 5, 18, 18,
+    91, 44, 3, 6, 17, 6, 14, 10, 15, 30, 35, 30, 26, 22, 28, 34,
+    13, 16, 9, 6, 14, 19, 20, 20, 12, 7, 7, 14, 10, 5, 18, 17,
+    49, 34, 17, 15, 18, 22, 22, 20, 16, 22, 27, 17, 10, 23, 25, 24,
+    13, 12, 14, 8, 21, 15, 11, 16, 18, 21, 21, 15, 9, 8, 16, 11,
+    26, 6, 8, 19, 22, 23, 20, 12, 14, 9, 13, 1, 19, 39, 35, 19,
+    7, 7, 8, 14, 20, 6, 7, 11, 6, 20, 31, 38, 23, 4, 15, 13,
+    21, 21, 22, 12, 8, 10, 12, 6, 14, 4, 21, 18, 18, 24, 19, 9,
+    2, 8, 3, 15, 13, 10, 16, 18, 0, 11, 12, 22, 12, 21, 21, 13,
+    16, 16, 32, 28, 18, 10, 2, 7, 10, 14991, 29977, 14990, 23, 10, 4, 10,
+    18, 8, 7, 15, 10, 7, 14, 17, 2, 11, 9, 11, 17, 15, 13, 21,
+    6, 11, 22, 28, 25, 29, 24, 8, 12, 29996, 59987, 29998, 17, 15, 14, 16,
+    15, 6, 15, 23, 19, 12, 15, 18, 9, 16, 19, 15, 13, 7, 9, 14,
+    12, 13, 19, 17, 22, 42, 30, 2, 9, 14996, 29991, 15005, 20, 19, 21, 14,
+    6, 4, 16, 25, 17, 16, 5, 18, 18, 7, 10, 7, 13, 31, 16, 15,
+    28, 27, 19, 11, 7, 7, 9, 5, 28, 14, 15, 14, 15, 5, 6, 6,
+    11, 5, 12, 12, 10, 13, 9, 13, 1, 3, 8, 6, 28, 40, 17, 14,
+    40, 36, 28, 20, 11, 11, 12, 6, 28, 28, 11, 4, 6, 12, 18, 11,
+    6, 10, 8, 12, 9, 15, 17, 12, 9, 16, 15, 10, 22, 35, 20, 16,
+    20, 19, 27, 19, 9, 12, 15, 8, 10, 17, 17, 6, 18, 22, 9, 21,
+    14, 7, 7, 11, 7, 7, 21, 16, 10, 20, 17, 6, 13, 29, 21, 8,
+    11, 2, 15, 17, 11, 18, 18, 2, 20, 25, 16, 7, 13, 21, 9, 31,
+    17, 5, 13, 13, 11, 11, 20, 20, 5, 11, 11, 6, 11, 16, 15, 13,
+    19, 19, 20, 25, 27, 15, 13, 11, 20, 24, 13, 4, 6, 6, 7, 25,
+    21, 12, 19, 22, 17, 3, 9, 14, 6, 4, 4, 9, 18, 20, 6, 14,
+    10, 23, 16, 16, 21, 15, 24, 21, 11, 16, 14, 15, 19, 27, 18, 19,
+    18, 19, 27, 21, 17, 5, 5, 8, 5, 5, 15, 13, 24, 41, 20, 18,
+    3, 14, 4, 10, 2, 5, 18, 17, 2, 6, 14, 19, 16, 12, 7, 20,
+    18, 4, 16, 7, 7, 6, 15, 22, 8, 16, 27, 16, 18, 33, 16, 11,
+    9, 29, 20, 5, 19, 26, 10, 13, 7, 23, 31, 11, 13, 19, 14, 8,
+    8, 7, 11, 19, 17, 21, 12, 11, 6, 8, 17, 11, 3, 13, 5, 10,
+    12, 37, 25, 13, 10, 25, 19, 14, 5, 22, 17, 9, 26, 11, 12, 14,
+    10, 7, 14, 28, 8, 14, 7, 11, 8, 11, 20, 25, 20, 3, 8, 15,
+};
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+# Generates radar_two_targets.h: a synthetic radar frame with two targets and
+# the range profile and range-Doppler map computed from it in floating point,
+# following the steps documented in source/radar_dsp.c. Needs numpy.
+#
+#   python3 radar_two_targets.py > radar_two_targets.h
+
+import numpy as np
+
+SAMPLES = 64
+CHIRPS = 32
+OFFSET = 2048
+INPUT_SHIFT = 3
+
+# Range bin, Doppler bin and amplitude in ADC counts of each target
+TARGETS = [(10, 5, 600), (21, -3, 300)]
+
+
+def hann(size):
+    return np.round(0.5 * (1 - np.cos(2 * np.pi * np.arange(size) / size)) * 32767) / 32768
+
+
+def frame():
+    rng = np.random.default_rng(31)
+    n = np.arange(SAMPLES)
+    data = np.full((CHIRPS, SAMPLES), float(OFFSET))
+    for chirp in range(CHIRPS):
+        for bin, doppler, amplitude in TARGETS:
+            data[chirp] += amplitude * np.cos(2 * np.pi * (bin * n / SAMPLES + doppler * chirp / CHIRPS) + 0.7)
+    data += rng.integers(-4, 5, size=data.shape)
+    return np.clip(np.round(data), 0, 4095).astype(np.int64)
+
+
+def reference(raw):
+    x = raw - raw.sum(axis=1, keepdims=True) // SAMPLES
+    x = x * (1 << INPUT_SHIFT) * hann(SAMPLES)
+    spectra = np.fft.fft(x, axis=1)[:, :SAMPLES // 2]
+    profile = np.abs(spectra) / SAMPLES
+    doppler = np.fft.fft(spectra * hann(CHIRPS)[:, None], axis=0)
+    doppler = np.roll(doppler, CHIRPS // 2, axis=0)
+    return profile, np.abs(doppler) / (SAMPLES * CHIRPS)
+
+
+def array(ctype, name, values, per_line):
+    lines = ["static const %s %s[%d] =" % (ctype, name, values.size), "{"]
+    flat = values.ravel()
+    for i in range(0, flat.size, per_line):
+        lines.append("    " + ", ".join(str(v) for v in flat[i:i + per_line]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    raw = frame()
+    profile, doppler = reference(raw)
+    print("/* Generated by radar_two_targets.py; do not edit */")
+    print()
+    print("#define RADAR_TEST_SAMPLES          (%d)" % SAMPLES)
+    print("#define RADAR_TEST_CHIRPS           (%d)" % CHIRPS)
+    print()
+    print("/* Range bin, Doppler bin relative to zero velocity, amplitude in counts */")
+    print("static const int32_t radar_test_targets[%d][3] =" % len(TARGETS))
+    print("{")
+    for target in TARGETS:
+        print("    { %d, %d, %d }," % target)
+    print("};")
+    print()
+    print("/* [chirp][sample] */")
+    print(array("uint16_t", "radar_test_frame", raw, 16))
+    print()
+    print("/* Range profile in hundredths, [chirp][bin] */")
+    print(array("uint32_t", "radar_test_profile", np.round(profile * 100).astype(np.int64), 16))
+    print()
+    print("/* Range-Doppler map in hundredths, [Doppler bin][range bin] */")
+    print(array("uint32_t", "radar_test_map", np.round(doppler * 100).astype(np.int64), 16))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,59 @@
+/******************************************************************************
+* File Name:   decimator_smlad.c
+*
+* Description: This file builds the decimator a second time with the dual
+*              16-bit multiply-accumulate path of the target, on a C model
+*              of the SMLAD instruction, so the host tests can compare it
+*              with the portable path.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdint.h>
+
+/* SMLAD: acc + x[15:0] * y[15:0] + x[31:16] * y[31:16] */
+static inline uint32_t __SMLAD(uint32_t x, uint32_t y, uint32_t acc)
+{
+    int32_t low = (int32_t) (int16_t) (x & 0xFFFF) * (int16_t) (y & 0xFFFF);
+    int32_t high = (int32_t) (int16_t) (x >> 16) * (int16_t) (y >> 16);
+
+    return acc + (uint32_t) low + (uint32_t) high;
+}
+
+#undef __ARM_FEATURE_DSP
+#define __ARM_FEATURE_DSP 1
+#define decimator_init decimator_smlad_init
+#define decimator_reset decimator_smlad_reset
+#define decimator_process decimator_smlad_process
+
+#include "../source/decimator.c"
@@ -0,0 +1,141 @@
+/******************************************************************************
+* File Name:   cy_pdl.h
+*
+* Description: This file is the host replacement of the parts of the PDL the
+*              portable modules use, for the host tests: the interrupt setup
+*              and a DMA channel running chained 2D descriptors.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef TESTS_HAL_CY_PDL_H_
+#define TESTS_HAL_CY_PDL_H_
+
+#include "cyhal.h"
+
+/******************************************************************************
+ * Interrupts
+ *****************************************************************************/
+typedef int IRQn_Type;
+
+#define cpuss_interrupts_dw0_0_IRQn     (28)
+#define cpuss_interrupts_dw1_0_IRQn     (57)
+#define CY_SYSINT_SUCCESS               (0)
+
+typedef struct
+{
+    IRQn_Type intrSrc;
+    uint32_t intrPriority;
+} cy_stc_sysint_t;
+
+typedef void (*cy_israddress)(void);
+
+int Cy_SysInt_Init(const cy_stc_sysint_t *config, cy_israddress handler);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+
+/******************************************************************************
+ * DMA
+ *****************************************************************************/
+#define CY_DMA_INTR_MASK                (1u)
+#define CY_DMA_SUCCESS                  (0)
+
+enum
+{
+    CY_DMA_RETRIG_4CYC,
+    CY_DMA_DESCR,
+    CY_DMA_1ELEMENT,
+    CY_DMA_CHANNEL_ENABLED,
+    CY_DMA_HALFWORD,
+    CY_DMA_TRANSFER_SIZE_WORD,
+    CY_DMA_TRANSFER_SIZE_DATA,
+    CY_DMA_2D_TRANSFER,
+};
+
+typedef struct
+{
+    int unused;
+} DW_Type;
+
+extern DW_Type *DW0;
+extern DW_Type *DW1;
+
+typedef struct cy_stc_dma_descriptor
+{
+    int16_t *destination;
+    const volatile uint32_t *source;
+    uint32_t elements;
+    struct cy_stc_dma_descriptor *next;
+} cy_stc_dma_descriptor_t;
+
+typedef struct
+{
+    int retrigger;
+    int interruptType;
+    int triggerOutType;
+    int channelState;
+    int triggerInType;
+    int dataSize;
+    int srcTransferSize;
+    int dstTransferSize;
+    int descriptorType;
+    void *srcAddress;
+    void *dstAddress;
+    int32_t srcXincrement;
+    int32_t dstXincrement;
+    uint32_t xCount;
+    int32_t srcYincrement;
+    int32_t dstYincrement;
+    uint32_t yCount;
+    cy_stc_dma_descriptor_t *nextDescriptor;
+} cy_stc_dma_descriptor_config_t;
+
+typedef struct
+{
+    cy_stc_dma_descriptor_t *descriptor;
+    bool preemptable;
+    uint32_t priority;
+    bool enable;
+    bool bufferable;
+} cy_stc_dma_channel_config_t;
+
+int Cy_DMA_Descriptor_Init(cy_stc_dma_descriptor_t *descriptor, const cy_stc_dma_descriptor_config_t *config);
+int Cy_DMA_Channel_Init(DW_Type *base, uint32_t channel, const cy_stc_dma_channel_config_t *config);
+void Cy_DMA_Enable(DW_Type *base);
+void Cy_DMA_Channel_Enable(DW_Type *base, uint32_t channel);
+void Cy_DMA_Channel_Disable(DW_Type *base, uint32_t channel);
+void Cy_DMA_Channel_ClearInterrupt(DW_Type *base, uint32_t channel);
+void Cy_DMA_Channel_SetInterruptMask(DW_Type *base, uint32_t channel, uint32_t interrupt);
+cy_stc_dma_descriptor_t *Cy_DMA_Channel_GetCurrentDescriptor(DW_Type *base, uint32_t channel);
+
+#endif /* TESTS_HAL_CY_PDL_H_ */
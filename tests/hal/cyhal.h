@@ -0,0 +1,165 @@
+/******************************************************************************
+* File Name:   cyhal.h
+*
+* Description: This file is the host replacement of the parts of the HAL the
+*              portable modules use, for the host tests. The peripherals
+*              are simulated in hal.c.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef TESTS_HAL_CYHAL_H_
+#define TESTS_HAL_CYHAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cy_result.h"
+#include "cy_utils.h"
+
+/******************************************************************************
+ * Core
+ *****************************************************************************/
+#define NC                              (-1)
+
+typedef int cyhal_gpio_t;
+
+static inline void __DMB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/* Called in the critical section, it sleeps until an interrupt thread leaves
+ * a critical section */
+void __WFI(void);
+
+static inline uint32_t __get_IPSR(void)
+{
+    return 0;
+}
+
+static inline uint8_t __CLZ(uint32_t value)
+{
+    return value ? (uint8_t) __builtin_clz(value) : 32;
+}
+
+extern uint32_t SystemCoreClock;
+
+/* Interrupts are simulated by threads; the critical section is a lock that
+ * excludes them */
+uint32_t cyhal_system_critical_section_enter(void);
+void cyhal_system_critical_section_exit(uint32_t old_state);
+void cyhal_system_delay_ms(uint32_t milliseconds);
+
+/******************************************************************************
+ * Resources
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t type;
+    uint8_t block_num;
+    uint8_t channel_num;
+} cyhal_resource_inst_t;
+
+typedef struct
+{
+    int unused;
+} cyhal_i2c_t, cyhal_spi_t, cyhal_clock_t;
+
+extern const cyhal_clock_t CYHAL_CLOCK_PLL[2];
+extern const cyhal_clock_t CYHAL_CLOCK_HF[2];
+
+cy_rslt_t cyhal_clock_reserve(cyhal_clock_t *clock, const cyhal_clock_t *clock_);
+cy_rslt_t cyhal_clock_set_frequency(cyhal_clock_t *clock, uint32_t hz, const void *tolerance);
+cy_rslt_t cyhal_clock_set_enabled(cyhal_clock_t *clock, bool enabled, bool wait_for_lock);
+cy_rslt_t cyhal_clock_set_source(cyhal_clock_t *clock, const cyhal_clock_t *source);
+
+/******************************************************************************
+ * PDM/PCM
+ *****************************************************************************/
+#define CYHAL_PDM_PCM_MODE_LEFT                     (0)
+#define CYHAL_PDM_PCM_RSLT_ERR_INVALID_CONFIG_PARAM CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, 0x1A0U, 0)
+
+typedef struct
+{
+    volatile uint32_t RX_FIFO_RD;
+} PDM_Type;
+
+typedef struct
+{
+    PDM_Type *base;
+} cyhal_pdm_pcm_t;
+
+typedef struct
+{
+    uint32_t sample_rate;
+    uint8_t decimation_rate;
+    int mode;
+    uint8_t word_length;
+    int16_t left_gain;
+    int16_t right_gain;
+} cyhal_pdm_pcm_cfg_t;
+
+cy_rslt_t cyhal_pdm_pcm_init(cyhal_pdm_pcm_t *obj, cyhal_gpio_t pin_data, cyhal_gpio_t pin_clk,
+                             const cyhal_clock_t *clk_source, const cyhal_pdm_pcm_cfg_t *cfg);
+cy_rslt_t cyhal_pdm_pcm_start(cyhal_pdm_pcm_t *obj);
+
+/******************************************************************************
+ * DMA
+ *****************************************************************************/
+#define CYHAL_TRIGGER_AUDIOSS0_TR_PDM_RX_REQ        (0)
+#define CYHAL_DMA_INPUT_TRIGGER_SINGLE_ELEMENT      (0)
+#define CYHAL_DMA_PRIORITY_DEFAULT                  (0)
+#define CYHAL_DMA_DIRECTION_PERIPH2MEM              (1)
+
+typedef struct
+{
+    cyhal_resource_inst_t resource;
+} cyhal_dma_t;
+
+typedef struct
+{
+    int source;
+    int input;
+} cyhal_dma_src_t;
+
+cy_rslt_t cyhal_dma_init_adv(cyhal_dma_t *obj, const cyhal_dma_src_t *src, const void *dest, const void *dest_source,
+                             uint8_t priority, int direction);
+
+/******************************************************************************
+ * Pins of the kit
+ *****************************************************************************/
+#define P10_4                           (0x54)
+#define P10_5                           (0x55)
+
+#endif /* TESTS_HAL_CYHAL_H_ */
@@ -0,0 +1,390 @@
+/******************************************************************************
+* File Name:   hal.c
+*
+* Description: This file simulates the peripherals of the host tests: the
+*              PDM FIFO feeding the DMA channel, which runs its chain of
+*              descriptors and calls the installed interrupt handler at the
+*              end of each one, periodic timer interrupts, and the critical
+*              section with the sleep of WFI.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "hal.h"
+
+/******************************************************************************
+ * Global Variables
+ *****************************************************************************/
+/* A cycle of the host cycle counter is a nanosecond; see cycles.h */
+uint32_t SystemCoreClock = 1000000000u;
+
+const cyhal_clock_t CYHAL_CLOCK_PLL[2];
+const cyhal_clock_t CYHAL_CLOCK_HF[2];
+
+static DW_Type dw[2];
+DW_Type *DW0 = &dw[0];
+DW_Type *DW1 = &dw[1];
+
+/* The only PDM block and DMA channel */
+static PDM_Type pdm;
+static cy_stc_dma_descriptor_t *dma_descriptor = NULL;
+static uint32_t dma_element = 0;
+static bool dma_enabled = false;
+static bool dma_interrupt = false;
+static cy_israddress dma_handler = NULL;
+
+static pthread_mutex_t critical_section = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/* Signalled when a thread leaves a critical section, which ends __WFI */
+static pthread_cond_t interrupt = PTHREAD_COND_INITIALIZER;
+
+/* Periodic timers, each run by a thread that stands for its interrupt */
+#define HAL_TIMERS                      (8u)
+
+/* Real-time priority of the timer threads, above the tasks of cyabs_rtos */
+#define HAL_TIMER_PRIORITY              (30)
+
+typedef struct
+{
+    pthread_t thread;
+    uint32_t period_us;
+    void (*handler)(void);
+} hal_timer_t;
+
+static hal_timer_t timers[HAL_TIMERS];
+static uint32_t timer_count = 0;
+static volatile bool timers_running = false;
+
+
+/*******************************************************************************
+* Function Definitions
+*******************************************************************************/
+
+/*******************************************************************************
+* Function Name: cyhal_system_critical_section_enter
+********************************************************************************
+* Summary:
+*  Takes the lock that stands for masked interrupts. It is recursive, like
+*  nested critical sections on the target.
+*
+*******************************************************************************/
+uint32_t cyhal_system_critical_section_enter(void)
+{
+    pthread_mutex_lock(&critical_section);
+    return 0;
+}
+
+void cyhal_system_critical_section_exit(uint32_t old_state)
+{
+    (void) old_state;
+    pthread_cond_broadcast(&interrupt);
+    pthread_mutex_unlock(&critical_section);
+}
+
+/*******************************************************************************
+* Function Name: __WFI
+********************************************************************************
+* Summary:
+*  Sleeps until another thread leaves a critical section, e.g. an interrupt
+*  that posted an event. Like the main loop on the target, the caller holds
+*  the critical section once, so a post after its check still wakes it.
+*
+*******************************************************************************/
+void __WFI(void)
+{
+    pthread_cond_wait(&interrupt, &critical_section);
+}
+
+void cyhal_system_delay_ms(uint32_t milliseconds)
+{
+    struct timespec delay = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+    nanosleep(&delay, NULL);
+}
+
+/* The clocks, the PDM block and the interrupt controller only need to accept
+ * the configuration of the firmware */
+cy_rslt_t cyhal_clock_reserve(cyhal_clock_t *clock, const cyhal_clock_t *clock_)
+{
+    (void) clock;
+    (void) clock_;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_clock_set_frequency(cyhal_clock_t *clock, uint32_t hz, const void *tolerance)
+{
+    (void) clock;
+    (void) hz;
+    (void) tolerance;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_clock_set_enabled(cyhal_clock_t *clock, bool enabled, bool wait_for_lock)
+{
+    (void) clock;
+    (void) enabled;
+    (void) wait_for_lock;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_clock_set_source(cyhal_clock_t *clock, const cyhal_clock_t *source)
+{
+    (void) clock;
+    (void) source;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_pdm_pcm_init(cyhal_pdm_pcm_t *obj, cyhal_gpio_t pin_data, cyhal_gpio_t pin_clk,
+                             const cyhal_clock_t *clk_source, const cyhal_pdm_pcm_cfg_t *cfg)
+{
+    (void) pin_data;
+    (void) pin_clk;
+    (void) clk_source;
+    (void) cfg;
+    obj->base = &pdm;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_pdm_pcm_start(cyhal_pdm_pcm_t *obj)
+{
+    (void) obj;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_dma_init_adv(cyhal_dma_t *obj, const cyhal_dma_src_t *src, const void *dest, const void *dest_source,
+                             uint8_t priority, int direction)
+{
+    (void) src;
+    (void) dest;
+    (void) dest_source;
+    (void) priority;
+    (void) direction;
+    obj->resource.block_num = 0;
+    obj->resource.channel_num = 0;
+    return CY_RSLT_SUCCESS;
+}
+
+int Cy_SysInt_Init(const cy_stc_sysint_t *config, cy_israddress handler)
+{
+    (void) config;
+    dma_handler = handler;
+    return CY_SYSINT_SUCCESS;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    (void) irq;
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+    (void) irq;
+}
+
+/* A descriptor keeps what the simulated channel needs: where it moves the
+ * elements from and to, how many, and which descriptor follows */
+int Cy_DMA_Descriptor_Init(cy_stc_dma_descriptor_t *descriptor, const cy_stc_dma_descriptor_config_t *config)
+{
+    descriptor->destination = config->dstAddress;
+    descriptor->source = config->srcAddress;
+    descriptor->elements = config->xCount * config->yCount;
+    descriptor->next = config->nextDescriptor;
+    return CY_DMA_SUCCESS;
+}
+
+int Cy_DMA_Channel_Init(DW_Type *base, uint32_t channel, const cy_stc_dma_channel_config_t *config)
+{
+    (void) base;
+    (void) channel;
+    dma_descriptor = config->descriptor;
+    dma_element = 0;
+    dma_enabled = config->enable;
+    return CY_DMA_SUCCESS;
+}
+
+void Cy_DMA_Enable(DW_Type *base)
+{
+    (void) base;
+}
+
+void Cy_DMA_Channel_Enable(DW_Type *base, uint32_t channel)
+{
+    (void) base;
+    (void) channel;
+    dma_enabled = true;
+}
+
+void Cy_DMA_Channel_Disable(DW_Type *base, uint32_t channel)
+{
+    (void) base;
+    (void) channel;
+    dma_enabled = false;
+}
+
+void Cy_DMA_Channel_ClearInterrupt(DW_Type *base, uint32_t channel)
+{
+    (void) base;
+    (void) channel;
+}
+
+void Cy_DMA_Channel_SetInterruptMask(DW_Type *base, uint32_t channel, uint32_t interrupt)
+{
+    (void) base;
+    (void) channel;
+    dma_interrupt = 0 != (interrupt & CY_DMA_INTR_MASK);
+}
+
+cy_stc_dma_descriptor_t *Cy_DMA_Channel_GetCurrentDescriptor(DW_Type *base, uint32_t channel)
+{
+    (void) base;
+    (void) channel;
+    return dma_descriptor;
+}
+
+/*******************************************************************************
+* Function Name: hal_pdm_push
+********************************************************************************
+* Summary:
+*  Puts a sample in the PDM FIFO and lets the DMA channel move it. At the end
+*  of a descriptor the channel moves on to the next one and raises its
+*  interrupt, which runs the handler before the function returns.
+*
+* Parameters:
+*  sample: the sample
+*
+*******************************************************************************/
+void hal_pdm_push(uint32_t sample)
+{
+    pdm.RX_FIFO_RD = sample;
+    if (!dma_enabled || NULL == dma_descriptor)
+    {
+        return;
+    }
+    dma_descriptor->destination[dma_element] = (int16_t) *dma_descriptor->source;
+    if (++dma_element < dma_descriptor->elements)
+    {
+        return;
+    }
+    dma_element = 0;
+    dma_descriptor = dma_descriptor->next;
+    if (dma_interrupt && NULL != dma_handler)
+    {
+        dma_handler();
+    }
+}
+
+/*******************************************************************************
+* Function Name: hal_timer_thread
+********************************************************************************
+* Summary:
+*  Calls the handler of a timer at the end of each period, from absolute
+*  times, so the periods do not drift with the time the handler takes.
+*
+*******************************************************************************/
+static void* hal_timer_thread(void *argument)
+{
+    const hal_timer_t *timer = argument;
+    struct timespec next;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (timers_running)
+    {
+        next.tv_nsec += (long) timer->period_us * 1000L;
+        while (next.tv_nsec >= 1000000000L)
+        {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        if (timers_running)
+        {
+            timer->handler();
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: hal_timer_start
+********************************************************************************
+* Summary:
+*  Starts a periodic timer interrupt. Its thread runs at a real-time priority
+*  above the tasks where the system allows it.
+*
+* Parameters:
+*  period_us: the period in microseconds
+*  handler: the interrupt handler
+*
+*******************************************************************************/
+void hal_timer_start(uint32_t period_us, void (*handler)(void))
+{
+    hal_timer_t *timer = &timers[timer_count++];
+    struct sched_param param = { .sched_priority = HAL_TIMER_PRIORITY };
+    pthread_attr_t attr;
+
+    timer->period_us = period_us;
+    timer->handler = handler;
+    timers_running = true;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&attr, &param);
+    if (0 != pthread_create(&timer->thread, &attr, hal_timer_thread, timer))
+    {
+        pthread_create(&timer->thread, NULL, hal_timer_thread, timer);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+/*******************************************************************************
+* Function Name: hal_timer_stop
+********************************************************************************
+* Summary:
+*  Stops all timers; returns when no handler runs anymore.
+*
+*******************************************************************************/
+void hal_timer_stop(void)
+{
+    timers_running = false;
+    for (uint32_t i = 0; i < timer_count; i++)
+    {
+        pthread_join(timers[i].thread, NULL);
+    }
+    timer_count = 0;
+}
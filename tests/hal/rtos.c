@@ -0,0 +1,414 @@
+/******************************************************************************
+* File Name:   rtos.c
+*
+* Description: This file implements the RTOS abstraction of the host build on
+*              pthreads. Tasks are threads at real-time priorities where the
+*              system allows it, so a task of a higher priority preempts the
+*              lower ones as on the target; otherwise Linux shares the CPU.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "cyabs_rtos.h"
+#include "task.h"
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Real-time priority of CY_RTOS_PRIORITY_MIN; the others follow it */
+#define RTOS_PRIORITY_BASE              (10)
+
+
+/*******************************************************************************
+* Local Variables
+*******************************************************************************/
+static bool priorities_applied = true;
+
+
+/*******************************************************************************
+* Local Function Prototypes
+*******************************************************************************/
+static void* rtos_thread(void *argument);
+static void rtos_deadline(cy_time_t timeout_ms, struct timespec *deadline);
+static void rtos_init_cond(pthread_cond_t *cond);
+
+
+/*******************************************************************************
+* Function Definitions
+*******************************************************************************/
+
+/*******************************************************************************
+* Function Name: cy_rtos_create_thread
+********************************************************************************
+* Summary:
+*  Starts a thread running the entry function. The stack is the one of the
+*  thread library. If the system refuses a real-time priority, the thread
+*  runs at the normal priority and cy_rtos_priorities_applied returns false.
+*
+*******************************************************************************/
+cy_rslt_t cy_rtos_create_thread(cy_thread_t *thread, cy_thread_entry_fn_t entry_function, const char *name,
+                                void *stack, uint32_t stack_size, cy_thread_priority_t priority,
+                                cy_thread_arg_t arg)
+{
+    struct sched_param param = { .sched_priority = RTOS_PRIORITY_BASE + (int) priority };
+    pthread_attr_t attr;
+    int error;
+
+    (void) stack;
+    (void) stack_size;
+
+    thread->entry = entry_function;
+    thread->arg = arg;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&attr, &param);
+    error = pthread_create(&thread->thread, &attr, rtos_thread, thread);
+    pthread_attr_destroy(&attr);
+    if (0 != error)
+    {
+        priorities_applied = false;
+        error = pthread_create(&thread->thread, NULL, rtos_thread, thread);
+    }
+    if (0 == error && NULL != name)
+    {
+        pthread_setname_np(thread->thread, name);
+    }
+
+    return 0 == error ? CY_RSLT_SUCCESS : CY_RTOS_NO_MEMORY;
+}
+
+/*******************************************************************************
+* Function Name: cy_rtos_priorities_applied
+********************************************************************************
+* Summary:
+*  Returns whether all threads got their real-time priority.
+*
+*******************************************************************************/
+bool cy_rtos_priorities_applied(void)
+{
+    return priorities_applied;
+}
+
+/*******************************************************************************
+* Function Name: vTaskStartScheduler
+********************************************************************************
+* Summary:
+*  Waits forever; the threads are already running.
+*
+*******************************************************************************/
+void vTaskStartScheduler(void)
+{
+    for (;;)
+    {
+        pause();
+    }
+}
+
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore, uint32_t maxcount, uint32_t initcount)
+{
+    pthread_mutex_init(&semaphore->mutex, NULL);
+    rtos_init_cond(&semaphore->cond);
+    semaphore->count = initcount;
+    semaphore->max = maxcount;
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: cy_rtos_get_semaphore
+********************************************************************************
+* Summary:
+*  Takes a count of the semaphore, waiting up to timeout_ms for one.
+*
+*******************************************************************************/
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore, cy_time_t timeout_ms, bool in_isr)
+{
+    struct timespec deadline;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    (void) in_isr;
+    rtos_deadline(timeout_ms, &deadline);
+
+    pthread_mutex_lock(&semaphore->mutex);
+    while (0 == semaphore->count && CY_RSLT_SUCCESS == result)
+    {
+        if (CY_RTOS_NEVER_TIMEOUT == timeout_ms)
+        {
+            pthread_cond_wait(&semaphore->cond, &semaphore->mutex);
+        }
+        else if (ETIMEDOUT == pthread_cond_timedwait(&semaphore->cond, &semaphore->mutex, &deadline))
+        {
+            result = CY_RTOS_TIMEOUT;
+        }
+    }
+    if (0 != semaphore->count)
+    {
+        semaphore->count--;
+        result = CY_RSLT_SUCCESS;
+    }
+    pthread_mutex_unlock(&semaphore->mutex);
+
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: cy_rtos_set_semaphore
+********************************************************************************
+* Summary:
+*  Gives a count of the semaphore, up to its maximum, and wakes a waiter.
+*
+*******************************************************************************/
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore, bool in_isr)
+{
+    (void) in_isr;
+
+    pthread_mutex_lock(&semaphore->mutex);
+    if (semaphore->count < semaphore->max)
+    {
+        semaphore->count++;
+    }
+    pthread_cond_signal(&semaphore->cond);
+    pthread_mutex_unlock(&semaphore->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: cy_rtos_init_mutex
+********************************************************************************
+* Summary:
+*  Creates a recursive mutex, as the mutexes of the RTOS abstraction are.
+*
+*******************************************************************************/
+cy_rslt_t cy_rtos_init_mutex(cy_mutex_t *mutex)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex, cy_time_t timeout_ms)
+{
+    struct timespec deadline;
+
+    if (CY_RTOS_NEVER_TIMEOUT == timeout_ms)
+    {
+        pthread_mutex_lock(&mutex->mutex);
+        return CY_RSLT_SUCCESS;
+    }
+
+    rtos_deadline(timeout_ms, &deadline);
+    return 0 == pthread_mutex_clocklock(&mutex->mutex, CLOCK_MONOTONIC, &deadline) ? CY_RSLT_SUCCESS
+                                                                                   : CY_RTOS_TIMEOUT;
+}
+
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: cy_rtos_init_queue
+********************************************************************************
+* Summary:
+*  Creates a queue of length items of itemsize bytes, copied in and out.
+*
+*******************************************************************************/
+cy_rslt_t cy_rtos_init_queue(cy_queue_t *queue, size_t length, size_t itemsize)
+{
+    queue->items = malloc(length * itemsize);
+    if (NULL == queue->items)
+    {
+        return CY_RTOS_NO_MEMORY;
+    }
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    rtos_init_cond(&queue->not_empty);
+    rtos_init_cond(&queue->not_full);
+    queue->item_size = itemsize;
+    queue->length = length;
+    queue->head = 0;
+    queue->count = 0;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: cy_rtos_put_queue
+********************************************************************************
+* Summary:
+*  Copies an item to the back of the queue, waiting up to timeout_ms while it
+*  is full.
+*
+*******************************************************************************/
+cy_rslt_t cy_rtos_put_queue(cy_queue_t *queue, const void *item_ptr, cy_time_t timeout_ms, bool in_isr)
+{
+    struct timespec deadline;
+
+    (void) in_isr;
+    rtos_deadline(timeout_ms, &deadline);
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == queue->length)
+    {
+        if (0 == timeout_ms ||
+            (CY_RTOS_NEVER_TIMEOUT != timeout_ms &&
+             ETIMEDOUT == pthread_cond_timedwait(&queue->not_full, &queue->mutex, &deadline)))
+        {
+            pthread_mutex_unlock(&queue->mutex);
+            return CY_RTOS_QUEUE_FULL;
+        }
+        if (CY_RTOS_NEVER_TIMEOUT == timeout_ms)
+        {
+            pthread_cond_wait(&queue->not_full, &queue->mutex);
+        }
+    }
+
+    memcpy(queue->items + ((queue->head + queue->count) % queue->length) * queue->item_size, item_ptr,
+           queue->item_size);
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: cy_rtos_get_queue
+********************************************************************************
+* Summary:
+*  Copies the item at the front of the queue out and removes it, waiting up to
+*  timeout_ms while the queue is empty.
+*
+*******************************************************************************/
+cy_rslt_t cy_rtos_get_queue(cy_queue_t *queue, void *item_ptr, cy_time_t timeout_ms, bool in_isr)
+{
+    struct timespec deadline;
+
+    (void) in_isr;
+    rtos_deadline(timeout_ms, &deadline);
+
+    pthread_mutex_lock(&queue->mutex);
+    while (0 == queue->count)
+    {
+        if (0 == timeout_ms ||
+            (CY_RTOS_NEVER_TIMEOUT != timeout_ms &&
+             ETIMEDOUT == pthread_cond_timedwait(&queue->not_empty, &queue->mutex, &deadline)))
+        {
+            pthread_mutex_unlock(&queue->mutex);
+            return CY_RTOS_QUEUE_EMPTY;
+        }
+        if (CY_RTOS_NEVER_TIMEOUT == timeout_ms)
+        {
+            pthread_cond_wait(&queue->not_empty, &queue->mutex);
+        }
+    }
+
+    memcpy(item_ptr, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: rtos_thread
+********************************************************************************
+* Summary:
+*  Runs the entry function of a thread.
+*
+*******************************************************************************/
+static void* rtos_thread(void *argument)
+{
+    cy_thread_t *thread = argument;
+
+    thread->entry(thread->arg);
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: rtos_deadline
+********************************************************************************
+* Summary:
+*  Converts a timeout into an absolute time of the monotonic clock.
+*
+*******************************************************************************/
+static void rtos_deadline(cy_time_t timeout_ms, struct timespec *deadline)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    if (CY_RTOS_NEVER_TIMEOUT == timeout_ms)
+    {
+        return;
+    }
+
+    deadline->tv_sec += timeout_ms / 1000u;
+    deadline->tv_nsec += (long) (timeout_ms % 1000u) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_nsec -= 1000000000L;
+        deadline->tv_sec++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: rtos_init_cond
+********************************************************************************
+* Summary:
+*  Creates a condition variable whose timed waits use the monotonic clock.
+*
+*******************************************************************************/
+static void rtos_init_cond(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
@@ -0,0 +1,358 @@
+/******************************************************************************
+* File Name:   test_audio.c
+*
+* Description: This file tests the audio capture on the host: a ramp is fed
+*              through the simulated PDM FIFO and the circular chain of DMA
+*              descriptors, and the frames returned by pdm_preprocessing_feed
+*              are checked for gaps and duplicates, and against the overruns
+*              counted for a consumer that falls behind. At the decimated
+*              rates each frame is fed at its own level instead, which the
+*              decimator passes through.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "config.h"
+#include "audio.h"
+#include "decimator.h"
+#include "events.h"
+#include "hal.h"
+#include "test.h"
+#include "timebase.h"
+
+TEST_DEFINE_FAILURES;
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/* Captured samples, and the most frames in the circular buffer and in the
+ * ring of completed frames, as set in audio.c */
+#define CAPTURE_SIZE        (2u * FRAME_SIZE_MAX * DECIMATOR_MAX_FACTOR)
+#define SEGMENTS_MAX        (8u)
+#define RING_CAPACITY       (8u)
+
+/* Frames fed in each pass of a test */
+#define PASSES              (5u * SEGMENTS_MAX + 3u)
+
+/* The level of each frame at the decimated rates, which repeats after
+ * LEVEL_COUNT frames. The output settles on it once the filter, of 24 output
+ * samples, holds only samples of the frame, and then stays within
+ * LEVEL_TOLERANCE of it. */
+#define LEVEL_COUNT         (1024u)
+#define LEVEL_STEP          (32)
+#define LEVEL_SETTLE        (24u)
+#define LEVEL_TOLERANCE     (4)
+
+static int16_t output[FRAME_SIZE_MAX];
+
+/* The decimation factor and the frames in the circular buffer of the current
+ * configuration */
+static uint32_t factor = 1;
+static uint32_t segments = SEGMENTS_MAX;
+
+/* The next sample of the ramp fed to the PDM FIFO, and the number of frames
+ * completed so far */
+static uint32_t ramp = 0;
+static uint32_t frames_fed = 0;
+
+
+/*******************************************************************************
+* Function Definitions
+*******************************************************************************/
+
+/* The audio module only posts its event and measures its clock; the tests
+ * call pdm_preprocessing_feed directly */
+void events_post(event_t event)
+{
+    (void) event;
+}
+
+void timebase_rate_init(timebase_rate_t *rate, uint32_t nominal)
+{
+    (void) rate;
+    (void) nominal;
+}
+
+void timebase_rate_update(timebase_rate_t *rate, uint32_t count)
+{
+    (void) rate;
+    (void) count;
+}
+
+bool timebase_rate_get_drift(const timebase_rate_t *rate, int32_t *ppb, uint32_t *seconds)
+{
+    (void) rate;
+    (void) ppb;
+    (void) seconds;
+    return false;
+}
+
+void timebase_set_reference(const timebase_rate_t *reference)
+{
+    (void) reference;
+}
+
+static int16_t level(uint32_t frame)
+{
+    return (int16_t) ((int32_t) (frame % LEVEL_COUNT) * LEVEL_STEP - (int32_t) (LEVEL_COUNT / 2u) * LEVEL_STEP);
+}
+
+static bool near_level(int16_t sample, uint32_t frame)
+{
+    return abs(sample - level(frame)) <= LEVEL_TOLERANCE;
+}
+
+/*******************************************************************************
+* Function Name: feed
+********************************************************************************
+* Summary:
+*  Feeds whole frames through the PDM FIFO: the ramp, or at the decimated
+*  rates the level of each frame.
+*
+*******************************************************************************/
+static void feed(uint32_t frames, uint32_t size)
+{
+    for (uint32_t frame = frames_fed; frame < frames_fed + frames; frame++)
+    {
+        for (uint32_t n = 0; n < size * factor; n++)
+        {
+            hal_pdm_push(1 == factor ? ramp++ & 0xFFFF : (uint16_t) level(frame));
+        }
+    }
+    frames_fed += frames;
+}
+
+/*******************************************************************************
+* Function Name: find
+********************************************************************************
+* Summary:
+*  Finds the first frame at or after the expected one that an output frame
+*  holds, and checks that the frame is intact: the ramp from the start of the
+*  frame, or its level once the decimator has settled.
+*
+* Return:
+*  The frame; frames_fed if no frame fed matches.
+*
+*******************************************************************************/
+static uint32_t find(const int16_t *samples, size_t count, uint32_t size, uint32_t next)
+{
+    uint32_t frame = next;
+    uint32_t intact = 1;
+
+    if (1 == factor)
+    {
+        /* The ramp wraps at 16 bits */
+        uint16_t first = (uint16_t) samples[0];
+        while (frame < frames_fed && (uint16_t) (frame * size) != first)
+        {
+            frame++;
+        }
+        for (size_t n = 1; n < count; n++)
+        {
+            intact &= (uint16_t) samples[n] == (uint16_t) (first + n);
+        }
+    }
+    else
+    {
+        while (frame < frames_fed && !near_level(samples[count - 1], frame))
+        {
+            frame++;
+        }
+        for (size_t n = LEVEL_SETTLE; n < count; n++)
+        {
+            intact &= near_level(samples[n], frame);
+        }
+    }
+    TEST_CHECK(frame < frames_fed, "rate %u, size %u: frame was not fed after frame %u",
+               (unsigned) (PDM_SAMPLE_RATE / factor), (unsigned) size, (unsigned) next);
+    TEST_CHECK(intact, "rate %u, size %u: frame %u is not intact", (unsigned) (PDM_SAMPLE_RATE / factor),
+               (unsigned) size, (unsigned) frame);
+    return frame;
+}
+
+/*******************************************************************************
+* Function Name: drain
+********************************************************************************
+* Summary:
+*  Takes every queued frame and checks that each one holds an intact frame,
+*  later than the previous frame returned.
+*
+* Parameters:
+*  size: samples per frame
+*  next: the frame expected next; updated to follow the last frame returned
+*  skipped: incremented by the frames missing between those returned
+*
+* Return:
+*  The number of frames returned.
+*
+*******************************************************************************/
+static uint32_t drain(uint32_t size, uint32_t *next, uint32_t *skipped)
+{
+    uint32_t frames = 0;
+    size_t count;
+
+    while (0 != (count = pdm_preprocessing_feed(output)))
+    {
+        uint32_t frame;
+
+        TEST_CHECK(count == size, "frame of %zu samples, expected %u", count, (unsigned) size);
+        frame = find(output, count, size, *next);
+
+        *skipped += frame - *next;
+        *next = frame + 1;
+        frames++;
+    }
+    return frames;
+}
+
+/*******************************************************************************
+* Function Name: start
+********************************************************************************
+* Summary:
+*  Restarts the capture with a rate and frame size, dropping any frame in
+*  progress.
+*
+*******************************************************************************/
+static void start(uint32_t rate, uint32_t size)
+{
+    TEST_CHECK(CY_RSLT_SUCCESS == pdm_configure(rate, size), "configure %u, %u", (unsigned) rate, (unsigned) size);
+    factor = PDM_SAMPLE_RATE / rate;
+    segments = CAPTURE_SIZE / (size * factor);
+    segments = segments < SEGMENTS_MAX ? segments : SEGMENTS_MAX;
+    ramp = 0;
+    frames_fed = 0;
+}
+
+/*******************************************************************************
+* Function Name: test_prompt
+********************************************************************************
+* Summary:
+*  A consumer that takes each frame as soon as it is complete, or that lets up
+*  to one frame less wait than the circular buffer holds, sees every frame
+*  exactly once.
+*
+*******************************************************************************/
+static void test_prompt(uint32_t rate, uint32_t size, uint32_t lag)
+{
+    uint32_t overruns = pdm_get_overruns();
+    uint32_t next = 0;
+    uint32_t skipped = 0;
+    uint32_t frames = 0;
+
+    start(rate, size);
+    lag = lag < segments ? lag : segments - 1;
+    for (uint32_t pass = 0; pass < PASSES; pass++)
+    {
+        feed(lag, size);
+        frames += drain(size, &next, &skipped);
+    }
+    TEST_CHECK(frames == frames_fed, "rate %u, size %u, lag %u: %u of %u frames", (unsigned) rate, (unsigned) size,
+               (unsigned) lag, (unsigned) frames, (unsigned) frames_fed);
+    TEST_CHECK(0 == skipped, "rate %u, size %u, lag %u: %u frames skipped", (unsigned) rate, (unsigned) size,
+               (unsigned) lag, (unsigned) skipped);
+    TEST_CHECK(pdm_get_overruns() == overruns, "rate %u, size %u, lag %u: %u overruns", (unsigned) rate,
+               (unsigned) size, (unsigned) lag, (unsigned) (pdm_get_overruns() - overruns));
+}
+
+/*******************************************************************************
+* Function Name: test_late
+********************************************************************************
+* Summary:
+*  A consumer that lets more frames wait than the capture buffer can hold loses
+*  the frames the DMA has come around to again, and those the ring could not
+*  queue. Every lost frame is counted as an overrun, and the frames returned
+*  are intact.
+*
+* Parameters:
+*  extra: the frames fed in each pass beyond those the circular buffer holds
+*
+*******************************************************************************/
+static void test_late(uint32_t rate, uint32_t size, uint32_t extra)
+{
+    uint32_t overruns = pdm_get_overruns();
+    uint32_t next = 0;
+    uint32_t skipped = 0;
+    uint32_t frames = 0;
+    uint32_t expected = 0;
+    uint32_t lag;
+
+    start(rate, size);
+    lag = segments + extra;
+    for (uint32_t pass = 0; pass < PASSES; pass++)
+    {
+        uint32_t first = frames_fed;
+
+        feed(lag, size);
+        /* Frames are queued until the ring is full, and of those only the
+         * ones whose segment the DMA has not started to fill again are
+         * returned */
+        for (uint32_t frame = first; frame < first + lag && frame < first + RING_CAPACITY; frame++)
+        {
+            expected += frame + segments > frames_fed;
+        }
+        frames += drain(size, &next, &skipped);
+    }
+    skipped += frames_fed - next;
+
+    TEST_CHECK(frames == expected, "rate %u, size %u, lag %u: %u frames returned, expected %u", (unsigned) rate,
+               (unsigned) size, (unsigned) lag, (unsigned) frames, (unsigned) expected);
+    TEST_CHECK(frames + skipped == frames_fed, "rate %u, size %u, lag %u: %u returned and %u skipped of %u",
+               (unsigned) rate, (unsigned) size, (unsigned) lag, (unsigned) frames, (unsigned) skipped,
+               (unsigned) frames_fed);
+    TEST_CHECK(pdm_get_overruns() - overruns == skipped, "rate %u, size %u, lag %u: %u overruns for %u frames lost",
+               (unsigned) rate, (unsigned) size, (unsigned) lag, (unsigned) (pdm_get_overruns() - overruns),
+               (unsigned) skipped);
+}
+
+int main(void)
+{
+    static const uint32_t rates[] = { PDM_SAMPLE_RATE, 16000u, 8000u };
+    static const uint32_t sizes[] = { FRAME_SIZE_MIN, FRAME_SIZE, FRAME_SIZE_MAX };
+
+    TEST_CHECK(CY_RSLT_SUCCESS == pdm_init(), "pdm_init");
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+    {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            test_prompt(rates[r], sizes[i], 1);
+            test_prompt(rates[r], sizes[i], SEGMENTS_MAX - 1);
+            test_late(rates[r], sizes[i], 0);
+            test_late(rates[r], sizes[i], 3);
+            test_late(rates[r], sizes[i], 2 * SEGMENTS_MAX);
+        }
+    }
+    return TEST_RESULT("audio");
+}
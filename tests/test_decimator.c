@@ -0,0 +1,216 @@
+/******************************************************************************
+* File Name:   test_decimator.c
+*
+* Description: This file tests the audio decimator on the host: the pass
+*              band and stop band of the 2, 3 and 6 filters measured with
+*              sine tones, and the SMLAD path against the portable C path.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "decimator.h"
+#include "test.h"
+
+TEST_DEFINE_FAILURES;
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+#define INPUT_RATE          (48000.0)
+#define INPUT_SAMPLES       (48000u)
+#define AMPLITUDE           (16000.0)
+/* Input samples per decimator_process call; not a multiple of the block size,
+ * so the history is carried across partial blocks */
+#define CHUNK               (1020u)
+
+/* Bounds derived from the filter design in decimator.c, in units of the
+ * output sample rate */
+#define PASS_BAND_EDGE      (0.38)
+#define PASS_BAND_RIPPLE_DB (0.3)
+#define STOP_BAND_EDGE      (0.6)
+#define STOP_BAND_DB        (-69.0)
+
+bool decimator_smlad_init(decimator_t *decimator, uint32_t factor);
+size_t decimator_smlad_process(decimator_t *decimator, const int16_t *input, int16_t *output, size_t count);
+
+static int16_t input[INPUT_SAMPLES];
+static int16_t output[INPUT_SAMPLES];
+static int16_t reference[INPUT_SAMPLES];
+static decimator_t decimator;
+
+
+/*******************************************************************************
+* Function Name: decimate
+********************************************************************************
+* Summary:
+*  Decimates the input in chunks and returns the number of output samples.
+*
+*******************************************************************************/
+static size_t decimate(uint32_t factor, bool smlad, int16_t *out)
+{
+    size_t produced = 0;
+
+    if (smlad)
+    {
+        decimator_smlad_init(&decimator, factor);
+    }
+    else
+    {
+        decimator_init(&decimator, factor);
+    }
+    for (size_t offset = 0; offset < INPUT_SAMPLES; offset += CHUNK * factor)
+    {
+        size_t count = INPUT_SAMPLES - offset < CHUNK * factor ? INPUT_SAMPLES - offset : CHUNK * factor;
+        if (smlad)
+        {
+            produced += decimator_smlad_process(&decimator, &input[offset], &out[produced], count);
+        }
+        else
+        {
+            produced += decimator_process(&decimator, &input[offset], &out[produced], count);
+        }
+    }
+    return produced;
+}
+
+/*******************************************************************************
+* Function Name: tone_gain_db
+********************************************************************************
+* Summary:
+*  Passes a tone through the decimator and returns its gain in dB. In the pass
+*  band the output is correlated with the tone, in the stop band, where the
+*  tone is aliased, its RMS is compared with that of the input.
+*
+*******************************************************************************/
+static double tone_gain_db(uint32_t factor, double frequency, bool pass)
+{
+    size_t count;
+    size_t skip;
+    double sum_i = 0;
+    double sum_q = 0;
+    double power = 0;
+
+    for (size_t n = 0; n < INPUT_SAMPLES; n++)
+    {
+        input[n] = (int16_t) lrint(AMPLITUDE * sin(2 * M_PI * frequency * n / INPUT_RATE));
+    }
+    count = decimate(factor, false, output);
+
+    /* Skip the filter transient */
+    skip = 24;
+    for (size_t n = skip; n < count; n++)
+    {
+        /* Output n is aligned with input sample n * factor + factor - 1 */
+        double phase = 2 * M_PI * frequency * (n * factor + factor - 1) / INPUT_RATE;
+        sum_i += output[n] * cos(phase);
+        sum_q += output[n] * sin(phase);
+        power += (double) output[n] * output[n];
+    }
+    if (pass)
+    {
+        return 20 * log10(2 * hypot(sum_i, sum_q) / (count - skip) / AMPLITUDE);
+    }
+    return 10 * log10(power / (count - skip) / (AMPLITUDE * AMPLITUDE / 2));
+}
+
+/*******************************************************************************
+* Function Name: test_response
+********************************************************************************
+* Summary:
+*  Checks the pass band ripple and stop band attenuation of a filter.
+*
+*******************************************************************************/
+static void test_response(uint32_t factor)
+{
+    double output_rate = INPUT_RATE / factor;
+    double worst_pass = 0;
+    double worst_stop = -200;
+
+    for (double f = 0.02; f <= PASS_BAND_EDGE; f += 0.02)
+    {
+        double gain = tone_gain_db(factor, f * output_rate, true);
+        worst_pass = fabs(gain) > fabs(worst_pass) ? gain : worst_pass;
+        TEST_CHECK(fabs(gain) < PASS_BAND_RIPPLE_DB, "factor %u, %.0f Hz: %.3f dB", (unsigned) factor,
+                   f * output_rate, gain);
+    }
+    for (double f = STOP_BAND_EDGE; f * output_rate < INPUT_RATE / 2; f += 0.1)
+    {
+        double gain = tone_gain_db(factor, f * output_rate, false);
+        worst_stop = gain > worst_stop ? gain : worst_stop;
+        TEST_CHECK(gain < STOP_BAND_DB, "factor %u, %.0f Hz: %.1f dB", (unsigned) factor, f * output_rate, gain);
+    }
+    printf("factor %u: pass band %.3f dB, stop band %.1f dB\n", (unsigned) factor, worst_pass, worst_stop);
+}
+
+/*******************************************************************************
+* Function Name: test_smlad
+********************************************************************************
+* Summary:
+*  Checks that the SMLAD path gives the same samples as the C path on noise
+*  at full scale.
+*
+*******************************************************************************/
+static void test_smlad(uint32_t factor)
+{
+    size_t count;
+    size_t mismatches = 0;
+
+    srand(factor);
+    for (size_t n = 0; n < INPUT_SAMPLES; n++)
+    {
+        input[n] = (int16_t) (rand() % 65536 - 32768);
+    }
+    count = decimate(factor, false, reference);
+    TEST_CHECK(count == INPUT_SAMPLES / factor, "factor %u: %zu output samples", (unsigned) factor, count);
+    TEST_CHECK(decimate(factor, true, output) == count, "factor %u: SMLAD output count", (unsigned) factor);
+    for (size_t n = 0; n < count; n++)
+    {
+        mismatches += output[n] != reference[n];
+    }
+    TEST_CHECK(0 == mismatches, "factor %u: %zu samples differ", (unsigned) factor, mismatches);
+}
+
+int main(void)
+{
+    static const uint32_t factors[] = { 2, 3, 6 };
+
+    for (size_t i = 0; i < sizeof(factors) / sizeof(factors[0]); i++)
+    {
+        test_response(factors[i]);
+        test_smlad(factors[i]);
+    }
+    return TEST_RESULT("decimator");
+}
@@ -0,0 +1,323 @@
+/******************************************************************************
+* File Name:   test_fusion.c
+*
+* Description: This file tests the orientation filter on the host with a
+*              synthetic motion: the sensor readings of a known trajectory,
+*              with noise, gyroscope bias and linear acceleration, are fed to
+*              fusion_update, and the orientation and linear acceleration
+*              are compared with the truth. No recording of the sensors with
+*              a reference orientation exists, so the trajectory stands in
+*              for one; its readings are quantized to the sensor counts.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include "bmm.h"
+#include "fusion.h"
+#include "imu.h"
+#include "test.h"
+
+TEST_DEFINE_FAILURES;
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+#define RATE                    FUSION_IMU_RATE
+#define OUTPUT_RATE             (200u)
+#define MAG_RATE                (50u)
+
+/* Timeline in seconds: the sensor rests tilted, then moves with linear
+ * acceleration; the magnetometer joins at MAG_START */
+#define MOTION_START            (3.0)
+#define MAG_START               (15.0)
+#define END                     (40.0)
+
+/* The errors are checked once the filter has converged: the tilt after the
+ * initial convergence, the heading a while after the magnetometer joins */
+#define TILT_CHECK_START        (1.5)
+#define HEADING_CHECK_START     (25.0)
+
+/* Bounds of the errors, in degrees and g */
+#define TILT_RMS_MAX            (1.0)
+#define TILT_MAX                (4.0)
+#define ANGLE_RMS_MAX           (3.0)
+#define ANGLE_MAX               (6.0)
+#define LINEAR_RMS_MAX          (0.02)
+#define LINEAR_MAX              (0.08)
+
+/* Sensor imperfections: noise, and a constant gyroscope bias */
+#define ACCEL_NOISE_G           (0.005)
+#define GYRO_NOISE_DPS          (0.1)
+#define GYRO_BIAS_DPS           (0.2)
+#define MAG_NOISE_UT            (0.3)
+
+/* Earth frame with z up: gravity and the magnetic field, north along x */
+#define MAG_NORTH_UT            (20.0)
+#define MAG_UP_UT               (-43.0)
+
+#define DEG_TO_RAD              (M_PI / 180.0)
+
+typedef struct
+{
+    double w, x, y, z;
+} quaternion_t;
+
+typedef struct
+{
+    double sum;
+    double max;
+    uint32_t count;
+} error_t;
+
+
+/*******************************************************************************
+* Function Name: noise
+********************************************************************************
+* Summary:
+*  Returns gaussian noise with the given standard deviation, from a fixed seed.
+*
+*******************************************************************************/
+static double noise(double sigma)
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static quaternion_t multiply(quaternion_t a, quaternion_t b)
+{
+    quaternion_t q =
+    {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    };
+    return q;
+}
+
+static quaternion_t conjugate(quaternion_t q)
+{
+    quaternion_t c = { q.w, -q.x, -q.y, -q.z };
+    return c;
+}
+
+/*******************************************************************************
+* Function Name: to_sensor
+********************************************************************************
+* Summary:
+*  Rotates an earth frame vector into the sensor frame of orientation q, which
+*  rotates sensor frame vectors into the earth frame.
+*
+*******************************************************************************/
+static void to_sensor(quaternion_t q, const double *earth, double *sensor)
+{
+    quaternion_t v = { 0, earth[0], earth[1], earth[2] };
+
+    v = multiply(multiply(conjugate(q), v), q);
+    sensor[0] = v.x;
+    sensor[1] = v.y;
+    sensor[2] = v.z;
+}
+
+/*******************************************************************************
+* Function Name: angular_rate
+********************************************************************************
+* Summary:
+*  The angular rate of the trajectory in the sensor frame, in rad/s: at rest,
+*  then a smooth rotation about all axes of up to 60 degrees per second.
+*
+*******************************************************************************/
+static void angular_rate(double t, double *omega)
+{
+    double amplitude = t < MOTION_START ? 0.0 : 60.0 * DEG_TO_RAD;
+
+    omega[0] = amplitude * sin(2.0 * M_PI * 0.30 * t);
+    omega[1] = amplitude * sin(2.0 * M_PI * 0.21 * t + 1.0);
+    omega[2] = amplitude * 0.7 * sin(2.0 * M_PI * 0.17 * t + 2.0);
+}
+
+/*******************************************************************************
+* Function Name: linear_acceleration
+********************************************************************************
+* Summary:
+*  The linear acceleration of the trajectory in the earth frame, in g: bursts
+*  of shaking in the horizontal plane and along the vertical.
+*
+*******************************************************************************/
+static void linear_acceleration(double t, double *acceleration)
+{
+    double envelope = t < MOTION_START ? 0.0 : sin(2.0 * M_PI * 0.1 * t);
+
+    envelope = envelope > 0 ? envelope : 0;
+    acceleration[0] = 0.15 * envelope * sin(2.0 * M_PI * 1.5 * t);
+    acceleration[1] = 0.10 * envelope * sin(2.0 * M_PI * 2.3 * t + 0.5);
+    acceleration[2] = 0.05 * envelope * sin(2.0 * M_PI * 3.1 * t + 1.0);
+}
+
+static int16_t to_counts(double value, double scale)
+{
+    return (int16_t) lround(value / scale);
+}
+
+static void error_add(error_t *error, double value)
+{
+    error->sum += value * value;
+    error->max = value > error->max ? value : error->max;
+    error->count++;
+}
+
+static double error_rms(const error_t *error)
+{
+    return error->count ? sqrt(error->sum / error->count) : 0.0;
+}
+
+int main(void)
+{
+    /* Rolled by 20 and pitched by -10 degrees; the heading is north, as
+     * assumed by the filter at start-up */
+    quaternion_t truth = multiply((quaternion_t) { cos(10.0 * DEG_TO_RAD), sin(10.0 * DEG_TO_RAD), 0, 0 },
+                                  (quaternion_t) { cos(-5.0 * DEG_TO_RAD), 0, sin(-5.0 * DEG_TO_RAD), 0 });
+    const double up[3] = { 0.0, 0.0, 1.0 };
+    const double field[3] = { MAG_NORTH_UT, 0.0, MAG_UP_UT };
+    error_t tilt = { 0 };
+    error_t angle = { 0 };
+    error_t linear = { 0 };
+    uint32_t samples = (uint32_t) (END * RATE);
+
+    srand(41);
+    TEST_CHECK(fusion_configure(OUTPUT_RATE), "fusion_configure");
+
+    for (uint32_t n = 0; n < samples; n++)
+    {
+        double t = (double) n / RATE;
+        double omega[3];
+        double specific[3];
+        double gravity[3];
+        double linear_earth[3];
+        double linear_sensor[3];
+        double mag_sensor[3];
+        int16_t accel[3];
+        int16_t gyro[3];
+        int16_t mag[3];
+        float result[FUSION_AXIS];
+
+        /* Rotate the truth over the sample period; the gyroscope measures the
+         * rate of the period */
+        angular_rate(t, omega);
+        double rate = sqrt(omega[0] * omega[0] + omega[1] * omega[1] + omega[2] * omega[2]);
+        if (rate > 0)
+        {
+            double half = 0.5 * rate / RATE;
+            quaternion_t step = { cos(half), sin(half) * omega[0] / rate, sin(half) * omega[1] / rate,
+                                  sin(half) * omega[2] / rate };
+            truth = multiply(truth, step);
+        }
+
+        linear_acceleration(t, linear_earth);
+        to_sensor(truth, up, gravity);
+        to_sensor(truth, linear_earth, linear_sensor);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            specific[axis] = gravity[axis] + linear_sensor[axis];
+            accel[axis] = to_counts(specific[axis] + noise(ACCEL_NOISE_G), IMU_ACCEL_SCALE);
+            gyro[axis] = to_counts(omega[axis] / DEG_TO_RAD + GYRO_BIAS_DPS + noise(GYRO_NOISE_DPS), GYRO_SCALE);
+        }
+
+        if (t >= MAG_START && 0 == n % (RATE / MAG_RATE))
+        {
+            to_sensor(truth, field, mag_sensor);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                mag[axis] = to_counts(mag_sensor[axis] + noise(MAG_NOISE_UT), BMM_SCALE);
+            }
+            fusion_set_magnetometer(mag);
+        }
+
+        if (!fusion_update(accel, gyro, RATE, result))
+        {
+            continue;
+        }
+
+        quaternion_t estimate = { result[0], result[1], result[2], result[3] };
+        double norm = sqrt(estimate.w * estimate.w + estimate.x * estimate.x + estimate.y * estimate.y +
+                           estimate.z * estimate.z);
+        TEST_CHECK(fabs(norm - 1.0) < 1e-3, "t = %.3f s: quaternion norm %f", t, norm);
+
+        /* Tilt: the angle between the true and the estimated gravity in the
+         * sensor frame */
+        double estimated_gravity[3] =
+        {
+            2.0 * (estimate.x * estimate.z - estimate.w * estimate.y),
+            2.0 * (estimate.w * estimate.x + estimate.y * estimate.z),
+            estimate.w * estimate.w - estimate.x * estimate.x - estimate.y * estimate.y + estimate.z * estimate.z,
+        };
+        double dot = (gravity[0] * estimated_gravity[0] + gravity[1] * estimated_gravity[1] +
+                      gravity[2] * estimated_gravity[2]) / norm / norm;
+        double residual = 0;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            double difference = result[4 + axis] - linear_sensor[axis];
+            residual += difference * difference;
+        }
+
+        if (t >= TILT_CHECK_START)
+        {
+            error_add(&tilt, acos(fmin(dot, 1.0)) / DEG_TO_RAD);
+            error_add(&linear, sqrt(residual));
+        }
+        if (t >= HEADING_CHECK_START)
+        {
+            /* The whole rotation from the estimate to the truth */
+            quaternion_t difference = multiply(conjugate(estimate), truth);
+            error_add(&angle, 2.0 * acos(fmin(fabs(difference.w) / norm, 1.0)) / DEG_TO_RAD);
+        }
+    }
+
+    printf("tilt: rms %.2f, max %.2f degrees\n", error_rms(&tilt), tilt.max);
+    printf("orientation with magnetometer: rms %.2f, max %.2f degrees\n", error_rms(&angle), angle.max);
+    printf("linear acceleration: rms %.4f, max %.4f g\n", error_rms(&linear), linear.max);
+
+    TEST_CHECK(error_rms(&tilt) < TILT_RMS_MAX, "tilt rms %.2f degrees", error_rms(&tilt));
+    TEST_CHECK(tilt.max < TILT_MAX, "tilt max %.2f degrees", tilt.max);
+    TEST_CHECK(error_rms(&angle) < ANGLE_RMS_MAX, "orientation rms %.2f degrees", error_rms(&angle));
+    TEST_CHECK(angle.max < ANGLE_MAX, "orientation max %.2f degrees", angle.max);
+    TEST_CHECK(error_rms(&linear) < LINEAR_RMS_MAX, "linear acceleration rms %.4f g", error_rms(&linear));
+    TEST_CHECK(linear.max < LINEAR_MAX, "linear acceleration max %.4f g", linear.max);
+
+    return TEST_RESULT("fusion");
+}
@@ -0,0 +1,237 @@
+/******************************************************************************
+* File Name:   test_radar_dsp.c
+*
+* Description: This file tests the radar range and range-Doppler processing
+*              on the host with a synthetic frame of two targets. The outputs
+*              are compared with the floating point reference computed by
+*              data/radar_two_targets.py, and the targets must stand out at
+*              their range and Doppler bins. The smallest geometry of two
+*              chirps must still carry the targets into the map.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "radar_dsp.h"
+#include "test.h"
+#include "data/radar_two_targets.h"
+
+TEST_DEFINE_FAILURES;
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+#define RADAR_TEST_BINS         (RADAR_TEST_SAMPLES / 2)
+#define RADAR_TEST_TARGETS      (sizeof(radar_test_targets) / sizeof(radar_test_targets[0]))
+
+/* Largest difference from the reference, in hundredths of an output unit:
+ * one unit for the rounding of the output, plus the Q15 rounding of the
+ * window and the FFT, relative to the largest output */
+#define TOLERANCE_ABSOLUTE      (100u)
+#define TOLERANCE_RELATIVE      (0.002)
+
+/* A target must exceed every output away from the targets by this factor */
+#define PEAK_MARGIN             (10u)
+
+static uint16_t profile[RADAR_TEST_CHIRPS * RADAR_TEST_BINS];
+static uint16_t map[RADAR_TEST_CHIRPS * RADAR_TEST_BINS];
+
+
+/*******************************************************************************
+* Function Name: compare
+********************************************************************************
+* Summary:
+*  Compares an output with its reference and prints the largest difference.
+*
+*******************************************************************************/
+static void compare(const char *name, const uint16_t *output, const uint32_t *reference, size_t count)
+{
+    uint32_t largest = 0;
+    uint32_t difference_max = 0;
+    size_t worst = 0;
+    uint32_t tolerance;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        largest = reference[i] > largest ? reference[i] : largest;
+    }
+    tolerance = TOLERANCE_ABSOLUTE + (uint32_t) (largest * TOLERANCE_RELATIVE);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t difference = (uint32_t) abs((int32_t) output[i] * 100 - (int32_t) reference[i]);
+        if (difference > difference_max)
+        {
+            difference_max = difference;
+            worst = i;
+        }
+    }
+    printf("%s: largest output %.2f, largest difference %.2f at %zu\n", name, largest / 100.0,
+           difference_max / 100.0, worst);
+    TEST_CHECK(difference_max <= tolerance, "%s[%zu] = %u, reference %.2f", name, worst, output[worst],
+               reference[worst] / 100.0);
+}
+
+/*******************************************************************************
+* Function Name: near_target
+********************************************************************************
+* Summary:
+*  Checks whether a range bin, and a Doppler row unless it is negative, is
+*  within the main lobe of the Hann window around a target.
+*
+*******************************************************************************/
+static bool near_target(int32_t bin, int32_t row)
+{
+    for (size_t t = 0; t < RADAR_TEST_TARGETS; t++)
+    {
+        int32_t target_row = radar_test_targets[t][1] + RADAR_TEST_CHIRPS / 2;
+        if (abs(bin - radar_test_targets[t][0]) <= 1 && (row < 0 || abs(row - target_row) <= 1))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*******************************************************************************
+* Function Name: test_peaks
+********************************************************************************
+* Summary:
+*  Checks that each target is the largest output at its range bin in every
+*  chirp, and at its range and Doppler bin in the map, and that everything
+*  away from the targets is well below them.
+*
+*******************************************************************************/
+static void test_peaks(void)
+{
+    uint16_t weakest = UINT16_MAX;
+    uint16_t clutter = 0;
+
+    for (uint32_t chirp = 0; chirp < RADAR_TEST_CHIRPS; chirp++)
+    {
+        for (size_t t = 0; t < RADAR_TEST_TARGETS; t++)
+        {
+            uint16_t peak = profile[chirp * RADAR_TEST_BINS + radar_test_targets[t][0]];
+            weakest = peak < weakest ? peak : weakest;
+        }
+        /* Bin 0 holds what the integer mean removal leaves */
+        for (int32_t bin = 1; bin < RADAR_TEST_BINS; bin++)
+        {
+            uint16_t value = profile[chirp * RADAR_TEST_BINS + bin];
+            clutter = !near_target(bin, -1) && value > clutter ? value : clutter;
+        }
+    }
+    printf("range profile: weakest target %u, largest clutter %u\n", weakest, clutter);
+    TEST_CHECK(weakest > PEAK_MARGIN * clutter, "range profile: target %u, clutter %u", weakest, clutter);
+
+    weakest = UINT16_MAX;
+    clutter = 0;
+    for (size_t t = 0; t < RADAR_TEST_TARGETS; t++)
+    {
+        int32_t row = radar_test_targets[t][1] + RADAR_TEST_CHIRPS / 2;
+        uint16_t peak = map[row * RADAR_TEST_BINS + radar_test_targets[t][0]];
+        weakest = peak < weakest ? peak : weakest;
+    }
+    for (int32_t row = 0; row < RADAR_TEST_CHIRPS; row++)
+    {
+        for (int32_t bin = 1; bin < RADAR_TEST_BINS; bin++)
+        {
+            uint16_t value = map[row * RADAR_TEST_BINS + bin];
+            clutter = !near_target(bin, row) && value > clutter ? value : clutter;
+        }
+    }
+    printf("range-Doppler map: weakest target %u, largest clutter %u\n", weakest, clutter);
+    TEST_CHECK(weakest > PEAK_MARGIN * clutter, "range-Doppler map: target %u, clutter %u", weakest, clutter);
+}
+
+/*******************************************************************************
+* Function Name: test_two_chirps
+********************************************************************************
+* Summary:
+*  Processes the first two chirps of the frame. The Doppler window of two
+*  chirps is {0, 1}, so both rows of the map hold the spectrum of the second
+*  chirp scaled by 1 / 2, and the targets must stand out in them.
+*
+*******************************************************************************/
+static void test_two_chirps(void)
+{
+    uint32_t difference_max = 0;
+    uint16_t weakest = UINT16_MAX;
+    uint16_t clutter = 0;
+
+    TEST_CHECK(radar_dsp_init(RADAR_TEST_SAMPLES, 2), "radar_dsp_init with 2 chirps");
+    radar_dsp_range(radar_test_frame, profile);
+    radar_dsp_doppler(map);
+
+    for (int32_t row = 0; row < 2; row++)
+    {
+        for (int32_t bin = 1; bin < RADAR_TEST_BINS; bin++)
+        {
+            uint16_t value = map[row * RADAR_TEST_BINS + bin];
+            uint32_t expected = (profile[RADAR_TEST_BINS + bin] + 1u) / 2u;
+            uint32_t difference = value > expected ? value - expected : expected - value;
+
+            difference_max = difference > difference_max ? difference : difference_max;
+            if (near_target(bin, -1))
+            {
+                weakest = value < weakest ? value : weakest;
+            }
+            else
+            {
+                clutter = value > clutter ? value : clutter;
+            }
+        }
+    }
+    printf("two chirps: largest difference %u, weakest target %u, largest clutter %u\n", difference_max,
+           weakest, clutter);
+    TEST_CHECK(difference_max <= 1, "two chirps: map differs from the range profile by %u", difference_max);
+    TEST_CHECK(weakest > PEAK_MARGIN * clutter, "two chirps: target %u, clutter %u", weakest, clutter);
+}
+
+int main(void)
+{
+    TEST_CHECK(radar_dsp_init(RADAR_TEST_SAMPLES, RADAR_TEST_CHIRPS), "radar_dsp_init");
+    TEST_CHECK(!radar_dsp_init(RADAR_TEST_SAMPLES + 1, RADAR_TEST_CHIRPS), "radar_dsp_init accepts 65 samples");
+    TEST_CHECK(radar_dsp_init(RADAR_TEST_SAMPLES, RADAR_TEST_CHIRPS), "radar_dsp_init");
+
+    radar_dsp_range(radar_test_frame, profile);
+    radar_dsp_doppler(map);
+
+    compare("range profile", profile, radar_test_profile, RADAR_TEST_CHIRPS * RADAR_TEST_BINS);
+    compare("range-Doppler map", map, radar_test_map, RADAR_TEST_CHIRPS * RADAR_TEST_BINS);
+    test_peaks();
+    test_two_chirps();
+
+    return TEST_RESULT("radar_dsp");
+}
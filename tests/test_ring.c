@@ -0,0 +1,313 @@
+/******************************************************************************
+* File Name:   test_ring.c
+*
+* Description: This file stress tests the single-producer single-consumer ring
+*              with a producer and a consumer thread: the items arrive whole and
+*              in order, and every item that is not delivered is counted as an
+*              overflow.
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ring.h"
+#include "test.h"
+
+TEST_DEFINE_FAILURES;
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+#define CAPACITY            (64u)
+#define ITEMS               (4000000u)
+
+/* Words of an item; they all carry its sequence number, so an item that is
+ * read while it is written shows up as a torn item */
+#define ITEM_WORDS          (8u)
+
+typedef struct
+{
+    uint32_t word[ITEM_WORDS];
+} item_t;
+
+typedef struct
+{
+    ring_t ring;
+    item_t items[CAPACITY];
+    uint32_t pushed;
+    uint32_t dropped;
+} stress_t;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t gaps;
+    uint32_t torn;
+    uint32_t reordered;
+    uint32_t high_count;
+} consumer_t;
+
+
+/*******************************************************************************
+* Function Name: producer
+********************************************************************************
+* Summary:
+*  Writes the sequence numbers 0 to ITEMS - 1, alternating ring_push with
+*  filling a slot of ring_reserve in place, and counts the items the ring
+*  refused. It yields now and then, so the threads also interleave on a
+*  single core.
+*
+*******************************************************************************/
+static void* producer(void *argument)
+{
+    stress_t *stress = argument;
+    unsigned int seed = 1;
+
+    for (uint32_t sequence = 0; sequence < ITEMS; sequence++)
+    {
+        bool stored;
+
+        if (sequence & 1)
+        {
+            item_t item;
+            for (uint32_t word = 0; word < ITEM_WORDS; word++)
+            {
+                item.word[word] = sequence;
+            }
+            stored = ring_push(&stress->ring, &item);
+        }
+        else
+        {
+            item_t *slot = ring_reserve(&stress->ring);
+            stored = NULL != slot;
+            if (stored)
+            {
+                for (uint32_t word = 0; word < ITEM_WORDS; word++)
+                {
+                    slot->word[word] = sequence;
+                }
+                ring_commit(&stress->ring);
+            }
+        }
+
+        if (stored)
+        {
+            stress->pushed++;
+        }
+        else
+        {
+            stress->dropped++;
+        }
+
+        if (0 == rand_r(&seed) % 64)
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: consume
+********************************************************************************
+* Summary:
+*  Checks one item against the sequence number expected next: the gap to the
+*  previous item is the number of items the producer dropped in between.
+*
+*******************************************************************************/
+static void consume(consumer_t *consumer, const item_t *item, uint32_t *next)
+{
+    uint32_t sequence = item->word[0];
+
+    for (uint32_t word = 1; word < ITEM_WORDS; word++)
+    {
+        if (item->word[word] != sequence)
+        {
+            consumer->torn++;
+            break;
+        }
+    }
+
+    if (sequence < *next)
+    {
+        consumer->reordered++;
+    }
+    else
+    {
+        consumer->gaps += sequence - *next;
+        *next = sequence + 1;
+    }
+    consumer->received++;
+}
+
+/*******************************************************************************
+* Function Name: consumer_run
+********************************************************************************
+* Summary:
+*  Reads items until the producer is done and the ring is empty, alternating
+*  ring_pop with reading in place through ring_peek. It yields when the ring
+*  is empty, and stalls now and then so the ring overflows.
+*
+*******************************************************************************/
+static void consumer_run(stress_t *stress, consumer_t *consumer, const volatile bool *done)
+{
+    unsigned int seed = 2;
+    uint32_t next = 0;
+
+    for (;;)
+    {
+        bool finished = *done;
+        uint32_t count = ring_count(&stress->ring);
+        bool got;
+
+        if (count > consumer->high_count)
+        {
+            consumer->high_count = count;
+        }
+
+        if (consumer->received & 1)
+        {
+            item_t item;
+            got = ring_pop(&stress->ring, &item);
+            if (got)
+            {
+                consume(consumer, &item, &next);
+            }
+        }
+        else
+        {
+            const item_t *slot = ring_peek(&stress->ring);
+            got = NULL != slot;
+            if (got)
+            {
+                consume(consumer, slot, &next);
+                ring_release(&stress->ring);
+            }
+        }
+
+        if (!got && finished)
+        {
+            break;
+        }
+
+        if (!got || 0 == rand_r(&seed) % 256)
+        {
+            sched_yield();
+        }
+    }
+
+    /* The items dropped after the last one received */
+    consumer->gaps += ITEMS - next;
+}
+
+static volatile bool producer_done;
+
+static void* producer_thread(void *argument)
+{
+    producer(argument);
+    __atomic_store_n(&producer_done, true, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: test_sequential
+********************************************************************************
+* Summary:
+*  Checks the bookkeeping on a single thread: the capacity, the overflow and
+*  high-water counts, flushing, and the capacity check of ring_init.
+*
+*******************************************************************************/
+static void test_sequential(void)
+{
+    static item_t items[CAPACITY];
+    ring_t ring;
+    item_t item = { { 0 } };
+
+    TEST_CHECK(CY_RSLT_SUCCESS != ring_init(&ring, items, sizeof(item_t), 48),
+               "a capacity of 48 is accepted");
+    TEST_CHECK(CY_RSLT_SUCCESS == ring_init(&ring, items, sizeof(item_t), CAPACITY), "ring_init");
+
+    for (uint32_t n = 0; n < CAPACITY; n++)
+    {
+        item.word[0] = n;
+        TEST_CHECK(ring_push(&ring, &item), "push %u of %u", n, CAPACITY);
+    }
+    for (uint32_t n = 0; n < 5; n++)
+    {
+        TEST_CHECK(!ring_push(&ring, &item), "push into a full ring");
+    }
+    TEST_CHECK(NULL == ring_reserve(&ring), "reserve in a full ring");
+    TEST_CHECK(6 == ring_get_overflows(&ring), "overflows %u, expected 6", ring_get_overflows(&ring));
+    TEST_CHECK(CAPACITY == ring_get_high_water(&ring), "high water %u", ring_get_high_water(&ring));
+
+    TEST_CHECK(ring_pop(&ring, &item) && 0 == item.word[0], "first item %u", item.word[0]);
+    ring_flush(&ring);
+    TEST_CHECK(0 == ring_count(&ring), "count after flush %u", ring_count(&ring));
+    TEST_CHECK(!ring_pop(&ring, &item), "pop from an empty ring");
+    TEST_CHECK(CAPACITY == ring_get_high_water(&ring), "high water after flush %u", ring_get_high_water(&ring));
+}
+
+int main(void)
+{
+    static stress_t stress;
+    consumer_t consumer = { 0 };
+    pthread_t thread;
+
+    test_sequential();
+
+    TEST_CHECK(CY_RSLT_SUCCESS == ring_init(&stress.ring, stress.items, sizeof(item_t), CAPACITY), "ring_init");
+    pthread_create(&thread, NULL, producer_thread, &stress);
+    consumer_run(&stress, &consumer, &producer_done);
+    pthread_join(thread, NULL);
+
+    uint32_t overflows = ring_get_overflows(&stress.ring);
+    uint32_t high_water = ring_get_high_water(&stress.ring);
+
+    printf("%u items: %u received, %u dropped, %u overflows, high water %u of %u\n",
+           ITEMS, consumer.received, stress.dropped, overflows, high_water, CAPACITY);
+
+    TEST_CHECK(0 == consumer.torn, "%u torn items", consumer.torn);
+    TEST_CHECK(0 == consumer.reordered, "%u items out of order", consumer.reordered);
+    TEST_CHECK(consumer.received == stress.pushed, "received %u, pushed %u", consumer.received, stress.pushed);
+    TEST_CHECK(consumer.gaps == stress.dropped, "missing %u, dropped %u", consumer.gaps, stress.dropped);
+    TEST_CHECK(overflows == stress.dropped, "overflows %u, dropped %u", overflows, stress.dropped);
+    TEST_CHECK(stress.dropped > 0, "the ring never overflowed");
+    TEST_CHECK(high_water <= CAPACITY && high_water >= consumer.high_count,
+               "high water %u, seen %u", high_water, consumer.high_count);
+
+    return TEST_RESULT("ring");
+}
@@ -0,0 +1,1100 @@
+/******************************************************************************
+* File Name:   benchmark.cpp
+*
+* Description: Host-side benchmark of the streaming protocol. Opens the USB
+*              CDC tty of the device (or any tty or pty speaking the protocol),
+*              reads the config? response, subscribes to the chosen channels
+*              and keeps the heartbeat going while it measures what arrives:
+*              the frame rate, inter-arrival times and jitter, gaps and lost
+*              samples of each channel, and the total throughput. The results
+*              are written as JSON so firmware builds can be compared.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+constexpr int CONFIG_TIMEOUT_MS = 3000;
+constexpr int STATS_TIMEOUT_MS = 2000;
+/* A text line longer than this is taken as lost framing */
+constexpr size_t MAX_LINE_LENGTH = 4096;
+constexpr size_t PACKET_HEADER_SIZE = 2;
+constexpr size_t PACKET_TRAILER_SIZE = 2;
+
+using Clock = std::chrono::steady_clock;
+
+/*******************************************************************************
+* JSON values, enough to read the config? and stats? responses
+*******************************************************************************/
+struct Json
+{
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json* get(const std::string& key) const
+    {
+        for (const auto& member : object)
+        {
+            if (member.first == key)
+            {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    Json parse()
+    {
+        Json value = parse_value();
+        skip_space();
+        if (pos_ != text_.size())
+        {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    const std::string& text_;
+    size_t pos_ = 0;
+
+    [[noreturn]] void fail(const char* what) const
+    {
+        throw std::runtime_error(std::string("JSON: ") + what + " at offset " + std::to_string(pos_));
+    }
+
+    void skip_space()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+        {
+            pos_++;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skip_space();
+        if (pos_ < text_.size() && text_[pos_] == c)
+        {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+        {
+            fail("unexpected character");
+        }
+    }
+
+    Json parse_value()
+    {
+        Json value;
+
+        skip_space();
+        if (pos_ >= text_.size())
+        {
+            fail("unexpected end");
+        }
+        char c = text_[pos_];
+        if (c == '{')
+        {
+            pos_++;
+            value.type = Json::Type::Object;
+            if (consume('}'))
+            {
+                return value;
+            }
+            do
+            {
+                skip_space();
+                std::string key = parse_string();
+                expect(':');
+                value.object.emplace_back(key, parse_value());
+            } while (consume(','));
+            expect('}');
+        }
+        else if (c == '[')
+        {
+            pos_++;
+            value.type = Json::Type::Array;
+            if (consume(']'))
+            {
+                return value;
+            }
+            do
+            {
+                value.array.push_back(parse_value());
+            } while (consume(','));
+            expect(']');
+        }
+        else if (c == '"')
+        {
+            value.type = Json::Type::String;
+            value.string = parse_string();
+        }
+        else if (text_.compare(pos_, 4, "true") == 0 || text_.compare(pos_, 5, "false") == 0)
+        {
+            value.type = Json::Type::Bool;
+            value.boolean = c == 't';
+            pos_ += value.boolean ? 4 : 5;
+        }
+        else if (text_.compare(pos_, 4, "null") == 0)
+        {
+            pos_ += 4;
+        }
+        else
+        {
+            const char* start = text_.c_str() + pos_;
+            char* end = nullptr;
+            value.type = Json::Type::Number;
+            value.number = std::strtod(start, &end);
+            if (end == start)
+            {
+                fail("invalid value");
+            }
+            pos_ += end - start;
+        }
+        return value;
+    }
+
+    std::string parse_string()
+    {
+        std::string result;
+
+        if (pos_ >= text_.size() || text_[pos_] != '"')
+        {
+            fail("expected string");
+        }
+        pos_++;
+        while (pos_ < text_.size() && text_[pos_] != '"')
+        {
+            if (text_[pos_] == '\\' && pos_ + 1 < text_.size())
+            {
+                pos_++;
+            }
+            result += text_[pos_++];
+        }
+        if (pos_ >= text_.size())
+        {
+            fail("unterminated string");
+        }
+        pos_++;
+        return result;
+    }
+};
+
+/*******************************************************************************
+* JSON output
+*******************************************************************************/
+std::string json_string(const std::string& text)
+{
+    std::string result = "\"";
+
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+std::string json_number(double value)
+{
+    char text[32];
+
+    if (!std::isfinite(value))
+    {
+        return "null";
+    }
+    std::snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+/*******************************************************************************
+* Serial port
+*******************************************************************************/
+class Port
+{
+public:
+    explicit Port(const std::string& path)
+    {
+        fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd_ < 0)
+        {
+            throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+        }
+
+        /* Raw 8N1; the baud rate only matters for the debug UART */
+        struct termios tio;
+        if (::isatty(fd_) && ::tcgetattr(fd_, &tio) == 0)
+        {
+            ::cfmakeraw(&tio);
+            tio.c_cflag |= CLOCAL | CREAD;
+            tio.c_cc[VMIN] = 0;
+            tio.c_cc[VTIME] = 0;
+#ifdef B1000000
+            ::cfsetispeed(&tio, B1000000);
+            ::cfsetospeed(&tio, B1000000);
+#endif
+            ::tcsetattr(fd_, TCSANOW, &tio);
+            ::tcflush(fd_, TCIOFLUSH);
+        }
+    }
+
+    ~Port()
+    {
+        ::close(fd_);
+    }
+
+    Port(const Port&) = delete;
+    Port& operator=(const Port&) = delete;
+
+    void send(const std::string& command)
+    {
+        std::string line = command + "\r\n";
+        size_t sent = 0;
+
+        while (sent < line.size())
+        {
+            ssize_t n = ::write(fd_, line.data() + sent, line.size() - sent);
+            if (n > 0)
+            {
+                sent += n;
+            }
+            else if (n < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                throw std::runtime_error(std::string("write: ") + std::strerror(errno));
+            }
+            else
+            {
+                struct pollfd pfd = { fd_, POLLOUT, 0 };
+                ::poll(&pfd, 1, 100);
+            }
+        }
+    }
+
+    /* Appends the available bytes to buffer, waiting up to timeout_ms for the
+     * first; returns the number of bytes read */
+    size_t receive(std::vector<uint8_t>& buffer, int timeout_ms)
+    {
+        struct pollfd pfd = { fd_, POLLIN, 0 };
+        uint8_t chunk[16384];
+        size_t total = 0;
+
+        if (::poll(&pfd, 1, timeout_ms) <= 0)
+        {
+            return 0;
+        }
+        if (pfd.revents & (POLLERR | POLLNVAL))
+        {
+            throw std::runtime_error("port closed");
+        }
+        for (;;)
+        {
+            ssize_t n = ::read(fd_, chunk, sizeof(chunk));
+            if (n <= 0)
+            {
+                if (n == 0 && total == 0 && (pfd.revents & POLLHUP))
+                {
+                    throw std::runtime_error("port closed");
+                }
+                break;
+            }
+            buffer.insert(buffer.end(), chunk, chunk + n);
+            total += n;
+        }
+        return total;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+/*******************************************************************************
+* Channels
+*******************************************************************************/
+struct Sensor
+{
+    int channel = 0;
+    std::string type;
+    std::string datatype;
+    std::vector<uint32_t> shape;
+    std::vector<uint32_t> rates;
+    std::vector<uint32_t> frame_sizes;
+};
+
+struct Subscription
+{
+    std::string command;        /* Arguments of subscribe, e.g. "1,16000,512" */
+    int channel = 0;
+    uint32_t rate = 0;
+    uint32_t frame_size = 0;    /* 0: the frame size of the config? shape */
+};
+
+struct Channel
+{
+    Sensor sensor;
+    Subscription subscription;
+    size_t payload_size = 0;
+    uint32_t samples_per_packet = 1;
+    std::vector<double> arrivals;   /* Seconds since the subscriptions */
+};
+
+size_t datatype_size(const std::string& datatype)
+{
+    if (datatype == "u8" || datatype == "s8")
+    {
+        return 1;
+    }
+    if (datatype == "u16" || datatype == "s16")
+    {
+        return 2;
+    }
+    if (datatype == "u32" || datatype == "s32" || datatype == "f32")
+    {
+        return 4;
+    }
+    if (datatype == "f64")
+    {
+        return 8;
+    }
+    throw std::runtime_error("unknown datatype " + datatype);
+}
+
+int channel_number(uint8_t c)
+{
+    if (c >= '1' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'Z')
+    {
+        return c - 'A' + 10;
+    }
+    return 0;
+}
+
+std::vector<uint32_t> json_numbers(const Json* value)
+{
+    std::vector<uint32_t> numbers;
+
+    if (value != nullptr)
+    {
+        for (const Json& item : value->array)
+        {
+            numbers.push_back(static_cast<uint32_t>(item.number));
+        }
+    }
+    return numbers;
+}
+
+std::map<int, Sensor> parse_sensors(const Json& config)
+{
+    std::map<int, Sensor> sensors;
+    const Json* list = config.get("sensors");
+
+    if (list == nullptr)
+    {
+        throw std::runtime_error("config? response without sensors");
+    }
+    for (const Json& item : list->array)
+    {
+        Sensor sensor;
+        const Json* value;
+
+        if ((value = item.get("channel")) != nullptr)
+        {
+            sensor.channel = static_cast<int>(value->number);
+        }
+        if ((value = item.get("type")) != nullptr)
+        {
+            sensor.type = value->string;
+        }
+        if ((value = item.get("datatype")) != nullptr)
+        {
+            sensor.datatype = value->string;
+        }
+        sensor.shape = json_numbers(item.get("shape"));
+        sensor.rates = json_numbers(item.get("rates"));
+        sensor.frame_sizes = json_numbers(item.get("frame_sizes"));
+        sensors[sensor.channel] = sensor;
+    }
+    return sensors;
+}
+
+Subscription parse_subscription(const std::string& argument)
+{
+    Subscription subscription;
+    std::vector<uint32_t> values;
+    std::stringstream stream(argument);
+    std::string field;
+
+    while (std::getline(stream, field, ','))
+    {
+        char* end = nullptr;
+        unsigned long value = std::strtoul(field.c_str(), &end, 10);
+        if (field.empty() || *end != 0)
+        {
+            throw std::runtime_error("invalid subscription " + argument);
+        }
+        values.push_back(static_cast<uint32_t>(value));
+    }
+    if (values.size() < 2 || values.size() > 3)
+    {
+        throw std::runtime_error("invalid subscription " + argument + ", expected <channel>,<rate>[,<frame size>]");
+    }
+    subscription.command = argument;
+    subscription.channel = static_cast<int>(values[0]);
+    subscription.rate = values[1];
+    subscription.frame_size = values.size() > 2 ? values[2] : 0;
+    return subscription;
+}
+
+/* Sets the packet size and the samples per packet from the config? entry;
+ * the first dimension of the shape is the frame size, except for the radar
+ * channels whose packets hold one frame */
+void setup_channel(Channel& channel)
+{
+    const Sensor& sensor = channel.sensor;
+    std::vector<uint32_t> shape = sensor.shape;
+    size_t size = datatype_size(sensor.datatype);
+
+    if (shape.empty())
+    {
+        throw std::runtime_error("channel " + std::to_string(sensor.channel) + " has no shape");
+    }
+    if (channel.subscription.frame_size != 0 && !sensor.frame_sizes.empty())
+    {
+        shape[0] = channel.subscription.frame_size;
+    }
+    for (uint32_t dimension : shape)
+    {
+        size *= dimension;
+    }
+    channel.payload_size = size;
+    channel.samples_per_packet = sensor.type.compare(0, 5, "RADAR") == 0 ? 1 : shape[0];
+
+    if (std::find(sensor.rates.begin(), sensor.rates.end(), channel.subscription.rate) == sensor.rates.end())
+    {
+        std::cerr << "warning: rate " << channel.subscription.rate << " is not listed for channel "
+                  << sensor.channel << "\n";
+    }
+}
+
+/*******************************************************************************
+* Stream parser
+*******************************************************************************/
+class Stream
+{
+public:
+    Stream(Port& port, std::map<int, Channel>& channels) : port_(port), channels_(channels) {}
+
+    uint64_t bytes = 0;
+    uint64_t framing_errors = 0;
+    std::vector<std::string> messages;
+
+    /* Reads for up to timeout_ms and records the packets that arrive before
+     * the end of the measurement */
+    void poll(int timeout_ms, Clock::time_point start, Clock::time_point end)
+    {
+        size_t received = port_.receive(buffer_, timeout_ms);
+        Clock::time_point now = Clock::now();
+
+        if (now < end)
+        {
+            bytes += received;
+        }
+        parse(std::chrono::duration<double>(now - start).count(), now < end);
+    }
+
+    /* Returns and clears the text lines received so far */
+    std::vector<std::string> take_lines()
+    {
+        std::vector<std::string> lines;
+        lines.swap(lines_);
+        return lines;
+    }
+
+private:
+    Port& port_;
+    std::map<int, Channel>& channels_;
+    std::vector<uint8_t> buffer_;
+    std::vector<std::string> lines_;
+    bool synchronized_ = true;
+
+    void parse(double time, bool record)
+    {
+        size_t pos = 0;
+
+        while (pos < buffer_.size())
+        {
+            size_t available = buffer_.size() - pos;
+
+            if (buffer_[pos] == 'B')
+            {
+                if (available < PACKET_HEADER_SIZE)
+                {
+                    break;
+                }
+                auto channel = channels_.find(channel_number(buffer_[pos + 1]));
+                if (channel != channels_.end())
+                {
+                    size_t size = PACKET_HEADER_SIZE + channel->second.payload_size + PACKET_TRAILER_SIZE;
+                    if (available < size)
+                    {
+                        break;
+                    }
+                    if (buffer_[pos + size - 2] == '\r' && buffer_[pos + size - 1] == '\n')
+                    {
+                        if (record)
+                        {
+                            channel->second.arrivals.push_back(time);
+                        }
+                        synchronized_ = true;
+                        pos += size;
+                        continue;
+                    }
+                }
+            }
+            else
+            {
+                size_t end = pos;
+                bool printable = true;
+
+                while (end + 1 < buffer_.size() && !(buffer_[end] == '\r' && buffer_[end + 1] == '\n') &&
+                       end - pos < MAX_LINE_LENGTH)
+                {
+                    printable = printable && (buffer_[end] >= 0x20 && buffer_[end] < 0x7f);
+                    end++;
+                }
+                if (printable && end + 1 < buffer_.size() && buffer_[end] == '\r')
+                {
+                    std::string line(buffer_.begin() + pos, buffer_.begin() + end);
+                    lines_.push_back(line);
+                    if (line.compare(0, 5, "ERROR") == 0)
+                    {
+                        messages.push_back(line);
+                    }
+                    synchronized_ = true;
+                    pos = end + 2;
+                    continue;
+                }
+                if (printable && end - pos < MAX_LINE_LENGTH)
+                {
+                    break;
+                }
+            }
+
+            /* Neither a packet of a subscribed channel nor a line: count the
+             * loss of framing once and continue after the next line end */
+            if (synchronized_)
+            {
+                framing_errors++;
+                synchronized_ = false;
+            }
+            pos = resync(pos + 1);
+        }
+        buffer_.erase(buffer_.begin(), buffer_.begin() + pos);
+    }
+
+    size_t resync(size_t pos)
+    {
+        for (; pos + 1 < buffer_.size(); pos++)
+        {
+            if (buffer_[pos] == '\r' && buffer_[pos + 1] == '\n')
+            {
+                return pos + 2;
+            }
+        }
+        return pos;
+    }
+};
+
+/*******************************************************************************
+* Results
+*******************************************************************************/
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return NAN;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+std::string json_percentiles(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return "{ \"min\": " + json_number(values.empty() ? NAN : values.front() * 1e3) +
+           ", \"p50\": " + json_number(percentile(values, 0.50) * 1e3) +
+           ", \"p90\": " + json_number(percentile(values, 0.90) * 1e3) +
+           ", \"p99\": " + json_number(percentile(values, 0.99) * 1e3) +
+           ", \"p999\": " + json_number(percentile(values, 0.999) * 1e3) +
+           ", \"max\": " + json_number(values.empty() ? NAN : values.back() * 1e3) + " }";
+}
+
+struct ChannelResult
+{
+    uint64_t packets = 0;
+    double frame_rate = 0;
+    double expected_frame_rate = 0;
+    double bytes_per_s = 0;
+    uint64_t gaps = 0;
+    uint64_t missing_samples = 0;
+    double loss = 0;
+};
+
+ChannelResult evaluate(const Channel& channel, double duration, double gap_factor, double gap_min,
+                       std::vector<double>& intervals, std::vector<double>& jitter)
+{
+    ChannelResult result;
+    const std::vector<double>& arrivals = channel.arrivals;
+    double period = static_cast<double>(channel.samples_per_packet) / channel.subscription.rate;
+
+    result.packets = arrivals.size();
+    result.expected_frame_rate = 1.0 / period;
+    result.bytes_per_s = arrivals.size() * (PACKET_HEADER_SIZE + channel.payload_size + PACKET_TRAILER_SIZE) /
+                         duration;
+    if (arrivals.size() < 2)
+    {
+        return result;
+    }
+
+    double span = arrivals.back() - arrivals.front();
+    result.frame_rate = (arrivals.size() - 1) / span;
+    for (size_t i = 1; i < arrivals.size(); i++)
+    {
+        double interval = arrivals[i] - arrivals[i - 1];
+        intervals.push_back(interval);
+        jitter.push_back(std::fabs(interval - period));
+        if (interval > gap_factor * period && interval - period > gap_min)
+        {
+            result.gaps++;
+        }
+    }
+
+    /* The packets carry no sequence numbers; the samples missing from the
+     * nominal rate over the time between the first and last packet are lost.
+     * A deficit of up to one packet is within the jitter of those two. */
+    double expected = channel.subscription.rate * span;
+    double received = static_cast<double>(arrivals.size() - 1) * channel.samples_per_packet;
+    if (expected - received > channel.samples_per_packet)
+    {
+        result.missing_samples = static_cast<uint64_t>(std::llround(expected - received));
+        result.loss = (expected - received) / expected;
+    }
+    return result;
+}
+
+/*******************************************************************************
+* Command line
+*******************************************************************************/
+struct Options
+{
+    std::string device;
+    std::vector<Subscription> subscriptions;
+    std::vector<std::string> configure;
+    double duration = 10;
+    int heartbeat_ms = 1000;
+    double gap_factor = 1.5;
+    double gap_min_ms = 10;
+    std::string output;
+    bool device_stats = true;
+};
+
+void usage(const char* name)
+{
+    std::cerr <<
+        "Usage: " << name << " -d <tty> -s <channel>,<rate>[,<frame size>] [-s ...] [options]\n"
+        "\n"
+        "  -d, --device <tty>        USB CDC tty of the device, or any tty or pty\n"
+        "  -s, --subscribe <args>    channel to measure, as the arguments of subscribe\n"
+        "  -c, --configure <args>    send configure,<args> first, e.g. 2,s16\n"
+        "  -t, --duration <seconds>  length of the measurement (default 10)\n"
+        "      --heartbeat <ms>      heartbeat period (default 1000)\n"
+        "      --gap-factor <x>      interval counted as a gap, in nominal periods (default 1.5)\n"
+        "      --gap-min <ms>        least excess over the nominal period of a gap (default 10)\n"
+        "      --no-device-stats     do not ask the device for its stats? counters\n"
+        "  -o, --output <file>       write the JSON results to a file instead of stdout\n";
+}
+
+Options parse_options(int argc, char** argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error(option + " needs a value");
+            }
+            return argv[++i];
+        };
+
+        if (option == "-d" || option == "--device")
+        {
+            options.device = value();
+        }
+        else if (option == "-s" || option == "--subscribe")
+        {
+            options.subscriptions.push_back(parse_subscription(value()));
+        }
+        else if (option == "-c" || option == "--configure")
+        {
+            options.configure.push_back(value());
+        }
+        else if (option == "-t" || option == "--duration")
+        {
+            options.duration = std::stod(value());
+        }
+        else if (option == "--heartbeat")
+        {
+            options.heartbeat_ms = std::stoi(value());
+        }
+        else if (option == "--gap-factor")
+        {
+            options.gap_factor = std::stod(value());
+        }
+        else if (option == "--gap-min")
+        {
+            options.gap_min_ms = std::stod(value());
+        }
+        else if (option == "--no-device-stats")
+        {
+            options.device_stats = false;
+        }
+        else if (option == "-o" || option == "--output")
+        {
+            options.output = value();
+        }
+        else if (option == "-h" || option == "--help")
+        {
+            usage(argv[0]);
+            std::exit(0);
+        }
+        else
+        {
+            throw std::runtime_error("unknown option " + option);
+        }
+    }
+    if (options.device.empty() || options.subscriptions.empty() || options.duration <= 0 ||
+        options.heartbeat_ms <= 0)
+    {
+        usage(argv[0]);
+        std::exit(2);
+    }
+    return options;
+}
+
+/* Sends config? and returns the parsed response. Stale packets of an earlier
+ * session may precede it; config? cancels their subscriptions. */
+Json read_config(Port& port)
+{
+    std::vector<uint8_t> buffer;
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(CONFIG_TIMEOUT_MS);
+
+    port.send("config?");
+    while (Clock::now() < deadline)
+    {
+        port.receive(buffer, 100);
+
+        /* The response starts with a line holding only the opening brace */
+        for (size_t start = 0; start + 2 < buffer.size(); start++)
+        {
+            if (buffer[start] != '{' || buffer[start + 1] != '\r' || (start > 0 && buffer[start - 1] != '\n'))
+            {
+                continue;
+            }
+            int depth = 0;
+            for (size_t end = start; end < buffer.size(); end++)
+            {
+                depth += buffer[end] == '{' ? 1 : buffer[end] == '}' ? -1 : 0;
+                if (depth == 0)
+                {
+                    std::string text(buffer.begin() + start, buffer.begin() + end + 1);
+                    return JsonParser(text).parse();
+                }
+            }
+            break;
+        }
+    }
+    throw std::runtime_error("no config? response");
+}
+
+/*******************************************************************************
+* Function Name: run
+********************************************************************************
+* Summary:
+*  Runs the benchmark and returns the JSON results.
+*
+*******************************************************************************/
+std::string run(const Options& options, bool& complete)
+{
+    Port port(options.device);
+    std::map<int, Channel> channels;
+    std::string device_name;
+    std::string device_stats = "null";
+
+    for (const std::string& configure : options.configure)
+    {
+        port.send("configure," + configure);
+    }
+
+    Json config = read_config(port);
+    if (const Json* name = config.get("device_name"))
+    {
+        device_name = name->string;
+    }
+    std::map<int, Sensor> sensors = parse_sensors(config);
+    for (const Subscription& subscription : options.subscriptions)
+    {
+        auto sensor = sensors.find(subscription.channel);
+        if (sensor == sensors.end())
+        {
+            throw std::runtime_error("the device has no channel " + std::to_string(subscription.channel));
+        }
+        Channel& channel = channels[subscription.channel];
+        channel.sensor = sensor->second;
+        channel.subscription = subscription;
+        setup_channel(channel);
+    }
+
+    Stream stream(port, channels);
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(options.duration));
+    Clock::time_point heartbeat = start;
+
+    for (const auto& channel : channels)
+    {
+        port.send("subscribe," + channel.second.subscription.command);
+    }
+    for (Clock::time_point now = start; now < end; now = Clock::now())
+    {
+        if (now >= heartbeat)
+        {
+            port.send("heartbeat");
+            heartbeat += std::chrono::milliseconds(options.heartbeat_ms);
+        }
+        int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::min(heartbeat, end) - now).count());
+        stream.poll(std::max(timeout, 1), start, end);
+    }
+
+    /* The device counters are read while streaming, then streaming stops */
+    if (options.device_stats)
+    {
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(STATS_TIMEOUT_MS);
+        bool answered = false;
+
+        stream.take_lines();
+        port.send("stats?");
+        while (!answered && Clock::now() < deadline)
+        {
+            stream.poll(50, start, end);
+            for (const std::string& line : stream.take_lines())
+            {
+                if (line.compare(0, 1, "{") == 0)
+                {
+                    JsonParser(line).parse();
+                    device_stats = line;
+                    answered = true;
+                }
+                else if (line.compare(0, 5, "ERROR") == 0)
+                {
+                    answered = true;
+                }
+            }
+        }
+    }
+    port.send("unsubscribe");
+
+    std::ostringstream json;
+    uint64_t total = 0;
+    complete = true;
+
+    json << "{\n"
+         << "  \"device\": " << json_string(options.device) << ",\n"
+         << "  \"device_name\": " << json_string(device_name) << ",\n"
+         << "  \"duration_s\": " << json_number(options.duration) << ",\n"
+         << "  \"channels\": [";
+    for (const auto& entry : channels)
+    {
+        const Channel& channel = entry.second;
+        std::vector<double> intervals;
+        std::vector<double> jitter;
+        ChannelResult result = evaluate(channel, options.duration, options.gap_factor, options.gap_min_ms / 1e3,
+                                        intervals, jitter);
+
+        total += result.packets * (PACKET_HEADER_SIZE + channel.payload_size + PACKET_TRAILER_SIZE);
+        complete = complete && result.packets > 0;
+        json << (entry.first == channels.begin()->first ? "\n" : ",\n")
+             << "    { \"channel\": " << channel.sensor.channel
+             << ", \"type\": " << json_string(channel.sensor.type)
+             << ", \"rate\": " << channel.subscription.rate
+             << ", \"samples_per_packet\": " << channel.samples_per_packet
+             << ", \"packet_bytes\": " << PACKET_HEADER_SIZE + channel.payload_size + PACKET_TRAILER_SIZE
+             << ",\n      \"packets\": " << result.packets
+             << ", \"frame_rate\": " << json_number(result.frame_rate)
+             << ", \"expected_frame_rate\": " << json_number(result.expected_frame_rate)
+             << ", \"bytes_per_s\": " << json_number(result.bytes_per_s)
+             << ",\n      \"interval_ms\": " << json_percentiles(intervals)
+             << ",\n      \"jitter_ms\": " << json_percentiles(jitter)
+             << ",\n      \"gaps\": " << result.gaps
+             << ", \"missing_samples\": " << result.missing_samples
+             << ", \"loss\": " << json_number(result.loss) << " }";
+
+        std::fprintf(stderr, "channel %2d %-24s %8llu packets %10.2f/s (expected %.2f/s) gaps %llu loss %.3f%%\n",
+                     channel.sensor.channel, channel.sensor.type.c_str(),
+                     static_cast<unsigned long long>(result.packets), result.frame_rate, result.expected_frame_rate,
+                     static_cast<unsigned long long>(result.gaps), result.loss * 100);
+    }
+    json << "\n  ],\n"
+         << "  \"total\": { \"bytes\": " << stream.bytes
+         << ", \"bytes_per_s\": " << json_number(stream.bytes / options.duration)
+         << ", \"packet_bytes_per_s\": " << json_number(total / options.duration)
+         << ", \"framing_errors\": " << stream.framing_errors << " },\n"
+         << "  \"errors\": [";
+    for (size_t i = 0; i < stream.messages.size(); i++)
+    {
+        json << (i > 0 ? ", " : " ") << json_string(stream.messages[i]);
+    }
+    json << (stream.messages.empty() ? "],\n" : " ],\n")
+         << "  \"device_stats\": " << device_stats << "\n"
+         << "}\n";
+
+    std::fprintf(stderr, "total %.0f bytes/s, %llu framing errors\n", stream.bytes / options.duration,
+                 static_cast<unsigned long long>(stream.framing_errors));
+    return json.str();
+}
+
+} // namespace
+
+/*******************************************************************************
+* Function Name: main
+********************************************************************************
+* Summary:
+*  Exits with 0 when every subscribed channel delivered packets, 1 when one
+*  did not, and 2 on errors.
+*
+*******************************************************************************/
+int main(int argc, char** argv)
+{
+    try
+    {
+        Options options = parse_options(argc, argv);
+        bool complete = false;
+        std::string results = run(options, complete);
+
+        if (options.output.empty())
+        {
+            std::cout << results;
+        }
+        else
+        {
+            std::ofstream file(options.output);
+            file << results;
+            if (!file)
+            {
+                throw std::runtime_error("cannot write " + options.output);
+            }
+        }
+        return complete ? 0 : 1;
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "error: " << error.what() << "\n";
+        return 2;
+    }
+}